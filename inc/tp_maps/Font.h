@@ -49,6 +49,8 @@ struct TP_MAPS_EXPORT GlyphGeometry
   std::array<glm::vec2, 4> textureCoords; // (Bottom left, Bottom right, Top right, Top left)
   std::array<glm::vec2, 4> vertices;      // (Bottom left, Bottom right, Top right, Top left)
 
+  size_t page{0}; //!< The atlas page that the textureCoords refer to.
+
   float leftBearing{0.0f}; //Negative for values to the left of 0
   float rightBearing{0.0f};
   float topBearing{0.0f};    //Positive above 0
@@ -118,6 +120,14 @@ public:
   //! Optionally this can be implemented to render a place holder for a missing glyph.
   virtual void missingGlyph(const std::function<void(const Glyph&)>& addGlyph) const;
 
+  //################################################################################################
+  //! Return true if prepareGlyph can be called from several threads at the same time.
+  /*!
+  If this returns true the FontRenderer will rasterize glyphs in parallel, by default glyphs are
+  rasterized on the render thread.
+  */
+  virtual bool threadSafe() const;
+
   //################################################################################################
   virtual float lineHeight() const = 0;
 };
@@ -20,6 +20,15 @@ class PreparedString;
 struct FontGeometry;
 struct Glyph;
 
+//##################################################################################################
+//! How glyphs are stored in the atlas.
+enum class FontAtlasMode
+{
+  Alpha,  //!< Single channel coverage taken from the glyph alpha, draw with FontShader.
+  Bitmap, //!< RGBA glyphs as rasterized by the font, for colored glyphs, draw with FontShader.
+  SDF     //!< Single channel signed distance fields, draw with FontSDFShader at any scale.
+};
+
 //##################################################################################################
 class TP_MAPS_EXPORT FontRenderer
 {
@@ -39,6 +48,25 @@ public:
   //################################################################################################
   std::shared_ptr<Font> font() const;
 
+  //################################################################################################
+  //! Set how glyphs are stored in the atlas, changing this regenerates the atlas.
+  /*!
+  In SDF mode the distance fields are generated on the CPU from the glyphs that the font produces,
+  a single atlas can then be used to render text at any size.
+
+  \param atlasMode: Store coverage, bitmaps, or signed distance fields. The default is Bitmap, use
+  Alpha to store a quarter of the data for fonts that only produce monochrome glyphs.
+  \param sdfSpread: The number of pixels around the edge of each glyph that the distance field
+  covers, this limits how far the text can be scaled down before it aliases.
+  */
+  void setAtlasMode(FontAtlasMode atlasMode, size_t sdfSpread=4);
+
+  //################################################################################################
+  FontAtlasMode atlasMode() const;
+
+  //################################################################################################
+  size_t sdfSpread() const;
+
   //################################################################################################
   //! Force a regeneration of the texture using only the required characters.
   void squeeze();
@@ -51,21 +79,45 @@ public:
   virtual void invalidateBuffers();
 
   //################################################################################################
-  //! Returns the textureID, binding if required.
+  //! Returns the textureID of the first atlas page, binding if required.
   virtual GLuint textureID();
 
+  //################################################################################################
+  //! Returns the number of atlas pages.
+  /*!
+  Glyphs are packed into free space in the atlas as they are required, when a page is full it
+  grows up to a max size and after that a new page is added. See GlyphGeometry::page.
+  */
+  size_t pageCount();
+
+  //################################################################################################
+  //! Returns the textureID of an atlas page, binding or uploading new glyphs if required.
+  GLuint pageTextureID(size_t page);
+
 protected:
   //################################################################################################
   virtual void prepareFontGeometry(const PreparedString& preparedString, FontGeometry& fontGeometry);
 
   //################################################################################################
+  //! Rebuild the atlas from scratch using only the required characters.
   virtual void generate();
 
   //################################################################################################
+  //! Override to modify glyphs before they are added to the atlas.
+  /*!
+  \note If Font::threadSafe returns true this will be called from several threads at once.
+  */
   virtual void modifyGlyph(const Glyph& glyph, const std::function<void(const Glyph&)>& addGlyph);
 
   //################################################################################################
   //! Reimplement this if you want to modify the texture.
+  /*!
+  This is called with the image of each atlas page when its texture is created, and again if the
+  page grows or the atlas is regenerated. Pass the modified image on to FontRenderer::setTexture.
+  Glyphs added to an existing page are uploaded directly without calling this.
+
+  \deprecated Use modifyGlyph, it is applied to every glyph as it is added.
+  */
   virtual void setTexture(const tp_image_utils::ColorMap& texture);
 
   //################################################################################################
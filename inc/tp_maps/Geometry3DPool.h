@@ -28,6 +28,10 @@ struct ProcessedGeometry3D
   GLuint  normalsTextureID{0}; //!< Normals.
   GLuint    rmttrTextureID{0}; //!< Roughness, metalness, transmission and transmission roughness.
 
+  glm::vec4    rgbaUVTransform{0.0f}; //!< Offset and scale in the atlas or zero, see TexturePool::setUseAtlas.
+  glm::vec4 normalsUVTransform{0.0f}; //!< Offset and scale in the atlas or zero.
+  glm::vec4   rmttrUVTransform{0.0f}; //!< Offset and scale in the atlas or zero.
+
   ProcessedGeometry3D const* alternativeMaterial{nullptr};
 };
 
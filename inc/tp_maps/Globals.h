@@ -67,8 +67,10 @@ namespace tp_maps
 TP_DECLARE_ID(                      defaultSID,                          "Default");
 TP_DECLARE_ID(                       screenSID,                           "Screen");
 TP_DECLARE_ID(                         maskSID,                             "Mask");
+TP_DECLARE_ID(                     overlaysSID,                         "Overlays");
 TP_DECLARE_ID(                   gizmoLayerSID,                      "Gizmo layer");
 TP_DECLARE_ID(                   lineShaderSID,                      "Line shader");
+TP_DECLARE_ID(               wideLineShaderSID,                 "Wide line shader");
 TP_DECLARE_ID(                  imageShaderSID,                     "Image shader");
 TP_DECLARE_ID(              flatColorShaderSID,                "Flat color shader");
 TP_DECLARE_ID(                image3DShaderSID,                  "Image 3D shader");
@@ -83,6 +85,7 @@ TP_DECLARE_ID(                pickingShaderSID,                   "Picking shade
 TP_DECLARE_ID(           depthImage3DShaderSID,            "Depth image 3D shader");
 TP_DECLARE_ID(                  depthShaderSID,                     "Depth shader");
 TP_DECLARE_ID(                   fontShaderSID,                      "Font shader");
+TP_DECLARE_ID(                fontSDFShaderSID,                  "Font SDF shader");
 TP_DECLARE_ID(                  frameShaderSID,                     "Frame shader");
 TP_DECLARE_ID(               postSSAOShaderSID,                 "Post ssao shader");
 TP_DECLARE_ID(       ambientOcclusionShaderSID,         "Ambient occlusion shader");
@@ -97,9 +100,16 @@ TP_DECLARE_ID(       depthOfFieldBlurShaderSID,       "Depth of field blur shade
 TP_DECLARE_ID(         calculateFocusShaderSID,           "Calculate focus shader");
 TP_DECLARE_ID(             downsampleShaderSID,                "Downsample shader");
 TP_DECLARE_ID(               mergeDofShaderSID,                 "Merge dof shader");
+TP_DECLARE_ID(      dofFastDownsampleShaderSID,       "DoF fast downsample shader");
+TP_DECLARE_ID(            dofFastBlurShaderSID,             "DoF fast blur shader");
+TP_DECLARE_ID(           dofFastMergeShaderSID,            "DoF fast merge shader");
+TP_DECLARE_ID(              dofReduceShaderSID,                "DoF reduce shader");
 TP_DECLARE_ID(            passThroughShaderSID,              "Pass through shader");
 TP_DECLARE_ID(             postGrid2DShaderSID,              "Post grid 2D shader");
 TP_DECLARE_ID(              postGammaShaderSID,                "Post gamma shader");
+TP_DECLARE_ID(         postAccumulateShaderSID,           "Post accumulate shader");
+TP_DECLARE_ID(            postUpscaleShaderSID,              "Post upscale shader");
+TP_DECLARE_ID(              postFusedShaderSID,                "Post fused shader");
 TP_DECLARE_ID(             backgroundShaderSID,                "Background shader");
 TP_DECLARE_ID(        backgroundImageShaderSID,          "Background image shader");
 TP_DECLARE_ID(      backgroundPatternShaderSID,        "Background pattern shader");
@@ -459,6 +469,15 @@ enum class HDR
   Yes //!< floating point FBO buffers.
 };
 
+//##################################################################################################
+//! The precision of floating point FBO buffers, only used with HDR::Yes and ExtendedFBO::Yes.
+enum class HDRPrecision
+{
+  Half,   //!< 16 bit float RGBA, enough for tone mapped output at half the memory of Full.
+  Packed, //!< R11G11B10F where it is color renderable, else Half. Unsigned, so normals use Half.
+  Full    //!< 32 bit float, for buffers that are read back or used for precise depth analysis.
+};
+
 //##################################################################################################
 enum class ExtendedFBO
 {
@@ -549,6 +568,24 @@ enum class NChannels
   RGBA = 4
 };
 
+//##################################################################################################
+//! Describes what the channels of a texture hold, used to pick a compressed format.
+enum class TextureUsage
+{
+  Color,   //!< Albedo (and alpha), compressed for perceptual quality.
+  Normals, //!< Tangent space normals, only x and y are required the shader reconstructs z.
+  Data,    //!< Independent data channels for example roughness and metalness.
+  Mask     //!< A single channel stored in red.
+};
+
+//##################################################################################################
+//! Controls if textures are block compressed before being uploaded.
+enum class TextureCompression
+{
+  None, //!< Upload uncompressed RGBA8 textures.
+  Auto  //!< Encode textures on the CPU into a format supported by the device, see TextureUsage.
+};
+
 //##################################################################################################
 enum class KeyboardModifier : size_t
 {
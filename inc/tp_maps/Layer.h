@@ -159,6 +159,22 @@ public:
   //! Set the render pass that this layer should do most of its rendering in.
   virtual void setDefaultRenderPass(const RenderPass& defaultRenderPass);
 
+  //################################################################################################
+  //! The passes that are affected when this layer changes.
+  /*!
+  When update() is called with RenderFromStage::Full the map will only render from the last cached
+  stage before the first of these passes, so a layer that only draws in the GUI does not cause the
+  shadows, geometry, and post processing to be rendered again. If this is empty, the default, every
+  call to update() causes a full render.
+
+  If this only contains the type of the default render pass it will follow changes to the default
+  render pass.
+  */
+  void setAffectedRenderPasses(const std::vector<RenderPass::RenderPassType>& affectedRenderPasses);
+
+  //################################################################################################
+  const std::vector<RenderPass::RenderPassType>& affectedRenderPasses() const;
+
   //################################################################################################
   //! The names of subviews to exclude this layer from.
   const std::unordered_set<tp_utils::StringID>& excludeFromSubviews() const;
@@ -294,6 +310,11 @@ protected:
   //################################################################################################
   void update(const RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews);
 
+  //################################################################################################
+  //! Update only the passes that a change affects, for changes that don't affect every pass the
+  //! layer draws in, see setAffectedRenderPasses().
+  void updateFromRenderPasses(const std::vector<RenderPass::RenderPassType>& renderPasses);
+
   //################################################################################################
   void callAsync(const std::function<void()>& callback);
 
@@ -38,6 +38,7 @@ class RenderInfo;
 class Shader;
 class Texture;
 class PickingResult;
+class WorkerThreads;
 class FontRenderer;
 class PostLayer;
 class EventHandler;
@@ -49,6 +50,7 @@ struct KeyEvent;
 struct TextEditingEvent;
 struct TextInputEvent;
 struct EventHandlerCallbacks;
+enum class CompressedFormat;
 
 //##################################################################################################
 class TP_MAPS_EXPORT Map
@@ -93,6 +95,21 @@ public:
   //################################################################################################
   ShaderProfile shaderProfile() const;
 
+  //################################################################################################
+  //! Compressed texture formats supported by the current context, populated in initializeGL.
+  const std::vector<CompressedFormat>& supportedCompressedFormats() const;
+
+  //################################################################################################
+  //! The max anisotropic filtering level of the current context, populated in initializeGL.
+  /*!
+  This is 1.0 if anisotropic filtering is not supported.
+  */
+  float maxTextureAnisotropy() const;
+
+  //################################################################################################
+  //! The threads shared by everything in this map for CPU work, created on first use.
+  WorkerThreads& workerThreads();
+
   //################################################################################################
   const ColorManagement& colorManagement() const;
 
@@ -267,6 +284,88 @@ public:
   //! Returns true if extended rendering buffers are enabled.
   ExtendedFBO extendedFBO() const;
 
+  //################################################################################################
+  //! Set the precision of the float buffers for intermediate FBOs that don't have their own.
+  void setDefaultHDRPrecision(HDRPrecision hdrPrecision);
+
+  //################################################################################################
+  HDRPrecision defaultHDRPrecision() const;
+
+  //################################################################################################
+  //! Set the precision of the float buffers for the intermediate FBO with this name.
+  /*!
+  Half precision is enough for buffers that are tone mapped for display, buffers that are sampled
+  by analysis passes that are sensitive to precision can be set to Full.
+
+  \param fboName The name of the render pass that swaps to the FBO.
+  \param hdrPrecision The precision to use for the color, normals, and specular buffers.
+  */
+  void setHDRPrecision(const tp_utils::StringID& fboName, HDRPrecision hdrPrecision);
+
+  //################################################################################################
+  //! Returns the precision for the named FBO or the default if it has not been set.
+  HDRPrecision hdrPrecision(const tp_utils::StringID& fboName) const;
+
+  //################################################################################################
+  //! Render the 3D scene at a fraction of the window resolution.
+  /*!
+  The SwapToFBO and SwapToMSAA targets are sized by the render scale. Before the first Text, GUI3D,
+  GUI or SwapToOriginalFBO pass the result is upscaled to the window resolution with bilinear
+  filtering and sharpening, so text and the GUI are always drawn at native resolution.
+
+  If the RenderModeManager is in adaptive mode the scale that it chooses is multiplied by this.
+
+  \param renderScale The fraction of the window size to render at, in the range 0.1 to 1.
+  */
+  void setRenderScale(float renderScale);
+
+  //################################################################################################
+  float renderScale() const;
+
+  //################################################################################################
+  //! Keep a copy of the frame before the Text, GUI3D, and GUI passes.
+  /*!
+  This adds a stage before the first of these passes and draws them into a copy of the frame, so
+  that layers that only affect those passes can be redrawn without rendering the rest of the frame,
+  see Layer::setAffectedRenderPasses(). This costs a full screen copy per frame and is always done
+  when the render scale is less than 1 as the upscale makes the copy anyway.
+  */
+  void setCacheBeforeOverlays(bool cacheBeforeOverlays);
+
+  //################################################################################################
+  bool cacheBeforeOverlays() const;
+
+  //################################################################################################
+  //! Combine consecutive per-pixel post effects into a single full screen pass.
+  /*!
+  Each post layer normally costs a full screen read and write. When this is enabled runs of two or
+  more consecutive post layers that are PostLayer::fusable() are drawn with a single generated
+  shader that applies the PostLayer::fusedFragmentSnippet() of each in turn. Effects that sample
+  neighbouring pixels or other buffers keep their own passes.
+  */
+  void setFusePostEffects(bool fusePostEffects);
+
+  //################################################################################################
+  bool fusePostEffects() const;
+
+  //################################################################################################
+  //! Skip drawing passes whose output is never read, default false, see RenderGraph.
+  /*!
+  Only enable this if layers don't read intermediate FBOs by name, the render graph can't see those
+  reads. FBOs drawn between PushFBOs and PopFBOs are kept either way.
+  */
+  void setCullUnusedRenderPasses(bool cullUnusedRenderPasses);
+
+  //################################################################################################
+  bool cullUnusedRenderPasses() const;
+
+  //################################################################################################
+  //! The strength of the sharpening applied when upscaling, 0 for plain bilinear filtering.
+  void setUpscaleSharpness(float upscaleSharpness);
+
+  //################################################################################################
+  float upscaleSharpness() const;
+
   //################################################################################################
   //! Called when buffers become invalid.
   /*!
@@ -432,6 +531,18 @@ public:
   //################################################################################################
   glm::vec2 screenSize() const;
 
+  //################################################################################################
+  //! The width of the intermediate FBOs that the current pass is rendered to.
+  /*!
+  This is width() scaled by the render scale of the current frame until the frame has been upscaled
+  after that, and outside of paintGL, it is the same as width().
+  */
+  int renderWidth() const;
+
+  //################################################################################################
+  //! The height of the intermediate FBOs that the current pass is rendered to.
+  int renderHeight() const;
+
   //################################################################################################
   tp_utils::CallbackCollection<void(int,int)> mapResized;
 
@@ -443,6 +554,16 @@ public:
   //! Called to queue a refresh
   virtual void update(const RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews);
 
+  //################################################################################################
+  //! Queue a refresh that starts from the last cached stage before the first of these passes.
+  /*!
+  The stages are taken from the passes of the last frame of each subview, the stages added by post
+  layers and the one added by setCacheBeforeOverlays() can be restarted from. If none of those are
+  before the first affected pass this is a full render.
+  */
+  void updateFromRenderPasses(const std::vector<RenderPass::RenderPassType>& renderPasses,
+                              const std::vector<tp_utils::StringID>& subviews);
+
 private:
 
   //################################################################################################
@@ -21,6 +21,9 @@ struct TP_MAPS_EXPORT PreparedStringConfig
 
   //! Offset the text in pixels.
   glm::vec2 pixelOffset{0.0f, 0.0f};
+
+  //! Scale the glyphs, use with FontAtlasMode::SDF to render different sizes from the same atlas.
+  float scale{1.0f};
 };
 
 //##################################################################################################
@@ -43,6 +46,9 @@ public:
   //################################################################################################
   virtual ~PreparedString();
 
+  //################################################################################################
+  FontRenderer* fontRenderer() const;
+
   //################################################################################################
   const std::u16string& text() const;
 
@@ -50,6 +56,10 @@ public:
   //! Returns the textureID, binding if required.
   GLuint textureID() const;
 
+  //################################################################################################
+  //! Returns the textureID of an atlas page, see GlyphGeometry::page.
+  GLuint pageTextureID(size_t page) const;
+
   //################################################################################################
   const FontGeometry& fontGeometry() const;
 
@@ -0,0 +1,118 @@
+#ifndef tp_maps_RenderGraph_h
+#define tp_maps_RenderGraph_h
+
+#include "tp_maps/Globals.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! A list of render passes compiled into passes that read and write named FBOs.
+/*!
+The render passes of a subview are ordered by hand in each PostLayer::addRenderPasses and the FBOs
+that a pass reads and draws to depend on the swaps, pushes, and pops that come before it. compile()
+walks the passes in the same way as Map::executeRenderPasses and records the FBOs that each pass
+reads and writes, from this it:
+ - Validates the passes, for example unbalanced PushFBOs and PopFBOs or blits with nothing to read.
+ - Culls blits that repeat the previous blit when nothing has been drawn in between.
+ - Optionally culls drawing passes and blits whose output is never read or displayed, see
+   setCullUnusedPasses().
+ - Computes the lifetime of each FBO within the frame and groups FBOs that could share memory.
+
+Swaps, pushes, pops, stages, MSAA blits, and custom passes are never culled as later passes depend
+on the state they set up or on buffers that post layers manage themselves.
+
+Layers can also read FBOs by name, for example FBOLayer, and the graph can't see those reads. So FBOs
+written between PushFBOs and PopFBOs are always treated as live, and culling unused passes is off
+unless it is enabled.
+
+Compiling does not make any OpenGL calls so a compiled graph can be inspected without a context.
+*/
+class TP_MAPS_EXPORT RenderGraph
+{
+  TP_NONCOPYABLE(RenderGraph);
+  TP_DQ;
+public:
+  //################################################################################################
+  //! An FBO that passes read from or draw to.
+  struct Resource
+  {
+    tp_utils::StringID name; //!< The name of the FBO, screenSID() for the original FBO.
+    bool multisample{false};
+    size_t firstPass{0};     //!< The index of the first pass that is not culled that uses the FBO.
+    size_t lastPass{0};      //!< The index of the last pass that is not culled that uses the FBO.
+    size_t aliasGroup{0};    //!< FBOs in the same group are never in use at the same time.
+    bool used{false};        //!< False if every pass that uses this FBO was culled.
+    bool pinned{false};      //!< Written between PushFBOs and PopFBOs so it may be read by name.
+  };
+
+  //################################################################################################
+  //! A render pass and the resources that it uses.
+  struct Pass
+  {
+    RenderPass renderPass;
+    std::vector<size_t> reads;  //!< Indices into resources().
+    std::vector<size_t> writes; //!< Indices into resources().
+    bool culled{false};
+  };
+
+  //################################################################################################
+  //! The index of the original FBO provided by the window manager in resources().
+  static constexpr size_t originalFBO{0};
+
+  //################################################################################################
+  RenderGraph();
+
+  //################################################################################################
+  ~RenderGraph();
+
+  //################################################################################################
+  //! Cull drawing passes and blits whose output is not read by a later pass, default false.
+  /*!
+  Only enable this if no layer reads the intermediate FBOs by name outside of a PushFBOs and
+  PopFBOs branch.
+  */
+  void setCullUnusedPasses(bool cullUnusedPasses);
+
+  //################################################################################################
+  bool cullUnusedPasses() const;
+
+  //################################################################################################
+  //! Compile a list of render passes, this replaces the results of any previous compile.
+  void compile(const std::vector<RenderPass>& renderPasses);
+
+  //################################################################################################
+  //! One entry for each of the render passes that were compiled, in the same order.
+  const std::vector<Pass>& passes() const;
+
+  //################################################################################################
+  const std::vector<Resource>& resources() const;
+
+  //################################################################################################
+  //! Problems found in the render passes, empty if they are valid.
+  const std::vector<std::string>& errors() const;
+
+  //################################################################################################
+  //! Returns true if the pass at this index does not need to be executed.
+  bool culled(size_t pass) const;
+
+  //################################################################################################
+  //! The number of groups of FBOs that could share memory.
+  size_t aliasGroupCount() const;
+
+  //################################################################################################
+  //! A table of the passes and resources for debugging.
+  std::string describe() const;
+
+  //################################################################################################
+  //! Compile some known pipelines and check which passes are culled.
+  /*!
+  This does not need an OpenGL context.
+  \return A description of each check that failed, empty if they all passed.
+  */
+  static std::vector<std::string> check();
+};
+
+}
+
+#endif
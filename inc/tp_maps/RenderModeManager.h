@@ -7,6 +7,24 @@ namespace tp_maps
 {
 class Map;
 
+//##################################################################################################
+//! The settings chosen by the adaptive mode of the RenderModeManager and the times behind them.
+struct AdaptiveRenderStats
+{
+  float cpuFrameTimeMS{0.0f};    //!< Smoothed time taken to submit each frame.
+  float gpuFrameTimeMS{0.0f};    //!< Smoothed time the GPU spent on each frame, 0 if not measured.
+  float targetFrameTimeMS{16.0f};
+
+  size_t qualityLevel{0};        //!< 0 is the cheapest, see RenderModeManager::qualityLevels().
+  size_t qualityChanges{0};      //!< The number of times the quality level has changed.
+
+  size_t shadowSamples{0};
+  size_t maxSamples{1};          //!< The upper limit on MSAA samples.
+  bool postEffects{false};       //!< False if skippable post layers are bypassed.
+  bool isDoFRendered{false};
+  float renderScale{1.0f};       //!< The scale applied to the internal resolution.
+};
+
 //##################################################################################################
 class TP_MAPS_EXPORT RenderModeManager
 {
@@ -49,8 +67,88 @@ public:
   //##################################################################################################
   bool msaaAllowed() const;
 
+  //################################################################################################
+  //! The upper limit on MSAA samples when msaaAllowed() is true.
+  size_t maxSamples() const;
+
+  //################################################################################################
+  //! False if post layers that are marked as skippable should be bypassed.
+  bool postEffectsAllowed() const;
+
   //################################################################################################
   void enterFastRenderMode();
+
+  //################################################################################################
+  //! Refine the idle view progressively rather than switching to Intermediate and Full modes.
+  /*!
+  When the view becomes idle each frame is rendered with the Fast mode settings and a different sub
+  pixel jitter and shadow and AO kernel rotation. A PostAccumulateLayer averages these frames so the
+  view converges over progressiveFrames() frames while each frame costs the same as a Fast frame.
+  Interaction, moving the camera, or any other full Map::update resets the accumulation.
+  */
+  void setProgressive(bool progressive);
+
+  //################################################################################################
+  bool progressive() const;
+
+  //################################################################################################
+  //! The number of samples to accumulate before the view is considered converged.
+  void setProgressiveFrames(size_t progressiveFrames);
+
+  //################################################################################################
+  size_t progressiveFrames() const;
+
+  //################################################################################################
+  //! The index of the sample being rendered, 0 if the accumulation has been reset.
+  size_t progressiveSample() const;
+
+  //################################################################################################
+  //! The sub pixel offset for the current sample, in the range -0.5 to 0.5 pixels.
+  glm::vec2 progressiveJitter() const;
+
+  //################################################################################################
+  //! Discard the accumulated samples, this is done by any full Map::update.
+  void resetProgressive();
+
+  //################################################################################################
+  //! Called by Map::update, resets progressive rendering unless the update came from this class.
+  void mapUpdated(const RenderFromStage& renderFromStage);
+
+  //################################################################################################
+  //! Choose the render settings from measured frame times rather than the render mode.
+  /*!
+  In adaptive mode the CPU and GPU time of each frame is measured, using timer queries where they
+  are supported, and the settings are stepped through qualityLevels() to keep the frame time close
+  to targetFrameTime(). The quality is reduced quickly when frames are too slow and only increased
+  after frames have been well inside the budget for a while, a step up that immediately pushes the
+  frame time over budget makes the next step up wait longer.
+  */
+  void setAdaptive(bool adaptive);
+
+  //################################################################################################
+  bool adaptive() const;
+
+  //################################################################################################
+  void setTargetFrameTime(float targetFrameTimeMS);
+
+  //################################################################################################
+  float targetFrameTime() const;
+
+  //################################################################################################
+  //! The number of quality levels that adaptive mode steps through.
+  static size_t qualityLevels();
+
+  //################################################################################################
+  const AdaptiveRenderStats& adaptiveStats() const;
+
+  //################################################################################################
+  //! Called by the map after each frame with the time it took.
+  /*!
+  \param cpuFrameTimeMS The time taken to submit the frame.
+  \param gpuFrameTimeMS The time the GPU spent on the frame, this may be from an earlier frame as
+  the result of timer queries are only read once they are available, 0 if this is not supported.
+  */
+  void frameRendered(float cpuFrameTimeMS, float gpuFrameTimeMS);
 };
 
 }
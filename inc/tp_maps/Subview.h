@@ -2,6 +2,7 @@
 #define tp_maps_Subview_h
 
 #include "tp_maps/Globals.h"
+#include "tp_maps/RenderGraph.h"
 
 namespace tp_maps
 {
@@ -51,6 +52,7 @@ private:
 
   std::vector<RenderPass> m_renderPasses;
   std::vector<RenderPass> m_computedRenderPasses;
+  RenderGraph m_renderGraph;
   std::unordered_map<tp_utils::StringID, size_t> m_stageNameToIndex;
 
   Controller* m_controller{nullptr};
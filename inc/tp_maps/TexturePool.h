@@ -3,6 +3,7 @@
 
 #include "tp_maps/Globals.h"
 #include "tp_maps/subsystems/open_gl/OpenGL.h" // IWYU pragma: keep
+#include "tp_maps/textures/Mipmaps.h"
 
 #include "tp_utils/CallbackCollection.h"
 
@@ -36,6 +37,54 @@ public:
   //################################################################################################
   void incrementKeepHot(bool keepHot);
 
+  //################################################################################################
+  //! Compress textures before upload using a format chosen from the usage in the TexturePoolKey.
+  /*!
+  Existing textures are deleted and will be regenerated the next time they are requested.
+  */
+  void setTextureCompression(TextureCompression textureCompression);
+
+  //################################################################################################
+  TextureCompression textureCompression() const;
+
+  //################################################################################################
+  //! If not empty compressed textures are cached in this directory, see compressImageCached.
+  void setCompressedTextureCacheDirectory(const std::string& compressedTextureCacheDirectory);
+
+  //################################################################################################
+  //! Pack small textures into shared atlas textures.
+  /*!
+  When enabled textureID(key, uvTransform) places combined textures that are no larger than
+  maxAtlasImageSize and use GL_CLAMP_TO_EDGE into shared atlas pages. Materials then only differ
+  by their UV transforms, so many can be drawn without binding different textures.
+
+  \param useAtlas: True to pack textures into atlas pages.
+  \param maxAtlasImageSize: Textures wider or taller than this are given their own texture.
+  */
+  void setUseAtlas(bool useAtlas, size_t maxAtlasImageSize=256);
+
+  //################################################################################################
+  bool useAtlas() const;
+
+  //################################################################################################
+  //! Generate mipmaps on worker threads rather than with glGenerateMipmap on the render thread.
+  /*!
+  Until a texture's mipmaps are ready it is drawn without them, once they are ready the texture is
+  recreated with all of its levels and changed is emitted. Results are collected in Map::animate.
+  Color textures are filtered in linear space, normals and data textures are not. This does not
+  apply to compressed textures or atlas pages.
+
+  \param generateMipmapsAsync: True to generate mipmaps on worker threads.
+  \param mipmapFilter: The filter used to reduce each level.
+  */
+  void setGenerateMipmapsAsync(bool generateMipmapsAsync, MipmapFilter mipmapFilter=MipmapFilter::Box);
+
+  //################################################################################################
+  bool generateMipmapsAsync() const;
+
+  //################################################################################################
+  MipmapFilter mipmapFilter() const;
+
   //################################################################################################
   void subscribe(const tp_utils::StringID& name,
                  const tp_image_utils::ColorMap& image,
@@ -61,6 +110,16 @@ public:
   //################################################################################################
   GLuint textureID(const TexturePoolKey& key);
 
+  //################################################################################################
+  //! Returns the texture for the key, this will be an atlas page if the texture is in an atlas.
+  /*!
+  \param key: The texture to fetch.
+  \param uvTransform: Set to the offset (xy) and scale (zw) of the texture in the atlas, or zero if
+  the texture is not in an atlas. This is passed to G3DMaterialShader::setTextureUVTransforms.
+  \return The texture ID.
+  */
+  GLuint textureID(const TexturePoolKey& key, glm::vec4& uvTransform);
+
   //################################################################################################
   void setTextureWrapS(const tp_utils::StringID& name, GLint textureWrapS);
 
@@ -73,6 +132,14 @@ public:
   //################################################################################################
   void setTextureWrapT(const TexturePoolKey& key, GLint textureWrapT);
 
+  //################################################################################################
+  //! Returns the GPU memory saved by sharing one texture between images with identical content.
+  /*!
+  Images are hashed when they are subscribed, names and keys with identical content and texture
+  parameters share the texture of the first one that was bound.
+  */
+  size_t bytesSavedByDeduplication() const;
+
   //################################################################################################
   void viewImage(const tp_utils::StringID& name, const std::function<void(const tp_image_utils::ColorMap&)>& closure) const;
 
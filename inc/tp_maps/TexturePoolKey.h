@@ -25,6 +25,8 @@ public:
   TPPixel defaultColor;
 
   NChannels nChannels;
+
+  TextureUsage usage;
 };
 
 //##################################################################################################
@@ -47,7 +49,8 @@ public:
                  size_t bIndex_,
                  size_t aIndex_,
                  TPPixel defaultColor_,
-                 NChannels nChannels_);
+                 NChannels nChannels_,
+                 TextureUsage usage_=TextureUsage::Color);
 
   //################################################################################################
   size_t makeHash();
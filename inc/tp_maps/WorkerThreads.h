@@ -0,0 +1,58 @@
+#ifndef tp_maps_WorkerThreads_h
+#define tp_maps_WorkerThreads_h
+
+#include "tp_maps/Globals.h"
+
+#include <functional>
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! A small pool of threads for CPU work that should be kept off the render thread.
+/*!
+Jobs must not make OpenGL calls, results that need uploading should be handed back to the render
+thread, see TexturePool::setGenerateMipmapsAsync.
+
+The Map owns one pool that everything shares, see Map::workerThreads(). Objects that queue jobs that
+use them should pass themselves as the owner and call cancelJobs() before they are destroyed.
+*/
+class TP_MAPS_EXPORT WorkerThreads
+{
+  TP_NONCOPYABLE(WorkerThreads);
+  TP_DQ;
+public:
+  //################################################################################################
+  //! Construct with a number of threads, 0 will use one less than the number of cores.
+  WorkerThreads(size_t nThreads=0);
+
+  //################################################################################################
+  //! Jobs that have not started are discarded, this waits for running jobs to finish.
+  ~WorkerThreads();
+
+  //################################################################################################
+  size_t nThreads() const;
+
+  //################################################################################################
+  //! Queue a job to run on one of the threads.
+  void addJob(const std::function<void()>& job);
+
+  //################################################################################################
+  //! Queue a job that can later be cancelled with cancelJobs(owner).
+  void addJob(const void* owner, const std::function<void()>& job);
+
+  //################################################################################################
+  //! Discard the jobs of owner that have not started and wait for the running ones to finish.
+  void cancelJobs(const void* owner);
+
+  //################################################################################################
+  //! Call closure for each index in [0, n) using the workers and the calling thread.
+  /*!
+  This blocks until every index has been processed.
+  */
+  void parallelFor(size_t n, const std::function<void(size_t)>& closure);
+};
+
+}
+
+#endif
@@ -64,6 +64,9 @@ protected:
 
   //################################################################################################
   void lightsChanged(LightingModelChanged lightingModelChanged) override;
+
+  //################################################################################################
+  void invalidateBuffers() override;
 };
 
 }
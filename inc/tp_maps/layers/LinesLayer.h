@@ -2,6 +2,7 @@
 #define tp_maps_LinesLayer_h
 
 #include "tp_maps/Layer.h"
+#include "tp_maps/shaders/WideLineShader.h"
 #include "tp_maps/subsystems/open_gl/OpenGL.h" // IWYU pragma: keep
 
 #include "tp_math_utils/Geometry3D.h"
@@ -41,6 +42,52 @@ public:
   //################################################################################################
   void updateLines(const std::function<void(std::vector<Lines>&)>& closure);
 
+  //################################################################################################
+  //! Replace a single entry, or add one if index is past the end.
+  /*!
+  In batched mode each entry reserves a power of two number of vertices, if the new lines still fit
+  only the range used by this entry is uploaded again, otherwise the whole buffer is rebuilt.
+  */
+  void setLine(size_t index, const Lines& line);
+
+  //################################################################################################
+  //! Pack all of the lines into one buffer and draw them in groups.
+  /*!
+  By default each entry has its own vertex buffer and draw call. In batched mode the entries are
+  packed into a single buffer and the entries that share a color and mode are drawn together,
+  this is much faster for large numbers of short lines.
+  */
+  void setBatched(bool batched);
+
+  //################################################################################################
+  bool batched() const;
+
+  //################################################################################################
+  //! Draw anti-aliased lines expanded on the GPU instead of using glLineWidth.
+  /*!
+  glLineWidth is ignored by core profiles and most GLES drivers only support 1 pixel wide lines.
+  Wide lines are drawn with WideLineShader and support any width, caps, and round joins. All of
+  the entries are drawn with a single call.
+  */
+  void setWideLines(bool wideLines);
+
+  //################################################################################################
+  bool wideLines() const;
+
+  //################################################################################################
+  //! The units that lineWidth is measured in for wide lines.
+  void setLineWidthUnits(LineWidthUnits lineWidthUnits);
+
+  //################################################################################################
+  LineWidthUnits lineWidthUnits() const;
+
+  //################################################################################################
+  //! How the ends of wide lines are drawn.
+  void setLineCap(LineCap lineCap);
+
+  //################################################################################################
+  LineCap lineCap() const;
+
   //################################################################################################
   //! Render a wire frame of the geometry.
   void setLinesFromGeometry(const std::vector<tp_math_utils::Geometry3D>& geometry);
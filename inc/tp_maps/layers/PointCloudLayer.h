@@ -0,0 +1,136 @@
+#ifndef tp_maps_PointCloudLayer_h
+#define tp_maps_PointCloudLayer_h
+
+#include "tp_maps/Layer.h"
+#include "tp_maps/SpriteTexture.h"
+
+#include "tp_utils/TPPixel.h"
+#include "tp_utils/RefCount.h"
+
+#include "glm/glm.hpp"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! A single point as it is stored on disk.
+struct PointCloudPoint
+{
+  glm::vec3 position;
+  TPPixel color;
+};
+
+//##################################################################################################
+//! Draws very large point clouds by streaming an octree of tiles from disk.
+/*!
+The points are split into an octree where each node holds a subset of the points in its bounds,
+the root holds a coarse sample of the whole cloud and each level adds detail to its parent. Each
+frame the visible nodes are chosen by their projected size on screen until the point budget is
+used up, nodes that are not loaded are read from disk on worker threads and the nodes that have
+not been drawn for the longest are unloaded when too many points are loaded.
+
+The tiles are written with writeTiles. A tile directory contains hierarchy.bin, which holds the
+bounds, point count, and children of each node, and a file for each node named after its path
+from the root, for example r.bin, r0.bin, r04.bin.
+*/
+class TP_MAPS_EXPORT PointCloudLayer: public Layer
+{
+  TP_REF_COUNT_OBJECTS("PointCloudLayer");
+  TP_DQ;
+public:
+  //################################################################################################
+  /*!
+  \param spriteTexture The sprite texture, PointCloudLayer will take ownership of spriteTexture.
+  */
+  PointCloudLayer(SpriteTexture* spriteTexture);
+
+  //################################################################################################
+  ~PointCloudLayer() override;
+
+  //################################################################################################
+  //! Open a tile directory written by writeTiles, returns false if the hierarchy can't be read.
+  bool open(const std::string& directory);
+
+  //################################################################################################
+  //! Unload all nodes and close the tile directory.
+  void close();
+
+  //################################################################################################
+  const std::string& directory() const;
+
+  //################################################################################################
+  //! Split points into an octree and write the tiles to a directory.
+  /*!
+  Each node takes a grid sample of the points in its bounds, the rest are passed down to the
+  children.
+
+  \param points The points to write.
+  \param directory The directory to write to, this must already exist.
+  \param maxPointsPerNode The max number of points to store in each node.
+  \return true if all of the files were written.
+  */
+  static bool writeTiles(const std::vector<PointCloudPoint>& points,
+                         const std::string& directory,
+                         size_t maxPointsPerNode=20000);
+
+  //################################################################################################
+  //! The max number of points to draw each frame, the default is 2 million.
+  void setPointBudget(size_t pointBudget);
+
+  //################################################################################################
+  size_t pointBudget() const;
+
+  //################################################################################################
+  //! The max number of points to keep loaded, the default is 8 million.
+  /*!
+  When this is exceeded the nodes that were drawn the longest time ago are unloaded. Nodes that
+  are drawn in the current frame are never unloaded so this should be larger than pointBudget.
+  */
+  void setMaxLoadedPoints(size_t maxLoadedPoints);
+
+  //################################################################################################
+  size_t maxLoadedPoints() const;
+
+  //################################################################################################
+  //! The radius of each point in pixels.
+  void setPointRadius(float pointRadius);
+
+  //################################################################################################
+  float pointRadius() const;
+
+  //################################################################################################
+  //! Nodes that are smaller than this on screen in pixels are not drawn, the default is 100.
+  void setMinNodeSize(float minNodeSize);
+
+  //################################################################################################
+  float minNodeSize() const;
+
+  //################################################################################################
+  //! The number of nodes in the hierarchy.
+  size_t nodeCount() const;
+
+  //################################################################################################
+  //! The number of points that are loaded.
+  size_t loadedPointCount() const;
+
+  //################################################################################################
+  //! The number of points drawn in the last frame.
+  size_t renderedPointCount() const;
+
+protected:
+  //################################################################################################
+  virtual glm::mat4 calculateMatrix() const;
+
+  //################################################################################################
+  void render(RenderInfo& renderInfo) override;
+
+  //################################################################################################
+  void invalidateBuffers() override;
+
+  //################################################################################################
+  void animate(double timestampMS) override;
+};
+
+}
+
+#endif
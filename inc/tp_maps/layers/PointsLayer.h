@@ -36,6 +36,32 @@ public:
   void setPoints(const std::vector<PointSpriteShader::PointSprite>& points);
 
   //################################################################################################
+  //! Replace points starting at index, only the changed points are uploaded.
+  /*!
+  Points past the end are appended, if index is past the end the gap is filled with free slots that
+appendPoints will reuse. The picking index of every other point is unchanged.
+  */
+  void updatePoints(size_t index, const std::vector<PointSpriteShader::PointSprite>& points);
+
+  //################################################################################################
+  //! Add points, reusing the slots of removed points before growing the buffer.
+  /*!
+  The buffer grows geometrically so this does not upload everything.
+  \return The index of each added point, in the same order as points.
+  */
+  std::vector<size_t> appendPoints(const std::vector<PointSpriteShader::PointSprite>& points);
+
+  //################################################################################################
+  //! Remove count points starting at index.
+  /*!
+  The removed points are replaced with zero radius placeholders that later calls to appendPoints
+  reuse, so the index and picking ID of every other point stays the same and only the removed range
+  is uploaded.
+  */
+  void removePoints(size_t index, size_t count);
+
+  //################################################################################################
+  //! The points including the zero radius placeholders left by removePoints.
   const std::vector<PointSpriteShader::PointSprite>& points() const;
 
 protected:
@@ -0,0 +1,45 @@
+#ifndef tp_maps_PostAccumulateLayer_h
+#define tp_maps_PostAccumulateLayer_h
+
+#include "tp_maps/layers/PostLayer.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Average the frames rendered by the progressive render mode.
+/*!
+Each new progressive sample is blended into a float history buffer with a weight of 1/n, so after n
+samples the output is the average of n frames each rendered with a different jitter, see
+RenderModeManager::setProgressive. Repaints that don't advance the sample show the history
+unchanged. The layer is skipped when progressive rendering is disabled, it should be added after
+the other post layers so that they are averaged as well.
+*/
+class TP_MAPS_EXPORT PostAccumulateLayer: public PostLayer
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  PostAccumulateLayer();
+
+  //################################################################################################
+  ~PostAccumulateLayer() override;
+
+  //################################################################################################
+  //! The number of samples in the current average.
+  size_t accumulatedSamples() const;
+
+protected:
+  //################################################################################################
+  void addRenderPasses(std::vector<RenderPass>& renderPasses) override;
+
+  //################################################################################################
+  void render(tp_maps::RenderInfo& renderInfo) override;
+
+  //################################################################################################
+  void invalidateBuffers() override;
+};
+
+}
+
+#endif
@@ -16,6 +16,9 @@ public:
 protected:
   //################################################################################################
   PostShader* makeShader() override;
+
+  //################################################################################################
+  bool perPixelEffect() const override;
 };
 
 }
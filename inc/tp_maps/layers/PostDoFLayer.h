@@ -15,6 +15,18 @@ namespace tp_maps
 {
 
 //##################################################################################################
+//! Depth of field.
+/*!
+If PostDoFParameters::fast is set a cheaper pipeline is used:
+ - One pass downsamples the color to quarter resolution and stores the circle of confusion in alpha.
+ - A separable scatter as gather blur at quarter resolution.
+ - One merge pass that mixes the sharp and blurred images by the circle of confusion.
+
+The largest circle of confusion is also reduced to a tiny FBO and read back asynchronously. While
+it is below PostDoFParameters::skipThreshold the blur and merge are skipped, skipped frames still
+run the quarter resolution downsample, the reduction, and a full screen copy. As the result arrives
+a frame or two late the layer requests a redraw after the paint when it changes the choice.
+*/
 class TP_MAPS_EXPORT PostDoFLayer: public PostLayer
 {
   TP_DQ;
@@ -13,9 +13,15 @@ public:
   //################################################################################################
   PostGammaLayer();
 
+  //################################################################################################
+  std::string fusedFragmentSnippet() const override;
+
 protected:
   //################################################################################################
   PostShader* makeShader() override;
+
+  //################################################################################################
+  bool perPixelEffect() const override;
 };
 
 }
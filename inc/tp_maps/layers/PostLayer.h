@@ -27,6 +27,9 @@ public:
   //################################################################################################
   void setFrameCoordinateSystem(const tp_utils::StringID& frameCoordinateSystem);
 
+  //################################################################################################
+  const tp_utils::StringID& frameCoordinateSystem() const;
+
   //################################################################################################
   //! The stage just before rendering the selection.
   const RenderFromStage& stage() const;
@@ -36,11 +39,21 @@ public:
 
   //################################################################################################
   //! If true just blit read to draw buffers.
+  /*!
+  This is also true for skippable layers while the RenderModeManager is not allowing post effects.
+  */
   bool bypass() const;
 
   //################################################################################################
   void setBypass(bool bypass);
 
+  //################################################################################################
+  //! If true this layer may be bypassed by the adaptive RenderModeManager to save time.
+  bool skippable() const;
+
+  //################################################################################################
+  void setSkippable(bool skippable);
+
   //################################################################################################
   //! Make the post layer a rectangle, size=1=fullscreen
   void setRectangle(const glm::vec2& size);
@@ -61,6 +74,18 @@ public:
   //################################################################################################
   void setBlit(bool blitRectangle, bool blitFrame);
 
+  //################################################################################################
+  //! True if this layer can currently be fused with its neighbours into a single pass.
+  /*!
+  This requires perPixelEffect() to return true and the layer to cover the whole screen without
+  blits, see Map::setFusePostEffects().
+  */
+  bool fusable() const;
+
+  //################################################################################################
+  //! GLSL that modifies vec3 color, the output of the previous effect, for a fused pass.
+  virtual std::string fusedFragmentSnippet() const;
+
 
 protected:  
   //################################################################################################
@@ -100,13 +125,24 @@ protected:
   void renderWithShader(PostShader* shader, std::function<void()> bindAdditionalTextures = []{});
 
   //################################################################################################
-  void renderToFbo(PostShader* shader, OpenGLFBO& fbo, const GLuint sourceTexture=0);
+  void renderToFbo(PostShader* shader,
+                   OpenGLFBO& fbo,
+                   const GLuint sourceTexture=0,
+                   std::function<void()> bindAdditionalTextures = []{});
 
   //################################################################################################
   void invalidateBuffers() override;
 
   //################################################################################################
   virtual PostShader* makeShader();
+
+  //################################################################################################
+  //! Return true if the effect only depends on the color of each pixel and its coord_tex.
+  /*!
+  Layers that return true must implement fusedFragmentSnippet() and use the default
+  addRenderPasses(). Effects that sample neighbouring pixels or other buffers must return false.
+  */
+  virtual bool perPixelEffect() const;
 };
 
 }
@@ -0,0 +1,31 @@
+#ifndef tp_maps_PointCloudPickingResult_h
+#define tp_maps_PointCloudPickingResult_h
+
+#include "tp_maps/PickingResult.h"
+#include "tp_maps/layers/PointCloudLayer.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+class TP_MAPS_EXPORT PointCloudPickingResult: public PickingResult
+{
+public:
+  //################################################################################################
+  PointCloudPickingResult(const tp_utils::StringID& pickingType_,
+                          const PickingDetails& details_,
+                          const RenderInfo& renderInfo_,
+                          PointCloudLayer* pointCloudLayer_,
+                          const std::string& nodeName_,
+                          size_t index_,
+                          const PointCloudPoint& point_);
+
+  PointCloudLayer* pointCloudLayer;
+  std::string nodeName; //!< The name of the node that the point is in, for example "r04".
+  size_t index;         //!< The index of the point in the node.
+  PointCloudPoint point;
+};
+
+}
+
+#endif
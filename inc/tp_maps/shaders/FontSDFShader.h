@@ -0,0 +1,31 @@
+#ifndef tp_maps_FontSDFShader_h
+#define tp_maps_FontSDFShader_h
+
+#include "tp_maps/shaders/FontShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! A shader for rendering fonts from a signed distance field atlas.
+/*!
+Use this with a FontRenderer in FontAtlasMode::SDF, the same atlas can then be used to render text
+at any scale without blurring.
+*/
+class TP_MAPS_EXPORT FontSDFShader: public FontShader
+{
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return fontSDFShaderSID();}
+
+  //################################################################################################
+  using FontShader::FontShader;
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+};
+
+}
+
+#endif
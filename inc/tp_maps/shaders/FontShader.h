@@ -54,6 +54,66 @@ public:
     void regenerateBuffers() override;
   };
 
+  //################################################################################################
+  //! Draws many strings that share a FontRenderer with a single draw call per atlas page.
+  /*!
+  The glyphs of all the strings are packed into one vertex buffer, each string is offset by its own
+  position in the space of the matrix passed to setMatrix and multiplied by its own color. When
+  a string changes just the glyphs of that string are rewritten, the whole buffer is only rebuilt
+  when the new glyphs need more space on an atlas page than the string already had.
+
+  \warning The PreparedStrings must remain valid until they are replaced or the batch is cleared.
+  */
+  class TP_MAPS_EXPORT Batch
+  {
+    TP_NONCOPYABLE(Batch);
+    TP_DQ;
+    friend class FontShader;
+  public:
+    //##############################################################################################
+    Batch(FontRenderer* fontRenderer);
+
+    //##############################################################################################
+    ~Batch();
+
+    //##############################################################################################
+    //! Remove all strings from the batch.
+    void clear();
+
+    //##############################################################################################
+    //! Add a string to the batch and return its index.
+    size_t addString(PreparedString* preparedString,
+                     const glm::vec3& position,
+                     const glm::vec4& color=glm::vec4(1.0f));
+
+    //##############################################################################################
+    //! Replace a string in the batch, nothing is rewritten if it has not changed.
+    /*!
+    \param index: The index returned by addString.
+    \param preparedString: The text to draw, this must use the same FontRenderer as the batch.
+    \param position: The position to draw the string at, added to each vertex.
+    \param color: Multiplied with the color set with setColor.
+    */
+    void setString(size_t index,
+                   PreparedString* preparedString,
+                   const glm::vec3& position,
+                   const glm::vec4& color=glm::vec4(1.0f));
+
+    //##############################################################################################
+    size_t size() const;
+
+    //##############################################################################################
+    //! The number of draw calls made by the last call to drawBatch.
+    size_t drawCount() const;
+
+    //##############################################################################################
+    //! Called when buffers become invalid.
+    /*!
+    This is called when the OpenGL context becomes invalid, all OpenGL resources should be ignored.
+    */
+    void invalidateBuffers();
+  };
+
   //################################################################################################
   //! Call this to draw the image
   /*!
@@ -61,6 +121,13 @@ public:
   */
   void drawPreparedString(PreparedString& preparedString);
 
+  //################################################################################################
+  //! Draw all the strings in a batch
+  /*!
+  \param batch The strings to render, only strings that have changed are uploaded.
+  */
+  void drawBatch(Batch& batch);
+
   //################################################################################################
   //! Prepare OpenGL for rendering
   void use(ShaderType shaderType) override;
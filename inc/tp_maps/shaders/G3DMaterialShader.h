@@ -52,6 +52,16 @@ public:
                            GLuint normalsTextureID,
                            GLuint rmttrTextureID);
 
+  //################################################################################################
+  //! Set the location of each texture in an atlas.
+  /*!
+  Each transform is the offset (xy) and scale (zw) of the sub-image in the atlas, a zero vector
+  means that the texture is not in an atlas, see TexturePool::setUseAtlas.
+  */
+  virtual void setTextureUVTransforms(const glm::vec4& rgbaUVTransform,
+                                      const glm::vec4& normalsUVTransform,
+                                      const glm::vec4& rmttrUVTransform);
+
   //################################################################################################
   void setBlankTextures();
 
@@ -63,6 +73,13 @@ public:
   */
   virtual void setShadowSamples(size_t shadowSamples);
 
+  //################################################################################################
+  //! Offset the shadow samples by a fraction of a shadow map texel.
+  /*!
+  Used to rotate the shadow kernel between progressive samples, see RenderModeManager.
+  */
+  void setShadowSampleOffset(const glm::vec2& shadowSampleOffset);
+
   //################################################################################################
   //! Discard alpha values less than this
   /*!
@@ -130,6 +147,10 @@ protected:
 
   //################################################################################################
   void drawVertexBuffer(GLenum mode, VertexBuffer* vertexBuffer);
+
+  //################################################################################################
+  //! Bind a texture to one of the three material texture units, skipped if already bound since use().
+  void bindTexture(size_t unit, GLuint textureID, GLint location);
 };
 
 }
@@ -48,6 +48,11 @@ public:
                    GLuint normalsTextureID,
                    GLuint rmttrTextureID) override;
 
+  //################################################################################################
+  void setTextureUVTransforms(const glm::vec4& rgbaUVTransform,
+                              const glm::vec4& normalsUVTransform,
+                              const glm::vec4& rmttrUVTransform) override;
+
   //################################################################################################
   //! Discard alpha values less than this
   /*!
@@ -87,7 +87,36 @@ public:
   };
 
   //################################################################################################
-  VertexBuffer* generateVertexBuffer(Map* map, const std::vector<glm::vec3>& vertices) const;
+  //! Upload vertices to a new vertex buffer.
+  /*!
+  \param usage GL_STATIC_DRAW, or GL_DYNAMIC_DRAW if the buffer will be written with updateVertexBuffer.
+  */
+  VertexBuffer* generateVertexBuffer(Map* map,
+                                     const std::vector<glm::vec3>& vertices,
+                                     GLenum usage=GL_STATIC_DRAW) const;
+
+  //################################################################################################
+  //! Upload vertices to a new vertex buffer that has no index buffer.
+  /*!
+  The result can only be drawn with the ranged drawLines, it is intended for large buffers that are
+  written with updateVertexBuffer where a matching index buffer would never be used.
+
+  \param usage GL_STATIC_DRAW, or GL_DYNAMIC_DRAW if the buffer will be written with updateVertexBuffer.
+  */
+  VertexBuffer* generateArrayBuffer(Map* map,
+                                    const std::vector<glm::vec3>& vertices,
+                                    GLenum usage=GL_DYNAMIC_DRAW) const;
+
+  //################################################################################################
+  //! Overwrite part of a vertex buffer with glBufferSubData.
+  /*!
+  \param vertexBuffer The buffer to update, it must have space for first+vertices.size() vertices.
+  \param vertices The new vertices.
+  \param first The index of the first vertex to overwrite.
+  */
+  void updateVertexBuffer(VertexBuffer* vertexBuffer,
+                          const std::vector<glm::vec3>& vertices,
+                          size_t first) const;
 
   //################################################################################################
   //! Call this to draw the lines
@@ -96,6 +125,21 @@ public:
   \param vertices The points that make up the line.
   */
   void drawLines(GLenum mode, LineShader::VertexBuffer* vertexBuffer);
+
+  //################################################################################################
+  //! Call this to draw several ranges of the same vertex buffer
+  /*!
+  Each range is drawn as a separate primitive so strips and loops are not joined together. Where
+  glMultiDrawArrays is available this is a single draw call.
+
+  \param mode One of GL_LINES, GL_LINE_LOOP, GL_LINE_STRIP
+  \param firsts The index of the first vertex of each range.
+  \param counts The number of vertices in each range.
+  */
+  void drawLines(GLenum mode,
+                 LineShader::VertexBuffer* vertexBuffer,
+                 const std::vector<GLint>& firsts,
+                 const std::vector<GLsizei>& counts);
 };
 
 }
@@ -80,6 +80,11 @@ public:
   };
 
   //################################################################################################
+  //! Holds one entry per point.
+  /*!
+  Where instancing is supported each point is drawn as an instance of a shared quad, otherwise each
+  point is drawn with GL_POINTS and gl_PointSize.
+  */
   struct VertexBuffer
   {
     TP_REF_COUNT_OBJECTS("PointSpriteShader::VertexBuffer");
@@ -99,16 +104,20 @@ public:
 #ifdef TP_VERTEX_ARRAYS_SUPPORTED
     //The Vertex Array Object
     GLuint vaoID{0};
+#endif
 
-    //The Index Buffer Object
-    GLuint iboID{0};
+#ifdef TP_INSTANCING_SUPPORTED
+    //The corners of the quad that is instanced for each point
+    GLuint quadVboID{0};
 #endif
 
-    //The Vertex Buffer Object
+    //The per point Vertex Buffer Object
     GLuint vboID{0};
 
-    GLuint vertexCount{0};
-    GLuint indexCount{0};
+    GLuint pointCount{0};
+
+    //The number of points that vboID has space for
+    GLuint capacity{0};
   };
 
   //################################################################################################
@@ -116,6 +125,25 @@ public:
                                      const std::vector<PointSprite>& pointSptrites,
                                      const std::vector<SpriteCoords>& coords) const;
 
+  //################################################################################################
+  //! Upload a range of points to an existing vertex buffer.
+  /*!
+  The vertex buffer is resized to hold pointSprites.size() points but only the range [first,
+  first+count) is written with glBufferSubData. If the capacity is exceeded it grows geometrically
+  and all the points are uploaded, so appending points does not reallocate each time.
+
+  \param vertexBuffer The buffer to update, as returned by generateVertexBuffer.
+  \param pointSptrites All of the points, indices match the indices in the buffer.
+  \param coords The sprite coords used to look up PointSprite::spriteIndex.
+  \param first The index of the first point that has changed.
+  \param count The number of points that have changed.
+  */
+  void updateVertexBuffer(VertexBuffer* vertexBuffer,
+                          const std::vector<PointSprite>& pointSptrites,
+                          const std::vector<SpriteCoords>& coords,
+                          size_t first,
+                          size_t count) const;
+
   //################################################################################################
   void deleteVertexBuffer(VertexBuffer* vertexBuffer) const;
 
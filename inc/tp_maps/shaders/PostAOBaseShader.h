@@ -19,6 +19,10 @@ struct PostAOParameters
   float boostLowerThreshold{0.4f};
   float boostUpperFactor{0.9f};
   float boostLowerFactor{0.8f};
+
+  //! Divide the resolution of the AO buffer by this, for example 2 or 4. Values above 1 skip the
+  //! blur pass and instead smooth the AO with a depth aware upsample when it is merged.
+  size_t resolutionDivisor{1};
 };
 
 //##################################################################################################
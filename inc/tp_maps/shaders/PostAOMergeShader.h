@@ -26,6 +26,10 @@ public:
   //################################################################################################
   void setSSAOTexture(const GLuint id);
 
+  //################################################################################################
+  //! Set the size of the SSAO texture, used to upsample it when it is lower resolution.
+  void setSSAOTextureSize(size_t width, size_t height);
+
 protected:
   //################################################################################################
   const std::string& fragmentShaderStr(ShaderType shaderType) override;
@@ -0,0 +1,42 @@
+#ifndef tp_maps_PostAccumulateShader_h
+#define tp_maps_PostAccumulateShader_h
+
+#include "tp_maps/shaders/PostShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Blend the previous FBO into a running average of previous frames.
+class TP_MAPS_EXPORT PostAccumulateShader: public PostShader
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return postAccumulateShaderSID();}
+
+  //################################################################################################
+  PostAccumulateShader(Map* map, tp_maps::ShaderProfile shaderProfile);
+
+  //################################################################################################
+  ~PostAccumulateShader();
+
+  //################################################################################################
+  //! The texture that holds the average of the previous frames.
+  void setHistoryTexture(const GLuint id);
+
+  //################################################################################################
+  //! The weight given to the new frame, 1 ignores the history.
+  void setBlendWeight(float blendWeight);
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+
+  //################################################################################################
+  void getLocations(GLuint program, ShaderType shaderType) override;
+};
+
+}
+
+#endif
@@ -19,6 +19,10 @@ struct PostDoFParameters
   float focalDistance{8.0f};
   float blurinessCutoffConstant{10.0f};
 
+  // Fast mode, see PostDoFLayer.
+  bool fast{false};
+  float skipThreshold{0.05f}; //!< Skip the blur if the largest circle of confusion is below this.
+
   // fuzzy equality function used to indicate that shaders need to be recompiled
   bool fuzzyEquals(const PostDoFParameters& other) const;
 };
@@ -49,6 +53,10 @@ public:
 protected:
   //################################################################################################
   void getLocations(GLuint program, ShaderType shaderType) override;
+
+  //################################################################################################
+  //! The parameters as GLSL constants to replace DOF_FRAG_VARS with.
+  std::string dofFragVars() const;
 };
 
 
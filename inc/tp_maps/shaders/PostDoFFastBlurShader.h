@@ -0,0 +1,38 @@
+#ifndef tp_maps_PostDoFFastBlurShader_h
+#define tp_maps_PostDoFFastBlurShader_h
+
+#include "tp_maps/shaders/PostShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Part of the fast DoF shaders, one direction of a separable gather blur.
+class TP_MAPS_EXPORT PostDoFFastBlurShader: public PostShader
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return dofFastBlurShaderSID();}
+
+  //################################################################################################
+  PostDoFFastBlurShader(Map* map, tp_maps::ShaderProfile shaderProfile);
+
+  //################################################################################################
+  ~PostDoFFastBlurShader();
+
+  //################################################################################################
+  //! The offset between taps in texture coordinates, call after use().
+  void setBlurStep(const glm::vec2& blurStep);
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+
+  //################################################################################################
+  void getLocations(GLuint program, ShaderType shaderType) override;
+};
+
+}
+
+#endif
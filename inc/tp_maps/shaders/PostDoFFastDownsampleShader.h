@@ -0,0 +1,27 @@
+#ifndef tp_maps_PostDoFFastDownsampleShader_h
+#define tp_maps_PostDoFFastDownsampleShader_h
+
+#include "tp_maps/shaders/PostDoFBaseShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Part of the fast DoF shaders, downsamples the color and stores the circle of confusion in alpha.
+class TP_MAPS_EXPORT PostDoFFastDownsampleShader: public PostDoFBaseShader
+{
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return dofFastDownsampleShaderSID();}
+
+  //################################################################################################
+  using PostDoFBaseShader::PostDoFBaseShader;
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+};
+
+}
+
+#endif
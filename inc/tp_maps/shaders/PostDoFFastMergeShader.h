@@ -0,0 +1,39 @@
+#ifndef tp_maps_PostDoFFastMergeShader_h
+#define tp_maps_PostDoFFastMergeShader_h
+
+#include "tp_maps/shaders/PostDoFBaseShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Part of the fast DoF shaders, mixes the blurred image with the sharp one by circle of confusion.
+class TP_MAPS_EXPORT PostDoFFastMergeShader: public PostDoFBaseShader
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return dofFastMergeShaderSID();}
+
+  //################################################################################################
+  PostDoFFastMergeShader(Map* map,
+                         tp_maps::ShaderProfile shaderProfile,
+                         const PostDoFParameters& parameters);
+
+  //################################################################################################
+  ~PostDoFFastMergeShader();
+
+  //################################################################################################
+  void setBlurredTexture(GLuint id);
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+
+  //################################################################################################
+  void getLocations(GLuint program, ShaderType shaderType) override;
+};
+
+}
+
+#endif
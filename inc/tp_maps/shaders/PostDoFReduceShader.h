@@ -0,0 +1,51 @@
+#ifndef tp_maps_PostDoFReduceShader_h
+#define tp_maps_PostDoFReduceShader_h
+
+#include "tp_maps/shaders/PostShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Part of the fast DoF shaders, one level of a max reduction of the circle of confusion.
+/*!
+Each output pixel holds the largest alpha of the block of source texels that it covers. The output
+should be at most 4 times smaller than the source along each axis, levels are chained down to a
+reductionSize x reductionSize FBO so that every texel of the source is read.
+*/
+class TP_MAPS_EXPORT PostDoFReduceShader: public PostShader
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return dofReduceShaderSID();}
+
+  //################################################################################################
+  //! The width and height of the last level.
+  static constexpr size_t reductionSize{8};
+
+  //################################################################################################
+  //! The largest reduction of each level along each axis.
+  static constexpr size_t reductionFactor{4};
+
+  //################################################################################################
+  PostDoFReduceShader(Map* map, tp_maps::ShaderProfile shaderProfile);
+
+  //################################################################################################
+  ~PostDoFReduceShader();
+
+  //################################################################################################
+  //! The size in pixels of the source texture and the FBO being drawn to, call after use().
+  void setSizes(const glm::vec2& sourceSize, const glm::vec2& outputSize);
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+
+  //################################################################################################
+  void getLocations(GLuint program, ShaderType shaderType) override;
+};
+
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef tp_maps_PostFusedShader_h
+#define tp_maps_PostFusedShader_h
+
+#include "tp_maps/shaders/PostShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Applies several per-pixel post effects in a single pass.
+/*!
+The fragment shader is generated by inserting the GLSL snippets of each effect into a template, see
+PostLayer::fusedFragmentSnippet(). As each combination of effects is a different program this is not
+created with Map::getShader<T>() but added to the map under a name that includes the snippets.
+*/
+class TP_MAPS_EXPORT PostFusedShader: public PostShader
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return postFusedShaderSID();}
+
+  //################################################################################################
+  /*!
+  \param fusedFragmentSnippets The snippets of each effect in the order they should be applied.
+  */
+  PostFusedShader(Map* map, tp_maps::ShaderProfile shaderProfile, const std::string& fusedFragmentSnippets);
+
+  //################################################################################################
+  ~PostFusedShader();
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+};
+
+}
+
+#endif
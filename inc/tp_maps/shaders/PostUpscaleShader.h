@@ -0,0 +1,42 @@
+#ifndef tp_maps_PostUpscaleShader_h
+#define tp_maps_PostUpscaleShader_h
+
+#include "tp_maps/shaders/PostShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Upscale a lower resolution FBO to the output with bilinear filtering and sharpening.
+class TP_MAPS_EXPORT PostUpscaleShader: public PostShader
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return postUpscaleShaderSID();}
+
+  //################################################################################################
+  PostUpscaleShader(Map* map, tp_maps::ShaderProfile shaderProfile);
+
+  //################################################################################################
+  ~PostUpscaleShader();
+
+  //################################################################################################
+  //! The size of the FBO that is being upscaled in pixels.
+  void setSourceSize(size_t width, size_t height);
+
+  //################################################################################################
+  //! The strength of the sharpening, 0 for plain bilinear filtering.
+  void setSharpness(float sharpness);
+
+protected:
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+
+  //################################################################################################
+  void getLocations(GLuint program, ShaderType shaderType) override;
+};
+
+}
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef tp_maps_WideLineShader_h
+#define tp_maps_WideLineShader_h
+
+#include "tp_maps/Shader.h"
+
+#include "tp_utils/RefCount.h"
+
+#include "glm/glm.hpp" // IWYU pragma: keep
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! How the ends of lines are drawn, joins between segments are always round.
+enum class LineCap
+{
+  Butt,   //!< Stop at the end point.
+  Square, //!< Extend past the end point by half the width.
+  Round   //!< A half circle centered on the end point.
+};
+
+//##################################################################################################
+//! The units that wide line widths are measured in.
+enum class LineWidthUnits
+{
+  Pixels, //!< The width is constant on screen.
+  World   //!< The width is in the units of the coordinate system and shrinks with distance.
+};
+
+//##################################################################################################
+//! A shader for drawing anti-aliased lines of any width.
+/*!
+Each segment is expanded into a screen space quad in the vertex shader and the coverage of each
+pixel is calculated from its distance to the segment, this does not depend on glLineWidth which
+most core profile and GLES drivers limit to 1 pixel. Where instancing is supported each segment is
+stored once and drawn as an instance of a shared quad, otherwise each segment is stored 6 times.
+
+Segments overlap at joins, so each segment also knows its neighbours and a pixel near a join is only
+drawn by the closer of the two segments. This stops translucent lines being blended twice there.
+*/
+class TP_MAPS_EXPORT WideLineShader: public Shader
+{
+  TP_DQ;
+public:
+  //################################################################################################
+  static inline const tp_utils::StringID& name(){return wideLineShaderSID();}
+
+  //################################################################################################
+  WideLineShader(Map* map, tp_maps::ShaderProfile shaderProfile);
+
+  //################################################################################################
+  ~WideLineShader() override;
+
+  //################################################################################################
+  const std::string& vertexShaderStr(ShaderType shaderType) override;
+
+  //################################################################################################
+  const std::string& fragmentShaderStr(ShaderType shaderType) override;
+
+  //################################################################################################
+  void bindLocations(GLuint program, ShaderType shaderType) override;
+
+  //################################################################################################
+  void getLocations(GLuint program, ShaderType shaderType) override;
+
+  //################################################################################################
+  void init() override;
+
+  //################################################################################################
+  //! Prepare OpenGL for rendering
+  void use(ShaderType shaderType) override;
+
+  //################################################################################################
+  //! Call this to set the camera matrix before drawing the lines
+  void setMatrix(const glm::mat4& matrix);
+
+  //################################################################################################
+  void setScreenSize(const glm::vec2& screenSize);
+
+  //################################################################################################
+  //! Set the width of the lines in pixels.
+  void setLineWidth(float lineWidth);
+
+  //################################################################################################
+  //! Set the width of the lines in world units.
+  /*!
+  \param lineWidth The width in the units of the coordinate system.
+  \param projectionMatrix The projection part of the matrix passed to setMatrix.
+  */
+  void setWorldLineWidth(float lineWidth, const glm::mat4& projectionMatrix);
+
+  //################################################################################################
+  void setLineCap(LineCap lineCap);
+
+  //################################################################################################
+  //! A single line segment as it is stored in the vertex buffer.
+  struct Segment
+  {
+    glm::vec3 start{0.0f, 0.0f, 0.0f};
+    glm::vec3 end{0.0f, 0.0f, 0.0f};
+    glm::vec4 color{1.0f, 1.0f, 1.0f, 1.0f};
+    glm::vec2 caps{1.0f, 1.0f}; //!< 1 where start or end are the end of a line, 0 for joins.
+    glm::vec3 previous{0.0f, 0.0f, 0.0f}; //!< The start of the previous segment if caps.x is 0.
+    glm::vec3 next{0.0f, 0.0f, 0.0f};     //!< The end of the next segment if caps.y is 0.
+  };
+
+  //################################################################################################
+  //! Split a line into segments and add them to segments.
+  /*!
+  \param segments The segments will be appended to this.
+  \param points The points that make up the line.
+  \param mode One of GL_LINES, GL_LINE_LOOP, GL_LINE_STRIP
+  \param color The color of the line.
+  */
+  static void appendSegments(std::vector<Segment>& segments,
+                             const std::vector<glm::vec3>& points,
+                             GLenum mode,
+                             const glm::vec4& color);
+
+  //################################################################################################
+  struct VertexBuffer
+  {
+    TP_REF_COUNT_OBJECTS("WideLineShader::VertexBuffer");
+
+    //##############################################################################################
+    VertexBuffer(Map* map_, const Shader* shader_);
+
+    //##############################################################################################
+    ~VertexBuffer();
+
+    //##############################################################################################
+    void bindVBO(size_t firstSegment=0) const;
+
+    Map* map;
+    ShaderPointer shader;
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+    //The Vertex Array Object
+    GLuint vaoID{0};
+#endif
+
+#ifdef TP_INSTANCING_SUPPORTED
+    //The corners of the quad that is instanced for each segment
+    GLuint quadVboID{0};
+#endif
+
+    //The Vertex Buffer Object
+    GLuint vboID{0};
+
+    GLuint segmentCount{0};
+  };
+
+  //################################################################################################
+  VertexBuffer* generateVertexBuffer(Map* map, const std::vector<Segment>& segments) const;
+
+  //################################################################################################
+  //! Overwrite a range of segments in an existing vertex buffer.
+  /*!
+  \param vertexBuffer The buffer to update, it must have space for first+segments.size() segments.
+  \param segments The new segments.
+  \param first The index of the first segment to overwrite.
+  */
+  void updateVertexBuffer(VertexBuffer* vertexBuffer,
+                          const std::vector<Segment>& segments,
+                          size_t first) const;
+
+  //################################################################################################
+  void deleteVertexBuffer(VertexBuffer* vertexBuffer) const;
+
+  //################################################################################################
+  //! Call this to draw all of the segments
+  void drawLines(VertexBuffer* vertexBuffer);
+
+  //################################################################################################
+  //! Call this to draw a range of segments in a single color for picking
+  void drawLinesPicking(VertexBuffer* vertexBuffer,
+                        const glm::vec4& pickingID,
+                        size_t firstSegment,
+                        size_t segmentCount);
+};
+
+}
+
+#endif
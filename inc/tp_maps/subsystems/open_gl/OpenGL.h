@@ -28,6 +28,8 @@
 #elif defined(TP_EMSCRIPTEN) //---------------------------------------------------------------------
 #  include <GLES3/gl3.h>
 #  define TP_GLES3
+// WebGL2 reads buffers with getBufferSubData, Emscripten implements it but gl3.h does not declare it.
+extern "C" void glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void* data);
 
 #elif defined(TP_ANDROID) //------------------------------------------------------------------------
 #  if __ANDROID_API__ < 18
@@ -91,9 +93,19 @@
 #  define tpDeleteVertexArrays glDeleteVertexArrays
 #  define tpDrawElements(mode, count, type, indices) glDrawRangeElements(mode, 0, count, GLsizei(count), type, indices)
 
+#  define TP_INSTANCING_SUPPORTED
+#  define TP_MULTI_DRAW_SUPPORTED
 #  define TP_GLSL_PICKING_SUPPORTED
 #  define TP_FBO_SUPPORTED
 
+#  ifdef GL_TIME_ELAPSED
+#    define TP_TIMER_QUERY_SUPPORTED
+#  endif
+
+#  ifdef GL_PIXEL_PACK_BUFFER
+#    define TP_PIXEL_BUFFER_SUPPORTED
+#  endif
+
 #  define TP_GL_DEPTH_COMPONENT32 GL_DEPTH_COMPONENT32F
 #  define TP_GL_DEPTH_COMPONENT24 GL_DEPTH_COMPONENT24
 #  define TP_GL_DRAW_FRAMEBUFFER GL_DRAW_FRAMEBUFFER
@@ -135,8 +147,10 @@ using TPGLenum = GLenum;
 #  define TP_GL_DEPTH_COMPONENT24 GL_DEPTH_COMPONENT24
 #  define TP_GL_DRAW_FRAMEBUFFER GL_DRAW_FRAMEBUFFER
 
+#  define TP_INSTANCING_SUPPORTED
 #  define TP_GLSL_PICKING_SUPPORTED
 #  define TP_FBO_SUPPORTED
+#  define TP_PIXEL_BUFFER_SUPPORTED
 
 #  define TP_ENABLE_MULTISAMPLE
 #  define TP_ENABLE_MULTISAMPLE_FBO
@@ -187,6 +201,7 @@ struct OpenGLFBO
   Multisample multisample{Multisample::No};      //!< Yes if multisample buffers have been created.
   Multisample multisampleParam{Multisample::No}; //!< Yes if multisample buffers was requested.
   HDR hdr{HDR::No};                              //!< Yes if HDR buffers have been created.
+  HDRPrecision hdrPrecision{HDRPrecision::Half}; //!< The precision of the float buffers.
   ExtendedFBO extendedFBO{ExtendedFBO::No};      //!< Yes if deferred rendering buffers have been created.
 
   bool blitRequired{false};
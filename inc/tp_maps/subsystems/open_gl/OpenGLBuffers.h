@@ -10,6 +10,19 @@ namespace tp_maps
 {
 class Map;
 
+//##################################################################################################
+//! Memory used by transient buffers, see OpenGLBuffers::acquireTransientBuffer.
+/*!
+Sizes are estimated from the formats requested, drivers may pad or compress.
+*/
+struct TransientBufferStats
+{
+  size_t allocatedBytes{0}; //!< The size of all of the buffers in the pool.
+  size_t peakBytes{0};      //!< The most bytes that were in use at once during the last frame.
+  size_t requestedBytes{0}; //!< The bytes that would be needed in the last frame without reuse.
+  size_t bufferCount{0};    //!< The number of buffers in the pool.
+};
+
 //##################################################################################################
 class TP_MAPS_EXPORT OpenGLBuffers
 {
@@ -30,7 +43,52 @@ public:
                      Multisample multisample,
                      HDR hdr,
                      ExtendedFBO extendedFBO,
-                     bool clear) const;
+                     bool clear,
+                     HDRPrecision hdrPrecision=HDRPrecision::Half) const;
+
+  //################################################################################################
+  //! Borrow a buffer from the transient pool, prepare and bind it.
+  /*!
+  Transient buffers are for intermediate results that are only needed for a few passes of a
+  single frame, for example the output of a blur that is consumed by the next pass. Once a buffer
+  is released it can be handed out again with the same size and format, so passes that don't
+  overlap share the same memory rather than each holding their own buffers.
+
+  Buffers that are still acquired at the end of the frame are released by collectTransientBuffers,
+  so the contents must not be relied on in the next frame. Buffers that have not been used for a
+  few frames are deleted.
+
+  \param name The name of the buffer while it is acquired, used for debugging.
+  \return The buffer or nullptr if it could not be prepared.
+  */
+  OpenGLFBO* acquireTransientBuffer(const tp_utils::StringID& name,
+                                    size_t width,
+                                    size_t height,
+                                    CreateColorBuffer createColorBuffer,
+                                    Multisample multisample,
+                                    HDR hdr,
+                                    ExtendedFBO extendedFBO,
+                                    bool clear,
+                                    HDRPrecision hdrPrecision=HDRPrecision::Half) const;
+
+  //################################################################################################
+  //! Return a buffer to the transient pool once nothing else will read from it this frame.
+  void releaseTransientBuffer(OpenGLFBO* buffer) const;
+
+  //################################################################################################
+  //! Called by the map at the end of each frame to release and trim transient buffers.
+  void collectTransientBuffers();
+
+  //################################################################################################
+  //! Delete all of the transient buffers, the context must be current.
+  void deleteTransientBuffers();
+
+  //################################################################################################
+  //! Forget the transient buffers without deleting them, for when the context has been lost.
+  void invalidateTransientBuffers();
+
+  //################################################################################################
+  TransientBufferStats transientBufferStats() const;
 
   //################################################################################################
   bool bindBuffer(OpenGLFBO& buffer) const;
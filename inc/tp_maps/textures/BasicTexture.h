@@ -2,6 +2,7 @@
 #define tp_maps_BasicTexture_h
 
 #include "tp_maps/Texture.h"
+#include "tp_maps/textures/TextureCompression.h"
 
 #include "tp_image_utils/ColorMap.h"
 
@@ -18,6 +19,12 @@ class TP_MAPS_EXPORT BasicTexture : public Texture
   TP_DQ;
 public:
   //################################################################################################
+  //! Construct a texture.
+  /*!
+  \param makeSquare: Pad to a square power of two size on profiles that don't support NPOT
+  textures (GLSL 110, 120 and 100 ES). The image is uploaded into the corner of the texture, use
+  textureDims to scale texture coordinates. Other profiles always upload at the image size.
+  */
   BasicTexture(Map* map,
                const tp_image_utils::ColorMap& image=tp_image_utils::ColorMap(),
                NChannels nChannels=NChannels::RGBA,
@@ -31,6 +38,42 @@ public:
                 NChannels nChannels,
                 bool quiet=false);
 
+  //################################################################################################
+  //! Set an image that has already been compressed, for example loaded with loadCompressedImage.
+  /*!
+  If the format is not supported by the context the texture will fail to bind, so check
+  Map::supportedCompressedFormats() first.
+  */
+  void setCompressedImage(const CompressedImage& compressedImage,
+                          bool quiet=false);
+
+  //################################################################################################
+  //! Compress images with this format before upload.
+  /*!
+  Images are encoded on the map's worker threads the first time they are bound, until that
+  completes the uncompressed image is uploaded and imageChanged is called once the compressed image
+  is ready. If the format is not supported by the context the uncompressed image is used.
+
+  \param compressedFormat: The format to encode images with, or None to disable compression.
+  \param cacheDirectory: If not empty encoded images are cached here, see compressImageCached.
+  */
+  void setCompressedFormat(CompressedFormat compressedFormat,
+                           const std::string& cacheDirectory=std::string());
+
+  //################################################################################################
+  CompressedFormat compressedFormat() const;
+
+  //################################################################################################
+  //! Set levels 1 to n of the mipmap chain, these are uploaded rather than using glGenerateMipmap.
+  /*!
+  The levels must be generated from the image, see generateMipmaps. If the chain
+  is incomplete glGenerateMipmap is used instead. This is cleared by setImage.
+  */
+  void setMipmaps(const std::vector<tp_image_utils::ColorMap>& mipmaps);
+
+  //################################################################################################
+  const std::vector<tp_image_utils::ColorMap>& mipmaps() const;
+
   //################################################################################################
   const tp_image_utils::ColorMap& image() const;
 
@@ -49,6 +92,7 @@ public:
   \param format: The format (normally GL_RGBA)
   \param magFilterOption: The texture magnification function to use
   \param minFilterOption: The texture minifying function to use
+  \param mipmaps: Levels 1 to n, if empty and mipmaps are used glGenerateMipmap is called
   \return the id for the new texture
   */
   GLuint bindTexture(const tp_image_utils::ColorMap& img,
@@ -57,7 +101,24 @@ public:
                      GLint magFilterOption,
                      GLint minFilterOption,
                      GLint textureWrapS = GL_CLAMP_TO_EDGE,
-                     GLint textureWrapT = GL_CLAMP_TO_EDGE);
+                     GLint textureWrapT = GL_CLAMP_TO_EDGE,
+                     const std::vector<tp_image_utils::ColorMap>& mipmaps = std::vector<tp_image_utils::ColorMap>());
+
+  //################################################################################################
+  //! Creates and binds a texure with each level of the compressed image
+  /*!
+  \param compressedImage: The compressed image, its format must be supported by the context
+  \param target: The target type (normally GL_TEXTURE_2D)
+  \param magFilterOption: The texture magnification function to use
+  \param minFilterOption: The texture minifying function to use
+  \return the id for the new texture
+  */
+  GLuint bindCompressedTexture(const CompressedImage& compressedImage,
+                               TPGLenum target,
+                               GLint magFilterOption,
+                               GLint minFilterOption,
+                               GLint textureWrapS = GL_CLAMP_TO_EDGE,
+                               GLint textureWrapT = GL_CLAMP_TO_EDGE);
 
   //################################################################################################
   glm::vec2 textureDims() const override;
@@ -0,0 +1,51 @@
+#ifndef tp_maps_Mipmaps_h
+#define tp_maps_Mipmaps_h
+
+#include "tp_maps/Globals.h"
+
+#include <vector>
+
+namespace tp_image_utils
+{
+class ColorMap;
+}
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! The filter used to reduce each mipmap level.
+enum class MipmapFilter
+{
+  Box,   //!< Average each 2x2 block, fast and matches glGenerateMipmap.
+  Kaiser //!< Separable 6 tap Kaiser windowed sinc, sharper with less aliasing.
+};
+
+//##################################################################################################
+std::vector<MipmapFilter> mipmapFilters();
+
+//##################################################################################################
+std::string mipmapFilterToString(MipmapFilter mipmapFilter);
+
+//##################################################################################################
+MipmapFilter mipmapFilterFromString(const std::string& mipmapFilter);
+
+//##################################################################################################
+//! Generate the mipmap chain for an image on the CPU.
+/*!
+This does not make any OpenGL calls so it can be called from a worker thread, the results can be
+passed to BasicTexture::setMipmaps.
+
+\param image: The full size image, this is level 0 and is not included in the results.
+\param mipmapFilter: The filter used to reduce each level.
+\param gammaCorrect: If true RGB is treated as sRGB and filtered in linear space, use this for
+color textures but not for normals or data. Alpha is always filtered linearly.
+\return Levels 1 to n, each half the size of the previous level (min 1) ending at 1x1.
+*/
+std::vector<tp_image_utils::ColorMap> generateMipmaps(const tp_image_utils::ColorMap& image,
+                                                      MipmapFilter mipmapFilter,
+                                                      bool gammaCorrect);
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef tp_maps_TextureCompression_h
+#define tp_maps_TextureCompression_h
+
+#include "tp_maps/Globals.h"
+#include "tp_maps/subsystems/open_gl/OpenGL.h" // IWYU pragma: keep
+
+#include <vector>
+
+namespace tp_image_utils
+{
+class ColorMap;
+}
+
+namespace tp_maps
+{
+
+//##################################################################################################
+//! Block compressed texture formats.
+/*!
+BC formats are used on desktop GL and ETC2 on GLES 3, all formats use 4x4 blocks.
+*/
+enum class CompressedFormat
+{
+  None,     //!< Not compressed.
+  BC1,      //!< RGB, 8 bytes per block (DXT1).
+  BC3,      //!< RGBA, 16 bytes per block (DXT5).
+  BC4,      //!< R, 8 bytes per block (RGTC1).
+  BC5,      //!< RG, 16 bytes per block (RGTC2), used for normals.
+  BC7,      //!< RGBA, 16 bytes per block (BPTC).
+  ETC2_RGB, //!< RGB, 8 bytes per block.
+  ETC2_RGBA //!< RGBA, 16 bytes per block, EAC alpha followed by an ETC2 color block.
+};
+
+//##################################################################################################
+std::vector<CompressedFormat> compressedFormats();
+
+//##################################################################################################
+std::string compressedFormatToString(CompressedFormat compressedFormat);
+
+//##################################################################################################
+CompressedFormat compressedFormatFromString(const std::string& compressedFormat);
+
+//##################################################################################################
+//! Returns the size of a single 4x4 block in bytes.
+size_t compressedBlockBytes(CompressedFormat compressedFormat);
+
+//##################################################################################################
+//! Returns the size in bytes of a compressed image of the given dimensions.
+size_t compressedImageBytes(CompressedFormat compressedFormat, size_t width, size_t height);
+
+//##################################################################################################
+//! Returns the internal format to pass to glCompressedTexImage2D.
+GLenum compressedFormatGLEnum(CompressedFormat compressedFormat);
+
+//##################################################################################################
+//! Query the compressed formats that the current context can sample from.
+/*!
+This must be called with a current context, it should be called once per context.
+*/
+std::vector<CompressedFormat> querySupportedCompressedFormats(ShaderProfile shaderProfile);
+
+//##################################################################################################
+//! Choose the best supported format for a texture.
+/*!
+\param usage what the texture channels are used for.
+\param hasAlpha true if the alpha channel is not fully opaque.
+\param supportedFormats formats supported by the device.
+\return The chosen format or CompressedFormat::None if nothing suitable is supported.
+*/
+CompressedFormat selectCompressedFormat(TextureUsage usage,
+                                        bool hasAlpha,
+                                        const std::vector<CompressedFormat>& supportedFormats);
+
+//##################################################################################################
+//! A single mip level of a compressed image.
+struct CompressedImageLevel
+{
+  size_t width{0};
+  size_t height{0};
+  std::vector<uint8_t> data;
+};
+
+//##################################################################################################
+//! A compressed image, possibly with a full mip chain.
+struct CompressedImage
+{
+  CompressedFormat format{CompressedFormat::None};
+  std::vector<CompressedImageLevel> levels;
+
+  //################################################################################################
+  bool isValid() const;
+
+  //################################################################################################
+  size_t width() const;
+
+  //################################################################################################
+  size_t height() const;
+
+  //################################################################################################
+  size_t sizeInBytes() const;
+};
+
+//##################################################################################################
+//! Returns true if any pixel has an alpha less than 255.
+bool imageHasAlpha(const tp_image_utils::ColorMap& image);
+
+//##################################################################################################
+//! A fast 64 bit hash of the pixels and dimensions of an image.
+uint64_t imageContentHash(const tp_image_utils::ColorMap& image);
+
+//##################################################################################################
+//! Encode a single level on the CPU.
+CompressedImageLevel compressImageLevel(const tp_image_utils::ColorMap& image,
+                                        CompressedFormat compressedFormat);
+
+//##################################################################################################
+//! Decode a single level on the CPU.
+/*!
+Only the block modes that compressImageLevel writes are decoded, that is BC7 mode 6 and the ETC1
+compatible modes of ETC2.
+
+\return false if the data is the wrong size or contains a block mode that is not decoded.
+*/
+bool decompressImageLevel(const CompressedImageLevel& level,
+                          CompressedFormat compressedFormat,
+                          tp_image_utils::ColorMap& image);
+
+//##################################################################################################
+//! Encode and decode test images in each format and check the results.
+/*!
+\return A description of each check that failed, empty if they all passed.
+*/
+std::vector<std::string> checkTextureCompression();
+
+//##################################################################################################
+//! Encode an image on the CPU, optionally generating a box filtered mip chain first.
+CompressedImage compressImage(const tp_image_utils::ColorMap& image,
+                              CompressedFormat compressedFormat,
+                              bool generateMipmaps);
+
+//##################################################################################################
+//! Same as compressImage but first looks for the result in a disk cache.
+/*!
+The cache is keyed on the content hash of the image, the format and the mipmap flag. If the
+cacheDirectory is empty the cache is not used. Results are written back to the cache.
+*/
+CompressedImage compressImageCached(const tp_image_utils::ColorMap& image,
+                                    CompressedFormat compressedFormat,
+                                    bool generateMipmaps,
+                                    const std::string& cacheDirectory);
+
+//##################################################################################################
+//! Read a compressed image previously written by saveCompressedImage.
+bool loadCompressedImage(const std::string& path, CompressedImage& compressedImage);
+
+//##################################################################################################
+//! Write a compressed image to disk, this can be used as an offline step.
+bool saveCompressedImage(const std::string& path, const CompressedImage& compressedImage);
+
+}
+
+#endif
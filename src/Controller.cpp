@@ -1,6 +1,7 @@
 #include "tp_maps/Controller.h"
 #include "tp_maps/Map.h"
 #include "tp_maps/Subview.h"
+#include "tp_maps/RenderModeManager.h"
 
 #include "glm/gtx/transform.hpp" // IWYU pragma: keep
 
@@ -178,7 +179,19 @@ void Controller::setMatrix(const tp_utils::StringID& coordinateSystem, const glm
 //##################################################################################################
 void Controller::setMatrices(const tp_utils::StringID& coordinateSystem, const Matrices& matrices)
 {
-  d->matrices[coordinateSystem] = matrices;
+  Matrices& m = d->matrices[coordinateSystem];
+  m = matrices;
+
+  // Offset the projection by a fraction of a pixel for progressive accumulation.
+  if(glm::vec2 jitter = d->map->renderModeManger().progressiveJitter(); jitter.x!=0.0f || jitter.y!=0.0f)
+  {
+    glm::vec2 offset = (jitter*2.0f) / glm::vec2(tpMax(1, d->map->renderWidth()), tpMax(1, d->map->renderHeight()));
+    glm::mat4 t = glm::translate(glm::mat4(1.0f), glm::vec3(offset, 0.0f));
+    m.p  = t * m.p;
+    m.vp = t * m.vp;
+    m.dp  = glm::dmat4(t) * m.dp;
+    m.dvp = glm::dmat4(t) * m.dvp;
+  }
 }
 
 //##################################################################################################
@@ -203,6 +203,7 @@ bool Errors::printFBOError(OpenGLFBO& buffer, const std::string& description)
                #endif
                    "  multisample:                  " << (buffer.multisample==Multisample::Yes?"Yes":"No")  << '\n' <<
                    "  hdr:                          " << (buffer.hdr==HDR::Yes?"Yes":"No")  << '\n' <<
+                   "  hdrPrecision:                 " << (buffer.hdrPrecision==HDRPrecision::Full?"Full":buffer.hdrPrecision==HDRPrecision::Packed?"Packed":"Half")  << '\n' <<
                    "  extendedFBO:                  " << (buffer.extendedFBO==ExtendedFBO::Yes?"Yes":"No");
 
     return true;
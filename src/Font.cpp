@@ -15,4 +15,10 @@ void Font::missingGlyph(const std::function<void(const Glyph&)>& addGlyph) const
   TP_UNUSED(addGlyph);
 }
 
+//##################################################################################################
+bool Font::threadSafe() const
+{
+  return false;
+}
+
 }
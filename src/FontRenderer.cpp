@@ -2,438 +2,1124 @@
 #include "tp_maps/Font.h"
 #include "tp_maps/PreparedString.h"
 #include "tp_maps/Map.h"
-#include "tp_maps/textures/BasicTexture.h"
+#include "tp_maps/WorkerThreads.h"
+
+#include "tp_image_utils/ColorMap.h"
 
 #include "tp_utils/TimeUtils.h"
 
 #include <unordered_map>
+#include <memory>
 #include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
 
 namespace tp_maps
 {
+
+namespace
+{
+// Pages start small and double in size until they reach maxPageSize, after that new glyphs go into
+// additional pages.
+constexpr size_t initialPageSize=256;
+constexpr size_t maxPageSize=2048;
+
+// Space between glyphs so that linear filtering doesn't pick up neighbouring glyphs.
+constexpr size_t glyphPadding=1;
+
+// Used as the distance for cells that have not been reached yet by the distance transform.
+constexpr double sdfInfinity=1e20;
+
+// The glyph index of characters that are not in the atlas.
+constexpr uint32_t noGlyph=UINT32_MAX;
+
+// The layout cache is cleared when it grows beyond this many strings.
+constexpr size_t maxCachedLayouts=4096;
+
+// Below this many new glyphs it is faster to prepare them on the calling thread.
+constexpr size_t minParallelGlyphs=8;
+
+// Beyond this many changed regions in a page they are merged into one before uploading.
+constexpr size_t maxDirtyRects=16;
+
 //##################################################################################################
-struct FontRenderer::Private
+//! Skyline rectangle packer, new rectangles are placed as low as possible on the skyline.
+struct Skyline_lt
 {
-  TP_REF_COUNT_OBJECTS("tp_maps::FontRenderer::Private");
-  TP_NONCOPYABLE(Private);
+  struct Node_lt
+  {
+    size_t x;
+    size_t y;
+    size_t width;
+  };
 
-  Q* q;
-  Map* map;
-  std::shared_ptr<Font> font;
+  size_t width{0};
+  size_t height{0};
+  std::vector<Node_lt> nodes;
 
-  std::vector<PreparedString*> preparedStrings;
-  std::unordered_set<char16_t> requiredCharacters;
+  //################################################################################################
+  Skyline_lt(size_t width_, size_t height_):
+    width(width_),
+    height(height_)
+  {
+    nodes.push_back({0, 0, width});
+  }
 
-  BasicTexture texture;
+  //################################################################################################
+  //! Returns the y that a rectangle would be placed at starting at node i, or false if it won't fit.
+  bool fits(size_t i, size_t w, size_t h, size_t& y) const
+  {
+    size_t x = nodes.at(i).x;
+    if(x+w > width)
+      return false;
 
-  std::unordered_map<char16_t, GlyphGeometry> glyphGeometry;
-  GlyphGeometry missingGeometry;
-  GLuint textureID{0};
+    y = 0;
+    for(size_t widthLeft=w; widthLeft>0; i++)
+    {
+      y = tpMax(y, nodes.at(i).y);
+      if(y+h > height)
+        return false;
 
-  bool bindTexture{false};
-  bool regenerate{false};
+      if(nodes.at(i).width >= widthLeft)
+        break;
+
+      widthLeft -= nodes.at(i).width;
+    }
+
+    return true;
+  }
 
   //################################################################################################
-  Private(Q* q_, Map* map_, std::shared_ptr<Font> font_):
-    q(q_),
-    map(map_),
-    font(std::move(font_)),
-    texture(map)
+  bool allocate(size_t w, size_t h, size_t& x, size_t& y)
   {
+    size_t bestIndex = nodes.size();
+    size_t bestTop = height+1;
+    size_t bestWidth = width+1;
+
+    for(size_t i=0; i<nodes.size(); i++)
+    {
+      size_t ny=0;
+      if(!fits(i, w, h, ny))
+        continue;
+
+      if(ny+h < bestTop || (ny+h == bestTop && nodes.at(i).width < bestWidth))
+      {
+        bestIndex = i;
+        bestTop = ny+h;
+        bestWidth = nodes.at(i).width;
+        x = nodes.at(i).x;
+        y = ny;
+      }
+    }
+
+    if(bestIndex == nodes.size())
+      return false;
+
+    nodes.insert(nodes.begin()+int(bestIndex), Node_lt{x, y+h, w});
+
+    // Trim the nodes that are now covered by the new one.
+    for(size_t i=bestIndex+1; i<nodes.size();)
+    {
+      const auto& prev = nodes.at(i-1);
+      auto& node = nodes.at(i);
+      size_t prevRight = prev.x + prev.width;
+      if(node.x >= prevRight)
+        break;
+
+      size_t shrink = prevRight - node.x;
+      if(node.width <= shrink)
+      {
+        nodes.erase(nodes.begin()+int(i));
+        continue;
+      }
+
+      node.x += shrink;
+      node.width -= shrink;
+      break;
+    }
+
+    // Merge neighbours at the same height.
+    for(size_t i=0; i+1<nodes.size();)
+    {
+      if(nodes.at(i).y == nodes.at(i+1).y)
+      {
+        nodes.at(i).width += nodes.at(i+1).width;
+        nodes.erase(nodes.begin()+int(i+1));
+      }
+      else
+        i++;
+    }
 
+    return true;
   }
 
   //################################################################################################
-  void freeAndInvalidate()
+  void grow(size_t newWidth, size_t newHeight)
   {
-    freeTexture();
-    regenerate = true;
+    if(newWidth > width)
+    {
+      if(nodes.back().y == 0)
+        nodes.back().width += newWidth - width;
+      else
+        nodes.push_back({width, 0, newWidth - width});
+    }
+
+    width = newWidth;
+    height = newHeight;
   }
+};
+
+//##################################################################################################
+struct AtlasPage_lt
+{
+  size_t size{initialPageSize};
+  size_t channels{4};
+  Skyline_lt skyline{initialPageSize, initialPageSize};
+  std::vector<uint8_t> data;
+  GLuint textureID{0};
+
+  // The regions that have changed since the last upload (x0, y0, x1, y1).
+  std::vector<glm::uvec4> dirtyRects;
 
   //################################################################################################
-  void freeTexture()
+  void addDirty(size_t x, size_t y, size_t w, size_t h)
   {
-    if(textureID)
+    dirtyRects.emplace_back(x, y, x+w, y+h);
+
+    if(dirtyRects.size()>maxDirtyRects)
     {
-      map->makeCurrent();
-      map->deleteTexture(textureID);
-      textureID = 0;
-      bindTexture = true;
+      glm::uvec4 r = dirtyRects.front();
+      for(const auto& rect : dirtyRects)
+        r = glm::uvec4(glm::min(glm::uvec2(r), glm::uvec2(rect)), glm::max(glm::uvec2(r.z, r.w), glm::uvec2(rect.z, rect.w)));
+      dirtyRects.clear();
+      dirtyRects.push_back(r);
     }
   }
 
   //################################################################################################
-  void generate()
+  AtlasPage_lt(size_t channels_):
+    channels(channels_),
+    data(initialPageSize*initialPageSize*channels_, 0)
   {
-    if(!regenerate)
-      return;
-    regenerate = false;
-    q->generate();
+
   }
 };
 
 //##################################################################################################
-FontRenderer::FontRenderer(Map* map, const std::shared_ptr<Font>& font):
-  d(new Private(this, map, font))
+struct GlyphDetails_lt
 {
-  d->map->addFontRenderer(this);
-}
+  //Width and height of the glyph
+  size_t width{0};
+  size_t height{0};
+
+  float leftBearing  {0.0f}; //Negative for values to the left of 0
+  float rightBearing {0.0f}; //Positive to the right of kerningWidth
+  float topBearing   {0.0f}; //Positive above 0
+  float bottomBearing{0.0f}; //Positive above 0
+
+  float kerningWidth{0.0f};
+
+  //The glyph as rasterized by the font
+  std::vector<TPPixel> pixels;
+
+  //The data to copy into the atlas, width*height*channels bytes including the border
+  std::vector<uint8_t> data;
+
+  //Pixels added around each side of the glyph to hold the distance field
+  size_t border{0};
+
+  char16_t character{};
+};
 
 //##################################################################################################
-FontRenderer::~FontRenderer()
+//! The position of each glyph in a string, this only depends on the glyph metrics so it remains
+//! valid when glyphs move in the atlas.
+struct TextLayout_lt
 {
-  d->map->removeFontRenderer(this);
-  delete d;
-}
+  std::vector<uint32_t> glyphs;   //!< Index into the glyph table or noGlyph.
+  std::vector<glm::vec2> offsets; //!< The pen position of each glyph.
+
+  float leftBearing{0.0f};
+  float topBearing {0.0f};
+  float totalWidth {0.0f};
+  float totalHeight{0.0f};
+};
 
 //##################################################################################################
-Map* FontRenderer::map() const
+struct LayoutKey_lt
 {
-  return d->map;
-}
+  std::u16string text;
+  float scale{1.0f};
+
+  //################################################################################################
+  bool operator==(const LayoutKey_lt& other) const
+  {
+    return scale == other.scale && text == other.text;
+  }
+};
 
 //##################################################################################################
-std::shared_ptr<Font> FontRenderer::font() const
+struct LayoutKeyHash_lt
 {
-  return d->font;
-}
+  //################################################################################################
+  size_t operator()(const LayoutKey_lt& key) const
+  {
+    return std::hash<std::u16string>()(key.text) ^ (std::hash<float>()(key.scale)<<1);
+  }
+};
 
 //##################################################################################################
-void FontRenderer::squeeze()
+//! 1D squared euclidean distance transform, see Felzenszwalb and Huttenlocher.
+/*!
+Transforms n values starting at offset in grid with the given stride, the other vectors are scratch
+space of at least n+1 values.
+*/
+void distanceTransform1D(std::vector<double>& grid,
+                         size_t offset,
+                         size_t stride,
+                         size_t n,
+                         std::vector<double>& f,
+                         std::vector<size_t>& v,
+                         std::vector<double>& z)
 {
-  TP_FUNCTION_TIME("FontRenderer::squeeze");
+  for(size_t q=0; q<n; q++)
+    f[q] = grid[offset+q*stride];
 
-  d->requiredCharacters.clear();
-  d->freeAndInvalidate();
+  auto intersection = [&](size_t q, size_t r)
+  {
+    return ((f[q]+double(q*q)) - (f[r]+double(r*r))) / double(2*(q-r));
+  };
+
+  size_t k=0;
+  v[0] = 0;
+  z[0] = -sdfInfinity;
+  z[1] = sdfInfinity;
+
+  for(size_t q=1; q<n; q++)
+  {
+    double s = intersection(q, v[k]);
+    while(k>0 && s<=z[k])
+    {
+      k--;
+      s = intersection(q, v[k]);
+    }
+
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k+1] = sdfInfinity;
+  }
+
+  k=0;
+  for(size_t q=0; q<n; q++)
+  {
+    while(z[k+1] < double(q))
+      k++;
+
+    double d = double(q) - double(v[k]);
+    grid[offset+q*stride] = d*d + f[v[k]];
+  }
 }
 
 //##################################################################################################
-void FontRenderer::invalidateBuffers()
+void distanceTransform2D(std::vector<double>& grid, size_t w, size_t h)
 {
-  TP_FUNCTION_TIME("FontRenderer::invalidateBuffers");
+  size_t n = tpMax(w, h);
+  std::vector<double> f(n);
+  std::vector<size_t> v(n);
+  std::vector<double> z(n+1);
 
-  d->textureID = 0;
-  d->bindTexture = true;
+  for(size_t x=0; x<w; x++)
+    distanceTransform1D(grid, x, w, h, f, v, z);
 
-  for(auto preparedString : preparedStrings())
-    preparedString->invalidateBuffers();
+  for(size_t y=0; y<h; y++)
+    distanceTransform1D(grid, y*w, 1, w, f, v, z);
 }
 
 //##################################################################################################
-GLuint FontRenderer::textureID()
+//! Replace the glyph data with a single channel signed distance field generated from its alpha.
+/*!
+The glyph is padded by spread pixels on each side, 0.5 is on the edge of the glyph and the distance
+is scaled so that 0 and 1 are spread pixels outside and inside the glyph.
+*/
+void generateSDF(GlyphDetails_lt& glyph, size_t spread)
 {
-  TP_FUNCTION_TIME("FontRenderer::textureID");
+  size_t w = glyph.width  + 2*spread;
+  size_t h = glyph.height + 2*spread;
 
-  d->generate();
+  // Squared distance to the nearest pixel inside the glyph, and to the nearest pixel outside.
+  std::vector<double> toInside(w*h, sdfInfinity);
+  std::vector<double> toOutside(w*h, 0.0);
 
-  if(d->bindTexture)
+  for(size_t y=0; y<glyph.height; y++)
   {
-    d->bindTexture = false;
-    d->map->deleteTexture(d->textureID);
-    d->textureID = d->texture.bindTexture();
+    for(size_t x=0; x<glyph.width; x++)
+    {
+      if(glyph.pixels[y*glyph.width + x].a >= 128)
+      {
+        size_t i = (y+spread)*w + x+spread;
+        toInside[i] = 0.0;
+        toOutside[i] = sdfInfinity;
+      }
+    }
   }
 
-  return d->textureID;
+  distanceTransform2D(toInside, w, h);
+  distanceTransform2D(toOutside, w, h);
+
+  // The edge lies half way between the last inside pixel and the first outside pixel.
+  double scale = 0.5 / double(spread);
+  glyph.data.resize(w*h);
+  for(size_t i=0; i<glyph.data.size(); i++)
+  {
+    double distance = (toOutside[i]>0.0)?(std::sqrt(toOutside[i])-0.5):(0.5-std::sqrt(toInside[i]));
+    double value = tpBound(0.0, 0.5 + distance*scale, 1.0);
+    glyph.data[i] = uint8_t(std::lround(value*255.0));
+  }
+
+  glyph.width  = w;
+  glyph.height = h;
+  glyph.border = spread;
+}
 }
 
 //##################################################################################################
-void FontRenderer::prepareFontGeometry(const PreparedString& preparedString, FontGeometry& fontGeometry)
+struct FontRenderer::Private
 {
-  TP_FUNCTION_TIME("FontRenderer::prepareFontGeometry");
+  TP_REF_COUNT_OBJECTS("tp_maps::FontRenderer::Private");
+  TP_NONCOPYABLE(Private);
 
-  d->generate();
+  Q* q;
+  Map* map;
+  std::shared_ptr<Font> font;
 
-  float lineSpacing=d->font->lineHeight();
+  std::vector<PreparedString*> preparedStrings;
+  std::unordered_set<char16_t> requiredCharacters;
 
-  fontGeometry.leftBearing  = 0.0f;
-  fontGeometry.rightBearing = 0.0f;
-  fontGeometry.topBearing   = 0.0f;
+  // Characters that have been required since the atlas was last updated.
+  std::vector<char16_t> pendingCharacters;
 
-  fontGeometry.totalWidth   = 0.0f;
-  fontGeometry.totalHeight  = lineSpacing;
+  std::vector<AtlasPage_lt> pages;
 
-  fontGeometry.top    = 0.0f;
-  fontGeometry.bottom = 0.0f;
-  fontGeometry.left   = 0.0f;
-  fontGeometry.right  = 0.0f;
+  // Glyphs in the order that they were added to the atlas, glyphIndexes maps a character directly
+  // to its index in the glyph table.
+  std::vector<GlyphGeometry> glyphTable;
+  std::vector<uint32_t> glyphIndexes;
+  GlyphGeometry missingGeometry;
 
-  const auto& text = preparedString.text();
+  // Layouts of strings that have been prepared, repeated strings reuse the layout and only need to
+  // look up the current texture coords of each glyph.
+  std::unordered_map<LayoutKey_lt, TextLayout_lt, LayoutKeyHash_lt> layoutCache;
 
-  fontGeometry.glyphs.resize(text.size());
-  size_t count=0;
-  size_t row=0;
-  glm::vec2 offset{0.0f, 0.0f};
-  for(const auto character : text)
+  FontAtlasMode atlasMode{FontAtlasMode::Bitmap};
+  size_t sdfSpread{4};
+
+  bool regenerate{false};
+
+  // The page being passed to setTexture.
+  size_t texturePage{0};
+
+  //################################################################################################
+  Private(Q* q_, Map* map_, std::shared_ptr<Font> font_):
+    q(q_),
+    map(map_),
+    font(std::move(font_))
+  {
+
+  }
+
+  //################################################################################################
+  ~Private()
   {
-    if(character == '\n')
+    freeTextures();
+  }
+
+  //################################################################################################
+  void freeAndInvalidate()
+  {
+    regenerate = true;
+  }
+
+  //################################################################################################
+  void freeTextures()
+  {
+    bool current=false;
+    for(auto& page : pages)
     {
-      offset.x = 0.0f;
-      offset.y += lineSpacing;
-      fontGeometry.totalHeight += lineSpacing;
-      row++;
+      if(page.textureID)
+      {
+        if(!current)
+        {
+          map->makeCurrent();
+          current = true;
+        }
+
+        map->deleteTexture(page.textureID);
+        page.textureID = 0;
+      }
     }
+  }
 
-    const auto& geometry = [&]
+  //################################################################################################
+  void generate()
+  {
+    if(regenerate)
+    {
+      regenerate = false;
+      pendingCharacters.clear();
+      q->generate();
+    }
+    else if(!pendingCharacters.empty())
     {
-      const auto i = d->glyphGeometry.find(character);
-      return (i==d->glyphGeometry.end())?d->missingGeometry:i->second;
-    }();
+      std::vector<char16_t> characters;
+      characters.swap(pendingCharacters);
+      if(addGlyphs(characters))
+        regenerateStrings();
+    }
+  }
 
-    if(count==0 || geometry.leftBearing<fontGeometry.leftBearing)
-      fontGeometry.leftBearing = geometry.leftBearing;
+  //################################################################################################
+  uint32_t glyphIndex(char16_t character) const
+  {
+    return (size_t(character)<glyphIndexes.size())?glyphIndexes[size_t(character)]:noGlyph;
+  }
 
-    if(row==0 && geometry.topBearing>fontGeometry.topBearing)
-      fontGeometry.topBearing = geometry.topBearing;
+  //################################################################################################
+  const GlyphGeometry& glyphGeometry(uint32_t index) const
+  {
+    return (index==noGlyph)?missingGeometry:glyphTable[index];
+  }
 
-    auto& outGeometry = fontGeometry.glyphs[count];
+  //################################################################################################
+  GlyphGeometry& addGlyph(char16_t character)
+  {
+    if(size_t(character)>=glyphIndexes.size())
+      glyphIndexes.resize(size_t(character)+1, noGlyph);
 
-    outGeometry.textureCoords[0] = geometry.textureCoords[0];
-    outGeometry.textureCoords[1] = geometry.textureCoords[1];
-    outGeometry.textureCoords[2] = geometry.textureCoords[2];
-    outGeometry.textureCoords[3] = geometry.textureCoords[3];
+    glyphIndexes[size_t(character)] = uint32_t(glyphTable.size());
+    return glyphTable.emplace_back();
+  }
 
-    outGeometry.vertices[0] = geometry.vertices[0] + offset;
-    outGeometry.vertices[1] = geometry.vertices[1] + offset;
-    outGeometry.vertices[2] = geometry.vertices[2] + offset;
-    outGeometry.vertices[3] = geometry.vertices[3] + offset;
+  //################################################################################################
+  //! Position each glyph of a string, the kerning and line breaks are calculated here.
+  /*!
+  \return True if every glyph was in the atlas, layouts with missing glyphs are not cached as the
+  glyphs may be added later.
+  */
+  bool calculateLayout(const std::u16string& text, float scale, TextLayout_lt& layout) const
+  {
+    TP_FUNCTION_TIME("FontRenderer::calculateLayout");
 
-    count++;
+    bool complete=true;
+    float lineSpacing=font->lineHeight()*scale;
 
-    offset.x += geometry.kerningWidth;
+    layout.totalHeight = lineSpacing;
+    layout.glyphs.reserve(text.size());
+    layout.offsets.reserve(text.size());
 
-    if(offset.x > fontGeometry.totalWidth)
-      fontGeometry.totalWidth = offset.x;
-  }
+    size_t row=0;
+    glm::vec2 offset{0.0f, 0.0f};
+    for(const auto character : text)
+    {
+      if(character == '\n')
+      {
+        offset.x = 0.0f;
+        offset.y += lineSpacing;
+        layout.totalHeight += lineSpacing;
+        row++;
+      }
 
-  fontGeometry.glyphs.resize(count);
+      uint32_t index = glyphIndex(character);
+      if(index == noGlyph && character != '\n')
+        complete = false;
 
-  glm::vec2 calculatedOffset{fontGeometry.totalWidth/2.0f, fontGeometry.totalHeight/2.0f};
-  calculatedOffset *= glm::vec2(-1.0f, -1.0f) + preparedString.config().relativeOffset;
-  calculatedOffset += preparedString.config().pixelOffset;
-  calculatedOffset = glm::floor(calculatedOffset);
+      const auto& geometry = glyphGeometry(index);
 
-  for(auto& glyph : fontGeometry.glyphs)
-  {
-    for(auto& vert : glyph.vertices)
-    {
-      vert += calculatedOffset;
+      if(layout.glyphs.empty() || geometry.leftBearing*scale<layout.leftBearing)
+        layout.leftBearing = geometry.leftBearing*scale;
 
-      if(vert.y>fontGeometry.top)
-        fontGeometry.top = vert.y;
+      if(row==0 && geometry.topBearing*scale>layout.topBearing)
+        layout.topBearing = geometry.topBearing*scale;
 
-      if(vert.y<fontGeometry.bottom)
-        fontGeometry.bottom = vert.y;
+      layout.glyphs.push_back(index);
+      layout.offsets.push_back(offset);
 
-      if(vert.x<fontGeometry.left)
-        fontGeometry.left = vert.x;
+      offset.x += geometry.kerningWidth*scale;
 
-      if(vert.x>fontGeometry.right)
-        fontGeometry.right = vert.x;
+      if(offset.x > layout.totalWidth)
+        layout.totalWidth = offset.x;
     }
+
+    return complete;
   }
 
-  fontGeometry.totalHeight = tpMax(fontGeometry.totalHeight, fontGeometry.top - fontGeometry.bottom);
-}
+  //################################################################################################
+  size_t channels() const
+  {
+    return (atlasMode==FontAtlasMode::Bitmap)?4:1;
+  }
 
-//##################################################################################################
-void FontRenderer::generate()
-{
-  TP_FUNCTION_TIME("FontRenderer::generate");
+  //################################################################################################
+  static void pageFormat(size_t channels, GLint& internalFormat, GLenum& format)
+  {
+    if(channels==4)
+    {
+      internalFormat = GL_RGBA;
+      format = GL_RGBA;
+      return;
+    }
 
-  size_t padding1 = 1;
-  size_t padding2 = padding1*2;
+#ifdef TP_GLES2
+    internalFormat = GL_LUMINANCE;
+    format = GL_LUMINANCE;
+#else
+    internalFormat = GL_R8;
+    format = GL_RED;
+#endif
+  }
 
-  auto pad1 = [padding1](size_t s){return s+padding1;};
-  auto pad2 = [padding2](size_t s){return s+padding2;};
+  //################################################################################################
+  //! The page as an RGBA image, single channel pages are stored in alpha.
+  static tp_image_utils::ColorMap pageImage(const AtlasPage_lt& page)
+  {
+    tp_image_utils::ColorMap image(page.size, page.size);
+    TPPixel* dst = image.data();
 
-  d->glyphGeometry.clear();
+    if(page.channels==4)
+      memcpy(dst, page.data.data(), page.data.size());
+    else
+      for(size_t i=0; i<page.data.size(); i++)
+        dst[i] = TPPixel(255, 255, 255, page.data[i]);
+
+    return image;
+  }
 
-  struct GlyphDetails_lt
+  //################################################################################################
+  //! Copy an image returned from setTexture back into a page.
+  static void setPageImage(AtlasPage_lt& page, const tp_image_utils::ColorMap& image)
   {
-    //Width and height of the glyph
-    size_t width{0};
-    size_t height{0};
+    if(image.width()!=page.size || image.height()!=page.size)
+    {
+      tpWarning() << "FontRenderer::setTexture image must be the same size as the atlas page.";
+      return;
+    }
+
+    const TPPixel* src = image.constData();
+
+    if(page.channels==4)
+      memcpy(page.data.data(), src, page.data.size());
+    else
+      for(size_t i=0; i<page.data.size(); i++)
+        page.data[i] = src[i].a;
+  }
+
+  //################################################################################################
+  void regenerateStrings()
+  {
+    for(auto preparedString : preparedStrings)
+      preparedString->regenerateBuffers();
+  }
 
-    float leftBearing  {0.0f}; //Negative for values to the left of 0
-    float rightBearing {0.0f}; //Positive to the right of kerningWidth
-    float topBearing   {0.0f}; //Positive above 0
-    float bottomBearing{0.0f}; //Positive above 0
+  //################################################################################################
+  //! Double the size of a page, returns false if it is already at the max size.
+  /*!
+  Pages are square and power of two sized so the texture coords of the glyphs already in the page
+  can be scaled exactly.
+  */
+  bool growPage(size_t p)
+  {
+    auto& page = pages.at(p);
+    if(page.size >= maxPageSize)
+      return false;
 
-    float kerningWidth{0.0f};
+    TP_FUNCTION_TIME("FontRenderer::growPage");
 
-    std::vector<TPPixel> data;
+    size_t oldSize = page.size;
+    size_t newSize = oldSize*2;
 
-    char16_t character{};
+    std::vector<uint8_t> data(newSize*newSize*page.channels, 0);
+    for(size_t y=0; y<oldSize; y++)
+      memcpy(data.data() + y*newSize*page.channels, page.data.data() + y*oldSize*page.channels, oldSize*page.channels);
 
-    bool valid{false};
-  };
+    page.data.swap(data);
+    page.size = newSize;
+    page.skyline.grow(newSize, newSize);
+
+    // The texture has changed size so it needs to be created again.
+    if(page.textureID)
+    {
+      map->makeCurrent();
+      map->deleteTexture(page.textureID);
+      page.textureID = 0;
+    }
+    page.dirtyRects.clear();
+
+    for(auto& glyph : glyphTable)
+      if(glyph.page == p)
+        for(auto& coord : glyph.textureCoords)
+          coord *= 0.5f;
+
+    return true;
+  }
 
-  //-- Generate the glyphs -------------------------------------------------------------------------
-  std::vector<GlyphDetails_lt*> glyphs;
-  glyphs.reserve(requiredCharacters().size());
-  for(const auto character : requiredCharacters())
+  //################################################################################################
+  //! Find space for a glyph growing or adding pages as required.
+  bool allocate(size_t w, size_t h, size_t& p, size_t& x, size_t& y, bool& resized)
   {
-    auto current = new GlyphDetails_lt();
-    current->character = character;
+    if(w>maxPageSize || h>maxPageSize)
+      return false;
 
-    d->font->prepareGlyph(character, [&](const Glyph& glyph)
+    for(p=0; p<pages.size(); p++)
     {
-      modifyGlyph(glyph, [&](const Glyph& glyph)
+      for(;;)
       {
-        auto size = size_t(glyph.w) * size_t(glyph.h);
-        current->width  = size_t(glyph.w);
-        current->height = size_t(glyph.h);
+        if(pages.at(p).skyline.allocate(w, h, x, y))
+          return true;
 
-        current->leftBearing   = glyph.leftBearing  ;
-        current->rightBearing  = glyph.rightBearing ;
-        current->topBearing    = glyph.topBearing   ;
-        current->bottomBearing = glyph.bottomBearing;
+        if(!growPage(p))
+          break;
 
-        current->kerningWidth  = glyph.kerningWidth ;
+        resized = true;
+      }
+    }
 
-        current->data.resize(size);
-        if(size>0)
-          memcpy(current->data.data(), glyph.data, size*sizeof(TPPixel));
-      });
-    });
+    // Nothing has been placed in a new page yet so growing it doesn't move any existing glyphs.
+    pages.emplace_back(channels());
+    for(;;)
+    {
+      if(pages.at(p).skyline.allocate(w, h, x, y))
+        return true;
 
-    glyphs.push_back(current);
-  }
+      if(!growPage(p))
+        break;
+    }
 
-  //-- Sort the glyphs by height to aid in box packing ---------------------------------------------
-  std::sort(glyphs.begin(), glyphs.end(), [](GlyphDetails_lt* lhs, GlyphDetails_lt* rhs){return lhs->height>rhs->height;});
+    pages.pop_back();
+    return false;
+  }
 
-  //-- Figure out the texture size -----------------------------------------------------------------
-  size_t textureSize = 256;
-  bool overflow = true;
-  for(; textureSize<=4096 && overflow; textureSize*=2)
+  //################################################################################################
+  //! Rasterize and pack glyphs into free space in the atlas.
+  /*!
+  Existing glyphs are not moved so strings that have already been prepared remain valid unless a
+  page had to grow.
+
+  \return True if a page grew and the texture coords of existing glyphs changed.
+  */
+  bool addGlyphs(const std::vector<char16_t>& characters)
   {
-    size_t w=padding1;
-    size_t h=padding1;
-    size_t rowHeight=0;
+    TP_FUNCTION_TIME("FontRenderer::addGlyphs");
 
-    overflow = false;
-    for(const auto glyph : glyphs)
+    std::vector<GlyphDetails_lt> glyphs;
+    glyphs.reserve(characters.size());
+    for(const auto character : characters)
+      if(glyphIndex(character) == noGlyph)
+        glyphs.emplace_back().character = character;
+
+    //-- Rasterize the glyphs into their own buffers -----------------------------------------------
+    auto rasterize = [&](size_t i)
+    {
+      auto& current = glyphs.at(i);
+      font->prepareGlyph(current.character, [&](const Glyph& glyph)
+      {
+        q->modifyGlyph(glyph, [&](const Glyph& glyph)
+        {
+          auto size = size_t(glyph.w) * size_t(glyph.h);
+          current.width  = size_t(glyph.w);
+          current.height = size_t(glyph.h);
+
+          current.leftBearing   = glyph.leftBearing  ;
+          current.rightBearing  = glyph.rightBearing ;
+          current.topBearing    = glyph.topBearing   ;
+          current.bottomBearing = glyph.bottomBearing;
+
+          current.kerningWidth  = glyph.kerningWidth ;
+
+          current.pixels.resize(size);
+          if(size>0)
+            memcpy(current.pixels.data(), glyph.data, size*sizeof(TPPixel));
+        });
+      });
+    };
+
+    //-- Convert the glyphs to the atlas format ----------------------------------------------------
+    auto convert = [&](size_t i)
     {
-      if(pad2(glyph->width)>textureSize || pad2(glyph->height)>textureSize)
+      auto& current = glyphs.at(i);
+      if(current.width==0 || current.height==0)
+        return;
+
+      switch(atlasMode)
       {
-        overflow = true;
+      case FontAtlasMode::Alpha:
+        current.data.resize(current.pixels.size());
+        for(size_t p=0; p<current.pixels.size(); p++)
+          current.data[p] = current.pixels[p].a;
+        break;
+
+      case FontAtlasMode::Bitmap:
+        current.data.resize(current.pixels.size()*sizeof(TPPixel));
+        memcpy(current.data.data(), current.pixels.data(), current.data.size());
+        break;
+
+      case FontAtlasMode::SDF:
+        generateSDF(current, sdfSpread);
         break;
       }
 
-      w+=pad1(glyph->width);
+      current.pixels = std::vector<TPPixel>();
+    };
 
-      if(w>textureSize)
+    // Fonts are only called from multiple threads if they allow it, but converting glyphs and in
+    // particular generating distance fields is always done in parallel.
+    if(glyphs.size()>=minParallelGlyphs && map)
+    {
+      TP_FUNCTION_TIME("FontRenderer::addGlyphs parallel");
+
+      auto& workerThreads = map->workerThreads();
+      if(font->threadSafe())
+        workerThreads.parallelFor(glyphs.size(), [&](size_t i){rasterize(i); convert(i);});
+      else
+      {
+        for(size_t i=0; i<glyphs.size(); i++)
+          rasterize(i);
+        workerThreads.parallelFor(glyphs.size(), convert);
+      }
+    }
+    else
+    {
+      for(size_t i=0; i<glyphs.size(); i++)
       {
-        h+=pad1(rowHeight);
-        rowHeight=0;
+        rasterize(i);
+        convert(i);
+      }
+    }
 
-        if((h+pad1(glyph->height))>textureSize)
+    //-- Sort the glyphs by height to aid in box packing -------------------------------------------
+    std::sort(glyphs.begin(), glyphs.end(), [](const auto& lhs, const auto& rhs){return lhs.height>rhs.height;});
+
+    //-- Draw glyphs into the atlas ----------------------------------------------------------------
+    bool resized=false;
+    for(const auto& glyph : glyphs)
+    {
+      size_t p=0;
+      size_t x=0;
+      size_t y=0;
+
+      if(glyph.width>0 && glyph.height>0)
+      {
+        if(!allocate(glyph.width+glyphPadding, glyph.height+glyphPadding, p, x, y, resized))
         {
-          overflow = true;
-          break;
+          tpWarning() << "FontRenderer failed to fit glyph: " << int(glyph.character);
+          continue;
         }
 
-        w=pad1(glyph->width);
+        x += glyphPadding;
+        y += glyphPadding;
+
+        auto& page = pages.at(p);
+        size_t bytes = glyph.width*page.channels;
+        for(size_t sy=0; sy<glyph.height; sy++)
+          memcpy(page.data.data() + ((y+sy)*page.size + x)*page.channels, glyph.data.data() + sy*bytes, bytes);
+
+        page.addDirty(x, y, glyph.width, glyph.height);
       }
 
-      if(glyph->height>rowHeight)
-        rowHeight = glyph->height;
+      auto& geometry = addGlyph(glyph.character);
+      geometry.page = p;
+
+      float textureSize = pages.empty()?1.0f:float(pages.at(p).size);
+      float fx = float(x) / textureSize;
+      float fy = float(y) / textureSize;
+      float fr = float(x+glyph.width) / textureSize;
+      float fb = float(y+glyph.height) / textureSize;
+
+      geometry.textureCoords[0] = {fx, fy};
+      geometry.textureCoords[1] = {fr, fy};
+      geometry.textureCoords[2] = {fr, fb};
+      geometry.textureCoords[3] = {fx, fb};
+
+      // The distance field border extends the quad beyond the glyph.
+      float left   = glyph.leftBearing   - float(glyph.border);
+      float bottom = glyph.bottomBearing - float(glyph.border);
+
+      geometry.vertices[0] = {              0.0f+left,                0.0f+bottom}; // Bottom left
+      geometry.vertices[1] = {float(glyph.width)+left,                0.0f+bottom}; // Bottom right
+      geometry.vertices[2] = {float(glyph.width)+left, float(glyph.height)+bottom}; // Top right
+      geometry.vertices[3] = {              0.0f+left, float(glyph.height)+bottom}; // Top left
+
+      geometry.leftBearing   = glyph.leftBearing  ;
+      geometry.rightBearing  = glyph.rightBearing ;
+      geometry.topBearing    = glyph.topBearing   ;
+      geometry.bottomBearing = glyph.bottomBearing;
+
+      geometry.kerningWidth = glyph.kerningWidth;
     }
+
+    return resized;
   }
 
-  //Texture is too large.
-  if(overflow)
-    return;
+  //################################################################################################
+  GLuint textureID(size_t p)
+  {
+    if(p>=pages.size())
+      return 0;
 
-  TPPixel fillColor;
-  fillColor.r = 0;
-  fillColor.g = 0;
-  fillColor.b = 0;
-  fillColor.a = 255;
+    auto& page = pages.at(p);
 
-  tp_image_utils::ColorMap textureData(textureSize, textureSize, nullptr, fillColor);
+    GLint internalFormat=GL_RGBA;
+    GLenum format=GL_RGBA;
+    pageFormat(page.channels, internalFormat, format);
 
-  for(size_t y=0; y<textureSize; y++)
-  {
-    for(size_t x=0; x<textureSize; x++)
+    if(!page.textureID)
     {
-      TPPixel p;
-      p.r = uint8_t((float(x) / float(textureSize)) * 255.0f);
-      p.g = uint8_t((float(y) / float(textureSize)) * 255.0f);
-      p.b=0;
-      p.a = 255;
-      textureData.setPixel(x, y, p);
+      TP_FUNCTION_TIME("FontRenderer::textureID bind");
+
+      // Give subclasses a chance to modify the whole page.
+      texturePage = p;
+      q->setTexture(pageImage(page));
+
+      glGenTextures(1, &page.textureID);
+      glBindTexture(GL_TEXTURE_2D, page.textureID);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, GLsizei(page.size), GLsizei(page.size), 0, format, GL_UNSIGNED_BYTE, page.data.data());
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glGenerateMipmap(GL_TEXTURE_2D);
+
+      page.dirtyRects.clear();
+    }
+    else if(!page.dirtyRects.empty())
+    {
+      TP_FUNCTION_TIME("FontRenderer::textureID upload");
+
+      glBindTexture(GL_TEXTURE_2D, page.textureID);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+      std::vector<uint8_t> buffer;
+      for(const auto& r : page.dirtyRects)
+      {
+        size_t w = r.z - r.x;
+        size_t h = r.w - r.y;
+        size_t bytes = w*page.channels;
+
+        buffer.resize(bytes*h);
+        for(size_t y=0; y<h; y++)
+          memcpy(buffer.data()+y*bytes, page.data.data() + ((r.y+y)*page.size + r.x)*page.channels, bytes);
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, GLint(r.x), GLint(r.y), GLsizei(w), GLsizei(h), format, GL_UNSIGNED_BYTE, buffer.data());
+      }
+
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+      // Regenerate the mipmaps once for all the glyphs added since the last upload.
+      glGenerateMipmap(GL_TEXTURE_2D);
+
+      page.dirtyRects.clear();
     }
+
+    return page.textureID;
   }
+};
 
-  //-- Draw glyphs to the texture ------------------------------------------------------------------
+//##################################################################################################
+FontRenderer::FontRenderer(Map* map, const std::shared_ptr<Font>& font):
+  d(new Private(this, map, font))
+{
+  d->map->addFontRenderer(this);
+}
+
+//##################################################################################################
+FontRenderer::~FontRenderer()
+{
+  d->map->removeFontRenderer(this);
+  delete d;
+}
+
+//##################################################################################################
+Map* FontRenderer::map() const
+{
+  return d->map;
+}
+
+//##################################################################################################
+std::shared_ptr<Font> FontRenderer::font() const
+{
+  return d->font;
+}
+
+//##################################################################################################
+void FontRenderer::setAtlasMode(FontAtlasMode atlasMode, size_t sdfSpread)
+{
+  sdfSpread = tpMax(size_t(1), sdfSpread);
+  if(d->atlasMode == atlasMode && d->sdfSpread == sdfSpread)
+    return;
+
+  d->atlasMode = atlasMode;
+  d->sdfSpread = sdfSpread;
+  d->freeAndInvalidate();
+}
+
+//##################################################################################################
+FontAtlasMode FontRenderer::atlasMode() const
+{
+  return d->atlasMode;
+}
+
+//##################################################################################################
+size_t FontRenderer::sdfSpread() const
+{
+  return d->sdfSpread;
+}
+
+//##################################################################################################
+void FontRenderer::squeeze()
+{
+  TP_FUNCTION_TIME("FontRenderer::squeeze");
+
+  d->requiredCharacters.clear();
+  for(auto preparedString : d->preparedStrings)
+    for(const auto character : preparedString->text())
+      d->requiredCharacters.insert(character);
+
+  d->freeAndInvalidate();
+}
+
+//##################################################################################################
+void FontRenderer::invalidateBuffers()
+{
+  TP_FUNCTION_TIME("FontRenderer::invalidateBuffers");
+
+  for(auto& page : d->pages)
   {
-    size_t w=padding1;
-    size_t h=padding1;
-    size_t rowHeight=0;
+    page.textureID = 0;
+    page.dirtyRects.clear();
+  }
+
+  for(auto preparedString : preparedStrings())
+    preparedString->invalidateBuffers();
+}
+
+//##################################################################################################
+GLuint FontRenderer::textureID()
+{
+  return pageTextureID(0);
+}
+
+//##################################################################################################
+size_t FontRenderer::pageCount()
+{
+  d->generate();
+  return d->pages.size();
+}
+
+//##################################################################################################
+GLuint FontRenderer::pageTextureID(size_t page)
+{
+  TP_FUNCTION_TIME("FontRenderer::pageTextureID");
+
+  d->generate();
+  return d->textureID(page);
+}
 
-    for(const auto glyph : glyphs)
+//##################################################################################################
+void FontRenderer::prepareFontGeometry(const PreparedString& preparedString, FontGeometry& fontGeometry)
+{
+  TP_FUNCTION_TIME("FontRenderer::prepareFontGeometry");
+
+  d->generate();
+
+  const float scale = preparedString.config().scale;
+
+  TextLayout_lt uncachedLayout;
+  const TextLayout_lt* layout=&uncachedLayout;
+  {
+    LayoutKey_lt key{preparedString.text(), scale};
+    auto i = d->layoutCache.find(key);
+    if(i != d->layoutCache.end())
+      layout = &i->second;
+    else if(d->calculateLayout(key.text, scale, uncachedLayout))
     {
-      size_t x = w;
+      if(d->layoutCache.size() >= maxCachedLayouts)
+        d->layoutCache.clear();
+      layout = &(d->layoutCache[std::move(key)] = std::move(uncachedLayout));
+    }
+  }
 
-      w+=pad1(glyph->width);
+  fontGeometry.leftBearing  = layout->leftBearing;
+  fontGeometry.rightBearing = 0.0f;
+  fontGeometry.topBearing   = layout->topBearing;
 
-      if(w>textureSize)
-      {
-        h+=pad1(rowHeight);
-        rowHeight=0;
+  fontGeometry.totalWidth   = layout->totalWidth;
+  fontGeometry.totalHeight  = layout->totalHeight;
 
-        x = padding1;
-        w=pad1(glyph->width);
-      }
+  fontGeometry.top    = 0.0f;
+  fontGeometry.bottom = 0.0f;
+  fontGeometry.left   = 0.0f;
+  fontGeometry.right  = 0.0f;
 
-      if(glyph->height>rowHeight)
-        rowHeight = glyph->height;
+  // Only the texture coords are read from the glyph table, these change when the atlas grows.
+  fontGeometry.glyphs.resize(layout->glyphs.size());
+  for(size_t g=0; g<layout->glyphs.size(); g++)
+  {
+    const auto& geometry = d->glyphGeometry(layout->glyphs[g]);
+    const auto& offset = layout->offsets[g];
+    auto& outGeometry = fontGeometry.glyphs[g];
 
-      {
-        size_t y = h;
-        size_t bytes = glyph->width*sizeof(TPPixel);
-        for(size_t sy=0; sy<glyph->height; sy++, y++)
-        {
-          const auto src = glyph->data.data() + (sy*glyph->width);
-          auto dst = textureData.data() + ((y*size_t(textureData.width())) + x);
-          memcpy(dst, src, bytes);
-        }
-      }
+    outGeometry.textureCoords = geometry.textureCoords;
+    outGeometry.page = geometry.page;
 
-      {
-        auto& glyphGeometry = d->glyphGeometry[glyph->character];
+    outGeometry.vertices[0] = geometry.vertices[0]*scale + offset;
+    outGeometry.vertices[1] = geometry.vertices[1]*scale + offset;
+    outGeometry.vertices[2] = geometry.vertices[2]*scale + offset;
+    outGeometry.vertices[3] = geometry.vertices[3]*scale + offset;
+  }
 
-        float fx = float(x) / float(textureSize);
-        float fy = float(h) / float(textureSize);
-        float fr = float(x+glyph->width) / float(textureSize);
-        float fb = float(h+glyph->height) / float(textureSize);
+  glm::vec2 calculatedOffset{fontGeometry.totalWidth/2.0f, fontGeometry.totalHeight/2.0f};
+  calculatedOffset *= glm::vec2(-1.0f, -1.0f) + preparedString.config().relativeOffset;
+  calculatedOffset += preparedString.config().pixelOffset;
+  calculatedOffset = glm::floor(calculatedOffset);
 
-        glyphGeometry.textureCoords[0] = {fx, fy};
-        glyphGeometry.textureCoords[1] = {fr, fy};
-        glyphGeometry.textureCoords[2] = {fr, fb};
-        glyphGeometry.textureCoords[3] = {fx, fb};
+  for(auto& glyph : fontGeometry.glyphs)
+  {
+    for(auto& vert : glyph.vertices)
+    {
+      vert += calculatedOffset;
+
+      if(vert.y>fontGeometry.top)
+        fontGeometry.top = vert.y;
 
-        glyphGeometry.vertices[0] = {               0.0f+glyph->leftBearing,                 0.0f+glyph->bottomBearing}; // Bottom left
-        glyphGeometry.vertices[1] = {float(glyph->width)+glyph->leftBearing,                 0.0f+glyph->bottomBearing}; // Bottom right
-        glyphGeometry.vertices[2] = {float(glyph->width)+glyph->leftBearing, float(glyph->height)+glyph->bottomBearing}; // Top right
-        glyphGeometry.vertices[3] = {               0.0f+glyph->leftBearing, float(glyph->height)+glyph->bottomBearing}; // Top left
+      if(vert.y<fontGeometry.bottom)
+        fontGeometry.bottom = vert.y;
 
-        glyphGeometry.leftBearing   = glyph->leftBearing  ;
-        glyphGeometry.rightBearing  = glyph->rightBearing ;
-        glyphGeometry.topBearing    = glyph->topBearing   ;
-        glyphGeometry.bottomBearing = glyph->bottomBearing;
+      if(vert.x<fontGeometry.left)
+        fontGeometry.left = vert.x;
 
-        glyphGeometry.kerningWidth = glyph->kerningWidth;
-      }
+      if(vert.x>fontGeometry.right)
+        fontGeometry.right = vert.x;
     }
   }
 
-  //-- Finally assign this to a texture ------------------------------------------------------------
-  setTexture(textureData);
+  fontGeometry.totalHeight = tpMax(fontGeometry.totalHeight, fontGeometry.top - fontGeometry.bottom);
+}
+
+//##################################################################################################
+void FontRenderer::generate()
+{
+  TP_FUNCTION_TIME("FontRenderer::generate");
+
+  d->freeTextures();
+  d->pages.clear();
+  d->glyphTable.clear();
+  d->glyphIndexes.clear();
+  d->layoutCache.clear();
 
-  tpDeleteAll(glyphs);
+  d->addGlyphs(std::vector<char16_t>(requiredCharacters().begin(), requiredCharacters().end()));
+  d->regenerateStrings();
 }
 
 //##################################################################################################
@@ -445,13 +1131,8 @@ void FontRenderer::modifyGlyph(const Glyph& glyph, const std::function<void(cons
 //##################################################################################################
 void FontRenderer::setTexture(const tp_image_utils::ColorMap& texture)
 {
-  d->texture.setImage(texture, NChannels::RGBA);
-  d->freeTexture();
-
-  for(auto preparedString : preparedStrings())
-    preparedString->regenerateBuffers();
-
-  d->bindTexture = true;
+  if(d->texturePage<d->pages.size())
+    Private::setPageImage(d->pages.at(d->texturePage), texture);
 }
 
 //##################################################################################################
@@ -471,15 +1152,12 @@ void FontRenderer::addPreparedString(PreparedString* preparedString)
 {
   TP_FUNCTION_TIME("FontRenderer::addPreparedString");
 
-  size_t size = d->requiredCharacters.size();
-
   d->preparedStrings.push_back(preparedString);
 
+  // New characters are added to free space in the atlas the next time it is used, see generate.
   for(const auto character : preparedString->text())
-    d->requiredCharacters.insert(character);
-
-  if(size!=d->requiredCharacters.size())
-    d->freeAndInvalidate();
+    if(d->requiredCharacters.insert(character).second)
+      d->pendingCharacters.push_back(character);
 }
 
 //##################################################################################################
@@ -284,9 +284,9 @@ struct PoolDetails_lt
         auto& details = processedGeometry.at(m);
         const auto& textureDetails = textureKeys.at(m);
 
-        details.    rgbaTextureID = texturePool->textureID(textureDetails.rgba   );
-        details. normalsTextureID = texturePool->textureID(textureDetails.normals);
-        details.   rmttrTextureID = texturePool->textureID(textureDetails.rmttr  );
+        details.    rgbaTextureID = texturePool->textureID(textureDetails.rgba   , details.    rgbaUVTransform);
+        details. normalsTextureID = texturePool->textureID(textureDetails.normals, details. normalsUVTransform);
+        details.   rmttrTextureID = texturePool->textureID(textureDetails.rmttr  , details.   rmttrUVTransform);
       }
     }
   }
@@ -532,9 +532,9 @@ void Geometry3DPool::subscribe(const tp_utils::StringID& name,
 
         if(rgba.isValid()) textureKeys.rgba   = TexturePoolKey(rgba   , rgba   , rgba   ,  rgba, 0, 1, 2, 3, TPPixel(fToUI8(material. albedo.x), fToUI8(material. albedo.y), fToUI8(material.albedo.z)    , fToUI8(material.alpha)                ), NChannels::RGBA);
         else               textureKeys.rgba   = TexturePoolKey(rgb    , rgb    , rgb    ,     a, 0, 1, 2, 0, TPPixel(fToUI8(material. albedo.x), fToUI8(material. albedo.y), fToUI8(material.albedo.z)    , fToUI8(material.alpha)                ), NChannels::RGBA);
-        textureKeys.normals                   = TexturePoolKey(normals, normals, normals,    {}, 0, 1, 2, 0, TPPixel(128                       , 128                       , 255                          , 255                                   ), NChannels::RGB );
-        if(rmttr.isValid())textureKeys.rmttr  = TexturePoolKey(rmttr  , rmttr  , rmttr  , rmttr, 0, 1, 2, 3, TPPixel(fToUI8(material.roughness), fToUI8(material.metalness), transmission, fToUI8(material.transmissionRoughness)), NChannels::RGBA);
-        else               textureKeys.rmttr  = TexturePoolKey(r      ,  m     ,   t    ,    tr, 0, 0, 0, 0, TPPixel(fToUI8(material.roughness), fToUI8(material.metalness), transmission, fToUI8(material.transmissionRoughness)), NChannels::RGBA);
+        textureKeys.normals                   = TexturePoolKey(normals, normals, normals,    {}, 0, 1, 2, 0, TPPixel(128                       , 128                       , 255                          , 255                                   ), NChannels::RGB , TextureUsage::Normals);
+        if(rmttr.isValid())textureKeys.rmttr  = TexturePoolKey(rmttr  , rmttr  , rmttr  , rmttr, 0, 1, 2, 3, TPPixel(fToUI8(material.roughness), fToUI8(material.metalness), transmission, fToUI8(material.transmissionRoughness)), NChannels::RGBA, TextureUsage::Data);
+        else               textureKeys.rmttr  = TexturePoolKey(r      ,  m     ,   t    ,    tr, 0, 0, 0, 0, TPPixel(fToUI8(material.roughness), fToUI8(material.metalness), transmission, fToUI8(material.transmissionRoughness)), NChannels::RGBA, TextureUsage::Data);
 
         textureSubscriptions.insert(textureKeys.rgba   );
         textureSubscriptions.insert(textureKeys.normals);
@@ -11,8 +11,10 @@ namespace tp_maps
 TP_DEFINE_ID(                      defaultSID,                          "Default");
 TP_DEFINE_ID(                       screenSID,                           "Screen");
 TP_DEFINE_ID(                         maskSID,                             "Mask");
+TP_DEFINE_ID(                     overlaysSID,                         "Overlays");
 TP_DEFINE_ID(                   gizmoLayerSID,                      "Gizmo layer");
 TP_DEFINE_ID(                   lineShaderSID,                      "Line shader");
+TP_DEFINE_ID(               wideLineShaderSID,                 "Wide line shader");
 TP_DEFINE_ID(                  imageShaderSID,                     "Image shader");
 TP_DEFINE_ID(              flatColorShaderSID,                "Flat color shader");
 TP_DEFINE_ID(                image3DShaderSID,                  "Image 3D shader");
@@ -27,6 +29,7 @@ TP_DEFINE_ID(                pickingShaderSID,                   "Picking shader
 TP_DEFINE_ID(           depthImage3DShaderSID,            "Depth image 3D shader");
 TP_DEFINE_ID(                  depthShaderSID,                     "Depth shader");
 TP_DEFINE_ID(                   fontShaderSID,                      "Font shader");
+TP_DEFINE_ID(                fontSDFShaderSID,                  "Font SDF shader");
 TP_DEFINE_ID(                  frameShaderSID,                     "Frame shader");
 TP_DEFINE_ID(               postSSAOShaderSID,                 "Post ssao shader");
 TP_DEFINE_ID(       ambientOcclusionShaderSID,         "Ambient occlusion shader");
@@ -41,10 +44,17 @@ TP_DEFINE_ID(       depthOfFieldBlurShaderSID,       "Depth of field blur shader
 TP_DEFINE_ID(         calculateFocusShaderSID,           "Calculate focus shader");
 TP_DEFINE_ID(             downsampleShaderSID,                "Downsample shader");
 TP_DEFINE_ID(               mergeDofShaderSID,                 "Merge dof shader");
+TP_DEFINE_ID(      dofFastDownsampleShaderSID,       "DoF fast downsample shader");
+TP_DEFINE_ID(            dofFastBlurShaderSID,             "DoF fast blur shader");
+TP_DEFINE_ID(           dofFastMergeShaderSID,            "DoF fast merge shader");
+TP_DEFINE_ID(              dofReduceShaderSID,                "DoF reduce shader");
 TP_DEFINE_ID(           gaussianBlurShaderSID,             "Gaussian blur shader");
 TP_DEFINE_ID(            passThroughShaderSID,              "Pass through shader");
 TP_DEFINE_ID(             postGrid2DShaderSID,              "Post grid 2D shader");
 TP_DEFINE_ID(              postGammaShaderSID,                "Post gamma shader");
+TP_DEFINE_ID(         postAccumulateShaderSID,           "Post accumulate shader");
+TP_DEFINE_ID(            postUpscaleShaderSID,              "Post upscale shader");
+TP_DEFINE_ID(              postFusedShaderSID,                "Post fused shader");
 TP_DEFINE_ID(             backgroundShaderSID,                "Background shader");
 TP_DEFINE_ID(        backgroundImageShaderSID,          "Background image shader");
 TP_DEFINE_ID(      backgroundPatternShaderSID,        "Background pattern shader");
@@ -132,6 +142,16 @@ std::string parseShaderString(const std::string& text, ShaderProfile shaderProfi
     tp_utils::replace(result, "#define " + key, "#define " + key + " " + value);
   };
 
+  if(result.find("#pragma replace TP_ATLAS_UV") != std::string::npos)
+    replace("TP_ATLAS_UV", tp_utils::resource("/tp_maps/AtlasUV.glsl").data);
+
+  // fwidth, dFdx, and dFdy need an extension in GLSL ES 1.00 that must be enabled before the
+  // precision statement in the header, everywhere else they are core.
+  if(shaderProfile == ShaderProfile::GLSL_100_ES)
+    replace("TP_FRAG_SHADER_HEADER_DERIVATIVES", "#version 100\n#extension GL_OES_standard_derivatives : enable\nprecision highp float;\n");
+  else
+    replace("TP_FRAG_SHADER_HEADER_DERIVATIVES", "#pragma replace TP_FRAG_SHADER_HEADER");
+
   switch(shaderProfile)
   {
     case ShaderProfile::GLSL_110:
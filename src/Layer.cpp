@@ -26,6 +26,7 @@ struct Layer::Private
   glm::mat4 modelMatrix{1.0f};
   tp_utils::StringID coordinateSystem{defaultSID()};
   RenderPass defaultRenderPass{RenderPass::Normal};
+  std::vector<RenderPass::RenderPassType> affectedRenderPasses;
 
   std::unordered_set<tp_utils::StringID> excludeFromSubviews;
   std::vector<tp_utils::StringID> onlyInSubviews;
@@ -55,6 +56,21 @@ struct Layer::Private
       layer->d->propagateSubviews();
     }
   }
+
+  //################################################################################################
+  //! The subviews that this layer is drawn in.
+  std::vector<tp_utils::StringID> subviews() const
+  {
+    if(!onlyInSubviews.empty())
+      return onlyInSubviews;
+
+    std::vector<tp_utils::StringID> subviews = map->allSubviewNames();
+
+    for(const auto& excluded : excludeFromSubviews)
+      tpRemoveOne(subviews, excluded);
+
+    return subviews;
+  }
 };
 
 //##################################################################################################
@@ -207,9 +223,24 @@ const RenderPass& Layer::defaultRenderPass() const
 //##################################################################################################
 void Layer::setDefaultRenderPass(const RenderPass& defaultRenderPass)
 {
+  if(d->affectedRenderPasses.size() == 1 && d->affectedRenderPasses.front() == d->defaultRenderPass.type)
+    d->affectedRenderPasses.front() = defaultRenderPass.type;
+
   d->defaultRenderPass = defaultRenderPass;
 }
 
+//##################################################################################################
+void Layer::setAffectedRenderPasses(const std::vector<RenderPass::RenderPassType>& affectedRenderPasses)
+{
+  d->affectedRenderPasses = affectedRenderPasses;
+}
+
+//##################################################################################################
+const std::vector<RenderPass::RenderPassType>& Layer::affectedRenderPasses() const
+{
+  return d->affectedRenderPasses;
+}
+
 //##################################################################################################
 const std::unordered_set<tp_utils::StringID>& Layer::excludeFromSubviews() const
 {
@@ -453,27 +484,28 @@ void Layer::update(const RenderFromStage& renderFromStage)
   if(!d->map)
     return;
 
-  if(!d->onlyInSubviews.empty())
-    d->map->update(renderFromStage, d->onlyInSubviews);
-
-  else
-  {
-    std::vector<tp_utils::StringID> subviews = d->map->allSubviewNames();
+  update(renderFromStage, d->subviews());
+}
 
-    for(const auto& excluded : d->excludeFromSubviews)
-      tpRemoveOne(subviews, excluded);
+//##################################################################################################
+void Layer::update(const RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews)
+{
+  if(!d->map)
+    return;
 
+  if(renderFromStage == RenderFromStage::Full && !d->affectedRenderPasses.empty())
+    d->map->updateFromRenderPasses(d->affectedRenderPasses, subviews);
+  else
     d->map->update(renderFromStage, subviews);
-  }
 }
 
 //##################################################################################################
-void Layer::update(const RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews)
+void Layer::updateFromRenderPasses(const std::vector<RenderPass::RenderPassType>& renderPasses)
 {
   if(!d->map)
     return;
 
-  d->map->update(renderFromStage, subviews);
+  d->map->updateFromRenderPasses(renderPasses, d->subviews());
 }
 
 //##################################################################################################
@@ -13,6 +13,10 @@
 #include "tp_maps/FontRenderer.h"
 #include "tp_maps/SwapRowOrder.h"
 #include "tp_maps/RenderModeManager.h"
+#include "tp_maps/WorkerThreads.h"
+#include "tp_maps/textures/TextureCompression.h"
+#include "tp_maps/shaders/PostUpscaleShader.h"
+#include "tp_maps/shaders/PostFusedShader.h"
 #include "tp_maps/event_handlers/MouseEventHandler.h"
 #include "tp_maps/subsystems/open_gl/OpenGLBuffers.h"
 #include "tp_maps/color_management/BasicColorManagement.h"
@@ -33,6 +37,7 @@
 #include "glm/gtx/norm.hpp" // IWYU pragma: keep
 
 #include <algorithm>
+#include <chrono>
 
 // Note: GL
 
@@ -199,6 +204,9 @@ struct Map::Private
   GLboolean writeAlpha{GL_FALSE};
 
   ShaderProfile shaderProfile{TP_DEFAULT_PROFILE};
+  std::vector<CompressedFormat> supportedCompressedFormats;
+  float maxTextureAnisotropy{1.0f};
+  std::unique_ptr<WorkerThreads> workerThreads;
 
   std::unique_ptr<ColorManagement> colorManagement{new BasicColorManagement()};
 
@@ -222,8 +230,34 @@ struct Map::Private
 
   tp_utils::ElapsedTimer renderTimer;
 
+#ifdef TP_TIMER_QUERY_SUPPORTED
+  // Timer query results are read frames later when they become available to avoid stalling.
+  static constexpr size_t gpuTimerCount{3};
+  GLuint gpuTimerQueries[gpuTimerCount]{0, 0, 0};
+  bool gpuTimerPending[gpuTimerCount]{false, false, false};
+  size_t gpuTimerIndex{0};
+  bool gpuTimerActive{false};
+#endif
+  float gpuFrameTimeMS{0.0f};
+
   HDR hdr{HDR::No};
   ExtendedFBO extendedFBO{ExtendedFBO::No};
+  HDRPrecision defaultHDRPrecision{HDRPrecision::Half};
+  std::unordered_map<tp_utils::StringID, HDRPrecision> hdrPrecisions;
+
+  float renderScale{1.0f};
+  float upscaleSharpness{0.5f};
+  float frameRenderScale{1.0f};         //!< The scale of the frame being rendered, 1 once upscaled.
+  float previousFrameRenderScale{1.0f};
+  bool cacheBeforeOverlays{false};
+  bool overlaysStarted{false};
+  FullScreenShader::Object* upscaleObject{nullptr};
+
+  std::vector<std::string> renderGraphErrors; //!< Printed when they change to avoid a flood.
+
+  bool fusePostEffects{false};
+  bool cullUnusedRenderPasses{false};
+  std::vector<std::vector<PostLayer*>> fusedPostLayers; //!< Indexed by the fused pass index.
 
   OpenGLFBO pickingBuffer;
   OpenGLFBO renderToImageBuffer;
@@ -299,6 +333,78 @@ struct Map::Private
     updateSubview(&defaultSubview);
   }
 
+  //################################################################################################
+  void beginGPUTimer()
+  {
+#ifdef TP_TIMER_QUERY_SUPPORTED
+    if(!renderModeManager->adaptive())
+      return;
+
+    if(!gpuTimerQueries[0])
+      glGenQueries(GLsizei(gpuTimerCount), gpuTimerQueries);
+
+    readGPUTimers();
+
+    gpuTimerActive = !gpuTimerPending[gpuTimerIndex];
+    if(gpuTimerActive)
+      glBeginQuery(GL_TIME_ELAPSED, gpuTimerQueries[gpuTimerIndex]);
+#endif
+  }
+
+  //################################################################################################
+  void endGPUTimer()
+  {
+#ifdef TP_TIMER_QUERY_SUPPORTED
+    if(!gpuTimerActive)
+      return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuTimerActive = false;
+    gpuTimerPending[gpuTimerIndex] = true;
+    gpuTimerIndex = (gpuTimerIndex+1) % gpuTimerCount;
+#endif
+  }
+
+  //################################################################################################
+  void readGPUTimers()
+  {
+#ifdef TP_TIMER_QUERY_SUPPORTED
+    // Oldest first so that gpuFrameTimeMS ends up holding the most recent result.
+    for(size_t i=0; i<gpuTimerCount; i++)
+    {
+      size_t index = (gpuTimerIndex+i) % gpuTimerCount;
+      if(!gpuTimerPending[index])
+        continue;
+
+      GLint available=0;
+      glGetQueryObjectiv(gpuTimerQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+      if(!available)
+        continue;
+
+      GLuint64 elapsedNS=0;
+      glGetQueryObjectui64v(gpuTimerQueries[index], GL_QUERY_RESULT, &elapsedNS);
+      gpuTimerPending[index] = false;
+      gpuFrameTimeMS = float(double(elapsedNS) / 1000000.0);
+    }
+#endif
+  }
+
+  //################################################################################################
+  void deleteGPUTimers()
+  {
+#ifdef TP_TIMER_QUERY_SUPPORTED
+    if(!gpuTimerQueries[0])
+      return;
+
+    glDeleteQueries(GLsizei(gpuTimerCount), gpuTimerQueries);
+    for(size_t i=0; i<gpuTimerCount; i++)
+    {
+      gpuTimerQueries[i] = 0;
+      gpuTimerPending[i] = false;
+    }
+#endif
+  }
+
   //################################################################################################
   void deleteShaders()
   {
@@ -316,6 +422,9 @@ struct Map::Private
     delete rectangleObject;
     rectangleObject = nullptr;
 #endif
+
+    delete upscaleObject;
+    upscaleObject = nullptr;
   }
 
   //################################################################################################
@@ -330,6 +439,260 @@ struct Map::Private
     return intermediateFBO.get();
   }
 
+  //################################################################################################
+  size_t renderWidth() const
+  {
+    return tpMax(size_t(1), size_t(float(currentSubview->m_width)*frameRenderScale + 0.5f));
+  }
+
+  //################################################################################################
+  size_t renderHeight() const
+  {
+    return tpMax(size_t(1), size_t(float(currentSubview->m_height)*frameRenderScale + 0.5f));
+  }
+
+  //################################################################################################
+  //! True if the overlays should be drawn into a copy of the current draw FBO.
+  bool overlayFBORequired() const
+  {
+    return !overlaysStarted && currentDrawFBO && (cacheBeforeOverlays || frameRenderScale<1.0f);
+  }
+
+  //################################################################################################
+  //! Copy or upscale the current draw FBO into the overlays FBO and make that the draw FBO.
+  /*!
+  This is called before the first Text, GUI3D, GUI, or SwapToOriginalFBO pass. The FBO that is
+  copied is left untouched so the overlays can be redrawn by restarting from the stage before them.
+  */
+  void swapToOverlayFBO()
+  {
+#ifdef TP_FBO_SUPPORTED
+    if(!overlayFBORequired())
+      return;
+
+    overlaysStarted = true;
+    frameRenderScale = 1.0f;
+
+    OpenGLFBO* sceneFBO = currentDrawFBO;
+    buffers.swapMultisampledBuffer(*sceneFBO, false);
+
+    currentReadFBO = sceneFBO;
+    currentDrawFBO = intermediateFBO(overlaysSID());
+
+    if(!buffers.prepareBuffer(*currentDrawFBO,
+                              currentSubview->m_width,
+                              currentSubview->m_height,
+                              CreateColorBuffer::Yes,
+                              Multisample::No,
+                              sceneFBO->hdr,
+                              ExtendedFBO::No,
+                              true,
+                              sceneFBO->hdrPrecision))
+    {
+      Errors::printOpenGLError("Map::Private::swapToOverlayFBO");
+      return;
+    }
+
+    bool sameSize = (sceneFBO->width == currentDrawFBO->width && sceneFBO->height == currentDrawFBO->height);
+
+#ifdef TP_BLIT_WITH_SHADER
+    bool copyWithShader = true;
+#else
+    bool copyWithShader = !sameSize;
+#endif
+
+    if(copyWithShader)
+    {
+      glDepthMask(false);
+      glDisable(GL_DEPTH_TEST);
+
+      auto shader = q->getShader<PostUpscaleShader>();
+      if(shader->error())
+        return;
+
+      if(!upscaleObject)
+        upscaleObject = shader->makeRectangleObject({1.0f,1.0f});
+
+      shader->use(renderInfo.shaderType());
+      shader->setReadFBO(*sceneFBO);
+      shader->setSourceSize(sceneFBO->width, sceneFBO->height);
+      shader->setSharpness(sameSize?0.0f:upscaleSharpness);
+
+      glm::mat4 m{1.0f};
+      shader->setFrameMatrix(m);
+      shader->setProjectionMatrix(m);
+
+      shader->draw(*upscaleObject);
+    }
+
+#ifndef TP_BLIT_WITH_SHADER
+    // Keep the depth of the scene so that GUI3D is still hidden behind geometry.
+    GLbitfield mask = copyWithShader?0:GL_COLOR_BUFFER_BIT;
+
+#ifdef TP_GLES3
+    // GLES does not allow depth to be blitted between buffers of different sizes.
+    if(sameSize)
+#endif
+      mask |= GL_DEPTH_BUFFER_BIT;
+
+    if(mask)
+    {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO->frameBuffer);
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+      glBlitFramebuffer(0, 0, GLint(sceneFBO->width), GLint(sceneFBO->height),
+                        0, 0, GLint(currentDrawFBO->width), GLint(currentDrawFBO->height),
+                        mask, GL_NEAREST);
+      glBindFramebuffer(GL_FRAMEBUFFER, currentDrawFBO->frameBuffer);
+    }
+#endif
+
+    DEBUG_printOpenGLError("Map::Private::swapToOverlayFBO");
+#endif
+  }
+
+  //################################################################################################
+  //! Track the FBOs as if swapToOverlayFBO had been called when passes are skipped.
+  void skipSwapToOverlayFBO()
+  {
+    if(!overlayFBORequired())
+      return;
+
+    overlaysStarted = true;
+    frameRenderScale = 1.0f;
+    currentReadFBO = currentDrawFBO;
+    currentDrawFBO = intermediateFBO(overlaysSID());
+  }
+
+  //################################################################################################
+  //! Returns true if the render passes so far leave an FBO bound to draw the overlays into.
+  static bool drawingToFBO(const std::vector<RenderPass>& renderPasses)
+  {
+    for(auto i=renderPasses.rbegin(); i!=renderPasses.rend(); ++i)
+    {
+      switch(i->type)
+      {
+        case RenderPass::SwapToFBO:
+        case RenderPass::SwapToMSAA:
+        return true;
+
+        case RenderPass::SwapToOriginalFBO:
+        return false;
+
+        default:
+        break;
+      }
+    }
+    return false;
+  }
+
+  //################################################################################################
+  //! Returns the last of a run of Delegate passes from first that can be drawn in one fused pass.
+  /*!
+  Bypassed post layers add no passes so they can be part of a run. Returns first if fewer than two
+  of the post layers in the run are fusable.
+  */
+  size_t lastFusedPass(const std::vector<RenderPass>& renderPasses, size_t first) const
+  {
+    if(!fusePostEffects)
+      return first;
+
+    size_t last = first;
+    size_t count = 0;
+    const tp_utils::StringID* frameCoordinateSystem = nullptr;
+    for(size_t i=first; i<renderPasses.size(); i++)
+    {
+      const auto& renderPass = renderPasses.at(i);
+      if(renderPass.type != RenderPass::Delegate || !renderPass.postLayer)
+        break;
+
+      const auto postLayer = renderPass.postLayer;
+      if(!postLayer->bypass())
+      {
+        if(!postLayer->fusable())
+          break;
+
+        // The fused pass is drawn with the frame matrix of the first layer.
+        if(frameCoordinateSystem && *frameCoordinateSystem != postLayer->frameCoordinateSystem())
+          break;
+
+        frameCoordinateSystem = &postLayer->frameCoordinateSystem();
+        count++;
+      }
+
+      last = i;
+    }
+
+    return (count>1)?last:first;
+  }
+
+  //################################################################################################
+  //! Add the passes to draw the post layers of the Delegate passes from first to last in one pass.
+  void addFusedPasses(std::vector<RenderPass>& computedRenderPasses,
+                      const std::vector<RenderPass>& renderPasses,
+                      size_t first,
+                      size_t last)
+  {
+    RenderPass fusedPass{RenderPass::Custom, postFusedShaderSID()};
+    fusedPass.index = fusedPostLayers.size();
+
+    auto& postLayers = fusedPostLayers.emplace_back();
+    for(size_t i=first; i<=last; i++)
+    {
+      auto postLayer = renderPasses.at(i).postLayer;
+
+      // Keep the stages so that updates to any of the layers restart from the fused pass.
+      computedRenderPasses.push_back(postLayer->stage());
+      if(!postLayer->bypass())
+        postLayers.push_back(postLayer);
+    }
+
+    fusedPass.postLayer = postLayers.front();
+    computedRenderPasses.emplace_back(RenderPass::SwapToFBO, postFusedShaderSID());
+    computedRenderPasses.push_back(fusedPass);
+  }
+
+  //################################################################################################
+  void renderFusedPostEffects(size_t index)
+  {
+    if(index>=fusedPostLayers.size() || fusedPostLayers.at(index).empty())
+      return;
+
+    const auto& postLayers = fusedPostLayers.at(index);
+
+    std::string snippets;
+    for(auto postLayer : postLayers)
+      if(auto snippet = postLayer->fusedFragmentSnippet(); !snippet.empty())
+        snippets += "  {\n    " + snippet + "\n  }\n";
+
+    // Each combination of effects is a different program so the snippets are part of the name.
+    tp_utils::StringID name(postFusedShaderSID().toString() + "\n" + snippets);
+    auto shader = static_cast<PostFusedShader*>(q->getShader(name));
+    if(!shader)
+    {
+      shader = new PostFusedShader(q, q->shaderProfile(), snippets);
+      static_cast<Shader*>(shader)->init();
+      q->addShader(name, shader);
+    }
+
+    postLayers.front()->renderWithShader(shader);
+  }
+
+  //################################################################################################
+  //! The stage to restart from to render the first of renderPasses in the last frame.
+  static RenderFromStage restartStage(Subview* subview, const std::vector<RenderPass::RenderPassType>& renderPasses)
+  {
+    RenderFromStage stage = RenderFromStage::Full;
+    for(const auto& renderPass : subview->m_computedRenderPasses)
+    {
+      if(tpContains(renderPasses, renderPass.type))
+        break;
+
+      if(renderPass.type == RenderPass::Stage)
+        stage = RenderFromStage(RenderFromStage::Stage, renderPass.index);
+    }
+    return stage;
+  }
+
   //################################################################################################
   void render()
   {
@@ -453,6 +816,8 @@ void Map::preDelete()
 
   d->buffers.deleteBuffer(d->pickingBuffer);
   d->buffers.deleteBuffer(d->renderToImageBuffer);
+  d->buffers.deleteTransientBuffers();
+  d->deleteGPUTimers();
 
   for(auto& lightBuffer : d->lightBuffers)
     d->buffers.deleteBuffer(lightBuffer);
@@ -462,6 +827,9 @@ void Map::preDelete()
   d->rectangleObject = nullptr;
 #endif
 
+  delete d->upscaleObject;
+  d->upscaleObject = nullptr;
+
   d->preDeleteCalled = true;
 }
 
@@ -534,6 +902,26 @@ ShaderProfile Map::shaderProfile() const
   return d->shaderProfile;
 }
 
+//##################################################################################################
+const std::vector<CompressedFormat>& Map::supportedCompressedFormats() const
+{
+  return d->supportedCompressedFormats;
+}
+
+//##################################################################################################
+float Map::maxTextureAnisotropy() const
+{
+  return d->maxTextureAnisotropy;
+}
+
+//##################################################################################################
+WorkerThreads& Map::workerThreads()
+{
+  if(!d->workerThreads)
+    d->workerThreads = std::make_unique<WorkerThreads>();
+  return *d->workerThreads;
+}
+
 //##################################################################################################
 const ColorManagement& Map::colorManagement() const
 {
@@ -765,6 +1153,7 @@ void Map::invalidateBuffers()
 
   d->buffers.invalidateBuffer(d->pickingBuffer);
   d->buffers.invalidateBuffer(d->renderToImageBuffer);
+  d->buffers.invalidateTransientBuffers();
 
   for(auto& lightTexture : d->lightBuffers)
     d->buffers.invalidateBuffer(lightTexture);
@@ -781,6 +1170,9 @@ void Map::invalidateBuffers()
   d->rectangleObject = nullptr;
 #endif
 
+  delete d->upscaleObject;
+  d->upscaleObject = nullptr;
+
   invalidateBuffersCallbacks();
 }
 
@@ -990,6 +1382,117 @@ ExtendedFBO Map::extendedFBO() const
   return d->extendedFBO;
 }
 
+//##################################################################################################
+void Map::setDefaultHDRPrecision(HDRPrecision hdrPrecision)
+{
+  if(d->defaultHDRPrecision != hdrPrecision)
+  {
+    d->defaultHDRPrecision = hdrPrecision;
+    update(RenderFromStage::Full, d->allSubviewNames);
+  }
+}
+
+//##################################################################################################
+HDRPrecision Map::defaultHDRPrecision() const
+{
+  return d->defaultHDRPrecision;
+}
+
+//##################################################################################################
+void Map::setHDRPrecision(const tp_utils::StringID& fboName, HDRPrecision hdrPrecision)
+{
+  auto i = d->hdrPrecisions.find(fboName);
+  if(i == d->hdrPrecisions.end() || i->second != hdrPrecision)
+  {
+    d->hdrPrecisions[fboName] = hdrPrecision;
+    update(RenderFromStage::Full, d->allSubviewNames);
+  }
+}
+
+//##################################################################################################
+HDRPrecision Map::hdrPrecision(const tp_utils::StringID& fboName) const
+{
+  return tpGetMapValue(d->hdrPrecisions, fboName, d->defaultHDRPrecision);
+}
+
+//##################################################################################################
+void Map::setRenderScale(float renderScale)
+{
+  renderScale = tpBound(0.1f, renderScale, 1.0f);
+  if(d->renderScale == renderScale)
+    return;
+
+  d->renderScale = renderScale;
+  update(RenderFromStage::Full, allSubviewNames());
+}
+
+//##################################################################################################
+float Map::renderScale() const
+{
+  return d->renderScale;
+}
+
+//##################################################################################################
+void Map::setCacheBeforeOverlays(bool cacheBeforeOverlays)
+{
+  if(d->cacheBeforeOverlays == cacheBeforeOverlays)
+    return;
+
+  d->cacheBeforeOverlays = cacheBeforeOverlays;
+  update(RenderFromStage::Full, allSubviewNames());
+}
+
+//##################################################################################################
+bool Map::cacheBeforeOverlays() const
+{
+  return d->cacheBeforeOverlays;
+}
+
+//##################################################################################################
+void Map::setFusePostEffects(bool fusePostEffects)
+{
+  if(d->fusePostEffects == fusePostEffects)
+    return;
+
+  d->fusePostEffects = fusePostEffects;
+  update(RenderFromStage::Full, allSubviewNames());
+}
+
+//##################################################################################################
+bool Map::fusePostEffects() const
+{
+  return d->fusePostEffects;
+}
+
+//##################################################################################################
+void Map::setCullUnusedRenderPasses(bool cullUnusedRenderPasses)
+{
+  if(d->cullUnusedRenderPasses == cullUnusedRenderPasses)
+    return;
+
+  d->cullUnusedRenderPasses = cullUnusedRenderPasses;
+  update(RenderFromStage::Full, allSubviewNames());
+}
+
+//##################################################################################################
+bool Map::cullUnusedRenderPasses() const
+{
+  return d->cullUnusedRenderPasses;
+}
+
+//##################################################################################################
+void Map::setUpscaleSharpness(float upscaleSharpness)
+{
+  d->upscaleSharpness = tpMax(0.0f, upscaleSharpness);
+  update(RenderFromStage::Full, allSubviewNames());
+}
+
+//##################################################################################################
+float Map::upscaleSharpness() const
+{
+  return d->upscaleSharpness;
+}
+
 //##################################################################################################
 std::vector<Layer*>& Map::layers()
 {
@@ -1370,7 +1873,8 @@ bool Map::renderToImage(size_t width, size_t height, HDR hdr, const std::functio
                                Multisample::No,
                                hdr,
                                ExtendedFBO::No,
-                               true))
+                               true,
+                               HDRPrecision::Full))
   {
     tpWarning() << "Error Map::renderToImage failed to create render buffer.";
     return false;
@@ -1467,12 +1971,27 @@ glm::vec2 Map::screenSize() const
   return {d->currentSubview->m_width, d->currentSubview->m_height};
 }
 
+//##################################################################################################
+int Map::renderWidth() const
+{
+  return int(d->renderWidth());
+}
+
+//##################################################################################################
+int Map::renderHeight() const
+{
+  return int(d->renderHeight());
+}
+
 //##################################################################################################
 void Map::update(const RenderFromStage& renderFromStage, const std::vector<tp_utils::StringID>& subviews)
 {
   if(inPaint())
     return;
 
+  if(d->renderModeManager)
+    d->renderModeManager->mapUpdated(renderFromStage);
+
   RenderFromStage s=renderFromStage;
 
   for(auto& subview : d->allSubviews)
@@ -1491,6 +2010,18 @@ void Map::update(const RenderFromStage& renderFromStage, const std::vector<tp_ut
   }
 }
 
+//##################################################################################################
+void Map::updateFromRenderPasses(const std::vector<RenderPass::RenderPassType>& renderPasses,
+                                 const std::vector<tp_utils::StringID>& subviews)
+{
+  if(inPaint())
+    return;
+
+  for(auto& subview : d->allSubviews)
+    if(tpContains(subviews, subview->m_name))
+      update(Private::restartStage(subview, renderPasses), {subview->m_name});
+}
+
 //##################################################################################################
 void Map::update(const RenderFromStage& renderFromStage, Controller* controller)
 {
@@ -1528,6 +2059,25 @@ void Map::initializeGL()
   // On some platforms the context isn't current, so fix that first
   makeCurrent();
 
+  d->supportedCompressedFormats = querySupportedCompressedFormats(d->shaderProfile);
+
+#ifdef TP_DEBUG_TEXTURE_COMPRESSION
+  static const bool textureCompressionChecked = []
+  {
+    for(const auto& failure : checkTextureCompression())
+      tpWarning() << "Texture compression check failed: " << failure;
+    return true;
+  }();
+  TP_UNUSED(textureCompressionChecked);
+#endif
+
+  // Query device limits once per context rather than on each texture upload.
+  d->maxTextureAnisotropy = 1.0f;
+#if defined(TP_LINUX) && !defined(TP_GLES3)
+  glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &d->maxTextureAnisotropy);
+  d->maxTextureAnisotropy = tpMax(1.0f, d->maxTextureAnisotropy);
+#endif
+
   glDisable(GL_SCISSOR_TEST);
   glDisable(GL_STENCIL_TEST);
   glDisable(GL_DITHER);
@@ -1565,9 +2115,40 @@ void Map::paintGLCurrentSubview()
 
   glViewport(0, 0, TPGLsizei(d->currentSubview->m_width), TPGLsizei(d->currentSubview->m_height));
 
-  setInPaint(true);
-  TP_CLEANUP([&]{setInPaint(false);});
-  paintGLNoMakeCurrent();
+  std::chrono::duration<float, std::milli> cpuFrameTime;
+  bool fullFrame=false;
+  {
+    setInPaint(true);
+    TP_CLEANUP([&]{setInPaint(false);});
+
+    d->frameRenderScale = d->renderScale;
+    if(d->renderModeManager->adaptive())
+      d->frameRenderScale *= d->renderModeManager->adaptiveStats().renderScale;
+
+    // The cached FBOs are the wrong size if the scale has changed.
+    if(d->frameRenderScale != d->previousFrameRenderScale)
+    {
+      d->previousFrameRenderScale = d->frameRenderScale;
+      d->currentSubview->m_renderFromStage = RenderFromStage::Full;
+    }
+
+    // Frames that restart from a cached stage are cheaper than a full frame so they are not timed.
+    fullFrame = (d->currentSubview->m_renderFromStage == RenderFromStage::Full ||
+                 d->currentSubview->m_renderFromStage == RenderFromStage::Reset);
+
+    auto frameStart = std::chrono::steady_clock::now();
+    if(fullFrame)
+      d->beginGPUTimer();
+    paintGLNoMakeCurrent();
+    d->endGPUTimer();
+    d->frameRenderScale = 1.0f;
+
+    cpuFrameTime = std::chrono::steady_clock::now() - frameStart;
+  }
+
+  // Called outside the paint so that a change of quality level can request a new frame.
+  if(fullFrame)
+    d->renderModeManager->frameRendered(cpuFrameTime.count(), d->gpuFrameTimeMS);
 }
 
 //##################################################################################################
@@ -1579,12 +2160,37 @@ void Map::paintGLNoMakeCurrent()
 
   d->renderTimer.start();
 
+  d->overlaysStarted = false;
+  bool cacheBeforeOverlays = d->cacheBeforeOverlays || d->frameRenderScale<1.0f;
+
+  d->fusedPostLayers.clear();
   d->currentSubview->m_computedRenderPasses.clear();
   d->currentSubview->m_computedRenderPasses.reserve(d->currentSubview->m_renderPasses.size()*2);
-  for(const auto& renderPass : d->currentSubview->m_renderPasses)
+  for(size_t i=0; i<d->currentSubview->m_renderPasses.size(); i++)
   {
+    const auto& renderPass = d->currentSubview->m_renderPasses.at(i);
+
+    // Add a stage to restart from when only the overlays need to be redrawn, the index of the
+    // overlay pass is used as it can't be the index of another stage.
+    if(cacheBeforeOverlays &&
+       (renderPass.type == RenderPass::Text || renderPass.type == RenderPass::GUI3D || renderPass.type == RenderPass::GUI) &&
+       Private::drawingToFBO(d->currentSubview->m_computedRenderPasses))
+    {
+      cacheBeforeOverlays = false;
+      RenderFromStage stage{RenderFromStage::Stage, i};
+      stage.stageName = overlaysSID();
+      d->currentSubview->m_computedRenderPasses.emplace_back(stage);
+    }
+
     if(renderPass.type == RenderPass::Delegate)
     {
+      if(size_t last=d->lastFusedPass(d->currentSubview->m_renderPasses, i); last!=i)
+      {
+        d->addFusedPasses(d->currentSubview->m_computedRenderPasses, d->currentSubview->m_renderPasses, i, last);
+        i = last;
+        continue;
+      }
+
       d->currentSubview->m_computedRenderPasses.push_back(renderPass.postLayer->stage());
       renderPass.postLayer->addRenderPasses(d->currentSubview->m_computedRenderPasses);
     }
@@ -1597,6 +2203,27 @@ void Map::paintGLNoMakeCurrent()
   for(const auto& rp : d->currentSubview->m_computedRenderPasses)
     tpWarning() << tp_utils::fixedWidthKeepRight(std::to_string(ctr++), 3, ' ') << " Render pass: " << rp.describe();
 #endif
+
+  d->currentSubview->m_renderGraph.setCullUnusedPasses(d->cullUnusedRenderPasses);
+  d->currentSubview->m_renderGraph.compile(d->currentSubview->m_computedRenderPasses);
+  if(d->renderGraphErrors != d->currentSubview->m_renderGraph.errors())
+  {
+    d->renderGraphErrors = d->currentSubview->m_renderGraph.errors();
+    for(const auto& error : d->renderGraphErrors)
+      tpWarning() << "Render pass error: " << error;
+  }
+
+#ifdef TP_DEBUG_RENDER_PASSES
+  static const bool renderGraphChecked = []
+  {
+    for(const auto& failure : RenderGraph::check())
+      tpWarning() << "Render graph check failed: " << failure;
+    return true;
+  }();
+  TP_UNUSED(renderGraphChecked);
+
+  tpWarning() << "======== Render graph ========\n" << d->currentSubview->m_renderGraph.describe();
+#endif
 #ifdef TP_FBO_SUPPORTED
   GLint originalFrameBuffer = 0;
   glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &originalFrameBuffer);
@@ -1617,6 +2244,7 @@ void Map::paintGLNoMakeCurrent()
 
 #ifdef TP_FBO_SUPPORTED
   executeRenderPasses(d->currentSubview, rp, originalFrameBuffer);
+  d->buffers.collectTransientBuffers();
 #endif
 
   Errors::printOpenGLError("Map::paintGLNoMakeCurrent");
@@ -1673,6 +2301,7 @@ size_t Map::skipRenderPasses(Subview* subview)
 
         case RenderPass::SwapToOriginalFBO: //------------------------------------------------------
         {
+          d->skipSwapToOverlayFBO();
           d->currentReadFBO = d->currentDrawFBO;
           d->currentDrawFBO = nullptr;
           break;
@@ -1697,12 +2326,17 @@ size_t Map::skipRenderPasses(Subview* subview)
           break;
         }
 
-        case RenderPass::Background: //-------------------------------------------------------------
-        case RenderPass::Normal: //-----------------------------------------------------------------
-        case RenderPass::Transparency: //-----------------------------------------------------------
         case RenderPass::Text: //-------------------------------------------------------------------
         case RenderPass::GUI3D: //------------------------------------------------------------------
         case RenderPass::GUI: //--------------------------------------------------------------------
+        {
+          d->skipSwapToOverlayFBO();
+          break;
+        }
+
+        case RenderPass::Background: //-------------------------------------------------------------
+        case RenderPass::Normal: //-----------------------------------------------------------------
+        case RenderPass::Transparency: //-----------------------------------------------------------
         case RenderPass::Picking: //----------------------------------------------------------------
         case RenderPass::PickingGUI3D: //-----------------------------------------------------------
         case RenderPass::Custom: //-----------------------------------------------------------------
@@ -1748,6 +2382,10 @@ void Map::executeRenderPasses(Subview* subview, size_t rp, GLint& originalFrameB
     });
 #endif
 
+    // Passes whose output is never used or that repeat the previous blit.
+    if(subview->m_renderGraph.culled(rp))
+      continue;
+
     auto renderPass = subview->m_computedRenderPasses.at(rp);
     try
     {
@@ -1839,13 +2477,14 @@ void Map::executeRenderPasses(Subview* subview, size_t rp, GLint& originalFrameB
           d->currentDrawFBO = d->intermediateFBO(renderPass.name);
 
           if(!d->buffers.prepareBuffer(*d->currentDrawFBO,
-                                       d->currentSubview->m_width,
-                                       d->currentSubview->m_height,
+                                       d->renderWidth(),
+                                       d->renderHeight(),
                                        CreateColorBuffer::Yes,
                                        renderPass.type==RenderPass::SwapToMSAA?Multisample::Yes:Multisample::No,
                                        hdr(),
                                        extendedFBO(),
-                                       true))
+                                       true,
+                                       hdrPrecision(renderPass.name)))
           {
             Errors::printOpenGLError("RenderPass::SwapDrawFBO " + passName);
             return;
@@ -1859,6 +2498,7 @@ void Map::executeRenderPasses(Subview* subview, size_t rp, GLint& originalFrameB
 #ifdef TP_FBO_SUPPORTED
           DEBUG_scopedDebug("RenderPass::SwapToOriginalFBO " + renderPass.getNameString(), TPPixel(255, 255, 0));
 
+          d->swapToOverlayFBO();
           d->currentReadFBO = d->currentDrawFBO;
           d->currentDrawFBO = nullptr;
 
@@ -1994,6 +2634,7 @@ void Map::executeRenderPasses(Subview* subview, size_t rp, GLint& originalFrameB
         case RenderPass::Text: //-------------------------------------------------------------------
         {
           DEBUG_scopedDebug("RenderPass::Text", TPPixel(200, 152, 255));
+          d->swapToOverlayFBO();
           glDisable(GL_DEPTH_TEST);
           glDepthMask(false);
           d->render();
@@ -2003,6 +2644,7 @@ void Map::executeRenderPasses(Subview* subview, size_t rp, GLint& originalFrameB
         case RenderPass::GUI3D: //------------------------------------------------------------------
         {
           DEBUG_scopedDebug("RenderPass::GUI3D", TPPixel(200, 152, 50));
+          d->swapToOverlayFBO();
           glEnable(GL_DEPTH_TEST);
           auto s = pixelScale();
           glScissor(0, 0, GLsizei(float(width())*s), GLsizei(float(height())*s));
@@ -2014,6 +2656,7 @@ void Map::executeRenderPasses(Subview* subview, size_t rp, GLint& originalFrameB
         case RenderPass::GUI: //--------------------------------------------------------------------
         {
           DEBUG_scopedDebug("RenderPass::GUI", TPPixel(200, 152, 50));
+          d->swapToOverlayFBO();
           glEnable(GL_SCISSOR_TEST);
           glDisable(GL_DEPTH_TEST);
           auto s = pixelScale();
@@ -2034,6 +2677,13 @@ void Map::executeRenderPasses(Subview* subview, size_t rp, GLint& originalFrameB
         case RenderPass::Custom: //-----------------------------------------------------------------
         {
           DEBUG_scopedDebug("RenderPass::Custom " + renderPass.getNameString(), TPPixel(90, 200, 100));
+
+          if(renderPass.name == postFusedShaderSID())
+          {
+            d->renderFusedPostEffects(renderPass.index);
+            break;
+          }
+
           d->render();
           break;
         }
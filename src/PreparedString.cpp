@@ -47,6 +47,12 @@ PreparedString::~PreparedString()
   delete d;
 }
 
+//##################################################################################################
+FontRenderer* PreparedString::fontRenderer() const
+{
+  return d->fontRenderer;
+}
+
 //################################################################################################
 const std::u16string& PreparedString::text() const
 {
@@ -59,6 +65,12 @@ GLuint PreparedString::textureID() const
   return d->fontRenderer->textureID();
 }
 
+//##################################################################################################
+GLuint PreparedString::pageTextureID(size_t page) const
+{
+  return d->fontRenderer->pageTextureID(page);
+}
+
 //##################################################################################################
 const FontGeometry& PreparedString::fontGeometry() const
 {
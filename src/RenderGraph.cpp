@@ -0,0 +1,573 @@
+#include "tp_maps/RenderGraph.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <algorithm>
+
+namespace tp_maps
+{
+
+namespace
+{
+//##################################################################################################
+constexpr size_t noResource_lt = size_t(-1);
+
+//##################################################################################################
+bool isCullable_lt(RenderPass::RenderPassType type)
+{
+  switch(type)
+  {
+    case RenderPass::BlitFromFBO:
+    case RenderPass::Blit:
+    case RenderPass::Background:
+    case RenderPass::Normal:
+    case RenderPass::Transparency:
+    case RenderPass::Text:
+    case RenderPass::GUI3D:
+    case RenderPass::GUI:
+    return true;
+
+    default:
+    return false;
+  }
+}
+
+//##################################################################################################
+//! BlitMSAA is not included as it also changes the attachments of the draw FBO.
+bool isBlit_lt(RenderPass::RenderPassType type)
+{
+  return type == RenderPass::BlitFromFBO || type == RenderPass::Blit;
+}
+
+//##################################################################################################
+bool isOverlay_lt(RenderPass::RenderPassType type)
+{
+  return type == RenderPass::Text || type == RenderPass::GUI3D || type == RenderPass::GUI;
+}
+
+//##################################################################################################
+//! Passes that clear the FBO that they write so don't depend on what was in it before.
+bool clearsWrites_lt(RenderPass::RenderPassType type)
+{
+  return type == RenderPass::SwapToFBO || type == RenderPass::SwapToMSAA;
+}
+}
+
+//##################################################################################################
+struct RenderGraph::Private
+{
+  std::vector<Pass> passes;
+  std::vector<Resource> resources;
+  std::vector<std::string> errors;
+  size_t aliasGroupCount{0};
+  bool cullUnusedPasses{false};
+
+  //################################################################################################
+  size_t resource(const tp_utils::StringID& name, bool multisample)
+  {
+    for(size_t i=0; i<resources.size(); i++)
+    {
+      if(resources.at(i).name == name)
+      {
+        resources.at(i).multisample |= multisample;
+        return i;
+      }
+    }
+
+    auto& r = resources.emplace_back();
+    r.name = name;
+    r.multisample = multisample;
+    return resources.size()-1;
+  }
+
+  //################################################################################################
+  void error(size_t p, const std::string& message)
+  {
+    errors.push_back("Pass " + std::to_string(p) + " " + passes.at(p).renderPass.describe() + ": " + message);
+  }
+
+  //################################################################################################
+  //! Walk the passes recording the FBOs that each one reads and writes.
+  void findResources()
+  {
+    size_t read = noResource_lt;
+    size_t draw = originalFBO;
+    std::vector<std::pair<size_t, size_t>> stack;
+
+    auto addRead = [&](Pass& pass, size_t r)
+    {
+      if(r != noResource_lt && !tpContains(pass.reads, r))
+        pass.reads.push_back(r);
+    };
+
+    // Once the overlays stage has been passed the first overlay pass will swap to the overlays FBO.
+    bool overlaysPending = false;
+
+    for(size_t p=0; p<passes.size(); p++)
+    {
+      auto& pass = passes.at(p);
+      const auto& renderPass = pass.renderPass;
+
+      if(overlaysPending && (isOverlay_lt(renderPass.type) || renderPass.type == RenderPass::SwapToOriginalFBO))
+      {
+        overlaysPending = false;
+        read = draw;
+        draw = resource(overlaysSID(), false);
+      }
+
+      switch(renderPass.type)
+      {
+        case RenderPass::RenderSubview: //----------------------------------------------------------
+        case RenderPass::PreRender: //--------------------------------------------------------------
+        case RenderPass::LightFBOs: //--------------------------------------------------------------
+        case RenderPass::Delegate: //---------------------------------------------------------------
+        break;
+
+        case RenderPass::SwapToFBO: //--------------------------------------------------------------
+        case RenderPass::SwapToMSAA: //-------------------------------------------------------------
+        {
+          read = draw;
+          draw = resource(renderPass.name, renderPass.type == RenderPass::SwapToMSAA);
+          pass.writes.push_back(draw);
+
+          // FBOs drawn in a branch are kept for layers that read them by name.
+          if(!stack.empty())
+            resources.at(draw).pinned = true;
+          break;
+        }
+
+        case RenderPass::SwapToOriginalFBO: //------------------------------------------------------
+        {
+          read = draw;
+          draw = originalFBO;
+          break;
+        }
+
+        case RenderPass::BlitMSAA: //---------------------------------------------------------------
+        case RenderPass::Blit: //-------------------------------------------------------------------
+        {
+          if(read == noResource_lt)
+            error(p, "There is no FBO to blit from.");
+
+          if(renderPass.type == RenderPass::BlitMSAA)
+            addRead(pass, draw);
+
+          addRead(pass, read);
+          pass.writes.push_back(draw);
+          break;
+        }
+
+        case RenderPass::BlitFromFBO: //------------------------------------------------------------
+        {
+          addRead(pass, resource(renderPass.name, false));
+          pass.writes.push_back(draw);
+          break;
+        }
+
+        case RenderPass::PushFBOs: //---------------------------------------------------------------
+        {
+          stack.emplace_back(read, draw);
+          break;
+        }
+
+        case RenderPass::PopFBOs: //----------------------------------------------------------------
+        {
+          if(stack.empty())
+          {
+            error(p, "PopFBOs without a matching PushFBOs.");
+            break;
+          }
+
+          read = stack.back().first;
+          draw = stack.back().second;
+          stack.pop_back();
+          break;
+        }
+
+        case RenderPass::Background: //-------------------------------------------------------------
+        case RenderPass::Normal: //-----------------------------------------------------------------
+        case RenderPass::Transparency: //-----------------------------------------------------------
+        case RenderPass::Text: //-------------------------------------------------------------------
+        case RenderPass::GUI3D: //------------------------------------------------------------------
+        case RenderPass::GUI: //--------------------------------------------------------------------
+        {
+          // These draw over the top of what is already in the FBO.
+          addRead(pass, draw);
+          pass.writes.push_back(draw);
+          break;
+        }
+
+        case RenderPass::Picking: //----------------------------------------------------------------
+        case RenderPass::PickingGUI3D: //-----------------------------------------------------------
+        {
+          error(p, "Picking passes should not be part of the render passes.");
+          break;
+        }
+
+        case RenderPass::Custom: //-----------------------------------------------------------------
+        {
+          if(renderPass.postLayer && read == noResource_lt)
+            error(p, "The post layer has no FBO to read from.");
+
+          addRead(pass, read);
+          addRead(pass, draw);
+          pass.writes.push_back(draw);
+          break;
+        }
+
+        case RenderPass::Stage: //------------------------------------------------------------------
+        {
+          // The map copies the frame into the overlays FBO at the first overlay pass after this.
+          if(renderPass.name == overlaysSID() && draw != originalFBO)
+          {
+            overlaysPending = true;
+            addRead(pass, draw);
+          }
+          break;
+        }
+      }
+    }
+
+    if(!stack.empty())
+      errors.push_back("PushFBOs without a matching PopFBOs.");
+
+    if(draw != originalFBO)
+      errors.push_back("The passes do not finish by drawing to the original FBO.");
+  }
+
+  //################################################################################################
+  //! Cull passes that write to FBOs that are not read by a later pass or displayed.
+  void cullPasses()
+  {
+    std::vector<bool> live(resources.size(), false);
+    live[originalFBO] = true;
+    for(size_t i=0; i<resources.size(); i++)
+      live[i] = live[i] || resources.at(i).pinned;
+
+    for(size_t p=passes.size(); p>0; p--)
+    {
+      auto& pass = passes.at(p-1);
+
+      if(isCullable_lt(pass.renderPass.type))
+      {
+        bool needed = std::any_of(pass.writes.begin(), pass.writes.end(), [&](size_t w){return live[w];});
+        if(!needed)
+        {
+          pass.culled = true;
+          continue;
+        }
+      }
+
+      if(clearsWrites_lt(pass.renderPass.type))
+        for(auto w : pass.writes)
+          live[w] = resources.at(w).pinned;
+
+      for(auto r : pass.reads)
+        live[r] = true;
+    }
+  }
+
+  //################################################################################################
+  //! Cull blits that repeat the last blit when nothing has changed the FBOs involved.
+  void cullRepeatedBlits()
+  {
+    const Pass* lastBlit = nullptr;
+
+    for(auto& pass : passes)
+    {
+      if(pass.culled)
+        continue;
+
+      if(isBlit_lt(pass.renderPass.type))
+      {
+        if(lastBlit &&
+           lastBlit->renderPass.type == pass.renderPass.type &&
+           lastBlit->reads == pass.reads &&
+           lastBlit->writes == pass.writes)
+        {
+          pass.culled = true;
+          continue;
+        }
+
+        lastBlit = &pass;
+        continue;
+      }
+
+      // Anything that draws could change what the blit would copy.
+      if(!pass.writes.empty())
+        lastBlit = nullptr;
+    }
+  }
+
+  //################################################################################################
+  //! Find the lifetime of each FBO and group FBOs with lifetimes that don't overlap.
+  void computeLifetimes()
+  {
+    for(auto& r : resources)
+    {
+      r.firstPass = noResource_lt;
+      r.lastPass = 0;
+      r.used = false;
+    }
+
+    for(size_t p=0; p<passes.size(); p++)
+    {
+      const auto& pass = passes.at(p);
+      if(pass.culled)
+        continue;
+
+      auto use = [&](size_t i)
+      {
+        auto& r = resources.at(i);
+        r.firstPass = tpMin(r.firstPass, p);
+        r.lastPass = tpMax(r.lastPass, p);
+        r.used = true;
+      };
+
+      for(auto i : pass.reads)
+        use(i);
+
+      for(auto i : pass.writes)
+        use(i);
+    }
+
+    std::vector<size_t> order;
+    for(size_t i=0; i<resources.size(); i++)
+    {
+      if(resources.at(i).used)
+        order.push_back(i);
+      else
+        resources.at(i).firstPass = 0;
+    }
+
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+      return resources.at(a).firstPass < resources.at(b).firstPass;
+    });
+
+    // The original FBO is provided by the window manager so it always has its own group.
+    struct Group
+    {
+      size_t lastPass;
+      bool multisample;
+    };
+    std::vector<Group> groups;
+
+    for(auto i : order)
+    {
+      auto& r = resources.at(i);
+
+      size_t g=0;
+      if(i != originalFBO)
+      {
+        for(g=1; g<groups.size(); g++)
+          if(groups.at(g).multisample == r.multisample && groups.at(g).lastPass < r.firstPass)
+            break;
+      }
+
+      if(g>=groups.size())
+        groups.resize(g+1, {0, false});
+
+      groups.at(g).lastPass = r.lastPass;
+      groups.at(g).multisample = r.multisample;
+      r.aliasGroup = g;
+    }
+
+    aliasGroupCount = groups.size();
+  }
+};
+
+//##################################################################################################
+RenderGraph::RenderGraph():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+RenderGraph::~RenderGraph()
+{
+  delete d;
+}
+
+//##################################################################################################
+void RenderGraph::setCullUnusedPasses(bool cullUnusedPasses)
+{
+  d->cullUnusedPasses = cullUnusedPasses;
+}
+
+//##################################################################################################
+bool RenderGraph::cullUnusedPasses() const
+{
+  return d->cullUnusedPasses;
+}
+
+//##################################################################################################
+void RenderGraph::compile(const std::vector<RenderPass>& renderPasses)
+{
+  d->passes.clear();
+  d->resources.clear();
+  d->errors.clear();
+  d->aliasGroupCount = 0;
+
+  d->passes.resize(renderPasses.size());
+  for(size_t p=0; p<renderPasses.size(); p++)
+    d->passes.at(p).renderPass = renderPasses.at(p);
+
+  d->resource(screenSID(), false);
+
+  d->findResources();
+  if(d->cullUnusedPasses)
+    d->cullPasses();
+  d->cullRepeatedBlits();
+  d->computeLifetimes();
+}
+
+//##################################################################################################
+const std::vector<RenderGraph::Pass>& RenderGraph::passes() const
+{
+  return d->passes;
+}
+
+//##################################################################################################
+const std::vector<RenderGraph::Resource>& RenderGraph::resources() const
+{
+  return d->resources;
+}
+
+//##################################################################################################
+const std::vector<std::string>& RenderGraph::errors() const
+{
+  return d->errors;
+}
+
+//##################################################################################################
+bool RenderGraph::culled(size_t pass) const
+{
+  return pass<d->passes.size() && d->passes.at(pass).culled;
+}
+
+//##################################################################################################
+size_t RenderGraph::aliasGroupCount() const
+{
+  return d->aliasGroupCount;
+}
+
+//##################################################################################################
+std::string RenderGraph::describe() const
+{
+  auto names = [&](const std::vector<size_t>& indices)
+  {
+    std::string result;
+    for(auto i : indices)
+    {
+      if(!result.empty())
+        result += ", ";
+      result += d->resources.at(i).name.toString();
+    }
+    return result;
+  };
+
+  std::string result;
+  for(size_t p=0; p<d->passes.size(); p++)
+  {
+    const auto& pass = d->passes.at(p);
+    result += tp_utils::fixedWidthKeepRight(std::to_string(p), 3, ' ');
+    result += pass.culled?" culled ":"        ";
+    result += tp_utils::fixedWidthKeepLeft(pass.renderPass.describe(), 49, ' ');
+    result += " Read: " + tp_utils::fixedWidthKeepLeft(names(pass.reads), 30, ' ');
+    result += " Write: " + names(pass.writes) + '\n';
+  }
+
+  for(const auto& r : d->resources)
+  {
+    result += tp_utils::fixedWidthKeepLeft(r.name.toString(), 30, ' ');
+    if(r.used)
+      result += " passes: " + std::to_string(r.firstPass) + "-" + std::to_string(r.lastPass) + " group: " + std::to_string(r.aliasGroup);
+    else
+      result += " unused";
+    result += '\n';
+  }
+
+  for(const auto& error : d->errors)
+    result += "Error: " + error + '\n';
+
+  return result;
+}
+
+//##################################################################################################
+std::vector<std::string> RenderGraph::check()
+{
+  std::vector<std::string> failures;
+
+  tp_utils::StringID xSID("X");
+  tp_utils::StringID ySID("Y");
+
+  auto expect = [&](const std::string& name,
+                    const std::vector<RenderPass>& renderPasses,
+                    bool cullUnusedPasses,
+                    const std::vector<size_t>& expectedCulled)
+  {
+    RenderGraph graph;
+    graph.setCullUnusedPasses(cullUnusedPasses);
+    graph.compile(renderPasses);
+
+    std::vector<size_t> culled;
+    for(size_t p=0; p<graph.passes().size(); p++)
+      if(graph.culled(p))
+        culled.push_back(p);
+
+    if(culled != expectedCulled || !graph.errors().empty())
+      failures.push_back(name + " (cull unused: " + (cullUnusedPasses?"yes":"no") + ")\n" + graph.describe());
+  };
+
+  // The default passes set by the Map with the gamma post layer expanded.
+  std::vector<RenderPass> defaultPasses{
+    RenderPass::LightFBOs,
+    {RenderPass::SwapToMSAA, defaultSID()},
+    RenderPass::Background,
+    RenderPass::Normal,
+    RenderPass::Transparency,
+    {RenderPass::SwapToFBO, postGammaShaderSID()},
+    {RenderPass::Custom, postGammaShaderSID()},
+    RenderPass::Text,
+    RenderPass::GUI3D,
+    RenderPass::GUI,
+    RenderPass::SwapToOriginalFBO,
+    RenderPass::Blit
+  };
+  expect("Default passes", defaultPasses, false, {});
+  expect("Default passes", defaultPasses, true, {});
+
+  // X is drawn in a branch and only read by name, for example by an FBOLayer.
+  std::vector<RenderPass> branchPasses{
+    {RenderPass::SwapToMSAA, defaultSID()},
+    RenderPass::Normal,
+    RenderPass::PushFBOs,
+    {RenderPass::SwapToFBO, xSID},
+    RenderPass::Normal,
+    RenderPass::PopFBOs,
+    RenderPass::GUI,
+    RenderPass::SwapToOriginalFBO,
+    RenderPass::Blit
+  };
+  expect("Push pop branch", branchPasses, false, {});
+  expect("Push pop branch", branchPasses, true, {});
+
+  // Nothing reads X, and the second blit repeats the first.
+  std::vector<RenderPass> unusedPasses{
+    {RenderPass::SwapToFBO, xSID},
+    RenderPass::Normal,
+    {RenderPass::SwapToFBO, ySID},
+    RenderPass::Background,
+    RenderPass::SwapToOriginalFBO,
+    RenderPass::Blit,
+    RenderPass::Blit
+  };
+  expect("Unused FBO", unusedPasses, false, {6});
+  expect("Unused FBO", unusedPasses, true, {1, 6});
+
+  return failures;
+}
+
+}
@@ -6,6 +6,50 @@
 namespace tp_maps
 {
 
+namespace
+{
+//##################################################################################################
+struct QualityLevel_lt
+{
+  RenderMode shadowSamples;
+  size_t maxSamples;
+  bool postEffects;
+  bool isDoFRendered;
+  float renderScale;
+};
+
+//##################################################################################################
+//! Ordered from cheapest to most expensive, each step changes as little as possible.
+const QualityLevel_lt qualityLevels_lt[] =
+{
+  {RenderMode::Fast        ,  1, false, false, 0.50f},
+  {RenderMode::Fast        ,  1, false, false, 0.75f},
+  {RenderMode::Fast        ,  1, true , false, 1.00f},
+  {RenderMode::Intermediate,  1, true , false, 1.00f},
+  {RenderMode::Intermediate,  2, true , true , 1.00f},
+  {RenderMode::Full        ,  4, true , true , 1.00f},
+  {RenderMode::Full        , 32, true , true , 1.00f}
+};
+
+constexpr size_t qualityLevelCount_lt = sizeof(qualityLevels_lt) / sizeof(QualityLevel_lt);
+
+//! Frames that are more than this fraction of the target count as over budget.
+constexpr float overBudget_lt = 1.1f;
+
+//! Frames that are less than this fraction of the target count as under budget.
+constexpr float underBudget_lt = 0.6f;
+
+//! Weight given to each new frame time in the smoothed times.
+constexpr float smoothing_lt = 0.2f;
+
+//! Frames to ignore after a change while the buffers are reallocated.
+constexpr size_t settleFrames_lt = 3;
+
+constexpr size_t stepDownFrames_lt = 3;
+constexpr size_t minStepUpFrames_lt = 30;
+constexpr size_t maxStepUpFrames_lt = 480;
+}
+
 //##################################################################################################
 struct RenderModeManager::Private
 {
@@ -29,6 +73,22 @@ struct RenderModeManager::Private
   bool isDoFRendered{false};
 
   bool msaaAllowed{false};
+  size_t maxSamples{32};
+  bool postEffectsAllowed{true};
+
+  bool progressive{false};
+  size_t progressiveFrames{16};
+  size_t progressiveSample{0};
+  bool updatingMap{false}; //!< True while this class is requesting a redraw, see mapUpdated.
+
+  bool adaptive{false};
+  AdaptiveRenderStats stats;
+  bool haveFrameTime{false};
+  size_t settleFrames{0};
+  size_t overBudgetFrames{0};
+  size_t underBudgetFrames{0};
+  size_t stepUpFrames{minStepUpFrames_lt};
+  size_t framesSinceStepUp{maxStepUpFrames_lt};
 
   //################################################################################################
   Private(Q* q_, Map* map_):
@@ -52,6 +112,93 @@ struct RenderModeManager::Private
       animateCallback.disconnect();
   }
 
+  //################################################################################################
+  //! Radical inverse, used to spread the jitter of successive samples evenly over the pixel.
+  static float halton(size_t index, size_t base)
+  {
+    float f = 1.0f;
+    float r = 0.0f;
+    while(index>0)
+    {
+      f /= float(base);
+      r += f * float(index % base);
+      index /= base;
+    }
+    return r;
+  }
+
+  //################################################################################################
+  //! Request a full redraw without resetting progressive rendering.
+  void updateMap()
+  {
+    updatingMap = true;
+    map->update(RenderFromStage::Full, map->allSubviewNames());
+    updatingMap = false;
+  }
+
+  //################################################################################################
+  void advanceProgressive()
+  {
+    progressiveSample++;
+    updateMap();
+
+    if((progressiveSample+1) >= progressiveFrames)
+    {
+      nextModeAfter = 0;
+      checkConnect(false);
+    }
+  }
+
+  //################################################################################################
+  void applyQualityLevel()
+  {
+    const auto& level = qualityLevels_lt[stats.qualityLevel];
+
+    shadowSamples      = q->shadowSamples(level.shadowSamples);
+    msaaAllowed        = level.maxSamples>1;
+    maxSamples         = level.maxSamples;
+    postEffectsAllowed = level.postEffects;
+    isDoFRendered      = level.isDoFRendered;
+
+    stats.shadowSamples = shadowSamples;
+    stats.maxSamples    = maxSamples;
+    stats.postEffects   = postEffectsAllowed;
+    stats.isDoFRendered = isDoFRendered;
+    stats.renderScale   = level.renderScale;
+  }
+
+  //################################################################################################
+  void setQualityLevel(size_t qualityLevel)
+  {
+    if(qualityLevel>stats.qualityLevel)
+      framesSinceStepUp = 0;
+
+    // If stepping up pushed the frame time straight over budget wait longer before trying again.
+    else if(framesSinceStepUp<minStepUpFrames_lt)
+      stepUpFrames = tpMin(stepUpFrames*2, maxStepUpFrames_lt);
+
+    stats.qualityLevel = qualityLevel;
+    stats.qualityChanges++;
+    resetFrameTimes();
+    applyQualityLevel();
+    updateMap();
+  }
+
+  //################################################################################################
+  void resetFrameTimes()
+  {
+    haveFrameTime = false;
+    settleFrames = settleFrames_lt;
+    overBudgetFrames = 0;
+    underBudgetFrames = 0;
+  }
+
+  //################################################################################################
+  tp_utils::Callback<void()> controllerUpdateCallback = [&]
+  {
+    q->enterFastRenderMode();
+  };
+
   //################################################################################################
   tp_utils::Callback<void(double)> animateCallback = [&](double)
   {
@@ -81,6 +228,12 @@ struct RenderModeManager::Private
 
     if(renderMode == RenderMode::Fast)
     {
+      if(progressive)
+      {
+        advanceProgressive();
+        return;
+      }
+
       q->setRenderMode(RenderMode::Intermediate);
       if(renderMode != defaultRenderMode)
       {
@@ -126,6 +279,7 @@ void RenderModeManager::setRenderMode(RenderMode renderMode)
 {
   d->renderMode = renderMode;
   d->nextModeAfter = 0;
+  d->progressiveSample = 0;
   d->checkConnect(false);
 
   switch(renderMode)
@@ -147,7 +301,11 @@ void RenderModeManager::setRenderMode(RenderMode renderMode)
       break;
   }
 
-  d->map->update(RenderFromStage::Full, d->map->allSubviewNames());
+  // In adaptive mode the settings come from the measured frame times instead.
+  if(d->adaptive)
+    d->applyQualityLevel();
+
+  d->updateMap();
 }
 
 //##################################################################################################
@@ -198,6 +356,18 @@ bool RenderModeManager::msaaAllowed() const
   return d->msaaAllowed;
 }
 
+//##################################################################################################
+size_t RenderModeManager::maxSamples() const
+{
+  return d->maxSamples;
+}
+
+//##################################################################################################
+bool RenderModeManager::postEffectsAllowed() const
+{
+  return d->postEffectsAllowed;
+}
+
 //##################################################################################################
 void RenderModeManager::enterFastRenderMode()
 {
@@ -206,4 +376,171 @@ void RenderModeManager::enterFastRenderMode()
   d->checkConnect(true);
 }
 
+//##################################################################################################
+void RenderModeManager::setProgressive(bool progressive)
+{
+  if(d->progressive == progressive)
+    return;
+
+  d->progressive = progressive;
+
+  if(progressive)
+    d->controllerUpdateCallback.connect(d->map->controllerUpdate);
+  else
+    d->controllerUpdateCallback.disconnect();
+
+  enterFastRenderMode();
+}
+
+//##################################################################################################
+bool RenderModeManager::progressive() const
+{
+  return d->progressive;
+}
+
+//##################################################################################################
+void RenderModeManager::setProgressiveFrames(size_t progressiveFrames)
+{
+  d->progressiveFrames = tpMax(size_t(1), progressiveFrames);
+}
+
+//##################################################################################################
+size_t RenderModeManager::progressiveFrames() const
+{
+  return d->progressiveFrames;
+}
+
+//##################################################################################################
+size_t RenderModeManager::progressiveSample() const
+{
+  return d->progressiveSample;
+}
+
+//##################################################################################################
+glm::vec2 RenderModeManager::progressiveJitter() const
+{
+  if(d->progressiveSample == 0)
+    return {0.0f, 0.0f};
+
+  return {Private::halton(d->progressiveSample, 2) - 0.5f, Private::halton(d->progressiveSample, 3) - 0.5f};
+}
+
+//##################################################################################################
+void RenderModeManager::resetProgressive()
+{
+  if(d->progressive)
+    enterFastRenderMode();
+}
+
+//##################################################################################################
+void RenderModeManager::mapUpdated(const RenderFromStage& renderFromStage)
+{
+  if(renderFromStage == RenderFromStage::Full && !d->updatingMap)
+    resetProgressive();
+}
+
+//##################################################################################################
+void RenderModeManager::setAdaptive(bool adaptive)
+{
+  if(d->adaptive == adaptive)
+    return;
+
+  d->adaptive = adaptive;
+  d->stats.qualityLevel = qualityLevelCount_lt/2;
+  d->stepUpFrames = minStepUpFrames_lt;
+  d->framesSinceStepUp = maxStepUpFrames_lt;
+  d->resetFrameTimes();
+
+  if(!adaptive)
+  {
+    d->maxSamples = 32;
+    d->postEffectsAllowed = true;
+  }
+
+  setRenderMode(d->renderMode);
+}
+
+//##################################################################################################
+bool RenderModeManager::adaptive() const
+{
+  return d->adaptive;
+}
+
+//##################################################################################################
+void RenderModeManager::setTargetFrameTime(float targetFrameTimeMS)
+{
+  d->stats.targetFrameTimeMS = tpMax(1.0f, targetFrameTimeMS);
+  d->resetFrameTimes();
+}
+
+//##################################################################################################
+float RenderModeManager::targetFrameTime() const
+{
+  return d->stats.targetFrameTimeMS;
+}
+
+//##################################################################################################
+size_t RenderModeManager::qualityLevels()
+{
+  return qualityLevelCount_lt;
+}
+
+//##################################################################################################
+const AdaptiveRenderStats& RenderModeManager::adaptiveStats() const
+{
+  return d->stats;
+}
+
+//##################################################################################################
+void RenderModeManager::frameRendered(float cpuFrameTimeMS, float gpuFrameTimeMS)
+{
+  if(!d->adaptive)
+    return;
+
+  auto& stats = d->stats;
+
+  // Skip the first frames after a change, they include the cost of reallocating buffers.
+  if(d->settleFrames>0)
+  {
+    d->settleFrames--;
+    return;
+  }
+
+  if(!d->haveFrameTime)
+  {
+    d->haveFrameTime = true;
+    stats.cpuFrameTimeMS = cpuFrameTimeMS;
+    stats.gpuFrameTimeMS = gpuFrameTimeMS;
+  }
+  else
+  {
+    stats.cpuFrameTimeMS += (cpuFrameTimeMS - stats.cpuFrameTimeMS) * smoothing_lt;
+    stats.gpuFrameTimeMS += (gpuFrameTimeMS - stats.gpuFrameTimeMS) * smoothing_lt;
+  }
+
+  d->framesSinceStepUp++;
+
+  float frameTimeMS = tpMax(stats.cpuFrameTimeMS, stats.gpuFrameTimeMS);
+
+  if(frameTimeMS > stats.targetFrameTimeMS*overBudget_lt)
+  {
+    d->underBudgetFrames = 0;
+    d->overBudgetFrames++;
+    if(d->overBudgetFrames>=stepDownFrames_lt && stats.qualityLevel>0)
+      d->setQualityLevel(stats.qualityLevel-1);
+  }
+  else if(frameTimeMS < stats.targetFrameTimeMS*underBudget_lt)
+  {
+    d->overBudgetFrames = 0;
+    d->underBudgetFrames++;
+    if(d->underBudgetFrames>=d->stepUpFrames && (stats.qualityLevel+1)<qualityLevelCount_lt)
+      d->setQualityLevel(stats.qualityLevel+1);
+  }
+  else
+  {
+    d->overBudgetFrames = 0;
+    d->underBudgetFrames = 0;
+  }
+}
+
 }
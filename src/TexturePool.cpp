@@ -3,6 +3,8 @@
 #include "tp_maps/Layer.h"
 #include "tp_maps/Map.h"
 #include "tp_maps/textures/BasicTexture.h"
+#include "tp_maps/textures/TextureCompression.h"
+#include "tp_maps/WorkerThreads.h"
 
 #include "tp_image_utils/ColorMap.h"
 #include "tp_image_utils/CombineChannels.h"
@@ -11,11 +13,31 @@
 #include "tp_utils/TimeUtils.h"
 #include "tp_utils/RefCount.h"
 
+#include "glm/glm.hpp" // IWYU pragma: keep
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <cstring>
+
 namespace tp_maps
 {
 
 namespace
 {
+constexpr size_t atlasSize=2048;
+
+// Sub-images are surrounded by a border of repeated edge pixels so that filtering and the first
+// few mip levels don't bleed between neighbouring sub-images.
+constexpr size_t atlasPadding=8;
+constexpr GLint atlasMaxMipLevel=3;
+
+//##################################################################################################
+uint64_t hashCombine(uint64_t h, uint64_t v)
+{
+  return h ^ (v + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2));
+}
+
 //##################################################################################################
 struct Details_lt
 {
@@ -27,6 +49,13 @@ struct Details_lt
   tp_image_utils::ColorMap image;
 
   bool makeSquare{true};
+
+  uint64_t imageHash{0};
+  uint64_t contentHash{0};
+  bool hasContentHash{false};
+  uint64_t contentRevision{0};
+  uint64_t verifiedOwnerRevision{0};
+
   BasicTexture* texture{nullptr};
   bool changed{true};
   bool overwrite{false};
@@ -34,6 +63,10 @@ struct Details_lt
 
   GLint textureWrapS{GL_CLAMP_TO_EDGE};
   GLint textureWrapT{GL_CLAMP_TO_EDGE};
+
+  std::vector<tp_image_utils::ColorMap> mipmaps;
+  uint64_t mipmapGeneration{0};
+  bool mipmapsPending{false};
 };
 
 //##################################################################################################
@@ -52,6 +85,12 @@ struct CombinedDetails_lt
   tp_image_utils::ColorMap rgbaImage;
   bool composeImage{true};
 
+  std::array<uint64_t, 4> channelHashes{0, 0, 0, 0};
+  uint64_t contentHash{0};
+  bool hasContentHash{false};
+  uint64_t contentRevision{0};
+  uint64_t verifiedOwnerRevision{0};
+
   bool makeSquare{true};
 
   BasicTexture* texture{nullptr};
@@ -59,12 +98,157 @@ struct CombinedDetails_lt
 
   GLint textureWrapS{GL_CLAMP_TO_EDGE};
   GLint textureWrapT{GL_CLAMP_TO_EDGE};
+
+  bool inAtlas{false};
+  size_t atlasPage{0};
+  glm::vec4 uvTransform{0.0f};
+
+  std::vector<tp_image_utils::ColorMap> mipmaps;
+  uint64_t mipmapGeneration{0};
+  bool mipmapsPending{false};
+};
+
+//##################################################################################################
+//! Content hashes can collide so the pixels are compared before a texture is shared.
+bool sameImage_lt(const tp_image_utils::ColorMap& a, const tp_image_utils::ColorMap& b)
+{
+  return
+      a.width()  == b.width()  &&
+      a.height() == b.height() &&
+      std::memcmp(a.constData(), b.constData(), a.size()*sizeof(TPPixel)) == 0;
+}
+
+//##################################################################################################
+//! Tracks which entry owns the texture for some content, other entries with the same content share it.
+template<typename Key>
+struct ContentOwners_lt
+{
+  std::unordered_map<uint64_t, Key> owners;
+  std::unordered_map<uint64_t, size_t> counts;
+  uint64_t nextRevision{1};
+
+  //################################################################################################
+  template<typename Details>
+  void set(const Key& key, Details& details, uint64_t contentHash, bool& ownerRemoved)
+  {
+    clear(key, details, ownerRemoved);
+    details.contentHash = contentHash;
+    details.hasContentHash = true;
+    details.contentRevision = nextRevision++;
+    details.verifiedOwnerRevision = 0;
+    counts[contentHash]++;
+  }
+
+  //################################################################################################
+  //! Returns true if details can share the texture of owner, the result of the pixel compare is
+  //! kept until either of them changes.
+  template<typename Details, typename Compare>
+  static bool sameContent(Details& details, const Details& owner, const Compare& compare)
+  {
+    if(details.verifiedOwnerRevision == owner.contentRevision)
+      return true;
+
+    if(!compare())
+      return false;
+
+    details.verifiedOwnerRevision = owner.contentRevision;
+    return true;
+  }
+
+  //################################################################################################
+  //! Sets ownerRemoved if the key owned a texture that other entries were sharing.
+  template<typename Details>
+  void clear(const Key& key, Details& details, bool& ownerRemoved)
+  {
+    if(!details.hasContentHash)
+      return;
+
+    details.hasContentHash = false;
+
+    bool shared=false;
+    if(auto c = counts.find(details.contentHash); c!=counts.end())
+    {
+      c->second--;
+      shared = c->second>0;
+      if(!c->second)
+        counts.erase(c);
+    }
+
+    if(auto o = owners.find(details.contentHash); o!=owners.end() && o->second==key)
+    {
+      owners.erase(o);
+      if(shared)
+        ownerRemoved = true;
+    }
+  }
+
+  //################################################################################################
+  //! Returns the owner of the content, key becomes the owner if there is not one yet.
+  const Key& owner(const Key& key, uint64_t contentHash)
+  {
+    return owners.try_emplace(contentHash, key).first->second;
+  }
+
+  //################################################################################################
+  const Key* findOwner(uint64_t contentHash) const
+  {
+    auto o = owners.find(contentHash);
+    return (o!=owners.end())?&o->second:nullptr;
+  }
+};
+
+//##################################################################################################
+//! A single atlas texture, sub-images are packed into horizontal shelves.
+struct AtlasPage_lt
+{
+  tp_image_utils::ColorMap image{atlasSize, atlasSize};
+  GLuint textureID{0};
+
+  size_t shelfY{0};
+  size_t shelfHeight{0};
+  size_t cursorX{0};
+
+  //! The number of sub-images currently using this page, when this reaches 0 the page is reused.
+  size_t count{0};
+
+  //! Regions of the image that have changed since it was uploaded, x, y, width, height.
+  std::vector<glm::uvec4> dirtyRects;
+
+  //################################################################################################
+  bool allocate(size_t w, size_t h, size_t& x, size_t& y)
+  {
+    if(cursorX+w > atlasSize)
+    {
+      shelfY += shelfHeight;
+      shelfHeight = 0;
+      cursorX = 0;
+    }
+
+    if(w>atlasSize || shelfY+h > atlasSize)
+      return false;
+
+    x = cursorX;
+    y = shelfY;
+    cursorX += w;
+    shelfHeight = tpMax(shelfHeight, h);
+    return true;
+  }
+
+  //################################################################################################
+  void reset()
+  {
+    shelfY = 0;
+    shelfHeight = 0;
+    cursorX = 0;
+    dirtyRects.clear();
+  }
 };
 }
 
 //##################################################################################################
 struct TexturePool::Private
 {
+  Q* q;
   Map* m_map;
   Layer* m_layer;
   std::unordered_map<tp_utils::StringID, Details_lt> images;
@@ -72,8 +256,31 @@ struct TexturePool::Private
 
   int keepHot{0};
 
+  TextureCompression textureCompression{TextureCompression::None};
+  std::string compressedTextureCacheDirectory;
+
+  bool useAtlas{false};
+  size_t maxAtlasImageSize{256};
+  std::vector<AtlasPage_lt> atlasPages;
+
+  ContentOwners_lt<tp_utils::StringID> imageOwners;
+  ContentOwners_lt<TexturePoolKey> combinedOwners;
+
+  bool generateMipmapsAsync{false};
+  MipmapFilter mipmapFilter{MipmapFilter::Box};
+  uint64_t nextMipmapGeneration{0};
+  bool animateCallbackConnected{false};
+
+  // Completed mipmap jobs, these are applied on the render thread in animate.
+  std::mutex completedMipmapsMutex;
+  std::vector<std::function<void()>> completedMipmaps;
+
+  // The map's shared threads, set when the first job is queued.
+  WorkerThreads* workerThreads{nullptr};
+
   //################################################################################################
-  Private(Map* map_, Layer* layer_):
+  Private(Q* q_, Map* map_, Layer* layer_):
+    q(q_),
     m_map(map_),
     m_layer(layer_)
   {
@@ -86,6 +293,9 @@ struct TexturePool::Private
   //################################################################################################
   ~Private()
   {
+    if(workerThreads)
+      workerThreads->cancelJobs(this);
+
     if(map())
     {
       for(auto& i : images)
@@ -100,6 +310,10 @@ struct TexturePool::Private
 
     for(auto& i : combinedImages)
       delete i.second.texture;
+
+    if(map())
+      for(auto& page : atlasPages)
+        map()->deleteTexture(page.textureID);
   }
 
   //################################################################################################
@@ -108,6 +322,359 @@ struct TexturePool::Private
     return (m_layer && m_layer->map())?m_layer->map():m_map;
   }
 
+  //################################################################################################
+  void deleteTextures()
+  {
+    auto deleteTexture = [&](auto& details)
+    {
+      if(details.textureID && map())
+        map()->deleteTexture(details.textureID);
+      delete details.texture;
+
+      details.textureID = 0;
+      details.texture = nullptr;
+    };
+
+    for(auto& i : images)
+      deleteTexture(i.second);
+
+    for(auto& i : combinedImages)
+      deleteTexture(i.second);
+  }
+
+  //################################################################################################
+  //! Compress the texture on the worker threads, textureID is bound again when that completes.
+  void setCompressedFormat(BasicTexture* texture,
+                           GLuint& textureID,
+                           TextureUsage usage,
+                           NChannels nChannels,
+                           const tp_image_utils::ColorMap& image)
+  {
+    if(textureCompression == TextureCompression::None)
+      return;
+
+    bool hasAlpha = (nChannels==NChannels::RGBA) && imageHasAlpha(image);
+    auto compressedFormat = selectCompressedFormat(usage, hasAlpha, map()->supportedCompressedFormats());
+    texture->setCompressedFormat(compressedFormat, compressedTextureCacheDirectory);
+
+    texture->setImageChangedCallback([this, &textureID]
+    {
+      if(textureID && map())
+      {
+        map()->makeCurrent();
+        map()->deleteTexture(textureID);
+      }
+
+      textureID = 0;
+      q->changed();
+    });
+  }
+
+  //################################################################################################
+  void updateContentHash(const TexturePoolKey& key, CombinedDetails_lt& details, bool& ownerRemoved)
+  {
+    uint64_t h = 0;
+    for(auto channelHash : details.channelHashes)
+      h = hashCombine(h, channelHash);
+
+    h = hashCombine(h, key.d().rIndex);
+    h = hashCombine(h, key.d().gIndex);
+    h = hashCombine(h, key.d().bIndex);
+    h = hashCombine(h, key.d().aIndex);
+    h = hashCombine(h, key.d().defaultColor.i);
+    h = hashCombine(h, uint64_t(key.d().nChannels));
+    h = hashCombine(h, uint64_t(key.d().usage));
+    h = hashCombine(h, details.makeSquare?1:0);
+
+    combinedOwners.set(key, details, h, ownerRemoved);
+  }
+
+  //################################################################################################
+  //! Returns the key of another entry with identical content whose texture can be shared.
+  const TexturePoolKey* sharedOwner(const TexturePoolKey& key, CombinedDetails_lt& details)
+  {
+    if(!details.hasContentHash || details.texture || details.inAtlas)
+      return nullptr;
+
+    const auto& owner = combinedOwners.owner(key, details.contentHash);
+    if(owner == key)
+      return nullptr;
+
+    auto o = combinedImages.find(owner);
+    if(o == combinedImages.end() ||
+       o->second.textureWrapS != details.textureWrapS ||
+       o->second.textureWrapT != details.textureWrapT)
+      return nullptr;
+
+    bool same = ContentOwners_lt<TexturePoolKey>::sameContent(details, o->second, [&]
+    {
+      composeImage(key, details);
+      composeImage(owner, o->second);
+      return
+          o->second.nChannels  == details.nChannels  &&
+          o->second.makeSquare == details.makeSquare &&
+          sameImage_lt(o->second.rgbaImage, details.rgbaImage);
+    });
+
+    if(!same)
+      return nullptr;
+
+    return &owner;
+  }
+
+  //################################################################################################
+  template<typename Details>
+  static void resetMipmaps(Details& details)
+  {
+    details.mipmaps.clear();
+    details.mipmapGeneration = 0;
+    details.mipmapsPending = false;
+  }
+
+  //################################################################################################
+  //! Returns true if the texture can be created, else mipmaps are being generated on a worker.
+  /*!
+  While the job runs the texture should be created without mipmaps, when the job completes the
+  texture is deleted so that it gets recreated with all of its levels.
+  */
+  template<typename Key, typename Details>
+  bool requestMipmaps(std::unordered_map<Key, Details>& entries,
+                      const Key& key,
+                      Details& details,
+                      const tp_image_utils::ColorMap& image,
+                      bool gammaCorrect)
+  {
+    // Compressed textures generate their own mipmaps before encoding.
+    if(!generateMipmapsAsync || textureCompression != TextureCompression::None)
+      return true;
+
+    if(!details.mipmaps.empty() || (image.width()<2 && image.height()<2))
+      return true;
+
+    if(details.mipmapsPending)
+      return false;
+
+    // The completed jobs are applied from the map's animate callback.
+    if(!map())
+      return true;
+
+    details.mipmapsPending = true;
+    details.mipmapGeneration = ++nextMipmapGeneration;
+
+    if(!workerThreads)
+      workerThreads = &map()->workerThreads();
+
+    if(!animateCallbackConnected)
+    {
+      animateCallbackConnected = true;
+      animateCallback.connect(map()->animateCallbacks);
+    }
+
+    // On profiles where BasicTexture pads to a power of two it ignores these and uses
+    // glGenerateMipmap instead.
+    workerThreads->addJob(this, [this,
+                                &entries,
+                                key,
+                                image,
+                                gammaCorrect,
+                                generation = details.mipmapGeneration,
+                                filter = mipmapFilter]
+    {
+      auto mipmaps = std::make_shared<std::vector<tp_image_utils::ColorMap>>(generateMipmaps(image, filter, gammaCorrect));
+
+      std::lock_guard<std::mutex> lock(completedMipmapsMutex);
+      completedMipmaps.emplace_back([this, &entries, key, generation, mipmaps]
+      {
+        auto i = entries.find(key);
+        if(i == entries.end() || i->second.mipmapGeneration != generation)
+          return;
+
+        auto& details = i->second;
+        details.mipmaps = std::move(*mipmaps);
+        details.mipmapsPending = false;
+
+        if(details.textureID && map())
+          map()->deleteTexture(details.textureID);
+        delete details.texture;
+
+        details.textureID = 0;
+        details.texture = nullptr;
+      });
+    });
+
+    return false;
+  }
+
+  //################################################################################################
+  void applyCompletedMipmaps()
+  {
+    std::vector<std::function<void()>> completed;
+    {
+      std::lock_guard<std::mutex> lock(completedMipmapsMutex);
+      completed.swap(completedMipmaps);
+    }
+
+    if(completed.empty())
+      return;
+
+    if(map())
+      map()->makeCurrent();
+
+    for(const auto& apply : completed)
+      apply();
+
+    q->changed();
+  }
+
+  //################################################################################################
+  template<typename Details>
+  void setMipmaps(BasicTexture* texture, const Details& details, bool mipmapsReady)
+  {
+    if(!details.mipmaps.empty())
+      texture->setMipmaps(details.mipmaps);
+    else if(!mipmapsReady)
+      texture->setMinFilterOption(GL_LINEAR);
+  }
+
+  //################################################################################################
+  void composeImage(const TexturePoolKey& key, CombinedDetails_lt& details)
+  {
+    if(!details.composeImage)
+      return;
+
+    details.composeImage = false;
+    details.nChannels = key.d().nChannels;
+
+    details.rgbaImage = tp_image_utils::combineChannels(&details.rImage,
+                                                       &details.gImage,
+                                                       &details.bImage,
+                                                       &details.aImage,
+                                                       key.d().rIndex,
+                                                       key.d().gIndex,
+                                                       key.d().bIndex,
+                                                       key.d().aIndex,
+                                                       key.d().defaultColor);
+  }
+
+  //################################################################################################
+  bool canAddToAtlas(const CombinedDetails_lt& details) const
+  {
+    // The shader clamps UVs to the sub-image so only clamp to edge can be emulated.
+    return
+        useAtlas &&
+        details.textureWrapS == GL_CLAMP_TO_EDGE &&
+        details.textureWrapT == GL_CLAMP_TO_EDGE &&
+        details.rgbaImage.width()>0 && details.rgbaImage.width()<=maxAtlasImageSize &&
+        details.rgbaImage.height()>0 && details.rgbaImage.height()<=maxAtlasImageSize;
+  }
+
+  //################################################################################################
+  void addToAtlas(CombinedDetails_lt& details)
+  {
+    const auto& image = details.rgbaImage;
+    size_t w = image.width()  + atlasPadding*2;
+    size_t h = image.height() + atlasPadding*2;
+
+    size_t x=0;
+    size_t y=0;
+    size_t p=0;
+    for(; p<atlasPages.size(); p++)
+      if(atlasPages.at(p).allocate(w, h, x, y))
+        break;
+
+    if(p==atlasPages.size())
+    {
+      atlasPages.emplace_back();
+      if(!atlasPages.back().allocate(w, h, x, y))
+        return;
+    }
+
+    auto& page = atlasPages.at(p);
+    page.count++;
+
+    const TPPixel* src = image.constData();
+    TPPixel* dst = page.image.data();
+    size_t iw = image.width();
+    size_t ih = image.height();
+    for(size_t ty=0; ty<h; ty++)
+    {
+      size_t sy = size_t(std::clamp(int(ty)-int(atlasPadding), 0, int(ih)-1));
+      TPPixel* row = dst + (y+ty)*atlasSize + x;
+      for(size_t tx=0; tx<w; tx++)
+        row[tx] = src[sy*iw + size_t(std::clamp(int(tx)-int(atlasPadding), 0, int(iw)-1))];
+    }
+
+    page.dirtyRects.emplace_back(x, y, w, h);
+
+    details.inAtlas = true;
+    details.atlasPage = p;
+    details.uvTransform =
+    {
+      float(x+atlasPadding) / float(atlasSize),
+      float(y+atlasPadding) / float(atlasSize),
+      float(iw) / float(atlasSize),
+      float(ih) / float(atlasSize)
+    };
+  }
+
+  //################################################################################################
+  void removeFromAtlas(CombinedDetails_lt& details)
+  {
+    if(!details.inAtlas)
+      return;
+
+    details.inAtlas = false;
+    details.uvTransform = glm::vec4(0.0f);
+
+    auto& page = atlasPages.at(details.atlasPage);
+    page.count--;
+    if(!page.count)
+      page.reset();
+  }
+
+  //################################################################################################
+  GLuint atlasTextureID(AtlasPage_lt& page)
+  {
+    if(!page.textureID)
+    {
+      BasicTexture texture(map(), page.image, NChannels::RGBA, false);
+      page.textureID = texture.bindTexture();
+#ifndef TP_GLES2
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, atlasMaxMipLevel);
+#endif
+      page.dirtyRects.clear();
+    }
+    else if(!page.dirtyRects.empty())
+    {
+      TP_FUNCTION_TIME("TexturePool::atlasTextureID upload");
+
+      glBindTexture(GL_TEXTURE_2D, page.textureID);
+
+      std::vector<TPPixel> buffer;
+      for(const auto& r : page.dirtyRects)
+      {
+        buffer.resize(size_t(r.z)*size_t(r.w));
+        for(size_t y=0; y<r.w; y++)
+        {
+          const TPPixel* src = page.image.constData() + (r.y+y)*atlasSize + r.x;
+          std::copy(src, src+r.z, buffer.data()+y*r.z);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, GLint(r.x), GLint(r.y), GLsizei(r.z), GLsizei(r.w), GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+      }
+      page.dirtyRects.clear();
+
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    return page.textureID;
+  }
+
+  //################################################################################################
+  tp_utils::Callback<void(double)> animateCallback = [&](double)
+  {
+    applyCompletedMipmaps();
+  };
+
   //################################################################################################
   tp_utils::Callback<void()> invalidateBuffersCallback = [&]
   {
@@ -116,19 +683,25 @@ struct TexturePool::Private
 
     for(auto& i : combinedImages)
       i.second.textureID=0;
+
+    for(auto& page : atlasPages)
+    {
+      page.textureID=0;
+      page.dirtyRects.clear();
+    }
   };
 };
 
 //##################################################################################################
 TexturePool::TexturePool(Map* map):
-  d(new Private(map, nullptr))
+  d(new Private(this, map, nullptr))
 {
 
 }
 
 //##################################################################################################
 TexturePool::TexturePool(Layer* layer):
-  d(new Private(nullptr, layer))
+  d(new Private(this, nullptr, layer))
 {
 
 }
@@ -147,6 +720,8 @@ void TexturePool::incrementKeepHot(bool keepHot)
   d->keepHot += keepHot?1:-1;
   if(d->keepHot==0)
   {
+    bool ownerRemoved=false;
+
     for(auto i = d->images.begin(); i!=d->images.end();)
     {
       if(!i->second.count)
@@ -156,6 +731,7 @@ void TexturePool::incrementKeepHot(bool keepHot)
           d->map()->deleteTexture(i->second.textureID);
         }
         delete i->second.texture;
+        d->imageOwners.clear(i->first, i->second, ownerRemoved);
         i = d->images.erase(i);
       }
       else
@@ -171,14 +747,103 @@ void TexturePool::incrementKeepHot(bool keepHot)
           d->map()->deleteTexture(i->second.textureID);
         }
         delete i->second.texture;
+        d->removeFromAtlas(i->second);
+        d->combinedOwners.clear(i->first, i->second, ownerRemoved);
         i = d->combinedImages.erase(i);
       }
       else
         ++i;
     }
+
+    if(ownerRemoved)
+      changed();
   }
 }
 
+//##################################################################################################
+void TexturePool::setTextureCompression(TextureCompression textureCompression)
+{
+  if(d->textureCompression == textureCompression)
+    return;
+
+  d->textureCompression = textureCompression;
+
+  if(d->map())
+    d->map()->makeCurrent();
+
+  d->deleteTextures();
+  changed();
+}
+
+//##################################################################################################
+TextureCompression TexturePool::textureCompression() const
+{
+  return d->textureCompression;
+}
+
+//##################################################################################################
+void TexturePool::setCompressedTextureCacheDirectory(const std::string& compressedTextureCacheDirectory)
+{
+  d->compressedTextureCacheDirectory = compressedTextureCacheDirectory;
+}
+
+//##################################################################################################
+void TexturePool::setUseAtlas(bool useAtlas, size_t maxAtlasImageSize)
+{
+  maxAtlasImageSize = tpMin(maxAtlasImageSize, atlasSize - atlasPadding*2);
+
+  if(d->useAtlas == useAtlas && d->maxAtlasImageSize == maxAtlasImageSize)
+    return;
+
+  d->useAtlas = useAtlas;
+  d->maxAtlasImageSize = maxAtlasImageSize;
+
+  for(auto& i : d->combinedImages)
+    d->removeFromAtlas(i.second);
+
+  changed();
+}
+
+//##################################################################################################
+bool TexturePool::useAtlas() const
+{
+  return d->useAtlas;
+}
+
+//##################################################################################################
+void TexturePool::setGenerateMipmapsAsync(bool generateMipmapsAsync, MipmapFilter mipmapFilter)
+{
+  if(d->generateMipmapsAsync == generateMipmapsAsync && d->mipmapFilter == mipmapFilter)
+    return;
+
+  d->generateMipmapsAsync = generateMipmapsAsync;
+  d->mipmapFilter = mipmapFilter;
+
+  for(auto& i : d->images)
+    d->resetMipmaps(i.second);
+
+  for(auto& i : d->combinedImages)
+    d->resetMipmaps(i.second);
+
+  if(d->map())
+    d->map()->makeCurrent();
+
+  d->deleteTextures();
+  changed();
+}
+
+//##################################################################################################
+bool TexturePool::generateMipmapsAsync() const
+{
+  return d->generateMipmapsAsync;
+}
+
+//##################################################################################################
+MipmapFilter TexturePool::mipmapFilter() const
+{
+  return d->mipmapFilter;
+}
+
 //##################################################################################################
 void TexturePool::subscribe(const tp_utils::StringID& name,
                             const tp_image_utils::ColorMap& image,
@@ -209,23 +874,35 @@ void TexturePool::subscribe(const tp_utils::StringID& name,
     details.changed = false;
     details.image = image;
     details.makeSquare = makeSquare;
+    d->resetMipmaps(details);
+
+    // Identical images share a texture, see textureID().
+    bool ownerRemoved=false;
+    details.imageHash = imageContentHash(image);
+    uint64_t contentHash = hashCombine(details.imageHash, uint64_t(details.nChannels));
+    contentHash = hashCombine(contentHash, makeSquare?1:0);
+    d->imageOwners.set(name, details, contentHash, ownerRemoved);
+
     for(auto& i : d->combinedImages)
     {
       auto& combinedDetails = i.second;
       const auto& key = i.first;
 
       bool changed=false;
-      if(key.d().rName == name){combinedDetails.rImage = image; changed=true;}
-      if(key.d().gName == name){combinedDetails.gImage = image; changed=true;}
-      if(key.d().bName == name){combinedDetails.bImage = image; changed=true;}
-      if(key.d().aName == name){combinedDetails.aImage = image; changed=true;}
+      if(key.d().rName == name){combinedDetails.rImage = image; combinedDetails.channelHashes[0] = details.imageHash; changed=true;}
+      if(key.d().gName == name){combinedDetails.gImage = image; combinedDetails.channelHashes[1] = details.imageHash; changed=true;}
+      if(key.d().bName == name){combinedDetails.bImage = image; combinedDetails.channelHashes[2] = details.imageHash; changed=true;}
+      if(key.d().aName == name){combinedDetails.aImage = image; combinedDetails.channelHashes[3] = details.imageHash; changed=true;}
 
       if(changed)
       {
+        d->updateContentHash(key, combinedDetails, ownerRemoved);
+        d->resetMipmaps(combinedDetails);
         combinedDetails.composeImage = true;
         if(combinedDetails.textureID && d->map())
           d->map()->deleteTexture(combinedDetails.textureID);
         delete combinedDetails.texture;
+        d->removeFromAtlas(combinedDetails);
 
         combinedDetails.textureID = 0;
         combinedDetails.texture = nullptr;
@@ -253,7 +930,12 @@ void TexturePool::unsubscribe(const tp_utils::StringID& name)
       d->map()->deleteTexture(i->second.textureID);
     delete i->second.texture;
 
+    bool ownerRemoved=false;
+    d->imageOwners.clear(i->first, i->second, ownerRemoved);
     d->images.erase(i);
+
+    if(ownerRemoved)
+      changed();
   }
 }
 
@@ -268,7 +950,7 @@ void TexturePool::subscribe(const TexturePoolKey& key,
 
   details.makeSquare = makeSquare;
 
-  auto findImage = [&](tp_image_utils::ColorMap& image, const tp_utils::StringID& name)
+  auto findImage = [&](tp_image_utils::ColorMap& image, uint64_t& imageHash, const tp_utils::StringID& name)
   {
     if(!name.isValid())
       return;
@@ -278,12 +960,18 @@ void TexturePool::subscribe(const TexturePoolKey& key,
       return;
 
     image = i->second.image;
+    imageHash = i->second.imageHash;
   };
 
-  findImage(details.rImage, key.d().rName);
-  findImage(details.gImage, key.d().gName);
-  findImage(details.bImage, key.d().bName);
-  findImage(details.aImage, key.d().aName);
+  findImage(details.rImage, details.channelHashes[0], key.d().rName);
+  findImage(details.gImage, details.channelHashes[1], key.d().gName);
+  findImage(details.bImage, details.channelHashes[2], key.d().bName);
+  findImage(details.aImage, details.channelHashes[3], key.d().aName);
+
+  bool ownerRemoved=false;
+  d->updateContentHash(key, details, ownerRemoved);
+  if(ownerRemoved)
+    changed();
 }
 
 //##################################################################################################
@@ -304,8 +992,14 @@ void TexturePool::unsubscribe(const TexturePoolKey& key)
     if(i->second.textureID && d->map())
       d->map()->deleteTexture(i->second.textureID);
     delete i->second.texture;
+    d->removeFromAtlas(i->second);
 
+    bool ownerRemoved=false;
+    d->combinedOwners.clear(i->first, i->second, ownerRemoved);
     d->combinedImages.erase(i);
+
+    if(ownerRemoved)
+      changed();
   }
 }
 
@@ -325,13 +1019,41 @@ GLuint TexturePool::textureID(const tp_utils::StringID& name)
   if(i == d->images.end())
     return 0;
 
+  if(!i->second.texture && i->second.hasContentHash)
+  {
+    if(const auto& owner = d->imageOwners.owner(name, i->second.contentHash); owner != name)
+    {
+      auto same = [&](const Details_lt& o)
+      {
+        return ContentOwners_lt<tp_utils::StringID>::sameContent(i->second, o, [&]
+        {
+          return
+              o.nChannels  == i->second.nChannels  &&
+              o.makeSquare == i->second.makeSquare &&
+              sameImage_lt(o.image, i->second.image);
+        });
+      };
+
+      if(auto o = d->images.find(owner); o != d->images.end() &&
+         o->second.textureWrapS == i->second.textureWrapS &&
+         o->second.textureWrapT == i->second.textureWrapT &&
+         same(o->second))
+        return textureID(owner);
+    }
+  }
+
   if(!i->second.texture)
   {
+    bool mipmapsReady = d->requestMipmaps(d->images, name, i->second, i->second.image, true);
+
     i->second.texture = new BasicTexture(d->map(),
                                          i->second.image,
                                          i->second.nChannels,
                                          i->second.makeSquare);
 
+    d->setCompressedFormat(i->second.texture, i->second.textureID, TextureUsage::Color, i->second.nChannels, i->second.image);
+    d->setMipmaps(i->second.texture, i->second, mipmapsReady);
+
     i->second.texture->setTextureWrapS(i->second.textureWrapS);
     i->second.texture->setTextureWrapT(i->second.textureWrapT);
   }
@@ -351,39 +1073,25 @@ GLuint TexturePool::textureID(const TexturePoolKey& key)
   if(i == d->combinedImages.end())
     return 0;
 
+  if(const auto* owner = d->sharedOwner(key, i->second); owner)
+    return textureID(*owner);
+
   if(!i->second.texture)
   {
-    if(i->second.composeImage)
-    {
-      i->second.composeImage = false;
-      i->second.nChannels = key.d().nChannels;
-
-      const auto& rImage = i->second.rImage;
-      const auto& gImage = i->second.gImage;
-      const auto& bImage = i->second.bImage;
-      const auto& aImage = i->second.aImage;
-
-      auto rIndex = key.d().rIndex;
-      auto gIndex = key.d().gIndex;
-      auto bIndex = key.d().bIndex;
-      auto aIndex = key.d().aIndex;
-
-      i->second.rgbaImage = tp_image_utils::combineChannels(&rImage,
-                                                            &gImage,
-                                                            &bImage,
-                                                            &aImage,
-                                                            rIndex,
-                                                            gIndex,
-                                                            bIndex,
-                                                            aIndex,
-                                                            key.d().defaultColor);
-    }
+    d->composeImage(key, i->second);
+
+    // Normals and data textures are linear so only color textures are filtered in linear space.
+    bool gammaCorrect = (key.d().usage == TextureUsage::Color);
+    bool mipmapsReady = d->requestMipmaps(d->combinedImages, key, i->second, i->second.rgbaImage, gammaCorrect);
 
     i->second.texture = new BasicTexture(d->map(),
                                          i->second.rgbaImage,
                                          i->second.nChannels,
                                          i->second.makeSquare);
 
+    d->setCompressedFormat(i->second.texture, i->second.textureID, key.d().usage, i->second.nChannels, i->second.rgbaImage);
+    d->setMipmaps(i->second.texture, i->second, mipmapsReady);
+
     i->second.texture->setTextureWrapS(i->second.textureWrapS);
     i->second.texture->setTextureWrapT(i->second.textureWrapT);
   }
@@ -394,6 +1102,38 @@ GLuint TexturePool::textureID(const TexturePoolKey& key)
   return i->second.textureID;
 }
 
+//##################################################################################################
+GLuint TexturePool::textureID(const TexturePoolKey& key, glm::vec4& uvTransform)
+{
+  uvTransform = glm::vec4(0.0f);
+
+  if(!d->useAtlas)
+    return textureID(key);
+
+  d->map()->makeCurrent();
+
+  auto i = d->combinedImages.find(key);
+  if(i == d->combinedImages.end())
+    return 0;
+
+  auto& details = i->second;
+  if(const auto* owner = d->sharedOwner(key, details); owner)
+    return textureID(*owner, uvTransform);
+
+  if(!details.inAtlas && !details.texture)
+  {
+    d->composeImage(key, details);
+    if(d->canAddToAtlas(details))
+      d->addToAtlas(details);
+  }
+
+  if(!details.inAtlas)
+    return textureID(key);
+
+  uvTransform = details.uvTransform;
+  return d->atlasTextureID(d->atlasPages.at(details.atlasPage));
+}
+
 //##################################################################################################
 void TexturePool::setTextureWrapS(const tp_utils::StringID& name, GLint textureWrapS)
 {
@@ -454,6 +1194,12 @@ void TexturePool::setTextureWrapS(const TexturePoolKey& key, GLint textureWrapS)
 
   i->second.textureWrapS = textureWrapS;
 
+  if(i->second.inAtlas)
+  {
+    d->removeFromAtlas(i->second);
+    changed();
+  }
+
   if(i->second.texture)
     i->second.texture->setTextureWrapS(i->second.textureWrapS);
 
@@ -478,6 +1224,12 @@ void TexturePool::setTextureWrapT(const TexturePoolKey& key, GLint textureWrapT)
 
   i->second.textureWrapT = textureWrapT;
 
+  if(i->second.inAtlas)
+  {
+    d->removeFromAtlas(i->second);
+    changed();
+  }
+
   if(i->second.texture)
     i->second.texture->setTextureWrapT(i->second.textureWrapT);
 
@@ -490,6 +1242,34 @@ void TexturePool::setTextureWrapT(const TexturePoolKey& key, GLint textureWrapT)
   }
 }
 
+//##################################################################################################
+size_t TexturePool::bytesSavedByDeduplication() const
+{
+  size_t bytes=0;
+
+  for(const auto& i : d->images)
+  {
+    if(!i.second.hasContentHash || i.second.texture)
+      continue;
+
+    if(auto owner = d->imageOwners.findOwner(i.second.contentHash); owner && *owner != i.first)
+      if(auto o = d->images.find(*owner); o != d->images.end() && o->second.texture)
+        bytes += o->second.image.size() * sizeof(TPPixel);
+  }
+
+  for(const auto& i : d->combinedImages)
+  {
+    if(!i.second.hasContentHash || i.second.texture || i.second.inAtlas)
+      continue;
+
+    if(auto owner = d->combinedOwners.findOwner(i.second.contentHash); owner && *owner != i.first)
+      if(auto o = d->combinedImages.find(*owner); o != d->combinedImages.end() && (o->second.texture || o->second.inAtlas))
+        bytes += o->second.rgbaImage.size() * sizeof(TPPixel);
+  }
+
+  return bytes;
+}
+
 //################################################################################################
 void TexturePool::viewImage(const tp_utils::StringID& name, const std::function<void(const tp_image_utils::ColorMap&)>& closure) const
 {
@@ -11,6 +11,9 @@ TexturePoolKey::TexturePoolKey()
   bIndex = 0;
   aIndex = 0;
 
+  nChannels = NChannels::RGBA;
+  usage = TextureUsage::Color;
+
   h = 0;
 }
 
@@ -24,7 +27,8 @@ TexturePoolKey::TexturePoolKey(const tp_utils::StringID& rName_,
                                size_t bIndex_,
                                size_t aIndex_,
                                TPPixel defaultColor_,
-                               NChannels nChannels_)
+                               NChannels nChannels_,
+                               TextureUsage usage_)
 {
   rName = rName_;
   gName = gName_;
@@ -40,6 +44,8 @@ TexturePoolKey::TexturePoolKey(const tp_utils::StringID& rName_,
 
   nChannels = nChannels_;
 
+  usage = usage_;
+
   h = makeHash();
 }
 
@@ -60,6 +66,8 @@ size_t TexturePoolKey::makeHash()
 
   h ^= std::hash<size_t>()(size_t(nChannels)) + 0x9e3779b9 + (h<<6) + (h>>2);
 
+  h ^= std::hash<size_t>()(size_t(usage)) + 0x9e3779b9 + (h<<6) + (h>>2);
+
   return h;
 }
 
@@ -80,6 +88,7 @@ std::string TexturePoolKey::debugString() const
 
   s += " defaultColor: " + defaultColor.toString();
   s += " nChannels: " + std::to_string(size_t(nChannels));
+  s += " usage: " + std::to_string(size_t(usage));
   s += " h: " + std::to_string(h);
 
   return s;
@@ -102,6 +111,8 @@ bool operator==(const TexturePoolKey& a, const TexturePoolKey& b)
 
   if(a.defaultColor!=b.defaultColor)return false;
 
+  if(a.usage!=b.usage)return false;
+
   return true;
 }
 
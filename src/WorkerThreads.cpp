@@ -0,0 +1,174 @@
+#include "tp_maps/WorkerThreads.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct WorkerThreads::Private
+{
+  TP_NONCOPYABLE(Private);
+  Private() = default;
+
+  std::vector<std::thread> threads;
+
+  struct Job
+  {
+    const void* owner;
+    std::function<void()> job;
+  };
+
+  std::mutex mutex;
+  std::condition_variable waitCondition;
+  std::condition_variable jobFinished;
+  std::deque<Job> jobs;
+  std::vector<const void*> runningOwners;
+  bool finish{false};
+
+  //################################################################################################
+  void run()
+  {
+    for(;;)
+    {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        waitCondition.wait(lock, [&]{return finish || !jobs.empty();});
+
+        if(finish)
+          return;
+
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        runningOwners.push_back(job.owner);
+      }
+
+      job.job();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        runningOwners.erase(std::find(runningOwners.begin(), runningOwners.end(), job.owner));
+      }
+      jobFinished.notify_all();
+    }
+  }
+};
+
+//##################################################################################################
+WorkerThreads::WorkerThreads(size_t nThreads):
+  d(new Private())
+{
+  if(nThreads==0)
+  {
+    size_t cores = std::thread::hardware_concurrency();
+    nThreads = (cores>1)?(cores-1):1;
+  }
+
+  d->threads.reserve(nThreads);
+  for(size_t i=0; i<nThreads; i++)
+    d->threads.emplace_back([&]{d->run();});
+}
+
+//##################################################################################################
+WorkerThreads::~WorkerThreads()
+{
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->finish = true;
+    d->jobs.clear();
+  }
+  d->waitCondition.notify_all();
+
+  for(auto& thread : d->threads)
+    thread.join();
+
+  delete d;
+}
+
+//##################################################################################################
+size_t WorkerThreads::nThreads() const
+{
+  return d->threads.size();
+}
+
+//##################################################################################################
+void WorkerThreads::addJob(const std::function<void()>& job)
+{
+  addJob(nullptr, job);
+}
+
+//##################################################################################################
+void WorkerThreads::addJob(const void* owner, const std::function<void()>& job)
+{
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->jobs.push_back({owner, job});
+  }
+  d->waitCondition.notify_one();
+}
+
+//##################################################################################################
+void WorkerThreads::cancelJobs(const void* owner)
+{
+  std::unique_lock<std::mutex> lock(d->mutex);
+
+  d->jobs.erase(std::remove_if(d->jobs.begin(), d->jobs.end(), [&](const auto& job)
+  {
+    return job.owner == owner;
+  }), d->jobs.end());
+
+  d->jobFinished.wait(lock, [&]{return !tpContains(d->runningOwners, owner);});
+}
+
+//##################################################################################################
+void WorkerThreads::parallelFor(size_t n, const std::function<void(size_t)>& closure)
+{
+  if(n==0)
+    return;
+
+  // Shared so that jobs that start after the loop has finished can safely find nothing to do.
+  struct State_lt
+  {
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+  };
+
+  auto state = std::make_shared<State_lt>();
+
+  auto work = [state, n, &closure]
+  {
+    for(size_t i=state->next++; i<n; i=state->next++)
+    {
+      closure(i);
+      if(++state->done == n)
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->finished.notify_all();
+      }
+    }
+  };
+
+  // The closure reference is only used while there are indexes left, and this function does not
+  // return until they have all been processed.
+  size_t nJobs = tpMin(nThreads(), n-1);
+  for(size_t j=0; j<nJobs; j++)
+    addJob(work);
+
+  work();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished.wait(lock, [&]{return state->done == n;});
+}
+
+}
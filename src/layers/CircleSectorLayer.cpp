@@ -97,6 +97,9 @@ void CircleSectorLayer::setDefaultRenderPass(const RenderPass& defaultRenderPass
   d->linesLayer->setDefaultRenderPass(defaultRenderPass);
   d->geometryLayer->setDefaultRenderPass(defaultRenderPass);
   Layer::setDefaultRenderPass(defaultRenderPass);
+
+  d->linesLayer->setAffectedRenderPasses(affectedRenderPasses());
+  d->geometryLayer->setAffectedRenderPasses(affectedRenderPasses());
 }
 
 //##################################################################################################
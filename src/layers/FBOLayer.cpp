@@ -141,6 +141,7 @@ FBOLayer::FBOLayer():
   d(new Private(this))
 {
   setDefaultRenderPass(RenderPass::GUI);
+  setAffectedRenderPasses({RenderPass::GUI});
 }
 
 //##################################################################################################
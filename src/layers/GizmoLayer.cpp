@@ -1535,18 +1535,31 @@ struct GizmoLayer::Private
     updateColors();
   }
 
+  //################################################################################################
+  //! Set the pass a layer draws in, layers that only draw after post processing only invalidate
+  //! the passes from there on when they change.
+  static void setRenderPass(Layer* layer, const RenderPass& defaultRenderPass)
+  {
+    if(defaultRenderPass.type == RenderPass::GUI3D || defaultRenderPass.type == RenderPass::GUI)
+      layer->setAffectedRenderPasses({defaultRenderPass.type});
+    else
+      layer->setAffectedRenderPasses({});
+
+    layer->setDefaultRenderPass(defaultRenderPass);
+  }
+
   //################################################################################################
   void setReferenceLinesRenderPass(const RenderPass& defaultRenderPass)
   {
-    translationArrowXLinesLayer->setDefaultRenderPass(defaultRenderPass);
-    translationArrowYLinesLayer->setDefaultRenderPass(defaultRenderPass);
-    translationArrowZLinesLayer->setDefaultRenderPass(defaultRenderPass);
+    setRenderPass(translationArrowXLinesLayer, defaultRenderPass);
+    setRenderPass(translationArrowYLinesLayer, defaultRenderPass);
+    setRenderPass(translationArrowZLinesLayer, defaultRenderPass);
 
-    translationPlaneXLinesLayer->setDefaultRenderPass(defaultRenderPass);
-    translationPlaneYLinesLayer->setDefaultRenderPass(defaultRenderPass);
-    translationPlaneZLinesLayer->setDefaultRenderPass(defaultRenderPass);
+    setRenderPass(translationPlaneXLinesLayer, defaultRenderPass);
+    setRenderPass(translationPlaneYLinesLayer, defaultRenderPass);
+    setRenderPass(translationPlaneZLinesLayer, defaultRenderPass);
 
-    translationPlaneScreenLinesLayer->setDefaultRenderPass(defaultRenderPass);
+    setRenderPass(translationPlaneScreenLinesLayer, defaultRenderPass);
   }
 
   //################################################################################################
@@ -1634,7 +1647,7 @@ GizmoLayer::GizmoLayer():
   auto createSectorLayer = [&](auto& l)
   {
     l = new CircleSectorLayer();
-    l->setDefaultRenderPass(RenderPass::GUI);
+    Private::setRenderPass(l, RenderPass::GUI);
     addChildLayer(l);
   };
 
@@ -1991,27 +2004,32 @@ void GizmoLayer::setDefaultRenderPass(const RenderPass& defaultRenderPass)
   else
     d->params.gizmoRenderPass = GizmoRenderPass::Normal;
 
-  d->rotationXGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->rotationYGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->rotationZGeometryLayer->setDefaultRenderPass(defaultRenderPass);
+  Private::setRenderPass(d->rotationXGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->rotationYGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->rotationZGeometryLayer, defaultRenderPass);
+
+  Private::setRenderPass(d->rotationScreenGeometryLayer, defaultRenderPass);
 
-  d->rotationScreenGeometryLayer->setDefaultRenderPass(defaultRenderPass);
+  Private::setRenderPass(d->translationArrowXGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->translationArrowYGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->translationArrowZGeometryLayer, defaultRenderPass);
 
-  d->translationArrowXGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->translationArrowYGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->translationArrowZGeometryLayer->setDefaultRenderPass(defaultRenderPass);
+  Private::setRenderPass(d->translationPlaneXGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->translationPlaneYGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->translationPlaneZGeometryLayer, defaultRenderPass);
 
-  d->translationPlaneXGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->translationPlaneYGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->translationPlaneZGeometryLayer->setDefaultRenderPass(defaultRenderPass);
+  Private::setRenderPass(d->translationPlaneScreenGeometryLayer, defaultRenderPass);
 
-  d->translationPlaneScreenGeometryLayer->setDefaultRenderPass(defaultRenderPass);
+  Private::setRenderPass(d->scaleArrowXGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->scaleArrowYGeometryLayer, defaultRenderPass);
+  Private::setRenderPass(d->scaleArrowZGeometryLayer, defaultRenderPass);
 
-  d->scaleArrowXGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->scaleArrowYGeometryLayer->setDefaultRenderPass(defaultRenderPass);
-  d->scaleArrowZGeometryLayer->setDefaultRenderPass(defaultRenderPass);
+  Private::setRenderPass(d->scaleArrowScreenGeometryLayer, defaultRenderPass);
 
-  d->scaleArrowScreenGeometryLayer->setDefaultRenderPass(defaultRenderPass);
+  if(defaultRenderPass.type == RenderPass::GUI3D)
+    setAffectedRenderPasses({RenderPass::GUI3D});
+  else
+    setAffectedRenderPasses({});
 
   Layer::setDefaultRenderPass(defaultRenderPass);
 }
@@ -14,6 +14,7 @@
 #include "glm/gtc/matrix_transform.hpp" // IWYU pragma: keep
 
 #include <vector>
+#include <memory>
 
 namespace tp_maps
 {
@@ -46,6 +47,7 @@ struct LightsLayer::Private
 
   FontRenderer* font{nullptr};
   std::vector<LabelDetails_lt> labels;  
+  std::unique_ptr<FontShader::Batch> labelBatch;
   std::string prefix;
 
   size_t clickIndex{0};
@@ -104,7 +106,7 @@ void LightsLayer::setFont(FontRenderer* font)
 {
   d->regenerateText = true;
   d->font = font;
-  update();
+  updateFromRenderPasses({RenderPass::Text});
 }
 
 //##################################################################################################
@@ -126,7 +128,7 @@ void LightsLayer::setPrefix(const std::string& prefix)
   {
     d->prefix = prefix;
     d->regenerateText = true;
-    update();
+    updateFromRenderPasses({RenderPass::Text});
   }
 }
 
@@ -241,6 +243,7 @@ void LightsLayer::render(RenderInfo& renderInfo)
 
       const auto& lights = map()->lights();
       d->labels.resize(lights.size());
+      d->labelBatch = std::make_unique<FontShader::Batch>(font());
       for(size_t l=0; l<lights.size(); l++)
       {
         const auto& light = lights.at(l);
@@ -251,6 +254,7 @@ void LightsLayer::render(RenderInfo& renderInfo)
 
         label.preparedString.reset(new tp_maps::FontShader::PreparedString(font(), tpFromUTF8(text), config));
         label.position = light.position();
+        d->labelBatch->addString(label.preparedString.get(), glm::vec3(0.0f));
       }
     }
 
@@ -263,8 +267,8 @@ void LightsLayer::render(RenderInfo& renderInfo)
 
     auto m = map()->controller()->matrix(tp_maps::defaultSID());
 
-    shader->use(renderInfo.shaderType());
-    shader->setColor({0.0f, 0.0f, 0.0f, 1.0f});
+    // All the labels are drawn in a single batch, labels that are behind the camera are hidden by
+    // making them transparent so that the layout of the batch does not change.
     for(size_t i=0; i<d->labels.size(); i++)
     {
       // if(d->lightIndex != i)
@@ -273,20 +277,32 @@ void LightsLayer::render(RenderInfo& renderInfo)
       const auto& label = d->labels.at(i);
 
       auto p = tpProj(m, label.position);
-      if(std::fabs(p.z)>1.0f)
-        continue;
+      float alpha = (std::fabs(p.z)>1.0f)?0.0f:1.0f;
 
       p.x = ((p.x+1.0f) / 2.0f) * width;
       p.y = (1.0f - ((p.y+1.0f) / 2.0f)) * height;
 
-      shader->setMatrix(glm::translate(matrix, glm::floor(glm::vec3(std::floor(p.x), std::floor(p.y), 0.0f))));
-      shader->drawPreparedString(*label.preparedString.get());
+      d->labelBatch->setString(i, label.preparedString.get(), glm::floor(glm::vec3(p.x, p.y, 0.0f)), {1.0f, 1.0f, 1.0f, alpha});
     }
+
+    shader->use(renderInfo.shaderType());
+    shader->setColor({0.0f, 0.0f, 0.0f, 1.0f});
+    shader->setMatrix(matrix);
+    shader->drawBatch(*d->labelBatch);
   }
 
   Layer::render(renderInfo);
 }
 
+//##################################################################################################
+void LightsLayer::invalidateBuffers()
+{
+  if(d->labelBatch)
+    d->labelBatch->invalidateBuffers();
+
+  Layer::invalidateBuffers();
+}
+
 //##################################################################################################
 bool LightsLayer::mouseEvent(const tp_maps::MouseEvent& event)
 {
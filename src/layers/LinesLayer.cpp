@@ -2,6 +2,7 @@
 #include "tp_maps/Map.h"
 #include "tp_maps/Controller.h"
 #include "tp_maps/shaders/LineShader.h"
+#include "tp_maps/shaders/WideLineShader.h"
 #include "tp_maps/picking_results/LinesPickingResult.h"
 
 #include "tp_math_utils/materials/OpenGLMaterial.h"
@@ -16,6 +17,34 @@ struct LinesDetails_lt
   glm::vec4 color;
   GLenum mode;
 };
+
+//##################################################################################################
+//! The range of the shared buffer reserved for a single entry in batched mode.
+struct BatchSlot_lt
+{
+  GLint first{0};
+  GLsizei capacity{0};
+};
+
+//##################################################################################################
+//! Round up to a power of two so that an entry can grow in place without rebuilding the buffer.
+GLsizei batchSlotCapacity_lt(size_t count)
+{
+  size_t capacity=2;
+  while(capacity<count)
+    capacity*=2;
+  return GLsizei(capacity);
+}
+
+//##################################################################################################
+//! Entries that share a color and mode, these are drawn with a single call.
+struct BatchGroup_lt
+{
+  glm::vec4 color;
+  GLenum mode;
+  std::vector<GLint> firsts;
+  std::vector<GLsizei> counts;
+};
 }
 
 //##################################################################################################
@@ -32,6 +61,23 @@ struct LinesLayer::Private
   std::vector<LinesDetails_lt> processedGeometry;
   float lineWidth{1.0f};
 
+  // Entries that have changed since the last upload, see setLine.
+  std::vector<size_t> dirtyLines;
+
+  // Used in batched mode instead of processedGeometry.
+  bool batched{false};
+  bool updateBatchGroups{true};
+  LineShader::VertexBuffer* batchVertexBuffer{nullptr};
+  std::vector<BatchSlot_lt> batchSlots;
+  std::vector<BatchGroup_lt> batchGroups;
+
+  // Used in wide line mode, the first segment and number of segments of each entry.
+  bool wideLines{false};
+  LineWidthUnits lineWidthUnits{LineWidthUnits::Pixels};
+  LineCap lineCap{LineCap::Butt};
+  WideLineShader::VertexBuffer* wideVertexBuffer{nullptr};
+  std::vector<std::pair<size_t, size_t>> wideRanges;
+
   //################################################################################################
   Private(Q* q_):
     q(q_)
@@ -52,6 +98,210 @@ struct LinesLayer::Private
       delete details.vertexBuffer;
 
     processedGeometry.clear();
+
+    delete batchVertexBuffer;
+    batchVertexBuffer=nullptr;
+    batchSlots.clear();
+    batchGroups.clear();
+    dirtyLines.clear();
+
+    delete wideVertexBuffer;
+    wideVertexBuffer=nullptr;
+    wideRanges.clear();
+  }
+
+  //################################################################################################
+  //! The number of segments WideLineShader::appendSegments will produce for an entry.
+  static size_t wideSegmentCount(const Lines& shape)
+  {
+    size_t n = shape.lines.size();
+    if(n<2)
+      return 0;
+
+    switch(shape.mode)
+    {
+    case GL_LINES:     return n/2;
+    case GL_LINE_LOOP: return n;
+    default:           return n-1;
+    }
+  }
+
+  //################################################################################################
+  void generateWideVertexBuffer(WideLineShader* shader)
+  {
+    deleteVertexBuffers();
+
+    size_t segmentCount=0;
+    for(const Lines& shape : lines)
+      segmentCount += wideSegmentCount(shape);
+
+    std::vector<WideLineShader::Segment> segments;
+    segments.reserve(segmentCount);
+    wideRanges.reserve(lines.size());
+    for(const Lines& shape : lines)
+    {
+      size_t first = segments.size();
+      WideLineShader::appendSegments(segments, shape.lines, shape.mode, shape.color);
+      wideRanges.emplace_back(first, segments.size()-first);
+    }
+
+    wideVertexBuffer = shader->generateVertexBuffer(q->map(), segments);
+  }
+
+  //################################################################################################
+  void updateDirtyWideLines(WideLineShader* shader)
+  {
+    std::vector<WideLineShader::Segment> segments;
+    for(auto i : dirtyLines)
+    {
+      const Lines& shape = lines.at(i);
+      segments.clear();
+      WideLineShader::appendSegments(segments, shape.lines, shape.mode, shape.color);
+      shader->updateVertexBuffer(wideVertexBuffer, segments, wideRanges.at(i).first);
+    }
+
+    dirtyLines.clear();
+  }
+
+  //################################################################################################
+  void generateVertexBuffers(LineShader* shader)
+  {
+    deleteVertexBuffers();
+
+    if(!batched)
+    {
+      for(const Lines& shape : lines)
+      {
+        LinesDetails_lt& details = processedGeometry.emplace_back();
+        details.vertexBuffer = shader->generateVertexBuffer(q->map(), shape.lines);
+        details.color = shape.color;
+        details.mode = shape.mode;
+      }
+      return;
+    }
+
+    size_t vertexCount=0;
+    for(const Lines& shape : lines)
+      vertexCount += size_t(batchSlotCapacity_lt(shape.lines.size()));
+
+    std::vector<glm::vec3> vertices;
+    vertices.reserve(vertexCount);
+    batchSlots.reserve(lines.size());
+    for(const Lines& shape : lines)
+    {
+      auto& slot = batchSlots.emplace_back();
+      slot.first = GLint(vertices.size());
+      slot.capacity = batchSlotCapacity_lt(shape.lines.size());
+      vertices.insert(vertices.end(), shape.lines.begin(), shape.lines.end());
+      vertices.resize(size_t(slot.first)+size_t(slot.capacity));
+    }
+
+    batchVertexBuffer = shader->generateArrayBuffer(q->map(), vertices);
+    updateBatchGroups = true;
+  }
+
+  //################################################################################################
+  //! Upload just the entries that have changed.
+  void updateDirtyLines(LineShader* shader)
+  {
+    for(auto i : dirtyLines)
+    {
+      const Lines& shape = lines.at(i);
+
+      if(batched)
+      {
+        shader->updateVertexBuffer(batchVertexBuffer, shape.lines, size_t(batchSlots.at(i).first));
+        continue;
+      }
+
+      LinesDetails_lt& details = processedGeometry.at(i);
+      delete details.vertexBuffer;
+      details.vertexBuffer = shader->generateVertexBuffer(q->map(), shape.lines);
+      details.color = shape.color;
+      details.mode = shape.mode;
+    }
+
+    dirtyLines.clear();
+  }
+
+  //################################################################################################
+  void renderWideLines(RenderInfo& renderInfo)
+  {
+    auto shader = q->map()->getShader<WideLineShader>();
+    if(shader->error())
+      return;
+
+    if(updateVertexBuffer)
+    {
+      generateWideVertexBuffer(shader);
+      updateVertexBuffer=false;
+    }
+    else if(!dirtyLines.empty())
+      updateDirtyWideLines(shader);
+
+    shader->use(renderInfo.shaderType());
+    shader->setMatrix(q->calculateMatrix());
+    shader->setScreenSize(q->map()->screenSize());
+    shader->setLineCap(lineCap);
+
+    if(lineWidthUnits == LineWidthUnits::World)
+      shader->setWorldLineWidth(lineWidth, q->map()->controller()->matrices(q->coordinateSystem()).p);
+    else
+      shader->setLineWidth(lineWidth);
+
+    if(renderInfo.pass==RenderPass::Picking)
+    {
+      for(size_t i=0; i<wideRanges.size(); i++)
+      {
+        const auto& range = wideRanges.at(i);
+        if(range.second==0)
+          continue;
+
+        auto pickingID = renderInfo.pickingIDMat(PickingDetails(0, [&, i](const PickingResult& r) -> PickingResult*
+        {
+          return new LinesPickingResult(r.pickingType, r.details, r.renderInfo, q, i);
+        }));
+
+        shader->drawLinesPicking(wideVertexBuffer, pickingID, range.first, range.second);
+      }
+    }
+    else
+      shader->drawLines(wideVertexBuffer);
+  }
+
+  //################################################################################################
+  void generateBatchGroups()
+  {
+    batchGroups.clear();
+    updateBatchGroups = false;
+
+    for(size_t i=0; i<lines.size(); i++)
+    {
+      const Lines& shape = lines.at(i);
+      if(shape.lines.size()<2)
+        continue;
+
+      // There are normally only a handful of colors so a linear search is fine here.
+      BatchGroup_lt* group=nullptr;
+      for(auto& g : batchGroups)
+      {
+        if(g.mode == shape.mode && g.color == shape.color)
+        {
+          group = &g;
+          break;
+        }
+      }
+
+      if(!group)
+      {
+        group = &batchGroups.emplace_back();
+        group->color = shape.color;
+        group->mode = shape.mode;
+      }
+
+      group->firsts.push_back(batchSlots.at(i).first);
+      group->counts.push_back(GLsizei(shape.lines.size()));
+    }
   }
 };
 
@@ -90,6 +340,98 @@ void LinesLayer::updateLines(const std::function<void(std::vector<Lines>&)>& clo
   update();
 }
 
+//##################################################################################################
+void LinesLayer::setLine(size_t index, const Lines& line)
+{
+  if(index>=d->lines.size())
+  {
+    d->lines.resize(index+1);
+    d->updateVertexBuffer = true;
+  }
+
+  d->lines.at(index) = line;
+
+  if(!d->updateVertexBuffer)
+  {
+    if(d->wideLines)
+    {
+      if(Private::wideSegmentCount(line) == d->wideRanges.at(index).second)
+        d->dirtyLines.push_back(index);
+      else
+        d->updateVertexBuffer = true;
+    }
+    else if(d->batched && GLsizei(line.lines.size())>d->batchSlots.at(index).capacity)
+      d->updateVertexBuffer = true;
+    else
+    {
+      d->dirtyLines.push_back(index);
+      d->updateBatchGroups = true;
+    }
+  }
+
+  update();
+}
+
+//##################################################################################################
+void LinesLayer::setBatched(bool batched)
+{
+  if(d->batched == batched)
+    return;
+
+  d->batched = batched;
+  d->updateVertexBuffer = true;
+  update();
+}
+
+//##################################################################################################
+bool LinesLayer::batched() const
+{
+  return d->batched;
+}
+
+//##################################################################################################
+void LinesLayer::setWideLines(bool wideLines)
+{
+  if(d->wideLines == wideLines)
+    return;
+
+  d->wideLines = wideLines;
+  d->updateVertexBuffer = true;
+  update();
+}
+
+//##################################################################################################
+bool LinesLayer::wideLines() const
+{
+  return d->wideLines;
+}
+
+//##################################################################################################
+void LinesLayer::setLineWidthUnits(LineWidthUnits lineWidthUnits)
+{
+  d->lineWidthUnits = lineWidthUnits;
+  update();
+}
+
+//##################################################################################################
+LineWidthUnits LinesLayer::lineWidthUnits() const
+{
+  return d->lineWidthUnits;
+}
+
+//##################################################################################################
+void LinesLayer::setLineCap(LineCap lineCap)
+{
+  d->lineCap = lineCap;
+  update();
+}
+
+//##################################################################################################
+LineCap LinesLayer::lineCap() const
+{
+  return d->lineCap;
+}
+
 //##################################################################################################
 void LinesLayer::setLinesFromGeometry(const std::vector<tp_math_utils::Geometry3D>& geometry)
 {
@@ -290,29 +632,61 @@ void LinesLayer::render(RenderInfo& renderInfo)
      renderInfo.pass != RenderPass::Picking)
     return;
 
+  if(d->wideLines)
+  {
+    d->renderWideLines(renderInfo);
+    return;
+  }
+
   auto shader = map()->getShader<LineShader>();
   if(shader->error())
     return;
 
   if(d->updateVertexBuffer)
   {
-    d->deleteVertexBuffers();
+    d->generateVertexBuffers(shader);
     d->updateVertexBuffer=false;
-
-    for(const Lines& shape : d->lines)
-    {
-      LinesDetails_lt& details = d->processedGeometry.emplace_back();
-      details.vertexBuffer = shader->generateVertexBuffer(map(), shape.lines);
-      details.color = shape.color;
-      details.mode = shape.mode;
-    }
   }
+  else if(!d->dirtyLines.empty())
+    d->updateDirtyLines(shader);
+
+  if(d->batched && d->updateBatchGroups)
+    d->generateBatchGroups();
 
   shader->use(renderInfo.shaderType());
   shader->setMatrix(calculateMatrix());
   shader->setLineWidth(d->lineWidth);
 
-  if(renderInfo.pass==RenderPass::Picking)
+  if(d->batched)
+  {
+    if(renderInfo.pass==RenderPass::Picking)
+    {
+      // Each entry needs its own picking color so these are drawn one at a time.
+      for(size_t i=0; i<d->lines.size(); i++)
+      {
+        const Lines& shape = d->lines.at(i);
+        if(shape.lines.size()<2)
+          continue;
+
+        auto pickingID = renderInfo.pickingIDMat(PickingDetails(0, [&, i](const PickingResult& r) -> PickingResult*
+        {
+          return new LinesPickingResult(r.pickingType, r.details, r.renderInfo, this, i);
+        }));
+
+        shader->setColor(pickingID);
+        shader->drawLines(shape.mode, d->batchVertexBuffer, {d->batchSlots.at(i).first}, {GLsizei(shape.lines.size())});
+      }
+    }
+    else
+    {
+      for(const BatchGroup_lt& group : d->batchGroups)
+      {
+        shader->setColor(group.color);
+        shader->drawLines(group.mode, d->batchVertexBuffer, group.firsts, group.counts);
+      }
+    }
+  }
+  else if(renderInfo.pass==RenderPass::Picking)
   {
     size_t i=0;
     for(const LinesDetails_lt& line : d->processedGeometry)
@@ -0,0 +1,881 @@
+#include "tp_maps/layers/PointCloudLayer.h"
+
+#include "tp_maps/Map.h"
+#include "tp_maps/Controller.h"
+#include "tp_maps/Texture.h"
+#include "tp_maps/WorkerThreads.h"
+#include "tp_maps/shaders/PointSpriteShader.h"
+#include "tp_maps/picking_results/PointCloudPickingResult.h"
+
+#include "tp_utils/DebugUtils.h"
+#include "tp_utils/TimeUtils.h"
+
+#include <fstream>
+#include <functional>
+#include <cmath>
+#include <queue>
+#include <mutex>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <unordered_set>
+
+namespace tp_maps
+{
+
+namespace
+{
+static_assert(sizeof(PointCloudPoint)==16, "PointCloudPoint is read and written as 16 bytes.");
+
+const uint32_t hierarchyMagic=0x43505054; // "TPPC"
+const uint32_t hierarchyVersion=1;
+
+// Nodes this deep keep all of their points, this stops coincident points from recursing forever.
+const size_t maxDepth=20;
+
+// Kept low so that the nodes with the highest priority are read first when the view changes.
+const size_t maxPendingLoads=4;
+
+//##################################################################################################
+struct NodeRecord_lt
+{
+  glm::vec3 min{0.0f};
+  glm::vec3 max{0.0f};
+  uint64_t pointCount{0};
+  uint8_t childMask{0};
+};
+
+//##################################################################################################
+struct Node_lt
+{
+  std::string name;
+  glm::vec3 min{0.0f};
+  glm::vec3 max{0.0f};
+  size_t pointCount{0};
+  std::vector<size_t> children;
+
+  bool loading{false};
+  bool failed{false};
+  uint64_t lastUsedFrame{0};
+
+  // Also kept after upload so that picking results can return the point.
+  std::shared_ptr<const std::vector<PointCloudPoint>> points;
+
+  PointSpriteShader::VertexBuffer* vertexBuffer{nullptr};
+};
+
+//##################################################################################################
+struct CompletedLoad_lt
+{
+  uint64_t generation{0};
+  size_t index{0};
+  std::shared_ptr<const std::vector<PointCloudPoint>> points;
+};
+
+//##################################################################################################
+std::string hierarchyPath(const std::string& directory)
+{
+  return directory + "/hierarchy.bin";
+}
+
+//##################################################################################################
+std::string nodePath(const std::string& directory, const std::string& name)
+{
+  return directory + "/" + name + ".bin";
+}
+
+//##################################################################################################
+bool readPoints(const std::string& path, size_t pointCount, std::vector<PointCloudPoint>& points)
+{
+  std::ifstream in(path, std::ios::binary);
+  if(!in)
+    return false;
+
+  points.resize(pointCount);
+  in.read(reinterpret_cast<char*>(points.data()), std::streamsize(pointCount*sizeof(PointCloudPoint)));
+  return bool(in);
+}
+
+//##################################################################################################
+glm::vec4 matrixRow(const glm::mat4& m, int r)
+{
+  return {m[0][r], m[1][r], m[2][r], m[3][r]};
+}
+
+//##################################################################################################
+struct TileWriter_lt
+{
+  const std::vector<PointCloudPoint>& points;
+  const std::string& directory;
+  size_t maxPointsPerNode;
+
+  // Lidar scans are mostly surfaces so the grid is sized for a 2D sample to fill each node.
+  size_t gridSize;
+
+  std::vector<NodeRecord_lt> records;
+  bool ok{true};
+
+  //################################################################################################
+  TileWriter_lt(const std::vector<PointCloudPoint>& points_,
+                const std::string& directory_,
+                size_t maxPointsPerNode_):
+    points(points_),
+    directory(directory_),
+    maxPointsPerNode(maxPointsPerNode_),
+    gridSize(tpMax(size_t(2), size_t(std::ceil(std::sqrt(double(maxPointsPerNode_))))))
+  {
+
+  }
+
+  //################################################################################################
+  void writeNode(const std::string& name,
+                 const glm::vec3& min,
+                 const glm::vec3& max,
+                 std::vector<uint32_t>& indexes,
+                 size_t depth)
+  {
+    std::vector<uint32_t> nodeIndexes;
+    std::array<std::vector<uint32_t>, 8> childIndexes;
+
+    if(indexes.size()<=maxPointsPerNode || depth>=maxDepth)
+      nodeIndexes.swap(indexes);
+    else
+    {
+      // Keep the first point in each grid cell, the rest are passed down to the children.
+      glm::vec3 center = (min+max)*0.5f;
+      glm::vec3 scale = float(gridSize) / (max-min);
+      glm::vec3 maxCell(float(gridSize-1));
+
+      std::unordered_set<uint64_t> occupied;
+      occupied.reserve(maxPointsPerNode);
+      nodeIndexes.reserve(maxPointsPerNode);
+
+      for(auto i : indexes)
+      {
+        const auto& p = points[i].position;
+
+        if(nodeIndexes.size()<maxPointsPerNode)
+        {
+          glm::vec3 c = glm::clamp((p-min)*scale, glm::vec3(0.0f), maxCell);
+          uint64_t cell = (uint64_t(c.x)*gridSize + uint64_t(c.y))*gridSize + uint64_t(c.z);
+          if(occupied.insert(cell).second)
+          {
+            nodeIndexes.push_back(i);
+            continue;
+          }
+        }
+
+        size_t child = (p.x>=center.x?4:0) | (p.y>=center.y?2:0) | (p.z>=center.z?1:0);
+        childIndexes[child].push_back(i);
+      }
+
+      indexes = std::vector<uint32_t>();
+    }
+
+    {
+      std::ofstream out(nodePath(directory, name), std::ios::binary | std::ios::trunc);
+      for(auto i : nodeIndexes)
+        out.write(reinterpret_cast<const char*>(&points[i]), sizeof(PointCloudPoint));
+
+      if(!out)
+      {
+        tpWarning() << "Failed to write point cloud node: " << nodePath(directory, name);
+        ok = false;
+      }
+    }
+
+    size_t r = records.size();
+    auto& record = records.emplace_back();
+    record.min = min;
+    record.max = max;
+    record.pointCount = nodeIndexes.size();
+    for(size_t c=0; c<8; c++)
+      if(!childIndexes.at(c).empty())
+        record.childMask |= uint8_t(1<<c);
+
+    nodeIndexes = std::vector<uint32_t>();
+
+    // Records are written depth first so that the children follow their parent.
+    glm::vec3 half = (max-min)*0.5f;
+    for(size_t c=0; c<8 && ok; c++)
+    {
+      if(!(records.at(r).childMask & (1<<c)))
+        continue;
+
+      glm::vec3 childMin = min + half*glm::vec3((c&4)?1.0f:0.0f, (c&2)?1.0f:0.0f, (c&1)?1.0f:0.0f);
+      writeNode(name + char('0'+c), childMin, childMin+half, childIndexes.at(c), depth+1);
+    }
+  }
+};
+}
+
+//##################################################################################################
+struct PointCloudLayer::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_maps::PointCloudLayer::Private");
+  TP_NONCOPYABLE(Private);
+
+  Q* q;
+
+  SpriteTexture* spriteTexture;
+
+  std::string directory;
+  std::vector<Node_lt> nodes;
+
+  size_t pointBudget{2000000};
+  size_t maxLoadedPoints{8000000};
+  float pointRadius{1.0f};
+  float minNodeSize{100.0f};
+
+  size_t loadedPointCount{0};
+  size_t renderedPointCount{0};
+  size_t pendingLoads{0};
+
+  // Incremented each frame to find the least recently used nodes.
+  uint64_t frame{0};
+
+  // Incremented by open and close so that loads for a previous directory are ignored.
+  uint64_t generation{0};
+
+  // The loaded nodes that were selected in the last frame.
+  std::vector<size_t> renderNodes;
+
+  GLuint textureID{0};
+
+  bool bindBeforeRender{true};
+  bool updateVertexBuffers{false};
+
+  // Nodes read by the worker threads, these are applied on the render thread in animate.
+  std::mutex completedLoadsMutex;
+  std::vector<CompletedLoad_lt> completedLoads;
+
+  // The map's shared threads, set when the first node is loaded.
+  WorkerThreads* workerThreads{nullptr};
+
+  //################################################################################################
+  Private(Q* q_, SpriteTexture* spriteTexture_):
+    q(q_),
+    spriteTexture(spriteTexture_)
+  {
+
+  }
+
+  //################################################################################################
+  ~Private()
+  {
+    if(workerThreads)
+      workerThreads->cancelJobs(this);
+
+    if(textureID)
+    {
+      q->map()->makeCurrent();
+      q->map()->deleteTexture(textureID);
+    }
+
+    delete spriteTexture;
+    deleteVertexBuffers();
+  }
+
+  //################################################################################################
+  void deleteVertexBuffers()
+  {
+    for(auto& node : nodes)
+    {
+      delete node.vertexBuffer;
+      node.vertexBuffer=nullptr;
+    }
+  }
+
+  //################################################################################################
+  void unloadNode(Node_lt& node)
+  {
+    delete node.vertexBuffer;
+    node.vertexBuffer=nullptr;
+
+    if(node.points)
+    {
+      node.points.reset();
+      loadedPointCount -= node.pointCount;
+    }
+  }
+
+  //################################################################################################
+  void clear()
+  {
+    generation++;
+    for(auto& node : nodes)
+      unloadNode(node);
+
+    nodes.clear();
+    renderNodes.clear();
+    directory.clear();
+    pendingLoads=0;
+    loadedPointCount=0;
+    renderedPointCount=0;
+  }
+
+  //################################################################################################
+  bool readHierarchy(const std::string& path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if(!in)
+      return false;
+
+    auto read = [&](auto& value)
+    {
+      in.read(reinterpret_cast<char*>(&value), sizeof(value));
+      return bool(in);
+    };
+
+    uint32_t magic=0;
+    uint32_t version=0;
+    uint32_t nodeCount=0;
+    if(!read(magic) || !read(version) || !read(nodeCount))
+      return false;
+
+    if(magic != hierarchyMagic || version != hierarchyVersion || nodeCount==0)
+      return false;
+
+    // Check that the file is big enough before trusting nodeCount with an allocation.
+    {
+      constexpr uint64_t recordSize = sizeof(float)*6 + sizeof(uint64_t) + sizeof(uint8_t);
+      auto headerEnd = in.tellg();
+      in.seekg(0, std::ios::end);
+      auto fileEnd = in.tellg();
+      in.seekg(headerEnd);
+      if(!in || fileEnd<headerEnd || uint64_t(fileEnd-headerEnd) < uint64_t(nodeCount)*recordSize)
+        return false;
+    }
+
+    std::vector<NodeRecord_lt> records(nodeCount);
+    for(auto& record : records)
+    {
+      if(!read(record.min.x) || !read(record.min.y) || !read(record.min.z) ||
+         !read(record.max.x) || !read(record.max.y) || !read(record.max.z) ||
+         !read(record.pointCount) || !read(record.childMask))
+        return false;
+    }
+
+    // Rebuild the tree from the depth first order that the records were written in.
+    nodes.resize(records.size());
+    size_t next=0;
+    std::function<bool(const std::string&, size_t)> addNode = [&](const std::string& name, size_t depth)
+    {
+      if(next>=records.size() || depth>maxDepth)
+        return false;
+
+      size_t index = next++;
+      const auto& record = records.at(index);
+      nodes.at(index).name = name;
+      nodes.at(index).min = record.min;
+      nodes.at(index).max = record.max;
+      nodes.at(index).pointCount = size_t(record.pointCount);
+
+      for(size_t c=0; c<8; c++)
+      {
+        if(!(record.childMask & (1<<c)))
+          continue;
+
+        nodes.at(index).children.push_back(next);
+        if(!addNode(name + char('0'+c), depth+1))
+          return false;
+      }
+
+      return true;
+    };
+
+    if(!addNode("r", 0) || next!=records.size())
+    {
+      nodes.clear();
+      return false;
+    }
+
+    return true;
+  }
+
+  //################################################################################################
+  //! Returns the radius of a node in pixels, or a negative number if it is outside the frustum.
+  float projectedSize(const Node_lt& node,
+                      const std::array<glm::vec4, 6>& planes,
+                      const glm::mat4& mv,
+                      const glm::mat4& p,
+                      float height) const
+  {
+    for(const auto& plane : planes)
+    {
+      glm::vec3 n(plane);
+      glm::vec3 v(n.x>=0.0f?node.max.x:node.min.x,
+                  n.y>=0.0f?node.max.y:node.min.y,
+                  n.z>=0.0f?node.max.z:node.min.z);
+      if(glm::dot(n, v) + plane.w < 0.0f)
+        return -1.0f;
+    }
+
+    float scale = tpMax(glm::length(glm::vec3(mv[0])), tpMax(glm::length(glm::vec3(mv[1])), glm::length(glm::vec3(mv[2]))));
+    float radius = glm::length(node.max-node.min) * 0.5f * scale;
+    float pixels = radius * p[1][1] * height * 0.5f;
+
+    // Orthographic projections don't shrink with distance.
+    if(std::fabs(p[2][3])<0.0001f)
+      return pixels;
+
+    glm::vec3 center = mv * glm::vec4((node.min+node.max)*0.5f, 1.0f);
+    float distance = glm::length(center);
+    if(distance<=radius)
+      return std::numeric_limits<float>::max();
+
+    return pixels / distance;
+  }
+
+  //################################################################################################
+  //! Choose the nodes to draw this frame, request the ones that are missing and unload old ones.
+  void selectNodes(const glm::mat4& mvp, const glm::mat4& mv, const glm::mat4& p, float height)
+  {
+    frame++;
+    renderNodes.clear();
+
+    std::array<glm::vec4, 6> planes;
+    {
+      glm::vec4 r0 = matrixRow(mvp, 0);
+      glm::vec4 r1 = matrixRow(mvp, 1);
+      glm::vec4 r2 = matrixRow(mvp, 2);
+      glm::vec4 r3 = matrixRow(mvp, 3);
+      planes = {r3+r0, r3-r0, r3+r1, r3-r1, r3+r2, r3-r2};
+    }
+
+    std::vector<size_t> loadRequests;
+    std::priority_queue<std::pair<float, size_t>> queue;
+
+    // The root is always drawn when it is visible so that distant clouds don't disappear.
+    if(projectedSize(nodes.front(), planes, mv, p, height)>=0.0f)
+      queue.emplace(std::numeric_limits<float>::max(), 0);
+
+    size_t selectedPoints=0;
+    while(!queue.empty())
+    {
+      size_t i = queue.top().second;
+      queue.pop();
+
+      auto& node = nodes.at(i);
+      if(selectedPoints+node.pointCount > pointBudget && selectedPoints>0)
+        break;
+
+      selectedPoints += node.pointCount;
+
+      if(node.points)
+      {
+        node.lastUsedFrame = frame;
+        renderNodes.push_back(i);
+      }
+      else if(!node.loading && !node.failed)
+        loadRequests.push_back(i);
+
+      for(auto c : node.children)
+      {
+        float size = projectedSize(nodes.at(c), planes, mv, p, height);
+        if(size>=minNodeSize)
+          queue.emplace(size, c);
+      }
+    }
+
+    // Requests are in priority order.
+    for(auto i : loadRequests)
+    {
+      if(pendingLoads>=maxPendingLoads)
+        break;
+      loadNode(i);
+    }
+
+    unloadLeastRecentlyUsed();
+  }
+
+  //################################################################################################
+  void loadNode(size_t index)
+  {
+    auto& node = nodes.at(index);
+    node.loading = true;
+    pendingLoads++;
+
+    if(!workerThreads)
+      workerThreads = &q->map()->workerThreads();
+
+    workerThreads->addJob(this, [this,
+                                index,
+                                path = nodePath(directory, node.name),
+                                pointCount = node.pointCount,
+                                generation = generation]
+    {
+      auto points = std::make_shared<std::vector<PointCloudPoint>>();
+      if(!readPoints(path, pointCount, *points))
+      {
+        tpWarning() << "Failed to read point cloud node: " << path;
+        points.reset();
+      }
+
+      std::lock_guard<std::mutex> lock(completedLoadsMutex);
+      completedLoads.push_back({generation, index, std::move(points)});
+    });
+  }
+
+  //################################################################################################
+  void applyCompletedLoads()
+  {
+    std::vector<CompletedLoad_lt> completed;
+    {
+      std::lock_guard<std::mutex> lock(completedLoadsMutex);
+      completed.swap(completedLoads);
+    }
+
+    bool changed=false;
+    for(auto& load : completed)
+    {
+      if(load.generation != generation)
+        continue;
+
+      auto& node = nodes.at(load.index);
+      node.loading = false;
+      pendingLoads--;
+
+      if(load.points)
+      {
+        node.points = std::move(load.points);
+        loadedPointCount += node.pointCount;
+        changed = true;
+      }
+      else
+        node.failed = true;
+    }
+
+    if(changed)
+      q->update();
+  }
+
+  //################################################################################################
+  void unloadLeastRecentlyUsed()
+  {
+    if(loadedPointCount<=maxLoadedPoints)
+      return;
+
+    std::vector<size_t> candidates;
+    for(size_t i=0; i<nodes.size(); i++)
+      if(nodes.at(i).points && nodes.at(i).lastUsedFrame!=frame)
+        candidates.push_back(i);
+
+    std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b)
+    {
+      return nodes.at(a).lastUsedFrame < nodes.at(b).lastUsedFrame;
+    });
+
+    for(auto i : candidates)
+    {
+      if(loadedPointCount<=maxLoadedPoints)
+        break;
+      unloadNode(nodes.at(i));
+    }
+  }
+
+  //################################################################################################
+  void generateVertexBuffer(PointSpriteShader* shader, Node_lt& node)
+  {
+    std::vector<PointSpriteShader::PointSprite> sprites;
+    sprites.reserve(node.points->size());
+    for(const auto& point : *node.points)
+    {
+      const auto& c = point.color;
+      glm::vec4 color(float(c.r)/255.0f, float(c.g)/255.0f, float(c.b)/255.0f, float(c.a)/255.0f);
+      sprites.emplace_back(color, point.position, 0, pointRadius);
+    }
+
+    node.vertexBuffer = shader->generateVertexBuffer(q->map(), sprites, spriteTexture->coords());
+  }
+};
+
+//##################################################################################################
+PointCloudLayer::PointCloudLayer(SpriteTexture* spriteTexture):
+  d(new Private(this, spriteTexture))
+{
+  spriteTexture->texture()->setImageChangedCallback([this]()
+  {
+    d->bindBeforeRender = true;
+    update();
+  });
+
+  spriteTexture->setCoordsChangedCallback([this]()
+  {
+    d->updateVertexBuffers = true;
+    update();
+  });
+}
+
+//##################################################################################################
+PointCloudLayer::~PointCloudLayer()
+{
+  delete d;
+}
+
+//##################################################################################################
+bool PointCloudLayer::open(const std::string& directory)
+{
+  d->clear();
+
+  if(!d->readHierarchy(hierarchyPath(directory)))
+  {
+    tpWarning() << "Failed to read point cloud hierarchy: " << hierarchyPath(directory);
+    return false;
+  }
+
+  d->directory = directory;
+  update();
+  return true;
+}
+
+//##################################################################################################
+void PointCloudLayer::close()
+{
+  d->clear();
+  update();
+}
+
+//##################################################################################################
+const std::string& PointCloudLayer::directory() const
+{
+  return d->directory;
+}
+
+//##################################################################################################
+bool PointCloudLayer::writeTiles(const std::vector<PointCloudPoint>& points,
+                                 const std::string& directory,
+                                 size_t maxPointsPerNode)
+{
+  TP_FUNCTION_TIME("PointCloudLayer::writeTiles");
+
+  if(points.empty() || maxPointsPerNode==0 || points.size()>std::numeric_limits<uint32_t>::max())
+    return false;
+
+  glm::vec3 min = points.front().position;
+  glm::vec3 max = min;
+  for(const auto& point : points)
+  {
+    min = glm::min(min, point.position);
+    max = glm::max(max, point.position);
+  }
+
+  // The octree is built from cubes so that nodes at the same depth have the same spacing.
+  glm::vec3 size = max-min;
+  float side = tpMax(tpMax(size.x, size.y), tpMax(size.z, 0.001f));
+  max = min + glm::vec3(side);
+
+  std::vector<uint32_t> indexes(points.size());
+  std::iota(indexes.begin(), indexes.end(), 0);
+
+  TileWriter_lt writer(points, directory, maxPointsPerNode);
+  writer.writeNode("r", min, max, indexes, 0);
+  if(!writer.ok)
+    return false;
+
+  std::ofstream out(hierarchyPath(directory), std::ios::binary | std::ios::trunc);
+  if(!out)
+    return false;
+
+  auto write = [&](auto value)
+  {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+
+  write(hierarchyMagic);
+  write(hierarchyVersion);
+  write(uint32_t(writer.records.size()));
+  for(const auto& record : writer.records)
+  {
+    write(record.min.x);
+    write(record.min.y);
+    write(record.min.z);
+    write(record.max.x);
+    write(record.max.y);
+    write(record.max.z);
+    write(record.pointCount);
+    write(record.childMask);
+  }
+
+  return bool(out);
+}
+
+//##################################################################################################
+void PointCloudLayer::setPointBudget(size_t pointBudget)
+{
+  d->pointBudget = pointBudget;
+  update();
+}
+
+//##################################################################################################
+size_t PointCloudLayer::pointBudget() const
+{
+  return d->pointBudget;
+}
+
+//##################################################################################################
+void PointCloudLayer::setMaxLoadedPoints(size_t maxLoadedPoints)
+{
+  d->maxLoadedPoints = maxLoadedPoints;
+  update();
+}
+
+//##################################################################################################
+size_t PointCloudLayer::maxLoadedPoints() const
+{
+  return d->maxLoadedPoints;
+}
+
+//##################################################################################################
+void PointCloudLayer::setPointRadius(float pointRadius)
+{
+  d->pointRadius = pointRadius;
+  d->updateVertexBuffers = true;
+  update();
+}
+
+//##################################################################################################
+float PointCloudLayer::pointRadius() const
+{
+  return d->pointRadius;
+}
+
+//##################################################################################################
+void PointCloudLayer::setMinNodeSize(float minNodeSize)
+{
+  d->minNodeSize = minNodeSize;
+  update();
+}
+
+//##################################################################################################
+float PointCloudLayer::minNodeSize() const
+{
+  return d->minNodeSize;
+}
+
+//##################################################################################################
+size_t PointCloudLayer::nodeCount() const
+{
+  return d->nodes.size();
+}
+
+//##################################################################################################
+size_t PointCloudLayer::loadedPointCount() const
+{
+  return d->loadedPointCount;
+}
+
+//##################################################################################################
+size_t PointCloudLayer::renderedPointCount() const
+{
+  return d->renderedPointCount;
+}
+
+//##################################################################################################
+glm::mat4 PointCloudLayer::calculateMatrix() const
+{
+  return map()->controller()->matrix(coordinateSystem()) * modelToWorldMatrix();
+}
+
+//##################################################################################################
+void PointCloudLayer::render(RenderInfo& renderInfo)
+{
+  if(d->nodes.empty())
+    return;
+
+  if(!d->spriteTexture->texture()->imageReady())
+    return;
+
+  if(renderInfo.pass != defaultRenderPass().type &&
+     renderInfo.pass != RenderPass::Picking)
+    return;
+
+  auto shader = map()->getShader<PointSpriteShader>();
+  if(shader->error())
+    return;
+
+  if(d->bindBeforeRender)
+  {
+    map()->deleteTexture(d->textureID);
+    d->textureID = d->spriteTexture->texture()->bindTexture();
+    d->bindBeforeRender=false;
+  }
+
+  if(!d->textureID)
+    return;
+
+  if(d->updateVertexBuffers)
+  {
+    d->deleteVertexBuffers();
+    d->updateVertexBuffers=false;
+  }
+
+  glm::mat4 matrix = calculateMatrix();
+
+  // Picking uses the nodes selected for the last frame so that the IDs match what was drawn.
+  if(renderInfo.pass != RenderPass::Picking)
+  {
+    auto matrices = map()->controller()->matrices(coordinateSystem());
+    d->selectNodes(matrix, matrices.v * modelToWorldMatrix(), matrices.p, float(map()->height()));
+  }
+
+  shader->use(renderInfo.shaderType());
+  shader->setMatrix(matrix);
+  shader->setScreenSize(map()->screenSize());
+  shader->setTexture(d->textureID);
+
+  map()->controller()->enableScissor(coordinateSystem());
+
+  size_t renderedPointCount=0;
+  for(auto i : d->renderNodes)
+  {
+    auto& node = d->nodes.at(i);
+    if(!node.points)
+      continue;
+
+    if(!node.vertexBuffer)
+      d->generateVertexBuffer(shader, node);
+
+    if(renderInfo.pass==RenderPass::Picking)
+    {
+      // Each node has its own range of IDs so the index in the callback is local to the node.
+      auto pickingID = renderInfo.pickingID(PickingDetails(0, [this, name=node.name, points=node.points](const PickingResult& r) -> PickingResult*
+      {
+        if(r.details.index<points->size() && r.renderInfo.map)
+          return new PointCloudPickingResult(r.pickingType, r.details, r.renderInfo, this, name, r.details.index, points->at(r.details.index));
+        return nullptr;
+      }, node.vertexBuffer->pointCount));
+
+      shader->drawPointSpritesPicking(node.vertexBuffer, pickingID);
+    }
+    else
+    {
+      shader->drawPointSprites(node.vertexBuffer);
+      renderedPointCount += node.pointCount;
+    }
+  }
+
+  if(renderInfo.pass != RenderPass::Picking)
+    d->renderedPointCount = renderedPointCount;
+
+  map()->controller()->disableScissor();
+}
+
+//##################################################################################################
+void PointCloudLayer::invalidateBuffers()
+{
+  d->deleteVertexBuffers();
+  d->textureID = 0;
+  d->bindBeforeRender = true;
+  Layer::invalidateBuffers();
+}
+
+//##################################################################################################
+void PointCloudLayer::animate(double timestampMS)
+{
+  d->applyCompletedLoads();
+  Layer::animate(timestampMS);
+}
+
+}
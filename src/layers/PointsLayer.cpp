@@ -6,6 +6,8 @@
 #include "tp_maps/picking_results/PointsPickingResult.h"
 
 #include <vector>
+#include <set>
+#include <algorithm>
 
 namespace tp_maps
 {
@@ -22,6 +24,9 @@ struct PointsLayer::Private
 
   std::vector<PointSpriteShader::PointSprite> points;
 
+  // Slots left by removePoints, these are drawn with zero radius and reused by appendPoints.
+  std::set<size_t> freeIndices;
+
   PointSpriteShader::VertexBuffer* vertexBuffer{nullptr};
 
   GLuint textureID{0};
@@ -29,6 +34,11 @@ struct PointsLayer::Private
   bool bindBeforeRender{true};
   bool updateVertexBuffer{true};
 
+  // The range of points that have changed since the last upload, used when only some points have
+  // been modified, see updatePoints.
+  bool partialUpdate{false};
+  size_t dirtyBegin{0};
+  size_t dirtyEnd{0};
 
   //################################################################################################
   Private(Q* q_, SpriteTexture* spriteTexture_):
@@ -57,6 +67,34 @@ struct PointsLayer::Private
     delete vertexBuffer;
     vertexBuffer=nullptr;
   }
+
+  //################################################################################################
+  void addDirty(size_t begin, size_t end)
+  {
+    if(!partialUpdate)
+    {
+      dirtyBegin = begin;
+      dirtyEnd = end;
+      partialUpdate = true;
+    }
+    else
+    {
+      dirtyBegin = tpMin(dirtyBegin, begin);
+      dirtyEnd = tpMax(dirtyEnd, end);
+    }
+
+    q->update();
+  }
+
+  //################################################################################################
+  //! Points that are drawn with zero radius, used to fill free slots.
+  static PointSpriteShader::PointSprite placeholder()
+  {
+    PointSpriteShader::PointSprite placeholder;
+    placeholder.color = glm::vec4(0.0f);
+    placeholder.radius = 0.0f;
+    return placeholder;
+  }
 };
 
 //##################################################################################################
@@ -86,6 +124,7 @@ PointsLayer::~PointsLayer()
 void PointsLayer::clearPoints()
 {
   d->points.clear();
+  d->freeIndices.clear();
   d->updateVertexBuffer = true;
   update();
 }
@@ -94,10 +133,82 @@ void PointsLayer::clearPoints()
 void PointsLayer::setPoints(const std::vector<PointSpriteShader::PointSprite>& points)
 {
   d->points = points;
+  d->freeIndices.clear();
   d->updateVertexBuffer = true;
   update();
 }
 
+//##################################################################################################
+void PointsLayer::updatePoints(size_t index, const std::vector<PointSpriteShader::PointSprite>& points)
+{
+  if(points.empty())
+    return;
+
+  size_t begin = index;
+  size_t end = index + points.size();
+  if(end>d->points.size())
+  {
+    // Any gap between the current end and index is filled with free placeholder points.
+    if(index>d->points.size())
+    {
+      begin = d->points.size();
+      for(size_t i=begin; i<index; i++)
+        d->freeIndices.insert(i);
+      d->points.resize(index, Private::placeholder());
+    }
+    d->points.resize(end);
+  }
+
+  std::copy(points.begin(), points.end(), d->points.begin()+int(index));
+  d->freeIndices.erase(d->freeIndices.lower_bound(index), d->freeIndices.lower_bound(end));
+  d->addDirty(begin, end);
+}
+
+//##################################################################################################
+std::vector<size_t> PointsLayer::appendPoints(const std::vector<PointSpriteShader::PointSprite>& points)
+{
+  std::vector<size_t> indices;
+  indices.reserve(points.size());
+
+  auto p = points.begin();
+  while(p!=points.end() && !d->freeIndices.empty())
+  {
+    size_t index = *d->freeIndices.begin();
+    d->freeIndices.erase(d->freeIndices.begin());
+    d->points[index] = *p;
+    d->addDirty(index, index+1);
+    indices.push_back(index);
+    ++p;
+  }
+
+  size_t index = d->points.size();
+  updatePoints(index, std::vector<PointSpriteShader::PointSprite>(p, points.end()));
+  for(; index<d->points.size(); index++)
+    indices.push_back(index);
+
+  return indices;
+}
+
+//##################################################################################################
+void PointsLayer::removePoints(size_t index, size_t count)
+{
+  if(index>=d->points.size())
+    return;
+
+  count = tpMin(count, d->points.size()-index);
+  if(count==0)
+    return;
+
+  auto placeholder = Private::placeholder();
+  for(size_t i=index; i<index+count; i++)
+  {
+    d->points[i] = placeholder;
+    d->freeIndices.insert(i);
+  }
+
+  d->addDirty(index, index+count);
+}
+
 //##################################################################################################
 const std::vector<PointSpriteShader::PointSprite>& PointsLayer::points() const
 {
@@ -144,6 +255,12 @@ void PointsLayer::render(RenderInfo& renderInfo)
 
     d->vertexBuffer = shader->generateVertexBuffer(map(), d->points, d->spriteTexture->coords());
     d->updateVertexBuffer=false;
+    d->partialUpdate=false;
+  }
+  else if(d->partialUpdate)
+  {
+    shader->updateVertexBuffer(d->vertexBuffer, d->points, d->spriteTexture->coords(), d->dirtyBegin, d->dirtyEnd-d->dirtyBegin);
+    d->partialUpdate=false;
   }
 
   shader->use(renderInfo.shaderType());
@@ -156,11 +273,11 @@ void PointsLayer::render(RenderInfo& renderInfo)
   {
     PickingDetails pickingDetails;
 
-    uint32_t pointCount = d->vertexBuffer->indexCount/4;
+    uint32_t pointCount = d->vertexBuffer->pointCount;
 
     auto pickingID = renderInfo.pickingID(PickingDetails(0, [&](const PickingResult& r) -> PickingResult*
     {
-      if(r.details.index<d->points.size() && r.renderInfo.map)
+      if(r.details.index<d->points.size() && r.renderInfo.map && !d->freeIndices.count(r.details.index))
       {
         return new PointsPickingResult(r.pickingType, r.details, r.renderInfo, this, r.details.index, d->points.at(r.details.index));
       }
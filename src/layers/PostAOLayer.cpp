@@ -23,8 +23,9 @@ struct PostAOLayer::Private
   RenderPass customRenderPass2{tp_maps::RenderPass::Custom, ssaoPass2};
   RenderPass customRenderPass3{tp_maps::RenderPass::Custom, ssaoPass3};
 
-  OpenGLFBO ssaoFbo;
-  OpenGLFBO blurFbo;
+  // Borrowed from the transient buffer pool for the duration of the passes that use them.
+  OpenGLFBO* ssaoFbo{nullptr};
+  OpenGLFBO* blurFbo{nullptr};
 
   //################################################################################################
   Private(Q* q_):
@@ -49,17 +50,12 @@ PostAOLayer::PostAOLayer():
   PostLayer({tp_maps::RenderPass::Custom, ambientOcclusionShaderSID()}),
   d(new Private(this))
 {
-
+  setSkippable(true);
 }
 
 //##################################################################################################
 PostAOLayer::~PostAOLayer()
 {
-  if(map())
-  {
-    map()->buffers().deleteBuffer(d->ssaoFbo);
-    map()->buffers().deleteBuffer(d->blurFbo);
-  }
   delete d;
 }
 
@@ -100,57 +96,79 @@ void PostAOLayer::addRenderPasses(std::vector<RenderPass>& renderPasses)
 //##################################################################################################
 void PostAOLayer::render(tp_maps::RenderInfo& renderInfo)
 {
+  size_t resolutionDivisor = tpMax(size_t(1), d->parameters.resolutionDivisor);
+
   if(renderInfo.pass == d->customRenderPass1) //----------------------------------------------------
   {
-    d->ssaoFbo.name = "ssao";
-    if(!map()->buffers().prepareBuffer(d->ssaoFbo,
-                                       map()->width(),
-                                       map()->height(),
-                                       CreateColorBuffer::Yes,
-                                       Multisample::No,
-                                       HDR::No,
-                                       ExtendedFBO::No,
-                                       true))
+    d->ssaoFbo = map()->buffers().acquireTransientBuffer("ssao",
+                                                         tpMax(size_t(1), size_t(map()->renderWidth())/resolutionDivisor),
+                                                         tpMax(size_t(1), size_t(map()->renderHeight())/resolutionDivisor),
+                                                         CreateColorBuffer::Yes,
+                                                         Multisample::No,
+                                                         HDR::No,
+                                                         ExtendedFBO::No,
+                                                         true);
+    if(!d->ssaoFbo)
     {
       Errors::printOpenGLError("SSAO FBO creation failed!");
       return;
     }
 
     auto ambientOcclusionShader = map()->getShader<PostAOShader>(d->parameters);
-    tp_maps::PostLayer::renderToFbo(ambientOcclusionShader, d->ssaoFbo );
+    tp_maps::PostLayer::renderToFbo(ambientOcclusionShader, *d->ssaoFbo);
   }
 
   else if(renderInfo.pass == d->customRenderPass2) //-----------------------------------------------
   {
-    d->blurFbo.name = "ssaoBlurred";
-   if(!map()->buffers().prepareBuffer(d->blurFbo,
-                                      map()->width(),
-                                      map()->height(),
-                                      CreateColorBuffer::Yes,
-                                      Multisample::No,
-                                      HDR::No,
-                                      ExtendedFBO::No,
-                                      true))
-   {
-     Errors::printOpenGLError("SSAO Blur FBO creation failed!");
-     return;
-   }
-
-   auto postBasicBlurShader = map()->getShader<PostBasicBlurShader>();
-   tp_maps::PostLayer::renderToFbo(postBasicBlurShader, d->blurFbo, d->ssaoFbo.textureID );
+    // At reduced resolution the merge pass smooths the AO while it upsamples it.
+    if(!d->ssaoFbo || resolutionDivisor>1)
+      return;
 
+    d->blurFbo = map()->buffers().acquireTransientBuffer("ssaoBlurred",
+                                                         map()->renderWidth(),
+                                                         map()->renderHeight(),
+                                                         CreateColorBuffer::Yes,
+                                                         Multisample::No,
+                                                         HDR::No,
+                                                         ExtendedFBO::No,
+                                                         true);
+    if(!d->blurFbo)
+    {
+      Errors::printOpenGLError("SSAO Blur FBO creation failed!");
+      return;
+    }
+
+    auto postBasicBlurShader = map()->getShader<PostBasicBlurShader>();
+    tp_maps::PostLayer::renderToFbo(postBasicBlurShader, *d->blurFbo, d->ssaoFbo->textureID);
+
+    map()->buffers().releaseTransientBuffer(d->ssaoFbo);
+    d->ssaoFbo = nullptr;
   }
 
   else if(renderInfo.pass == d->customRenderPass3) //-----------------------------------------------
   {
+    OpenGLFBO* aoFbo = d->blurFbo?d->blurFbo:d->ssaoFbo;
+    if(!aoFbo)
+      return;
+
     auto mergeAmbientOcclusionShader = map()->getShader<PostAOMergeShader>(d->parameters);
 
     auto bindAdditionalTextures = [&]()
     {
-      mergeAmbientOcclusionShader->setSSAOTexture(d->blurFbo.textureID);
+      mergeAmbientOcclusionShader->setSSAOTexture(aoFbo->textureID);
+      mergeAmbientOcclusionShader->setSSAOTextureSize(aoFbo->width, aoFbo->height);
     };
 
     tp_maps::PostLayer::renderWithShader(mergeAmbientOcclusionShader, bindAdditionalTextures);
+
+    for(auto fbo : {&d->ssaoFbo, &d->blurFbo})
+    {
+      if(*fbo)
+      {
+        map()->buffers().releaseTransientBuffer(*fbo);
+        *fbo = nullptr;
+      }
+    }
   }
 
 }
@@ -158,8 +176,8 @@ void PostAOLayer::render(tp_maps::RenderInfo& renderInfo)
 //##################################################################################################
 void PostAOLayer::invalidateBuffers()
 {
-  map()->buffers().invalidateBuffer( d->ssaoFbo );
-  map()->buffers().invalidateBuffer( d->blurFbo );
+  d->ssaoFbo = nullptr;
+  d->blurFbo = nullptr;
 
   PostLayer::invalidateBuffers();
 }
@@ -0,0 +1,143 @@
+#include "tp_maps/layers/PostAccumulateLayer.h"
+#include "tp_maps/shaders/PostAccumulateShader.h"
+#include "tp_maps/shaders/PassThroughShader.h"
+#include "tp_maps/Map.h"
+#include "tp_maps/RenderModeManager.h"
+#include "tp_maps/Errors.h"
+#include "tp_maps/subsystems/open_gl/OpenGLBuffers.h" // IWYU pragma: keep
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct PostAccumulateLayer::Private
+{
+  Q* q;
+
+  // Ping pong between two buffers as the history can't be read while it is being written.
+  OpenGLFBO historyFbos[2];
+  size_t historyIndex{0};
+  size_t accumulatedSamples{0};
+  size_t lastSample{0}; //!< The progressive sample that was last blended into the history.
+
+  //################################################################################################
+  Private(Q* q_):
+    q(q_)
+  {
+    historyFbos[0].name = "accumulationHistory";
+    historyFbos[1].name = "accumulationHistory";
+  }
+};
+
+//##################################################################################################
+PostAccumulateLayer::PostAccumulateLayer():
+  PostLayer({tp_maps::RenderPass::Custom, postAccumulateShaderSID()}),
+  d(new Private(this))
+{
+
+}
+
+//##################################################################################################
+PostAccumulateLayer::~PostAccumulateLayer()
+{
+  if(map())
+  {
+    map()->buffers().deleteBuffer(d->historyFbos[0]);
+    map()->buffers().deleteBuffer(d->historyFbos[1]);
+  }
+  delete d;
+}
+
+//##################################################################################################
+size_t PostAccumulateLayer::accumulatedSamples() const
+{
+  return d->accumulatedSamples;
+}
+
+//##################################################################################################
+void PostAccumulateLayer::addRenderPasses(std::vector<RenderPass>& renderPasses)
+{
+  if(!map()->renderModeManger().progressive())
+    return;
+
+  PostLayer::addRenderPasses(renderPasses);
+}
+
+//##################################################################################################
+void PostAccumulateLayer::render(tp_maps::RenderInfo& renderInfo)
+{
+  if(renderInfo.pass != defaultRenderPass())
+    return;
+
+  size_t width  = size_t(tpMax(1, map()->renderWidth()));
+  size_t height = size_t(tpMax(1, map()->renderHeight()));
+
+  OpenGLFBO& history     = d->historyFbos[d->historyIndex];
+  OpenGLFBO& accumulated = d->historyFbos[1-d->historyIndex];
+
+  size_t sample = map()->renderModeManger().progressiveSample();
+
+  if(sample == 0 ||
+     !history.frameBuffer ||
+     history.width != width ||
+     history.height != height)
+    d->accumulatedSamples = 0;
+
+  auto passThroughShader = map()->getShader<PassThroughShader>();
+
+  // Repaints that don't advance the sample, for example a hover or a repaint after convergence,
+  // show the history as it is rather than blending the same sample in again.
+  if(d->accumulatedSamples>0 && sample == d->lastSample)
+  {
+    tp_maps::PostLayer::renderWithShader(passThroughShader, [&]
+    {
+      passThroughShader->setFBOSourceTexture(history.textureID);
+    });
+    return;
+  }
+
+  if(!map()->buffers().prepareBuffer(accumulated,
+                                     width,
+                                     height,
+                                     CreateColorBuffer::Yes,
+                                     Multisample::No,
+                                     HDR::Yes,
+                                     ExtendedFBO::No,
+                                     false))
+  {
+    Errors::printOpenGLError("Accumulation FBO creation failed!");
+    return;
+  }
+
+  // Each sample index is blended in once so accumulatedSamples follows progressiveSample(), it is
+  // only lower if a sample was never painted or the history was lost part way through.
+  float blendWeight = 1.0f / float(d->accumulatedSamples+1);
+
+  auto accumulateShader = map()->getShader<PostAccumulateShader>();
+  tp_maps::PostLayer::renderToFbo(accumulateShader, accumulated, 0, [&]
+  {
+    accumulateShader->setHistoryTexture(history.textureID);
+    accumulateShader->setBlendWeight(blendWeight);
+  });
+
+  tp_maps::PostLayer::renderWithShader(passThroughShader, [&]
+  {
+    passThroughShader->setFBOSourceTexture(accumulated.textureID);
+  });
+
+  d->historyIndex = 1-d->historyIndex;
+  d->accumulatedSamples++;
+  d->lastSample = sample;
+}
+
+//##################################################################################################
+void PostAccumulateLayer::invalidateBuffers()
+{
+  map()->buffers().invalidateBuffer(d->historyFbos[0]);
+  map()->buffers().invalidateBuffer(d->historyFbos[1]);
+  d->accumulatedSamples = 0;
+
+  PostLayer::invalidateBuffers();
+}
+
+}
@@ -18,4 +18,11 @@ PostShader* PostBlitLayer::makeShader()
   return map()->getShader<PostBlitShader>();
 }
 
+//##################################################################################################
+bool PostBlitLayer::perPixelEffect() const
+{
+  // The default empty snippet is a blit.
+  return true;
+}
+
 }
@@ -7,9 +7,15 @@
 #include "tp_maps/shaders/PostDoFCalculateFocusShader.h"
 #include "tp_maps/shaders/PostDoFDownsampleShader.h"
 #include "tp_maps/shaders/PostDoFMergeShader.h"
+#include "tp_maps/shaders/PostDoFFastDownsampleShader.h"
+#include "tp_maps/shaders/PostDoFFastBlurShader.h"
+#include "tp_maps/shaders/PostDoFFastMergeShader.h"
+#include "tp_maps/shaders/PostDoFReduceShader.h"
 #include "tp_maps/shaders/PassThroughShader.h"
 #include "tp_maps/Map.h"
 
+#include <array>
+
 namespace tp_maps
 {
 
@@ -33,11 +39,42 @@ struct PostDoFLayer::Private
   RenderPass customRenderPass5{tp_maps::RenderPass::Custom, dofPass5};
   RenderPass customRenderPass6{tp_maps::RenderPass::Custom, dofPass6};
 
+  RenderPass fastDownsamplePass{tp_maps::RenderPass::Custom, "DoF fast downsample"};
+  RenderPass fastBlurPass{tp_maps::RenderPass::Custom, "DoF fast blur"};
+  RenderPass fastMergePass{tp_maps::RenderPass::Custom, "DoF fast merge"};
+  RenderPass fastSkippedPass{tp_maps::RenderPass::Custom, "DoF fast skipped"};
+
   int downsampleFactor{4};
 
-  OpenGLFBO downsampleFbo;
-  OpenGLFBO focusCalcFbo;
-  OpenGLFBO downsampledFocusCalcFbo;
+  // Borrowed from the transient buffer pool and released once the merge pass has read them.
+  OpenGLFBO* downsampleFbo{nullptr};
+  OpenGLFBO* focusCalcFbo{nullptr};
+  OpenGLFBO* downsampledFocusCalcFbo{nullptr};
+  OpenGLFBO* fastDownsampleFbo{nullptr};
+  OpenGLFBO* fastBlurFbo{nullptr};
+
+  // The largest circle of confusion is reduced into this and read back a frame or two later.
+  OpenGLFBO reductionFbo;
+#ifdef TP_PIXEL_BUFFER_SUPPORTED
+  GLuint reductionPBO{0};
+  GLsync reductionFence{nullptr};
+#endif
+  float maxCoC{1.0f}; //!< From the last read back, 1 until the first result arrives.
+  bool skipping{false};
+  bool updatePending{false};
+
+  //################################################################################################
+  void releaseBuffers()
+  {
+    for(auto fbo : {&downsampleFbo, &focusCalcFbo, &downsampledFocusCalcFbo, &fastDownsampleFbo, &fastBlurFbo})
+    {
+      if(*fbo)
+      {
+        q->map()->buffers().releaseTransientBuffer(*fbo);
+        *fbo = nullptr;
+      }
+    }
+  }
 
   //################################################################################################
   Private(Q* q_):
@@ -55,7 +92,201 @@ struct PostDoFLayer::Private
       q->map()->deleteShader(PostDoFMergeShader::name());
       q->map()->deleteShader(PostDoFDownsampleShader::name());
       q->map()->deleteShader(PostDoFBlurShader::name());
+      q->map()->deleteShader(PostDoFFastDownsampleShader::name());
+      q->map()->deleteShader(PostDoFFastMergeShader::name());
+    }
+  }
+
+  //################################################################################################
+  size_t fastWidth() const
+  {
+    return size_t(std::max(1, q->map()->renderWidth() / downsampleFactor));
+  }
+
+  //################################################################################################
+  size_t fastHeight() const
+  {
+    return size_t(std::max(1, q->map()->renderHeight() / downsampleFactor));
+  }
+
+  //################################################################################################
+  //! Map::update is ignored while painting, so redraws requested from render are deferred.
+  void updateAsync()
+  {
+    if(updatePending)
+      return;
+
+    updatePending = true;
+    q->callAsync([this]
+    {
+      updatePending = false;
+      q->update(q->stage());
+    });
+  }
+
+  //################################################################################################
+  //! Collect the result of the last reduction if it is ready, returns true if it was collected.
+  bool readReduction()
+  {
+#ifdef TP_PIXEL_BUFFER_SUPPORTED
+    if(!reductionFence)
+      return false;
+
+    GLenum result = glClientWaitSync(reductionFence, 0, 0);
+    if(result == GL_TIMEOUT_EXPIRED)
+    {
+      // Make sure that there is another frame to collect the result in.
+      if(skipping)
+        updateAsync();
+      return false;
     }
+
+    glDeleteSync(reductionFence);
+    reductionFence = nullptr;
+
+    if(result == GL_WAIT_FAILED)
+      return true;
+
+    constexpr size_t size = PostDoFReduceShader::reductionSize*PostDoFReduceShader::reductionSize*4;
+
+    auto findMaxCoC = [&](const uint8_t* data)
+    {
+      uint8_t coc=0;
+      for(size_t i=3; i<size; i+=4)
+        coc = std::max(coc, data[i]);
+      maxCoC = float(coc) / 255.0f;
+    };
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, reductionPBO);
+#ifdef TP_EMSCRIPTEN
+    // WebGL2 can't map buffers for reading, the fence has signaled so this does not stall.
+    std::array<uint8_t, size> data;
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, size, data.data());
+    findMaxCoC(data.data());
+#else
+    if(auto data = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT)); data)
+    {
+      findMaxCoC(data);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+#endif
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Redraw if this frame was drawn with the wrong choice.
+    if(skipping != (maxCoC < parameters.skipThreshold))
+      updateAsync();
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  //################################################################################################
+  //! Reduce the circle of confusion in fastDownsampleFbo and start reading it back.
+  void startReduction()
+  {
+#ifdef TP_PIXEL_BUFFER_SUPPORTED
+    if(reductionFence)
+      return;
+
+    const size_t reductionSize = PostDoFReduceShader::reductionSize;
+    const size_t reductionFactor = PostDoFReduceShader::reductionFactor;
+
+    auto reduceShader = q->map()->getShader<PostDoFReduceShader>();
+
+    // Chain levels that each shrink by at most reductionFactor so that every texel is read, the
+    // intermediate levels are transient and the last one is reductionFbo.
+    const OpenGLFBO* source = fastDownsampleFbo;
+    OpenGLFBO* previousLevel = nullptr;
+    for(;;)
+    {
+      size_t width  = tpMax(reductionSize, (source->width +reductionFactor-1)/reductionFactor);
+      size_t height = tpMax(reductionSize, (source->height+reductionFactor-1)/reductionFactor);
+      bool lastLevel = (width==reductionSize && height==reductionSize);
+
+      OpenGLFBO* level = &reductionFbo;
+      if(lastLevel)
+      {
+        if(!q->map()->buffers().prepareBuffer(reductionFbo,
+                                              reductionSize,
+                                              reductionSize,
+                                              CreateColorBuffer::Yes,
+                                              Multisample::No,
+                                              HDR::No,
+                                              ExtendedFBO::No,
+                                              false))
+          level = nullptr;
+      }
+      else
+      {
+        level = q->map()->buffers().acquireTransientBuffer("dofReduction",
+                                                           width,
+                                                           height,
+                                                           CreateColorBuffer::Yes,
+                                                           Multisample::No,
+                                                           HDR::No,
+                                                           ExtendedFBO::No,
+                                                           false);
+      }
+
+      if(!level)
+      {
+        if(previousLevel)
+          q->map()->buffers().releaseTransientBuffer(previousLevel);
+        Errors::printOpenGLError("DoF reduction FBO creation failed!");
+        return;
+      }
+
+      q->renderToFbo(reduceShader, *level, source->textureID, [&]
+      {
+        reduceShader->setSizes({float(source->width), float(source->height)}, {float(width), float(height)});
+      });
+
+      if(previousLevel)
+        q->map()->buffers().releaseTransientBuffer(previousLevel);
+
+      if(lastLevel)
+        break;
+
+      previousLevel = level;
+      source = level;
+    }
+
+    if(!reductionPBO)
+    {
+      glGenBuffers(1, &reductionPBO);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, reductionPBO);
+      glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(reductionSize*reductionSize*4), nullptr, GL_STREAM_READ);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, reductionFbo.frameBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, reductionPBO);
+    glReadPixels(0, 0, GLsizei(reductionSize), GLsizei(reductionSize), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, q->map()->currentDrawFBO()->frameBuffer);
+
+    reductionFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    if(skipping)
+      updateAsync();
+#endif
+  }
+
+  //################################################################################################
+  void deleteReduction()
+  {
+#ifdef TP_PIXEL_BUFFER_SUPPORTED
+    if(reductionFence)
+      glDeleteSync(reductionFence);
+
+    if(reductionPBO)
+      glDeleteBuffers(1, &reductionPBO);
+
+    reductionFence = nullptr;
+    reductionPBO = 0;
+#endif
+    q->map()->buffers().deleteBuffer(reductionFbo);
   }
 };
 
@@ -65,17 +296,14 @@ PostDoFLayer::PostDoFLayer():
   d(new Private(this))
 {
   setBypass(false);
+  setSkippable(true);
 }
 
 //##################################################################################################
 PostDoFLayer::~PostDoFLayer()
 {
   if(map())
-  {
-    map()->buffers().deleteBuffer(d->downsampleFbo);
-    map()->buffers().deleteBuffer(d->focusCalcFbo);
-    map()->buffers().deleteBuffer(d->downsampledFocusCalcFbo);
-  }
+    d->deleteReduction();
 
   delete d;
 }
@@ -92,6 +320,7 @@ void PostDoFLayer::setParameters(const PostDoFParameters& parameters)
   if(!parameters.fuzzyEquals(d->parameters))
   {
     d->parameters = parameters;
+    d->maxCoC = 1.0f;
     setBypass(!parameters.enabled);
     d->recompileShaders();
   }
@@ -121,6 +350,22 @@ void PostDoFLayer::addRenderPasses(std::vector<RenderPass>& renderPasses)
   if(bypass())
     return;
 
+  if(d->parameters.fast)
+  {
+    d->skipping = d->maxCoC < d->parameters.skipThreshold;
+
+    renderPasses.emplace_back(RenderPass::SwapToFBO, mergeDofShaderSID());
+    renderPasses.emplace_back(d->fastDownsamplePass);
+    if(d->skipping)
+      renderPasses.emplace_back(d->fastSkippedPass);
+    else
+    {
+      renderPasses.emplace_back(d->fastBlurPass);
+      renderPasses.emplace_back(d->fastMergePass);
+    }
+    return;
+  }
+
   renderPasses.emplace_back(RenderPass::SwapToFBO, mergeDofShaderSID());
   renderPasses.emplace_back(d->customRenderPass1);
   renderPasses.emplace_back(d->customRenderPass2);
@@ -150,15 +395,15 @@ void PostDoFLayer::render(tp_maps::RenderInfo& renderInfo)
 
   else if(renderInfo.pass == d->customRenderPass2) //-----------------------------------------------
   {
-    d->focusCalcFbo.name = "dofFocus";
-    if(!map()->buffers().prepareBuffer(d->focusCalcFbo,
-                                       map()->width(),
-                                       map()->height(),
-                                       CreateColorBuffer::Yes,
-                                       Multisample::No,
-                                       HDR::No,
-                                       ExtendedFBO::No,
-                                       true))
+    d->focusCalcFbo = map()->buffers().acquireTransientBuffer("dofFocus",
+                                                              map()->renderWidth(),
+                                                              map()->renderHeight(),
+                                                              CreateColorBuffer::Yes,
+                                                              Multisample::No,
+                                                              HDR::No,
+                                                              ExtendedFBO::No,
+                                                              true);
+    if(!d->focusCalcFbo)
     {
       Errors::printOpenGLError("Focus calc FBO creation failed!");
       return;
@@ -167,24 +412,27 @@ void PostDoFLayer::render(tp_maps::RenderInfo& renderInfo)
     // New fbo for focus texture ( using R channel )
     auto calculateFocusShader = map()->getShader<PostDoFCalculateFocusShader>(d->parameters);
     setNearAndFar(calculateFocusShader);
-    tp_maps::PostLayer::renderToFbo(calculateFocusShader, d->focusCalcFbo);
+    tp_maps::PostLayer::renderToFbo(calculateFocusShader, *d->focusCalcFbo);
   }
 
 
   else if(renderInfo.pass == d->customRenderPass3) //-----------------------------------------------
   {
-    size_t width  = std::max(1, map()->width() / d->downsampleFactor);
-    size_t height = std::max(1, map()->height() / d->downsampleFactor);
-
-    d->downsampledFocusCalcFbo.name = "dofFocusDownsampled";
-    if(!map()->buffers().prepareBuffer(d->downsampledFocusCalcFbo,
-                                       width,
-                                       height,
-                                       CreateColorBuffer::Yes,
-                                       Multisample::No,
-                                       HDR::No,
-                                       ExtendedFBO::No,
-                                       true))
+    if(!d->focusCalcFbo)
+      return;
+
+    size_t width  = std::max(1, map()->renderWidth() / d->downsampleFactor);
+    size_t height = std::max(1, map()->renderHeight() / d->downsampleFactor);
+
+    d->downsampledFocusCalcFbo = map()->buffers().acquireTransientBuffer("dofFocusDownsampled",
+                                                                         width,
+                                                                         height,
+                                                                         CreateColorBuffer::Yes,
+                                                                         Multisample::No,
+                                                                         HDR::No,
+                                                                         ExtendedFBO::No,
+                                                                         true);
+    if(!d->downsampledFocusCalcFbo)
     {
       Errors::printOpenGLError("Downsampled focus calc FBO creation failed!");
       return;
@@ -194,8 +442,8 @@ void PostDoFLayer::render(tp_maps::RenderInfo& renderInfo)
     auto calculateFocusShader = map()->getShader<PostDoFCalculateFocusShader>(d->parameters);
     setNearAndFar(calculateFocusShader);
     tp_maps::PostLayer::renderToFbo(calculateFocusShader,
-                                    d->downsampledFocusCalcFbo,
-                                    d->focusCalcFbo.textureID );
+                                    *d->downsampledFocusCalcFbo,
+                                    d->focusCalcFbo->textureID);
   }
 
 
@@ -208,18 +456,18 @@ void PostDoFLayer::render(tp_maps::RenderInfo& renderInfo)
 
   else if(renderInfo.pass == d->customRenderPass5)
   {
-    size_t width  = std::max(1, map()->width() / d->downsampleFactor);
-    size_t height = std::max(1, map()->height() / d->downsampleFactor);
-
-    d->downsampleFbo.name = "dofColorDownsampled";
-    if(!map()->buffers().prepareBuffer(d->downsampleFbo,
-                                       width,
-                                       height,
-                                       CreateColorBuffer::Yes,
-                                       Multisample::No,
-                                       HDR::No,
-                                       ExtendedFBO::No,
-                                       true))
+    size_t width  = std::max(1, map()->renderWidth() / d->downsampleFactor);
+    size_t height = std::max(1, map()->renderHeight() / d->downsampleFactor);
+
+    d->downsampleFbo = map()->buffers().acquireTransientBuffer("dofColorDownsampled",
+                                                               width,
+                                                               height,
+                                                               CreateColorBuffer::Yes,
+                                                               Multisample::No,
+                                                               HDR::No,
+                                                               ExtendedFBO::No,
+                                                               true);
+    if(!d->downsampleFbo)
     {
       Errors::printOpenGLError("Downsample FBO creation failed!");
       return;
@@ -228,32 +476,143 @@ void PostDoFLayer::render(tp_maps::RenderInfo& renderInfo)
     // Downsample the regular color FBO
     auto downsampleShader = map()->getShader<PostDoFDownsampleShader>(d->parameters);
     setNearAndFar(downsampleShader);
-    tp_maps::PostLayer::renderToFbo(downsampleShader, d->downsampleFbo );
+    tp_maps::PostLayer::renderToFbo(downsampleShader, *d->downsampleFbo);
   }
 
 
   else if(renderInfo.pass == d->customRenderPass6) //-----------------------------------------------
   {
+    if(!d->downsampleFbo || !d->focusCalcFbo || !d->downsampledFocusCalcFbo)
+    {
+      d->releaseBuffers();
+      return;
+    }
+
     auto mergeDofShader = map()->getShader<PostDoFMergeShader>(d->parameters);
     setNearAndFar(mergeDofShader);
 
     auto bindAdditionalTextures = [&]()
     {
-      mergeDofShader->setDownsampledTexture(d->downsampleFbo.textureID);
-      mergeDofShader->setFocusTexture(d->focusCalcFbo.textureID);
-      mergeDofShader->setDownsampledFocusTexture( d->downsampledFocusCalcFbo.textureID);
+      mergeDofShader->setDownsampledTexture(d->downsampleFbo->textureID);
+      mergeDofShader->setFocusTexture(d->focusCalcFbo->textureID);
+      mergeDofShader->setDownsampledFocusTexture(d->downsampledFocusCalcFbo->textureID);
     };
 
     tp_maps::PostLayer::renderWithShader(mergeDofShader, bindAdditionalTextures);
+
+    d->releaseBuffers();
+  }
+
+
+  else if(renderInfo.pass == d->fastDownsamplePass) //----------------------------------------------
+  {
+    // Either collect the last reduction or start a new one so that there is at most one in flight.
+    bool collected = d->readReduction();
+
+    d->fastDownsampleFbo = map()->buffers().acquireTransientBuffer("dofFastDownsampled",
+                                                                   d->fastWidth(),
+                                                                   d->fastHeight(),
+                                                                   CreateColorBuffer::Yes,
+                                                                   Multisample::No,
+                                                                   HDR::No,
+                                                                   ExtendedFBO::No,
+                                                                   true);
+    if(!d->fastDownsampleFbo)
+    {
+      Errors::printOpenGLError("Fast downsample FBO creation failed!");
+      return;
+    }
+
+    // Downsample the color and calculate the circle of confusion in one pass.
+    auto downsampleShader = map()->getShader<PostDoFFastDownsampleShader>(d->parameters);
+    setNearAndFar(downsampleShader);
+    tp_maps::PostLayer::renderToFbo(downsampleShader, *d->fastDownsampleFbo);
+
+    if(!collected)
+      d->startReduction();
+  }
+
+
+  else if(renderInfo.pass == d->fastBlurPass) //----------------------------------------------------
+  {
+    if(!d->fastDownsampleFbo)
+      return;
+
+    d->fastBlurFbo = map()->buffers().acquireTransientBuffer("dofFastBlur",
+                                                             d->fastWidth(),
+                                                             d->fastHeight(),
+                                                             CreateColorBuffer::Yes,
+                                                             Multisample::No,
+                                                             HDR::No,
+                                                             ExtendedFBO::No,
+                                                             false);
+    if(!d->fastBlurFbo)
+    {
+      Errors::printOpenGLError("Fast blur FBO creation failed!");
+      return;
+    }
+
+    // Blur horizontally into fastBlurFbo then vertically back into fastDownsampleFbo.
+    auto blurShader = map()->getShader<PostDoFFastBlurShader>();
+    glm::vec2 step{1.0f/float(d->fastWidth()), 1.0f/float(d->fastHeight())};
+
+    tp_maps::PostLayer::renderToFbo(blurShader, *d->fastBlurFbo, d->fastDownsampleFbo->textureID, [&]
+    {
+      blurShader->setBlurStep({step.x, 0.0f});
+    });
+
+    tp_maps::PostLayer::renderToFbo(blurShader, *d->fastDownsampleFbo, d->fastBlurFbo->textureID, [&]
+    {
+      blurShader->setBlurStep({0.0f, step.y});
+    });
+
+    map()->buffers().releaseTransientBuffer(d->fastBlurFbo);
+    d->fastBlurFbo = nullptr;
+  }
+
+
+  else if(renderInfo.pass == d->fastMergePass) //---------------------------------------------------
+  {
+    if(!d->fastDownsampleFbo)
+      return;
+
+    auto mergeShader = map()->getShader<PostDoFFastMergeShader>(d->parameters);
+    setNearAndFar(mergeShader);
+
+    tp_maps::PostLayer::renderWithShader(mergeShader, [&]
+    {
+      mergeShader->setBlurredTexture(d->fastDownsampleFbo->textureID);
+    });
+
+    d->releaseBuffers();
+  }
+
+
+  else if(renderInfo.pass == d->fastSkippedPass) //-------------------------------------------------
+  {
+    // Everything was in focus when last measured so just copy the frame.
+    auto passThroughShader = map()->getShader<PassThroughShader>();
+    tp_maps::PostLayer::renderWithShader(passThroughShader);
+
+    d->releaseBuffers();
   }
 }
 
 //##################################################################################################
 void PostDoFLayer::invalidateBuffers()
 {
-  map()->buffers().invalidateBuffer(d->downsampleFbo);
-  map()->buffers().invalidateBuffer(d->focusCalcFbo);
-  map()->buffers().invalidateBuffer(d->downsampledFocusCalcFbo);
+  d->downsampleFbo = nullptr;
+  d->focusCalcFbo = nullptr;
+  d->downsampledFocusCalcFbo = nullptr;
+  d->fastDownsampleFbo = nullptr;
+  d->fastBlurFbo = nullptr;
+
+  map()->buffers().invalidateBuffer(d->reductionFbo);
+#ifdef TP_PIXEL_BUFFER_SUPPORTED
+  d->reductionPBO = 0;
+  d->reductionFence = nullptr;
+#endif
+  d->maxCoC = 1.0f;
 
   PostLayer::invalidateBuffers();
 }
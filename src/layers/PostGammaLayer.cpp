@@ -18,4 +18,16 @@ PostShader* PostGammaLayer::makeShader()
   return map()->getShader<PostGammaShader>();
 }
 
+//##################################################################################################
+std::string PostGammaLayer::fusedFragmentSnippet() const
+{
+  return "color = fromLinear(color);";
+}
+
+//##################################################################################################
+bool PostGammaLayer::perPixelEffect() const
+{
+  return true;
+}
+
 }
@@ -3,6 +3,7 @@
 #include "tp_maps/shaders/PostBlitShader.h"
 #include "tp_maps/Map.h"
 #include "tp_maps/Controller.h"
+#include "tp_maps/RenderModeManager.h"
 #include "tp_maps/RenderInfo.h"
 
 #include <vector>
@@ -20,6 +21,7 @@ struct PostLayer::Private
   RenderFromStage stage{RenderFromStage::Stage, 0};
 
   bool bypass{false};
+  bool skippable{false};
 
   FullScreenShader::Object* rectangleObject{nullptr};
   FullScreenShader::Object* frameObject{nullptr};
@@ -73,6 +75,12 @@ void PostLayer::setFrameCoordinateSystem(const tp_utils::StringID& frameCoordina
   d->frameCoordinateSystem = frameCoordinateSystem;
 }
 
+//##################################################################################################
+const tp_utils::StringID& PostLayer::frameCoordinateSystem() const
+{
+  return d->frameCoordinateSystem;
+}
+
 //##################################################################################################
 const RenderFromStage& PostLayer::stage() const
 {
@@ -88,6 +96,9 @@ void PostLayer::setStageIndex(size_t stageIndex)
 //##################################################################################################
 bool PostLayer::bypass() const
 {
+  if(d->skippable && map() && !map()->renderModeManger().postEffectsAllowed())
+    return true;
+
   return d->bypass;
 }
 
@@ -101,6 +112,22 @@ void PostLayer::setBypass(bool bypass)
   update(stage());
 }
 
+//##################################################################################################
+bool PostLayer::skippable() const
+{
+  return d->skippable;
+}
+
+//##################################################################################################
+void PostLayer::setSkippable(bool skippable)
+{
+  if(d->skippable == skippable)
+    return;
+
+  d->skippable = skippable;
+  update(stage());
+}
+
 //##################################################################################################
 void PostLayer::setRectangle(const glm::vec2& size)
 {
@@ -125,6 +152,24 @@ void PostLayer::setBlit(bool blitRectangle, bool blitFrame)
   d->blitFrame = blitFrame;
 }
 
+//##################################################################################################
+bool PostLayer::fusable() const
+{
+  return
+      perPixelEffect() &&
+      !bypass() &&
+      d->rectangle &&
+      d->size == glm::vec2(1.0f, 1.0f) &&
+      !d->blitRectangle &&
+      !d->blitFrame;
+}
+
+//##################################################################################################
+std::string PostLayer::fusedFragmentSnippet() const
+{
+  return std::string();
+}
+
 //##################################################################################################
 void PostLayer::addRenderPasses(std::vector<RenderPass>& renderPasses)
 {
@@ -297,7 +342,10 @@ void PostLayer::renderWithShader(PostShader* shader, std::function<void()> bindA
 }
 
 //##################################################################################################
-void PostLayer::renderToFbo(PostShader* shader, OpenGLFBO& customFbo, const GLuint sourceTexture)
+void PostLayer::renderToFbo(PostShader* shader,
+                            OpenGLFBO& customFbo,
+                            const GLuint sourceTexture,
+                            std::function<void()> bindAdditionalTextures)
 {
   // Blit shader stuff
   {
@@ -331,8 +379,9 @@ void PostLayer::renderToFbo(PostShader* shader, OpenGLFBO& customFbo, const GLui
 
   shader->use(map()->renderInfo().shaderType());
 
-  // Change render target
+  // Change render target, it may be a different size to the draw FBO
   glBindFramebuffer(GL_FRAMEBUFFER, customFbo.frameBuffer);
+  glViewport(0, 0, TPGLsizei(customFbo.width), TPGLsizei(customFbo.height));
 
   glDisable(GL_DEPTH_TEST);
   glClearColor(0.8f,0.8f,0.8f,1.0f);
@@ -344,6 +393,8 @@ void PostLayer::renderToFbo(PostShader* shader, OpenGLFBO& customFbo, const GLui
   if(sourceTexture)
     shader->setFBOSourceTexture(sourceTexture);
 
+  bindAdditionalTextures();
+
   shader->setFrameMatrix(map()->controller()->matrices(d->frameCoordinateSystem).p);
   shader->setProjectionMatrix(map()->controller()->matrices(coordinateSystem()).p);
 
@@ -353,7 +404,9 @@ void PostLayer::renderToFbo(PostShader* shader, OpenGLFBO& customFbo, const GLui
     shader->draw(*d->frameObject);
 
   // Change framebuffer back
-  glBindFramebuffer(GL_FRAMEBUFFER, map()->currentDrawFBO()->frameBuffer);
+  const auto drawFBO = map()->currentDrawFBO();
+  glBindFramebuffer(GL_FRAMEBUFFER, drawFBO->frameBuffer);
+  glViewport(0, 0, TPGLsizei(drawFBO->width), TPGLsizei(drawFBO->height));
 }
 
 //##################################################################################################
@@ -369,5 +422,11 @@ PostShader* PostLayer::makeShader()
   return nullptr;
 }
 
+//##################################################################################################
+bool PostLayer::perPixelEffect() const
+{
+  return false;
+}
+
 
 }
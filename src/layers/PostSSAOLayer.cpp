@@ -31,7 +31,7 @@ PostSSAOLayer::PostSSAOLayer():
   PostLayer({tp_maps::RenderPass::Custom, postSSAOShaderSID()}),
   d(new Private(this))
 {
-
+  setSkippable(true);
 }
 
 //##################################################################################################
@@ -9,7 +9,7 @@ namespace tp_maps
 PostSSRLayer::PostSSRLayer(RenderPass::RenderPassType customRenderPass):
   PostLayer(customRenderPass)
 {
-
+  setSkippable(true);
 }
 
 //##################################################################################################
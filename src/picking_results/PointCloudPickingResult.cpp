@@ -0,0 +1,23 @@
+#include "tp_maps/picking_results/PointCloudPickingResult.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+PointCloudPickingResult::PointCloudPickingResult(const tp_utils::StringID& pickingType_,
+                                                 const PickingDetails& details_,
+                                                 const RenderInfo& renderInfo_,
+                                                 PointCloudLayer* pointCloudLayer_,
+                                                 const std::string& nodeName_,
+                                                 size_t index_,
+                                                 const PointCloudPoint& point_):
+  PickingResult(pickingType_, details_, renderInfo_, pointCloudLayer_),
+  pointCloudLayer(pointCloudLayer_),
+  nodeName(nodeName_),
+  index(index_),
+  point(point_)
+{
+
+}
+
+}
@@ -10,6 +10,7 @@ uniform sampler2D depthSampler;
 uniform sampler2D normalsSampler;
 
 uniform sampler2D noiseSampler;
+uniform vec2 noiseOffset;
 
 uniform mat4 projectionMatrix;
 uniform mat4 invProjectionMatrix;
@@ -58,13 +59,14 @@ void main()
 {
   vec4 color;
 
-  vec2 noiseScale = (1.0 / pixelSize) / 4.0;
+  // pixelSize is for the full resolution buffer, keep one noise texel per AO texel.
+  vec2 noiseScale = (1.0 / pixelSize) / (4.0 * resolutionDivisor);
 
   // AO calc
   float depth = TP_GLSL_TEXTURE_2D(depthSampler   , coord_tex).x;
   vec3 fragPos   = clipToView(coord_tex, depth, invProjectionMatrix);
   vec3 normal    = TP_GLSL_TEXTURE_2D(normalsSampler , coord_tex).xyz;
-  vec3 randomVec = TP_GLSL_TEXTURE_2D(noiseSampler, coord_tex * noiseScale).xyz;
+  vec3 randomVec = TP_GLSL_TEXTURE_2D(noiseSampler, coord_tex * noiseScale + noiseOffset).xyz;
 
   vec3 tangent   = normalize(randomVec - normal * dot(randomVec, normal));
   vec3 bitangent = cross(normal, tangent);
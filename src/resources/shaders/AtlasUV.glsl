@@ -0,0 +1,6 @@
+// Maps uv into a sub-image of a texture atlas, transform is offset (xy) and scale (zw). A zero
+// scale means that the texture is not in an atlas.
+vec2 atlasUV(vec2 uv, vec4 transform)
+{
+  return (transform.z>0.0)?(transform.xy + clamp(uv, 0.0, 1.0)*transform.zw):uv;
+}
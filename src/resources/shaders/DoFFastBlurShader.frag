@@ -0,0 +1,46 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec2 coord_tex;
+
+uniform sampler2D textureSampler;
+uniform sampler2D depthSampler;
+uniform sampler2D normalsSampler;
+
+uniform mat4 projectionMatrix;
+uniform mat4 invProjectionMatrix;
+
+uniform vec2 pixelSize;
+
+// The offset between taps in texture coordinates, along x or y for each of the two passes.
+uniform vec2 blurStep;
+
+const int blurRadius = 4;
+
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+void main()
+{
+  vec4 center = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex);
+
+  vec3 color = center.rgb;
+  float weight = 1.0;
+
+  for(int i=1; i<=blurRadius; i++)
+  {
+    vec4 tapA = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex + blurStep * float(i));
+    vec4 tapB = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex - blurStep * float(i));
+
+    // Scatter as gather: a tap only contributes if its own circle of confusion reaches this pixel.
+    float weightA = clamp(tapA.a * float(blurRadius) - float(i) + 1.0, 0.0, 1.0);
+    float weightB = clamp(tapB.a * float(blurRadius) - float(i) + 1.0, 0.0, 1.0);
+
+    color += tapA.rgb * weightA + tapB.rgb * weightB;
+    weight += weightA + weightB;
+  }
+
+  // Keep the circle of confusion of this pixel for the second pass.
+  TP_GLSL_GLFRAGCOLOR = vec4(color / weight, center.a);
+}
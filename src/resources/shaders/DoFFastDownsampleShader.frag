@@ -0,0 +1,65 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec2 coord_tex;
+
+uniform sampler2D textureSampler;
+uniform sampler2D depthSampler;
+uniform sampler2D normalsSampler;
+
+uniform mat4 projectionMatrix;
+uniform mat4 invProjectionMatrix;
+
+uniform vec2 pixelSize;
+
+uniform float near;
+uniform float far;
+
+#pragma replace DOF_FRAG_VARS
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+// Each bilinear tap averages 2x2 pixels so these cover the 4x4 pixels of each output pixel.
+const vec2 offsets[4] = vec2[]
+(
+  vec2(-1.0, -1.0),
+  vec2(-1.0,  1.0),
+  vec2( 1.0, -1.0),
+  vec2( 1.0,  1.0)
+);
+
+float LinearizeDepth( float depth )
+{
+  float z = depth * 2.0 - 1.0; // back to NDC
+  return (2.0 * near * far) / (far + near - z * (far - near));
+}
+
+// The circle of confusion in the range 0 (in focus) to 1 (the largest blur).
+float circleOfConfusion( float depth )
+{
+  float f = 0.0;
+
+  if( depth < focalDistance )
+    f = (depth - focalDistance) / (focalDistance - nearPlane);
+  else
+    f = (depth - focalDistance) / (farPlane - focalDistance);
+
+  return clamp(abs(f), 0.0, 1.0);
+}
+
+void main()
+{
+  vec3 color = vec3(0.0, 0.0, 0.0);
+  float coc = 0.0;
+
+  for(int i=0; i<4; i++)
+  {
+    vec2 coord = coord_tex + offsets[i] * pixelSize;
+    color += TP_GLSL_TEXTURE_2D(textureSampler, coord).rgb;
+    coc = max(coc, circleOfConfusion(LinearizeDepth(TP_GLSL_TEXTURE_2D(depthSampler, coord).x)));
+  }
+
+  // The circle of confusion is stored in alpha for the blur and the reduction.
+  TP_GLSL_GLFRAGCOLOR = vec4(color / 4.0, coc);
+}
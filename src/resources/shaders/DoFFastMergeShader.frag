@@ -0,0 +1,52 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec2 coord_tex;
+
+uniform sampler2D textureSampler;
+uniform sampler2D depthSampler;
+uniform sampler2D normalsSampler;
+
+uniform mat4 projectionMatrix;
+uniform mat4 invProjectionMatrix;
+
+uniform vec2 pixelSize;
+
+uniform float near;
+uniform float far;
+
+uniform sampler2D blurredTextureSampler;
+
+#pragma replace DOF_FRAG_VARS
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+float LinearizeDepth( float depth )
+{
+  float z = depth * 2.0 - 1.0; // back to NDC
+  return (2.0 * near * far) / (far + near - z * (far - near));
+}
+
+// The circle of confusion in the range 0 (in focus) to 1 (the largest blur).
+float circleOfConfusion( float depth )
+{
+  float f = 0.0;
+
+  if( depth < focalDistance )
+    f = (depth - focalDistance) / (focalDistance - nearPlane);
+  else
+    f = (depth - focalDistance) / (farPlane - focalDistance);
+
+  return clamp(abs(f), 0.0, 1.0);
+}
+
+void main()
+{
+  vec3 sharp = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex).rgb;
+  vec3 blurred = TP_GLSL_TEXTURE_2D(blurredTextureSampler, coord_tex).rgb;
+
+  float coc = circleOfConfusion(LinearizeDepth(TP_GLSL_TEXTURE_2D(depthSampler, coord_tex).x));
+
+  TP_GLSL_GLFRAGCOLOR = vec4(mix(sharp, blurred, smoothstep(skipThreshold, 0.25, coc)), 1.0);
+}
@@ -0,0 +1,46 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec2 coord_tex;
+
+uniform sampler2D textureSampler;
+uniform sampler2D depthSampler;
+uniform sampler2D normalsSampler;
+
+uniform mat4 projectionMatrix;
+uniform mat4 invProjectionMatrix;
+
+uniform vec2 pixelSize;
+
+// The size in pixels of the texture being read and of the FBO being drawn to.
+uniform vec2 sourceSize;
+uniform vec2 outputSize;
+
+// Each level reduces by at most 4 along each axis so a block never spans more than 5 texels.
+const int maxTaps = 5;
+
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+void main()
+{
+  // The block of source texels covered by this pixel, first and last inclusive.
+  vec2 ratio = sourceSize / outputSize;
+  vec2 pixel = floor(gl_FragCoord.xy);
+  vec2 first = floor(pixel*ratio);
+  vec2 last = max(first, ceil((pixel+1.0)*ratio) - 1.0);
+
+  float coc = 0.0;
+
+  for(int y=0; y<maxTaps; y++)
+  {
+    for(int x=0; x<maxTaps; x++)
+    {
+      vec2 texel = min(first + vec2(float(x), float(y)), last);
+      coc = max(coc, TP_GLSL_TEXTURE_2D(textureSampler, (texel+0.5)/sourceSize).a);
+    }
+  }
+
+  TP_GLSL_GLFRAGCOLOR = vec4(coc, coc, coc, coc);
+}
@@ -0,0 +1,30 @@
+#pragma replace TP_FRAG_SHADER_HEADER_DERIVATIVES
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec2 coord_tex;
+TP_GLSL_IN_F vec4 vertexColor;
+
+uniform sampler2D textureSampler;
+uniform vec4 color;
+
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+void main()
+{
+  // The atlas stores the signed distance to the glyph edge, 0.5 is on the edge. The edge is
+  // smoothed over one screen pixel so the text stays sharp at any scale.
+  float distance = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex).r;
+#if defined(GL_ES) && __VERSION__ < 300 && !defined(GL_OES_standard_derivatives)
+  float smoothing = 0.05;
+#else
+  float smoothing = max(fwidth(distance)*0.5, 0.0001);
+#endif
+  float alpha = smoothstep(0.5-smoothing, 0.5+smoothing, distance);
+
+  vec4 c = color*vertexColor;
+  TP_GLSL_GLFRAGCOLOR = vec4(c.rgb, c.a*alpha);
+  if(TP_GLSL_GLFRAGCOLOR.a < 0.01)
+    discard;
+}
@@ -4,15 +4,21 @@
 #define TP_GLSL_TEXTURE_2D
 
 TP_GLSL_IN_F vec2 coord_tex;
+TP_GLSL_IN_F vec4 vertexColor;
 
 uniform sampler2D textureSampler;
 uniform vec4 color;
+uniform float alphaAtlas;
 
 #pragma replace TP_GLSL_GLFRAGCOLOR_DEF
 
 void main()
 {
-  TP_GLSL_GLFRAGCOLOR = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex)*color;
+  // Single channel atlases store the coverage of the glyph in the red channel.
+  vec4 texel = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex);
+  texel = mix(texel, vec4(1.0, 1.0, 1.0, texel.r), alphaAtlas);
+
+  TP_GLSL_GLFRAGCOLOR = texel*color*vertexColor;
   if(TP_GLSL_GLFRAGCOLOR.a < 0.01)
     discard;
 }
@@ -5,8 +5,10 @@
 TP_GLSL_IN_V vec3 inVertex;
 //TP_GLSL_IN_V vec4 inTBNq;
 TP_GLSL_IN_V vec2 inTexture;
+TP_GLSL_IN_V vec4 inColor;
 
 TP_GLSL_OUT_V vec2 coord_tex;
+TP_GLSL_OUT_V vec4 vertexColor;
 
 uniform mat4 matrix;
 
@@ -14,4 +16,5 @@ void main()
 {
   gl_Position = matrix * vec4(inVertex, 1.0);
   coord_tex = inTexture;
+  vertexColor = inColor;
 }
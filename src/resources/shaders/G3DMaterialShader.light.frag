@@ -6,13 +6,16 @@
 TP_GLSL_IN_F vec2 uv_tangent;
 
 uniform sampler2D rgbaTexture;
+uniform vec4 rgbaUVTransform;
 const float discardOpacity=0.8;
 
 #pragma replace TP_GLSL_GLFRAGCOLOR_DEF
 
+#pragma replace TP_ATLAS_UV
+
 void main()
 {
-  vec4 rgbaTex = TP_GLSL_TEXTURE_2D(rgbaTexture, uv_tangent);
+  vec4 rgbaTex = TP_GLSL_TEXTURE_2D(rgbaTexture, atlasUV(uv_tangent, rgbaUVTransform));
 
   if(rgbaTex.a<discardOpacity)
     discard;
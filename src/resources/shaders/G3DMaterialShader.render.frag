@@ -63,6 +63,10 @@ uniform sampler2D rgbaTexture;
 uniform sampler2D normalsTexture;
 uniform sampler2D rmttrTexture;
 
+uniform vec4 rgbaUVTransform;
+uniform vec4 normalsUVTransform;
+uniform vec4 rmttrUVTransform;
+
 uniform Material material;
 
 uniform vec2 txlSize;
@@ -95,6 +99,7 @@ vec2 invTxlSize;
 #pragma replace LIGHT_FRAG_VARS
 
 uniform int shadowSamples;
+uniform vec2 shadowSampleOffset;
 
 float totShadowSamples()
 {
@@ -241,7 +246,7 @@ LightResult directionalLight(vec3 norm, Light light, vec3 lightDirection_tangent
     {
       for(int y = -shadowSamples; y <= shadowSamples; ++y)
       {
-        vec2 coord = uv_light.xy + (vec2(x, y)*txlSize);
+        vec2 coord = uv_light.xy + ((vec2(x, y)+shadowSampleOffset)*txlSize);
         if(coord.x>=0.0 && coord.x<=1.0 && coord.y>=0.0 && coord.y<=1.0)
         {
           float extraBias = bias*(abs(float(x))+abs(float(y)));
@@ -399,7 +404,7 @@ float spotLightSampleShadow2D(vec3 norm, Light light, vec3 lightDirection_tangen
     float nSamplesXY = float(1+2*shadowSamples);
     float sampleScale = clamp(spotLightSampleScale(linearDepth, nominalBlockerDepth, light, light.offsetScale.x), 1.0f, max(5.0f, 0.05f/(txlSize.x*tan(0.5f*light.fov))))/nSamplesXY;
 
-    vec2 randomOffset = vec2(rand(uv_light.xy)-0.5f, rand(uv_light.yz)-0.5f);
+    vec2 randomOffset = fract(vec2(rand(uv_light.xy), rand(uv_light.yz)) + shadowSampleOffset) - 0.5f;
 
     // calculate blocker depth as average shadow-weighted depth around current pixel
     float totWeight = 0.0f;
@@ -544,17 +549,24 @@ mat3 quaternionToMat3(vec4 q)
   return R;
 }
 
+//##################################################################################################
+#pragma replace TP_ATLAS_UV
+
 //##################################################################################################
 void main()
 {
-  vec4     rgbaTex = TP_GLSL_TEXTURE_2D(    rgbaTexture, uv_tangent);
-  vec3  normalsTex = TP_GLSL_TEXTURE_2D( normalsTexture, uv_tangent).xyz;
-  vec4    rmttrTex = TP_GLSL_TEXTURE_2D(    rmttrTexture, uv_tangent);
+  vec4     rgbaTex = TP_GLSL_TEXTURE_2D(    rgbaTexture, atlasUV(uv_tangent, rgbaUVTransform));
+  vec3  normalsTex = TP_GLSL_TEXTURE_2D( normalsTexture, atlasUV(uv_tangent, normalsUVTransform)).xyz;
+  vec4    rmttrTex = TP_GLSL_TEXTURE_2D(    rmttrTexture, atlasUV(uv_tangent, rmttrUVTransform));
 
   //Note: GammaCorrection
   rgbaTex.xyz = toLinear(rgbaTex.xyz);
 
-  vec3 norm = normalize(normalsTex*2.0-1.0);
+  // Two channel (BC5) normal maps have no z, so reconstruct it from x and y.
+  vec3 norm = normalsTex*2.0-1.0;
+  if(normalsTex.z < (1.0/255.0))
+    norm.z = sqrt(max(1.0 - dot(norm.xy, norm.xy), 0.0));
+  norm = normalize(norm);
 
   albedo = rgbaTex.xyz * material.albedoScale;
 
@@ -42,6 +42,10 @@ uniform sampler2D rgbaTexture;
 uniform sampler2D normalsTexture;
 uniform sampler2D rmttrTexture;
 
+uniform vec4 rgbaUVTransform;
+uniform vec4 normalsUVTransform;
+uniform vec4 rmttrUVTransform;
+
 uniform Material material;
 
 uniform vec2 txlSize;
@@ -235,17 +239,24 @@ mat3 quaternionToMat3(vec4 q)
   return R;
 }
 
+//##################################################################################################
+#pragma replace TP_ATLAS_UV
+
 //##################################################################################################
 void main()
 {
-  vec4     rgbaTex = TP_GLSL_TEXTURE_2D(    rgbaTexture, uv_tangent);
-  vec3  normalsTex = TP_GLSL_TEXTURE_2D( normalsTexture, uv_tangent).xyz;
-  vec4    rmttrTex = TP_GLSL_TEXTURE_2D(   rmttrTexture, uv_tangent);
+  vec4     rgbaTex = TP_GLSL_TEXTURE_2D(    rgbaTexture, atlasUV(uv_tangent, rgbaUVTransform));
+  vec3  normalsTex = TP_GLSL_TEXTURE_2D( normalsTexture, atlasUV(uv_tangent, normalsUVTransform)).xyz;
+  vec4    rmttrTex = TP_GLSL_TEXTURE_2D(   rmttrTexture, atlasUV(uv_tangent, rmttrUVTransform));
 
   //Note: GammaCorrection
   rgbaTex.xyz = toLinear(rgbaTex.xyz);
 
-  vec3 norm = normalize(normalsTex*2.0-1.0);
+  // Two channel (BC5) normal maps have no z, so reconstruct it from x and y.
+  vec3 norm = normalsTex*2.0-1.0;
+  if(normalsTex.z < (1.0/255.0))
+    norm.z = sqrt(max(1.0 - dot(norm.xy, norm.xy), 0.0));
+  norm = normalize(norm);
 
   albedo = rgbaTex.xyz * material.albedoScale;
 
@@ -6,18 +6,70 @@
 TP_GLSL_IN_F vec2 coord_tex;
 
 uniform sampler2D textureSampler;
+uniform sampler2D depthSampler;
 uniform sampler2D normalsSampler;
 uniform sampler2D ssaoTextureSampler;
 
+uniform mat4 invProjectionMatrix;
+
+uniform vec2 ssaoPixelSize;
+
 const float discardOpacity=0.8;
 
+//! Samples further than this fraction of the view depth away from the fragment are ignored.
+const float upsampleDepthSigma=0.05;
+
 /*AO_FRAG_VARS*/
 
 #pragma replace TP_GLSL_GLFRAGCOLOR_DEF
 
+//##################################################################################################
+float viewDepth(vec2 xy_tex)
+{
+  float depth = TP_GLSL_TEXTURE_2D(depthSampler, xy_tex).x;
+  vec4 coord_view = invProjectionMatrix * vec4((xy_tex*2.0)-1.0, depth*2.0-1.0, 1.0);
+  return coord_view.z / coord_view.w;
+}
+
+//##################################################################################################
+// Joint bilateral upsample of the low resolution AO. The AO shader point samples the full
+// resolution depth at the center of each AO texel, so the depth of each AO texel can be read back
+// from the same place. The 4x4 footprint also smooths the noise that the blur pass would remove.
+float readOcclusion()
+{
+#if RESOLUTION_DIVISOR > 1
+  float centerDepth = viewDepth(coord_tex);
+  vec2 base = (floor(coord_tex/ssaoPixelSize - 0.5) + 0.5) * ssaoPixelSize;
+
+  float occlusion = 0.0;
+  float weights = 0.0;
+  for(int y=-1; y<3; y++)
+  {
+    for(int x=-1; x<3; x++)
+    {
+      vec2 sampleCoord = clamp(base + vec2(float(x), float(y))*ssaoPixelSize, ssaoPixelSize*0.5, 1.0-ssaoPixelSize*0.5);
+
+      vec2 d = (sampleCoord - coord_tex) / ssaoPixelSize;
+      float spatialWeight = exp(-0.5*dot(d, d));
+
+      float depthDifference = abs(viewDepth(sampleCoord) - centerDepth) / (upsampleDepthSigma*abs(centerDepth) + 0.0001);
+      float weight = spatialWeight * (exp(-depthDifference) + 0.0001);
+
+      occlusion += TP_GLSL_TEXTURE_2D(ssaoTextureSampler, sampleCoord).x * weight;
+      weights += weight;
+    }
+  }
+
+  return occlusion / weights;
+#else
+  return TP_GLSL_TEXTURE_2D(ssaoTextureSampler, coord_tex).x;
+#endif
+}
+
+//##################################################################################################
 void main()
 {
-  float occlusion = TP_GLSL_TEXTURE_2D(ssaoTextureSampler, coord_tex).x;
+  float occlusion = readOcclusion();
 
   if( occlusion < boostUpperThreshold )
     occlusion *= boostUpperFactor;
@@ -2,10 +2,15 @@
 #define TP_GLSL_IN_V
 #define TP_GLSL_OUT_V
 
+// Per point
 TP_GLSL_IN_V vec4 inColor;
 TP_GLSL_IN_V vec3 inPosition;
 TP_GLSL_IN_V vec3 inOffset;
-TP_GLSL_IN_V vec2 inTexture;
+TP_GLSL_IN_V vec4 inTextureRect;
+TP_GLSL_IN_V float inRadius;
+
+// Per corner of the instanced quad
+TP_GLSL_IN_V vec2 inCorner;
 
 TP_GLSL_OUT_V vec2 coord_tex;
 TP_GLSL_OUT_V vec4 picking;
@@ -16,10 +21,13 @@ uniform uint pickingID;
 
 void main()
 {
+  vec3 offset = inOffset + vec3(inCorner, 0.0);
+  offset.xy *= inRadius;
+
   gl_Position = (matrix * vec4(inPosition, 1.0));
-  gl_Position = vec4(gl_Position.xyz * (1.0/gl_Position.w), 1.0) + vec4(inOffset.x*scaleFactor.x, inOffset.y*scaleFactor.y, inOffset.z, 0.0);
-  coord_tex = inTexture;
-  uint id = pickingID + (uint(gl_VertexID)/4u);
+  gl_Position = vec4(gl_Position.xyz * (1.0/gl_Position.w), 1.0) + vec4(offset.x*scaleFactor.x, offset.y*scaleFactor.y, offset.z, 0.0);
+  coord_tex = mix(inTextureRect.xy, inTextureRect.zw, inCorner*0.5+0.5);
+  uint id = pickingID + uint(gl_InstanceID);
   uint r = (id & 0x000000FFu) >>  0u;
   uint g = (id & 0x0000FF00u) >>  8u;
   uint b = (id & 0x00FF0000u) >> 16u;
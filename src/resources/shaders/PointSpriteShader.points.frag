@@ -0,0 +1,21 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec4 textureRect;
+TP_GLSL_IN_F vec4 color;
+TP_GLSL_IN_F float clip;
+
+uniform sampler2D textureSampler;
+
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+void main()
+{
+  // gl_PointCoord starts at the top left, sprite coords start at the bottom left.
+  vec2 coord_tex = mix(textureRect.xy, textureRect.zw, vec2(gl_PointCoord.x, 1.0-gl_PointCoord.y));
+  TP_GLSL_GLFRAGCOLOR = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex) * color;
+  if(TP_GLSL_GLFRAGCOLOR.a < 0.001 || clip<0.1)
+    discard;
+}
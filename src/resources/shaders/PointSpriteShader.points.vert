@@ -0,0 +1,29 @@
+#pragma replace TP_VERT_SHADER_HEADER
+#define TP_GLSL_IN_V
+#define TP_GLSL_OUT_V
+
+TP_GLSL_IN_V vec4 inColor;
+TP_GLSL_IN_V vec3 inPosition;
+TP_GLSL_IN_V vec3 inOffset;
+TP_GLSL_IN_V vec4 inTextureRect;
+TP_GLSL_IN_V float inRadius;
+
+TP_GLSL_OUT_V vec4 textureRect;
+TP_GLSL_OUT_V vec4 color;
+TP_GLSL_OUT_V float clip;
+
+uniform mat4 matrix;
+uniform vec2 scaleFactor;
+
+void main()
+{
+  vec3 offset = inOffset;
+  offset.xy *= inRadius;
+
+  gl_Position = (matrix * vec4(inPosition, 1.0));
+  clip = (gl_Position.z<-0.9999)?0.0:1.0;
+  gl_Position += vec4((offset.x*scaleFactor.x)*gl_Position.w, (offset.y*scaleFactor.y)*gl_Position.w, offset.z, 0.0);
+  gl_PointSize = 2.0*inRadius;
+  textureRect = inTextureRect;
+  color = inColor;
+}
@@ -2,10 +2,15 @@
 #define TP_GLSL_IN_V
 #define TP_GLSL_OUT_V
 
+// Per point
 TP_GLSL_IN_V vec4 inColor;
 TP_GLSL_IN_V vec3 inPosition;
 TP_GLSL_IN_V vec3 inOffset;
-TP_GLSL_IN_V vec2 inTexture;
+TP_GLSL_IN_V vec4 inTextureRect;
+TP_GLSL_IN_V float inRadius;
+
+// Per corner of the instanced quad
+TP_GLSL_IN_V vec2 inCorner;
 
 TP_GLSL_OUT_V vec2 coord_tex;
 TP_GLSL_OUT_V vec4 color;
@@ -16,9 +21,12 @@ uniform vec2 scaleFactor;
 
 void main()
 {
+  vec3 offset = inOffset + vec3(inCorner, 0.0);
+  offset.xy *= inRadius;
+
   gl_Position = (matrix * vec4(inPosition, 1.0));
   clip = (gl_Position.z<-0.9999)?0.0:1.0;
-  gl_Position += vec4((inOffset.x*scaleFactor.x)*gl_Position.w, (inOffset.y*scaleFactor.y)*gl_Position.w, inOffset.z, 0.0);
-  coord_tex = inTexture;
+  gl_Position += vec4((offset.x*scaleFactor.x)*gl_Position.w, (offset.y*scaleFactor.y)*gl_Position.w, offset.z, 0.0);
+  coord_tex = mix(inTextureRect.xy, inTextureRect.zw, inCorner*0.5+0.5);
   color = inColor;
 }
@@ -0,0 +1,28 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec2 coord_tex;
+
+uniform sampler2D textureSampler;
+uniform sampler2D historySampler;
+
+uniform float blendWeight;
+
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+void main()
+{
+  vec4 current = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex);
+
+  // The history is not read for the first sample as it may not have been initialized.
+  if(blendWeight>=1.0)
+  {
+    TP_GLSL_GLFRAGCOLOR = current;
+    return;
+  }
+
+  vec4 history = TP_GLSL_TEXTURE_2D(historySampler, coord_tex);
+  TP_GLSL_GLFRAGCOLOR = mix(history, current, blendWeight);
+}
@@ -0,0 +1,33 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+#define TP_GLSL_TEXTURE_2D
+
+TP_GLSL_IN_F vec2 coord_tex;
+
+uniform sampler2D textureSampler;
+
+uniform vec2 sourcePixelSize;
+uniform float sharpness;
+
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+void main()
+{
+  // The source texture uses linear filtering so each of these is a bilinear sample.
+  vec4 center = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex);
+  vec3 n = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex + vec2(0.0, -sourcePixelSize.y)).xyz;
+  vec3 s = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex + vec2(0.0,  sourcePixelSize.y)).xyz;
+  vec3 e = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex + vec2( sourcePixelSize.x, 0.0)).xyz;
+  vec3 w = TP_GLSL_TEXTURE_2D(textureSampler, coord_tex + vec2(-sourcePixelSize.x, 0.0)).xyz;
+
+  // Unsharp mask to restore some of the detail lost by upscaling.
+  vec3 blurred = (n + s + e + w) * 0.25;
+  vec3 sharpened = center.xyz + (center.xyz - blurred) * sharpness;
+
+  // Limit the result to the range of the neighbours to avoid halos around edges.
+  vec3 minColor = min(center.xyz, min(min(n, s), min(e, w)));
+  vec3 maxColor = max(center.xyz, max(max(n, s), max(e, w)));
+
+  TP_GLSL_GLFRAGCOLOR = vec4(clamp(sharpened, minColor, maxColor), center.a);
+}
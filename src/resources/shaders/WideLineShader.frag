@@ -0,0 +1,71 @@
+#pragma replace TP_FRAG_SHADER_HEADER
+#define TP_GLSL_IN_F
+#define TP_GLSL_GLFRAGCOLOR
+
+TP_GLSL_IN_F vec4 color;
+TP_GLSL_IN_F vec4 lineCoord;
+TP_GLSL_IN_F float lineLength;
+TP_GLSL_IN_F vec2 caps;
+TP_GLSL_IN_F vec4 joins;
+
+uniform float capStyle;
+uniform float picking;
+uniform vec4 pickingColor;
+
+#pragma replace TP_GLSL_GLFRAGCOLOR_DEF
+
+// Signed distance in pixels to the edge of the end of a segment, x is the distance past the end.
+float endDistance(float x, float y, float hw, float cap)
+{
+  if(cap<0.5 || capStyle>1.5)
+    return length(vec2(x, y)) - hw;
+
+  if(capStyle>0.5)
+    return max(abs(y), x) - hw;
+
+  return max(abs(y)-hw, x);
+}
+
+// Signed distance in pixels to a segment with round ends.
+float segmentDistance(vec2 p, vec2 a, vec2 b, float hw)
+{
+  vec2 ab = b-a;
+  float t = clamp(dot(p-a, ab)/max(dot(ab, ab), 0.0001), 0.0, 1.0);
+  return length(p-a-ab*t) - hw;
+}
+
+void main()
+{
+  vec3 c = lineCoord.xyz / lineCoord.w;
+
+  // Lines thinner than a pixel are drawn 1 pixel wide and faded out instead.
+  float coverage = min(c.z*2.0, 1.0);
+  c.z = max(c.z, 0.5);
+
+  float d = abs(c.y) - c.z;
+  if(c.x<0.0)
+    d = endDistance(-c.x, c.y, c.z, caps.x);
+  else if(c.x>lineLength)
+    d = endDistance(c.x-lineLength, c.y, c.z, caps.y);
+
+  // Segments overlap at joins, leave pixels that are closer to the neighbouring segment for it to
+  // draw so that translucent lines are not blended twice.
+  if(caps.x<0.5 && segmentDistance(c.xy, joins.xy, vec2(0.0), c.z)<=d)
+    discard;
+  if(caps.y<0.5 && segmentDistance(c.xy, vec2(lineLength, 0.0), joins.zw, c.z)<d)
+    discard;
+
+  if(picking>0.5)
+  {
+    if(d>0.0)
+      discard;
+    TP_GLSL_GLFRAGCOLOR = pickingColor;
+    return;
+  }
+
+  float alpha = clamp(0.5-d, 0.0, 1.0) * coverage * color.a;
+  if(alpha<0.001)
+    discard;
+
+  TP_GLSL_GLFRAGCOLOR = vec4(color.rgb, alpha);
+}
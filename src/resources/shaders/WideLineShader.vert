@@ -0,0 +1,93 @@
+#pragma replace TP_VERT_SHADER_HEADER
+#define TP_GLSL_IN_V
+#define TP_GLSL_OUT_V
+
+// Per segment
+TP_GLSL_IN_V vec3 inStart;
+TP_GLSL_IN_V vec3 inEnd;
+TP_GLSL_IN_V vec4 inColor;
+TP_GLSL_IN_V vec2 inCaps;
+TP_GLSL_IN_V vec3 inPrevious;
+TP_GLSL_IN_V vec3 inNext;
+
+// Per corner of the instanced quad, x is 0 at the start and 1 at the end, y is the side.
+TP_GLSL_IN_V vec2 inCorner;
+
+TP_GLSL_OUT_V vec4 color;
+TP_GLSL_OUT_V vec4 lineCoord;
+TP_GLSL_OUT_V float lineLength;
+TP_GLSL_OUT_V vec2 caps;
+TP_GLSL_OUT_V vec4 joins;
+
+uniform mat4 matrix;
+uniform vec2 screenSize;
+uniform float halfWidth;
+uniform float worldScale;
+uniform float capStyle;
+
+// Pixels added around the line for anti-aliasing.
+const float fringe = 1.0;
+const float nearW = 0.0001;
+
+// The screen position of a neighbouring point clipped towards p if it is behind the camera.
+vec2 neighbour(vec3 point, vec4 p, vec2 halfScreen)
+{
+  vec4 n = matrix*vec4(point, 1.0);
+  if(n.w<nearW)
+    n = mix(n, p, (nearW-n.w)/(p.w-n.w));
+  return (n.xy/n.w)*halfScreen;
+}
+
+void main()
+{
+  color = inColor;
+  caps = inCaps;
+  lineLength = 0.0;
+  lineCoord = vec4(0.0, 0.0, 0.0, 1.0);
+  joins = vec4(0.0);
+  gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+
+  vec4 a = matrix*vec4(inStart, 1.0);
+  vec4 b = matrix*vec4(inEnd, 1.0);
+
+  // Clip to the near plane so that segments that pass behind the camera don't flip.
+  if(a.w<nearW && b.w<nearW)
+    return;
+  else if(a.w<nearW)
+    a = mix(a, b, (nearW-a.w)/(b.w-a.w));
+  else if(b.w<nearW)
+    b = mix(b, a, (nearW-b.w)/(a.w-b.w));
+
+  vec2 halfScreen = screenSize*0.5;
+  vec2 sa = (a.xy/a.w)*halfScreen;
+  vec2 sb = (b.xy/b.w)*halfScreen;
+  vec2 delta = sb-sa;
+  float len = length(delta);
+  vec2 dir = (len>0.0001)?(delta/len):vec2(1.0, 0.0);
+  vec2 normal = vec2(-dir.y, dir.x);
+
+  // In world units the width shrinks with distance.
+  float hwa = (worldScale>0.0)?(halfWidth*worldScale*screenSize.y/a.w):halfWidth;
+  float hwb = (worldScale>0.0)?(halfWidth*worldScale*screenSize.y/b.w):halfWidth;
+  float hw = mix(hwa, hwb, inCorner.x);
+
+  // Joins between segments are round so they extend like round caps, butt caps don't extend.
+  float cap = mix(inCaps.x, inCaps.y, inCorner.x);
+  float extend = ((cap>0.5 && capStyle<0.5)?0.0:hw) + fringe;
+  float along = (inCorner.x>0.5)?(len+extend):(-extend);
+  float across = inCorner.y*(hw+fringe);
+
+  vec4 p = (inCorner.x>0.5)?b:a;
+  vec2 s = sa + dir*along + normal*across;
+  gl_Position = vec4((s/halfScreen)*p.w, p.z, p.w);
+
+  // Multiplied by w and divided again in the fragment shader to undo perspective correction, the
+  // distances need to be interpolated linearly in screen space.
+  lineCoord = vec4(along, across, hw, 1.0)*p.w;
+  lineLength = len;
+
+  // The neighbouring points in the same space as lineCoord, these are the same for every corner.
+  vec2 sp = neighbour(inPrevious, a, halfScreen) - sa;
+  vec2 sn = neighbour(inNext, b, halfScreen) - sa;
+  joins = vec4(dot(sp, dir), dot(sp, normal), dot(sn, dir), dot(sn, normal));
+}
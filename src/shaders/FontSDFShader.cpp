@@ -0,0 +1,13 @@
+#include "tp_maps/shaders/FontSDFShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+const std::string& FontSDFShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/FontSDFShader.frag"};
+  return s.dataStr(shaderProfile(), shaderType);
+}
+
+}
@@ -8,6 +8,8 @@
 
 #include "glm/gtc/type_ptr.hpp"
 
+#include <algorithm>
+
 //Note: GL
 
 namespace tp_maps
@@ -21,6 +23,45 @@ struct Vertex_lt
   glm::vec3 position{};
   glm::vec2 texture{};
 };
+
+//##################################################################################################
+//! A range of indexes that use the same atlas page.
+struct PageRange_lt
+{
+  size_t page{0};
+  GLuint start{0};
+  GLuint count{0};
+};
+
+//##################################################################################################
+struct BatchVertex_lt
+{
+  glm::vec3 position{};
+  glm::vec2 texture{};
+  glm::vec4 color{};
+};
+
+//##################################################################################################
+struct BatchString_lt
+{
+  FontShader::PreparedString* preparedString{nullptr};
+  glm::vec3 position{0.0f};
+  glm::vec4 color{1.0f};
+
+  // The revision of the prepared string geometry that was written to the buffer.
+  size_t revision{0};
+
+  // The slot in the vertex buffer of each glyph, 6 vertices per slot.
+  std::vector<size_t> slots;
+
+  // Slots left empty when the string changed to fewer glyphs, kept so it can grow back in place.
+  std::vector<size_t> spareSlots;
+
+  bool dirty{true};
+
+  // Set when the prepared string has been replaced, its glyphs need writing to the slots.
+  bool replaced{false};
+};
 }
 
 //##################################################################################################
@@ -32,6 +73,14 @@ struct FontShader::Private
 
   GLint matrixLocation{0};
   GLint colorLocation{0};
+  GLint alphaAtlasLocation{-1};
+
+  //################################################################################################
+  //! Tell the shader if the atlas only holds coverage, the SDF shader doesn't use this.
+  void setAtlasMode(FontRenderer* fontRenderer)
+  {
+    glUniform1f(alphaAtlasLocation, (fontRenderer->atlasMode()==FontAtlasMode::Alpha)?1.0f:0.0f);
+  }
 };
 
 //##################################################################################################
@@ -54,6 +103,11 @@ struct FontShader::PreparedString::Private
   GLuint vertexCount{0};
   GLuint  indexCount{0};
 
+  std::vector<PageRange_lt> pageRanges;
+
+  // Incremented each time the geometry changes so that batches know to rewrite the string.
+  size_t revision{0};
+
   bool regenerateBuffers{true};
   bool valid{false};
 
@@ -105,10 +159,228 @@ struct FontShader::PreparedString::Private
     vboID      = 0;
     vertexCount= 0;
     indexCount = 0;
+    pageRanges.clear();
     valid = false;
   }
 };
 
+//##################################################################################################
+struct FontShader::Batch::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_maps::FontShader::Batch::Private");
+  TP_NONCOPYABLE(Private);
+
+  Map* map;
+  FontRenderer* fontRenderer;
+
+  std::vector<BatchString_lt> strings;
+
+  // A copy of the vertex buffer so that changed strings can be written in place.
+  std::vector<BatchVertex_lt> verts;
+
+  // Ranges of vertices that use the same atlas page.
+  std::vector<PageRange_lt> pageRanges;
+
+  GLuint vaoID{0};
+  GLuint vboID{0};
+
+  size_t drawCount{0};
+
+  // Set when the number or order of glyphs has changed and the whole buffer needs rebuilding.
+  bool rebuild{true};
+
+  //################################################################################################
+  Private(FontRenderer* fontRenderer_):
+    map(fontRenderer_->map()),
+    fontRenderer(fontRenderer_)
+  {
+
+  }
+
+  //################################################################################################
+  ~Private()
+  {
+    freeBuffers();
+  }
+
+  //################################################################################################
+  void bindVBO()
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, vboID);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex_lt), tpVoidLiteral( 0));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex_lt), tpVoidLiteral(12));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(BatchVertex_lt), tpVoidLiteral(20));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glDisableVertexAttribArray(3);
+  }
+
+  //################################################################################################
+  void freeBuffers()
+  {
+    if(!vboID)
+      return;
+
+    map->makeCurrent();
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+    tpDeleteVertexArrays(1, &vaoID);
+#endif
+
+    glDeleteBuffers(1, &vboID);
+
+    vaoID = 0;
+    vboID = 0;
+    rebuild = true;
+  }
+
+  //################################################################################################
+  //! Write the 6 vertices for each glyph of a string into its slots.
+  void writeString(const BatchString_lt& string)
+  {
+    static const size_t corners[6]={0, 1, 2, 0, 2, 3};
+
+    const auto& glyphs = string.preparedString->fontGeometry().glyphs;
+    bool topDown = string.preparedString->config().topDown;
+
+    for(size_t g=0; g<string.slots.size(); g++)
+    {
+      const auto& glyph = glyphs.at(g);
+      BatchVertex_lt* v = verts.data() + string.slots.at(g)*6;
+      for(size_t i : corners)
+      {
+        glm::vec2 vertex = glyph.vertices.at(i);
+        if(topDown)
+          vertex.y = -vertex.y;
+
+        v->position = string.position + glm::vec3(vertex, 0.0f);
+        v->texture = glyph.textureCoords.at(i);
+        v->color = string.color;
+        v++;
+      }
+    }
+  }
+
+  //################################################################################################
+  //! The atlas page that a slot draws from.
+  size_t slotPage(size_t slot) const
+  {
+    for(const auto& range : pageRanges)
+      if(slot*6>=range.start && slot*6<range.start+range.count)
+        return range.page;
+    return 0;
+  }
+
+  //################################################################################################
+  //! Write a string whose glyphs have changed into the slots that it already has.
+  /*!
+  \return false if the string needs more slots on a page than it has, the batch must be laid out
+  again.
+  */
+  bool rewriteString(BatchString_lt& string)
+  {
+    std::vector<std::vector<size_t>> available;
+    auto addAvailable = [&](size_t slot)
+    {
+      size_t page = slotPage(slot);
+      if(page>=available.size())
+        available.resize(page+1);
+      available.at(page).push_back(slot);
+    };
+
+    for(auto slot : string.slots)
+      addAvailable(slot);
+    for(auto slot : string.spareSlots)
+      addAvailable(slot);
+
+    const auto& glyphs = string.preparedString->fontGeometry().glyphs;
+    std::vector<size_t> used(available.size(), 0);
+    std::vector<size_t> slots;
+    slots.reserve(glyphs.size());
+    for(const auto& glyph : glyphs)
+    {
+      if(glyph.page>=available.size() || used.at(glyph.page)>=available.at(glyph.page).size())
+        return false;
+      slots.push_back(available.at(glyph.page).at(used.at(glyph.page)++));
+    }
+
+    string.slots.swap(slots);
+    string.spareSlots.clear();
+    for(size_t p=0; p<available.size(); p++)
+    {
+      for(size_t i=used.at(p); i<available.at(p).size(); i++)
+      {
+        size_t slot = available.at(p).at(i);
+        string.spareSlots.push_back(slot);
+
+        // Zero area triangles with no color draw nothing.
+        std::fill(verts.begin()+std::ptrdiff_t(slot*6), verts.begin()+std::ptrdiff_t(slot*6+6), BatchVertex_lt());
+      }
+    }
+
+    writeString(string);
+    return true;
+  }
+
+  //################################################################################################
+  //! Assign slots to every glyph so that glyphs on the same page are contiguous.
+  void layout()
+  {
+    TP_FUNCTION_TIME("FontShader::Batch::layout");
+
+    std::vector<size_t> pageCounts;
+    for(const auto& string : strings)
+    {
+      if(!string.preparedString)
+        continue;
+
+      for(const auto& glyph : string.preparedString->fontGeometry().glyphs)
+      {
+        if(glyph.page>=pageCounts.size())
+          pageCounts.resize(glyph.page+1, 0);
+        pageCounts.at(glyph.page)++;
+      }
+    }
+
+    pageRanges.clear();
+    std::vector<size_t> pageOffsets(pageCounts.size(), 0);
+    size_t total=0;
+    for(size_t p=0; p<pageCounts.size(); p++)
+    {
+      pageOffsets.at(p) = total;
+      if(pageCounts.at(p)>0)
+      {
+        auto& range = pageRanges.emplace_back();
+        range.page = p;
+        range.start = GLuint(total*6);
+        range.count = GLuint(pageCounts.at(p)*6);
+      }
+      total += pageCounts.at(p);
+    }
+
+    verts.resize(total*6);
+
+    for(auto& string : strings)
+    {
+      string.slots.clear();
+      string.spareSlots.clear();
+      string.dirty = false;
+      string.replaced = false;
+
+      if(!string.preparedString)
+        continue;
+
+      const auto& glyphs = string.preparedString->fontGeometry().glyphs;
+      string.slots.reserve(glyphs.size());
+      for(const auto& glyph : glyphs)
+        string.slots.push_back(pageOffsets.at(glyph.page)++);
+
+      writeString(string);
+    }
+  }
+};
+
 //##################################################################################################
 FontShader::FontShader(Map* map, tp_maps::ShaderProfile shaderProfile):
   Shader(map, shaderProfile),
@@ -150,7 +422,8 @@ void FontShader::drawPreparedString(PreparedString& preparedString)
 {
   TP_FUNCTION_TIME("FontShader::drawPreparedString");
 
-  setTexture(preparedString.textureID());
+  // Make sure any new glyphs are in the atlas before the geometry is generated.
+  preparedString.textureID();
 
   if(preparedString.d->regenerateBuffers)
   {
@@ -168,8 +441,28 @@ void FontShader::drawPreparedString(PreparedString& preparedString)
       indexes.reserve(fontGeometry.glyphs.size()*6);
       verts.reserve(fontGeometry.glyphs.size()*4);
 
+      // Group the glyphs by atlas page so that each page can be drawn with a single call.
+      std::vector<const GlyphGeometry*> glyphs;
+      glyphs.reserve(fontGeometry.glyphs.size());
       for(const auto& glyph : fontGeometry.glyphs)
+        glyphs.push_back(&glyph);
+      std::stable_sort(glyphs.begin(), glyphs.end(), [](const auto* a, const auto* b){return a->page<b->page;});
+
+      auto& pageRanges = preparedString.d->pageRanges;
+      pageRanges.clear();
+
+      for(const auto* glyphPtr : glyphs)
       {
+        const auto& glyph = *glyphPtr;
+
+        if(pageRanges.empty() || pageRanges.back().page != glyph.page)
+        {
+          auto& range = pageRanges.emplace_back();
+          range.page = glyph.page;
+          range.start = GLuint(indexes.size());
+        }
+        pageRanges.back().count += 6;
+
         auto i = verts.size();
 
         indexes.push_back(GLushort(i+0));
@@ -237,16 +530,169 @@ void FontShader::drawPreparedString(PreparedString& preparedString)
   if(preparedString.d->valid)
   {
     TP_FUNCTION_TIME("FontShader::drawPreparedString draw");
+
+    // The color attribute is only used by batches, use the color uniform on its own.
+    glVertexAttrib4f(2, 1.0f, 1.0f, 1.0f, 1.0f);
+    d->setAtlasMode(preparedString.fontRenderer());
+
 #ifdef TP_VERTEX_ARRAYS_SUPPORTED
     tpBindVertexArray(preparedString.d->vaoID);
-    tpDrawElements(GL_TRIANGLES,
-                   preparedString.d->indexCount,
-                   GL_UNSIGNED_SHORT,
-                   nullptr);
+    if(preparedString.d->pageRanges.size()==1)
+    {
+      setTexture(preparedString.pageTextureID(preparedString.d->pageRanges.front().page));
+      tpDrawElements(GL_TRIANGLES,
+                     preparedString.d->indexCount,
+                     GL_UNSIGNED_SHORT,
+                     nullptr);
+    }
+    else
+    {
+      for(const auto& range : preparedString.d->pageRanges)
+      {
+        setTexture(preparedString.pageTextureID(range.page));
+        glDrawElements(GL_TRIANGLES, GLsizei(range.count), GL_UNSIGNED_SHORT, tpVoidLiteral(range.start*sizeof(GLushort)));
+      }
+    }
     tpBindVertexArray(0);
 #else
     preparedString.d->bindVBO();
-    glDrawArrays(GL_TRIANGLES, 0, preparedString.d->indexCount);
+    for(const auto& range : preparedString.d->pageRanges)
+    {
+      setTexture(preparedString.pageTextureID(range.page));
+      glDrawArrays(GL_TRIANGLES, GLint(range.start), GLsizei(range.count));
+    }
+#endif
+  }
+}
+
+//##################################################################################################
+void FontShader::drawBatch(Batch& batch)
+{
+  TP_FUNCTION_TIME("FontShader::drawBatch");
+
+  auto bd = batch.d;
+  bd->drawCount = 0;
+
+  // Make sure any new glyphs are in the atlas before the geometry is used.
+  bd->fontRenderer->textureID();
+
+  size_t dirtyStart=bd->verts.size();
+  size_t dirtyEnd=0;
+
+  auto addDirtySlot = [&](size_t slot)
+  {
+    dirtyStart = tpMin(dirtyStart, slot*6);
+    dirtyEnd   = tpMax(dirtyEnd, slot*6+6);
+  };
+
+  if(!bd->rebuild)
+  {
+    for(auto& string : bd->strings)
+    {
+      if(string.preparedString && (string.replaced || string.revision != string.preparedString->d->revision))
+      {
+        // Only lay out the whole batch again if the new glyphs don't fit in the old slots.
+        if(!bd->rewriteString(string))
+        {
+          bd->rebuild = true;
+          break;
+        }
+
+        string.revision = string.preparedString->d->revision;
+        string.replaced = false;
+        string.dirty = false;
+        for(auto slot : string.slots)
+          addDirtySlot(slot);
+        for(auto slot : string.spareSlots)
+          addDirtySlot(slot);
+      }
+    }
+  }
+
+  if(bd->rebuild)
+  {
+    bd->rebuild = false;
+    bd->layout();
+
+    for(auto& string : bd->strings)
+      if(string.preparedString)
+        string.revision = string.preparedString->d->revision;
+
+    // The number of glyphs may have changed so upload the whole buffer.
+    if(bd->vboID)
+    {
+      glBindBuffer(GL_ARRAY_BUFFER, bd->vboID);
+      glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(bd->verts.size()*sizeof(BatchVertex_lt)), bd->verts.data(), GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+  }
+  else
+  {
+    for(auto& string : bd->strings)
+    {
+      if(!string.dirty)
+        continue;
+
+      string.dirty = false;
+      if(string.slots.empty())
+        continue;
+
+      bd->writeString(string);
+      for(auto slot : string.slots)
+        addDirtySlot(slot);
+    }
+  }
+
+  if(bd->verts.empty())
+    return;
+
+  if(!bd->vboID)
+  {
+    glGenBuffers(1, &bd->vboID);
+    glBindBuffer(GL_ARRAY_BUFFER, bd->vboID);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(bd->verts.size()*sizeof(BatchVertex_lt)), bd->verts.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+    tpGenVertexArrays(1, &bd->vaoID);
+    tpBindVertexArray(bd->vaoID);
+    bd->bindVBO();
+    tpBindVertexArray(0);
+#endif
+  }
+
+  if(dirtyEnd>dirtyStart)
+  {
+    TP_FUNCTION_TIME("FontShader::drawBatch upload");
+    glBindBuffer(GL_ARRAY_BUFFER, bd->vboID);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    GLintptr(dirtyStart*sizeof(BatchVertex_lt)),
+                    GLsizeiptr((dirtyEnd-dirtyStart)*sizeof(BatchVertex_lt)),
+                    bd->verts.data()+dirtyStart);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  {
+    TP_FUNCTION_TIME("FontShader::drawBatch draw");
+    d->setAtlasMode(bd->fontRenderer);
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+    tpBindVertexArray(bd->vaoID);
+#else
+    bd->bindVBO();
+#endif
+
+    for(const auto& range : bd->pageRanges)
+    {
+      setTexture(bd->fontRenderer->pageTextureID(range.page));
+      glDrawArrays(GL_TRIANGLES, GLint(range.start), GLsizei(range.count));
+      bd->drawCount++;
+    }
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+    tpBindVertexArray(0);
+#else
+    glDisableVertexAttribArray(2);
 #endif
   }
 }
@@ -285,6 +731,7 @@ void FontShader::bindLocations(GLuint program, ShaderType shaderType)
 
   glBindAttribLocation(program, 0, "inVertex");
   glBindAttribLocation(program, 1, "inTexture");
+  glBindAttribLocation(program, 2, "inColor");
 }
 
 //##################################################################################################
@@ -294,6 +741,7 @@ void FontShader::getLocations(GLuint program, ShaderType shaderType)
 
   d->matrixLocation = glGetUniformLocation(program, "matrix");
   d->colorLocation  = glGetUniformLocation(program, "color");
+  d->alphaAtlasLocation = glGetUniformLocation(program, "alphaAtlas");
 
   if(d->matrixLocation<0)
     tpWarning() << "FontShader d->matrixLocation: " << d->matrixLocation;
@@ -343,6 +791,8 @@ void FontShader::PreparedString::invalidateBuffers()
   d->vboID       = 0;
   d->vertexCount = 0;
   d->indexCount  = 0;
+  d->pageRanges.clear();
+  d->revision++;
 
   tp_maps::PreparedString::invalidateBuffers();
 }
@@ -355,8 +805,89 @@ void FontShader::PreparedString::regenerateBuffers()
 
   d->regenerateBuffers = true;
   d->valid = false;
+  d->revision++;
 
   tp_maps::PreparedString::regenerateBuffers();
 }
 
+//##################################################################################################
+FontShader::Batch::Batch(FontRenderer* fontRenderer):
+  d(new Private(fontRenderer))
+{
+
+}
+
+//##################################################################################################
+FontShader::Batch::~Batch()
+{
+  delete d;
+}
+
+//##################################################################################################
+void FontShader::Batch::clear()
+{
+  d->strings.clear();
+  d->rebuild = true;
+}
+
+//##################################################################################################
+size_t FontShader::Batch::addString(PreparedString* preparedString,
+                                    const glm::vec3& position,
+                                    const glm::vec4& color)
+{
+  size_t index = d->strings.size();
+  auto& string = d->strings.emplace_back();
+  string.preparedString = preparedString;
+  string.position = position;
+  string.color = color;
+  d->rebuild = true;
+  return index;
+}
+
+//##################################################################################################
+void FontShader::Batch::setString(size_t index,
+                                  PreparedString* preparedString,
+                                  const glm::vec3& position,
+                                  const glm::vec4& color)
+{
+  auto& string = d->strings.at(index);
+
+  if(string.preparedString != preparedString)
+  {
+    // Replacing one string with another rewrites its slots in place if the glyphs fit.
+    if(string.preparedString && preparedString)
+      string.replaced = true;
+    else
+      d->rebuild = true;
+
+    string.preparedString = preparedString;
+  }
+  else if(string.position == position && string.color == color)
+    return;
+
+  string.position = position;
+  string.color = color;
+  string.dirty = true;
+}
+
+//##################################################################################################
+size_t FontShader::Batch::size() const
+{
+  return d->strings.size();
+}
+
+//##################################################################################################
+size_t FontShader::Batch::drawCount() const
+{
+  return d->drawCount;
+}
+
+//##################################################################################################
+void FontShader::Batch::invalidateBuffers()
+{
+  d->vaoID = 0;
+  d->vboID = 0;
+  d->rebuild = true;
+}
+
 }
@@ -8,6 +8,8 @@
 
 #include "glm/gtc/type_ptr.hpp"
 
+#include <array>
+
 namespace tp_maps
 {
 
@@ -111,12 +113,17 @@ struct UniformLocations_lt
 
   GLint                             txlSizeLocation{0};
   GLint                       shadowSamplesLocation{0};
+  GLint                  shadowSampleOffsetLocation{-1};
   GLint                      discardOpacityLocation{0};
 
   GLint                         rgbaTextureLocation{0};
   GLint                      normalsTextureLocation{0};
   GLint                        rmttrTextureLocation{0};
 
+  GLint                     rgbaUVTransformLocation{0};
+  GLint                  normalsUVTransformLocation{0};
+  GLint                    rmttrUVTransformLocation{0};
+
   std::vector<LightLocations_lt> lightLocations;
 };
 
@@ -141,8 +148,13 @@ struct G3DMaterialShader::Private
   GLint    lightMVPMatrixLocation{0};
   GLint     lightUVMatrixLocation{0};
   GLint  lightRGBATextureLocation{0};
+  GLint  lightRGBAUVTransformLocation{0};
 
   GLuint emptyTextureID{0};
+
+  //! The textures bound since the last call to use(), when textures are in an atlas most draws
+  //! share the same textures so binding them again can be skipped.
+  std::array<GLuint, 3> boundTextureIDs{0, 0, 0};
   GLuint emptyNormalTextureID{0};
 
   //################################################################################################
@@ -313,6 +325,8 @@ void G3DMaterialShader::use(ShaderType shaderType)
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, map()->writeAlpha());
 
+  d->boundTextureIDs = {0, 0, 0};
+
   Shader::use(shaderType);
 }
 
@@ -375,6 +389,7 @@ void G3DMaterialShader::setLights(const std::vector<tp_math_utils::Light>& light
     }
 
     setShadowSamples(map()->renderModeManger().shadowSamples());
+    setShadowSampleOffset(map()->renderModeManger().progressiveJitter());
   };
 
   if(currentShaderType() == ShaderType::Render)
@@ -573,12 +588,17 @@ void G3DMaterialShader::getLocations(GLuint program, ShaderType shaderType)
 
     locations.txlSizeLocation                = loc(program, "txlSize");
     locations.shadowSamplesLocation          = loc(program, "shadowSamples");
+    locations.shadowSampleOffsetLocation     = loc(program, "shadowSampleOffset");
     locations.discardOpacityLocation         = loc(program, "discardOpacity");
 
     locations.     rgbaTextureLocation       = loc(program, "rgbaTexture"     );
     locations.  normalsTextureLocation       = loc(program, "normalsTexture"  );
     locations.    rmttrTextureLocation       = loc(program, "rmttrTexture"    );
 
+    locations.     rgbaUVTransformLocation   = loc(program, "rgbaUVTransform"   );
+    locations.  normalsUVTransformLocation   = loc(program, "normalsUVTransform");
+    locations.    rmttrUVTransformLocation   = loc(program, "rmttrUVTransform"  );
+
     const auto& lights = map()->lights();
     size_t iMax = tpMin(d->maxLights, lights.size());
 
@@ -640,6 +660,7 @@ void G3DMaterialShader::getLocations(GLuint program, ShaderType shaderType)
     d->lightMVPMatrixLocation = glGetUniformLocation(program, "mvp");
     d->lightUVMatrixLocation    = glGetUniformLocation(program, "uvMatrix");
     d->lightRGBATextureLocation = glGetUniformLocation(program, "rgbaTexture");
+    d->lightRGBAUVTransformLocation = glGetUniformLocation(program, "rgbaUVTransform");
     break;
   }
   }
@@ -660,6 +681,18 @@ void G3DMaterialShader::drawVertexBuffer(GLenum mode, VertexBuffer* vertexBuffer
   d->draw(mode, vertexBuffer);
 }
 
+//##################################################################################################
+void G3DMaterialShader::bindTexture(size_t unit, GLuint textureID, GLint location)
+{
+  if(d->boundTextureIDs.at(unit) == textureID)
+    return;
+
+  d->boundTextureIDs.at(unit) = textureID;
+  glActiveTexture(GLenum(GL_TEXTURE0 + unit));
+  glBindTexture(GL_TEXTURE_2D, textureID);
+  glUniform1i(location, GLint(unit));
+}
+
 //##################################################################################################
 void G3DMaterialShader::setTextures(GLuint rgbaTextureID,
                                     GLuint normalsTextureID,
@@ -667,17 +700,31 @@ void G3DMaterialShader::setTextures(GLuint rgbaTextureID,
 {
   auto exec = [&](const UniformLocations_lt& locations)
   {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, rgbaTextureID);
-    glUniform1i(locations.rgbaTextureLocation, 0);
+    bindTexture(0, rgbaTextureID, locations.rgbaTextureLocation);
+    bindTexture(1, normalsTextureID, locations.normalsTextureLocation);
+    bindTexture(2, rmttrTextureID, locations.rmttrTextureLocation);
+  };
+
+  if(currentShaderType() == ShaderType::Render)
+    exec(d->renderLocations);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, normalsTextureID);
-    glUniform1i(locations.normalsTextureLocation, 1);
+  else if(currentShaderType() == ShaderType::RenderExtendedFBO)
+    exec(d->renderHDRLocations);
+
+  else if(currentShaderType() == ShaderType::Light)
+    bindTexture(0, rgbaTextureID, d->lightRGBATextureLocation);
+}
 
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, rmttrTextureID);
-    glUniform1i(locations.rmttrTextureLocation, 2);
+//##################################################################################################
+void G3DMaterialShader::setTextureUVTransforms(const glm::vec4& rgbaUVTransform,
+                                               const glm::vec4& normalsUVTransform,
+                                               const glm::vec4& rmttrUVTransform)
+{
+  auto exec = [&](const UniformLocations_lt& locations)
+  {
+    glUniform4fv(locations.   rgbaUVTransformLocation, 1, glm::value_ptr(   rgbaUVTransform));
+    glUniform4fv(locations.normalsUVTransformLocation, 1, glm::value_ptr(normalsUVTransform));
+    glUniform4fv(locations.  rmttrUVTransformLocation, 1, glm::value_ptr(  rmttrUVTransform));
   };
 
   if(currentShaderType() == ShaderType::Render)
@@ -687,11 +734,7 @@ void G3DMaterialShader::setTextures(GLuint rgbaTextureID,
     exec(d->renderHDRLocations);
 
   else if(currentShaderType() == ShaderType::Light)
-  {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, rgbaTextureID);
-    glUniform1i(d->lightRGBATextureLocation, 0);
-  }
+    glUniform4fv(d->lightRGBAUVTransformLocation, 1, glm::value_ptr(rgbaUVTransform));
 }
 
 //##################################################################################################
@@ -702,6 +745,22 @@ void G3DMaterialShader::setBlankTextures()
               d->emptyTextureID);
 }
 
+//##################################################################################################
+void G3DMaterialShader::setShadowSampleOffset(const glm::vec2& shadowSampleOffset)
+{
+  auto exec = [&](const UniformLocations_lt& locations)
+  {
+    if(locations.shadowSampleOffsetLocation>=0)
+      glUniform2fv(locations.shadowSampleOffsetLocation, 1, &shadowSampleOffset.x);
+  };
+
+  if(currentShaderType() == ShaderType::Render)
+    exec(d->renderLocations);
+
+  else if(currentShaderType() == ShaderType::RenderExtendedFBO)
+    exec(d->renderHDRLocations);
+}
+
 //##################################################################################################
 void G3DMaterialShader::setShadowSamples(size_t shadowSamples)
 {
@@ -770,6 +829,10 @@ void G3DMaterialShader::setMaterial(RenderInfo& renderInfo,
               processedGeometry3D.alternativeMaterial->normalsTextureID,
               processedGeometry3D.alternativeMaterial->rmttrTextureID);
 
+  setTextureUVTransforms(processedGeometry3D.alternativeMaterial->   rgbaUVTransform,
+                         processedGeometry3D.alternativeMaterial->normalsUVTransform,
+                         processedGeometry3D.alternativeMaterial->  rmttrUVTransform);
+
   setDiscardOpacity((renderInfo.pass == RenderPass::Transparency)?0.01f:0.80f);
 }
 
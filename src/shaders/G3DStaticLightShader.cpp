@@ -48,6 +48,10 @@ struct UniformLocations_lt
   GLint                         rgbaTextureLocation{0};
   GLint                      normalsTextureLocation{0};
   GLint                        rmttrTextureLocation{0};
+
+  GLint                     rgbaUVTransformLocation{0};
+  GLint                  normalsUVTransformLocation{0};
+  GLint                    rmttrUVTransformLocation{0};
 };
 
 }
@@ -185,23 +189,39 @@ void G3DStaticLightShader::setTextures(GLuint rgbaTextureID,
   case ShaderType::Render: [[fallthrough]];
   case ShaderType::RenderExtendedFBO:
   {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, rgbaTextureID);
-    glUniform1i(d->locations.rgbaTextureLocation, 0);
+    bindTexture(0, rgbaTextureID, d->locations.rgbaTextureLocation);
+    bindTexture(1, normalsTextureID, d->locations.normalsTextureLocation);
+    bindTexture(2, rmttrTextureID, d->locations.rmttrTextureLocation);
+    break;
+  }
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, normalsTextureID);
-    glUniform1i(d->locations.normalsTextureLocation, 1);
+  default:
+  {
+    G3DMaterialShader::setTextures(rgbaTextureID, normalsTextureID, rmttrTextureID);
+    break;
+  }
+  }
+}
 
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, rmttrTextureID);
-    glUniform1i(d->locations.rmttrTextureLocation, 2);
+//##################################################################################################
+void G3DStaticLightShader::setTextureUVTransforms(const glm::vec4& rgbaUVTransform,
+                                                  const glm::vec4& normalsUVTransform,
+                                                  const glm::vec4& rmttrUVTransform)
+{
+  switch(currentShaderType())
+  {
+  case ShaderType::Render: [[fallthrough]];
+  case ShaderType::RenderExtendedFBO:
+  {
+    glUniform4fv(d->locations.   rgbaUVTransformLocation, 1, glm::value_ptr(   rgbaUVTransform));
+    glUniform4fv(d->locations.normalsUVTransformLocation, 1, glm::value_ptr(normalsUVTransform));
+    glUniform4fv(d->locations.  rmttrUVTransformLocation, 1, glm::value_ptr(  rmttrUVTransform));
     break;
   }
 
   default:
   {
-    G3DMaterialShader::setTextures(rgbaTextureID, normalsTextureID, rmttrTextureID);
+    G3DMaterialShader::setTextureUVTransforms(rgbaUVTransform, normalsUVTransform, rmttrUVTransform);
     break;
   }
   }
@@ -342,6 +362,10 @@ void G3DStaticLightShader::getLocations(GLuint program, ShaderType shaderType)
     d->locations.     rgbaTextureLocation       = loc(program, "rgbaTexture"     );
     d->locations.  normalsTextureLocation       = loc(program, "normalsTexture"  );
     d->locations.    rmttrTextureLocation       = loc(program, "rmttrTexture"    );
+
+    d->locations.     rgbaUVTransformLocation   = loc(program, "rgbaUVTransform"   );
+    d->locations.  normalsUVTransformLocation   = loc(program, "normalsUVTransform");
+    d->locations.    rmttrUVTransformLocation   = loc(program, "rmttrUVTransform"  );
     break;
   }
 
@@ -29,6 +29,33 @@ struct LineShader::Private
 #else
     vertexBuffer->bindVBO();
     glDrawArrays(mode, 0, vertexBuffer->indexCount);
+#endif
+  }
+
+  //################################################################################################
+  void drawRanges(GLenum mode,
+                  LineShader::VertexBuffer* vertexBuffer,
+                  const std::vector<GLint>& firsts,
+                  const std::vector<GLsizei>& counts)
+  {
+    if(firsts.empty() || firsts.size() != counts.size())
+      return;
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+    tpBindVertexArray(vertexBuffer->vaoID);
+#else
+    vertexBuffer->bindVBO();
+#endif
+
+#ifdef TP_MULTI_DRAW_SUPPORTED
+    glMultiDrawArrays(mode, firsts.data(), counts.data(), GLsizei(firsts.size()));
+#else
+    for(size_t i=0; i<firsts.size(); i++)
+      glDrawArrays(mode, firsts.at(i), counts.at(i));
+#endif
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+    tpBindVertexArray(0);
 #endif
   }
 };
@@ -127,7 +154,9 @@ void LineShader::setColor(const glm::vec4& color)
 }
 
 //##################################################################################################
-LineShader::VertexBuffer* LineShader::generateVertexBuffer(Map* map, const std::vector<glm::vec3>& vertices) const
+LineShader::VertexBuffer* LineShader::generateVertexBuffer(Map* map,
+                                                          const std::vector<glm::vec3>& vertices,
+                                                          GLenum usage) const
 {
   auto vertexBuffer = new VertexBuffer(map, this);
 
@@ -150,7 +179,7 @@ LineShader::VertexBuffer* LineShader::generateVertexBuffer(Map* map, const std::
 
   glGenBuffers(1, &vertexBuffer->vboID);
   glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
-  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertices.size()*sizeof(glm::vec3)), vertices.data(), GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertices.size()*sizeof(glm::vec3)), vertices.data(), usage);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 
   tpGenVertexArrays(1, &vertexBuffer->vaoID);
@@ -163,13 +192,57 @@ LineShader::VertexBuffer* LineShader::generateVertexBuffer(Map* map, const std::
 
   glGenBuffers(1, &vertexBuffer->vboID);
   glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
-  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertices.size()*sizeof(glm::vec3)), vertices.data(), GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertices.size()*sizeof(glm::vec3)), vertices.data(), usage);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif
 
   return vertexBuffer;
 }
 
+//##################################################################################################
+LineShader::VertexBuffer* LineShader::generateArrayBuffer(Map* map,
+                                                          const std::vector<glm::vec3>& vertices,
+                                                          GLenum usage) const
+{
+  auto vertexBuffer = new VertexBuffer(map, this);
+
+  if(vertices.empty())
+    return vertexBuffer;
+
+  // indexCount is left at 0 so the indexed drawLines will skip this buffer.
+  vertexBuffer->vertexCount = GLuint(vertices.size());
+
+  glGenBuffers(1, &vertexBuffer->vboID);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
+  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertices.size()*sizeof(glm::vec3)), vertices.data(), usage);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+  tpGenVertexArrays(1, &vertexBuffer->vaoID);
+  tpBindVertexArray(vertexBuffer->vaoID);
+  vertexBuffer->bindVBO();
+  tpBindVertexArray(0);
+#endif
+
+  return vertexBuffer;
+}
+
+//##################################################################################################
+void LineShader::updateVertexBuffer(VertexBuffer* vertexBuffer,
+                                    const std::vector<glm::vec3>& vertices,
+                                    size_t first) const
+{
+  if(vertices.empty() || !vertexBuffer->vboID || first+vertices.size()>vertexBuffer->vertexCount)
+    return;
+
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  GLintptr(first*sizeof(glm::vec3)),
+                  GLsizeiptr(vertices.size()*sizeof(glm::vec3)),
+                  vertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 //##################################################################################################
 LineShader::VertexBuffer::VertexBuffer(Map* map_, const Shader *shader_):
   map(map_),
@@ -215,4 +288,13 @@ void LineShader::drawLines(GLenum mode, LineShader::VertexBuffer* vertexBuffer)
   d->draw(mode, vertexBuffer);
 }
 
+//##################################################################################################
+void LineShader::drawLines(GLenum mode,
+                           LineShader::VertexBuffer* vertexBuffer,
+                           const std::vector<GLint>& firsts,
+                           const std::vector<GLsizei>& counts)
+{
+  d->drawRanges(mode, vertexBuffer, firsts, counts);
+}
+
 }
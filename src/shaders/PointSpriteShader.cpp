@@ -10,14 +10,95 @@ namespace tp_maps
 
 namespace
 {
-//There will be 4 of these generated for each PointSprite.
+//There will be 1 of these generated for each PointSprite.
 struct PointSprite_lt
 {
-  glm::vec4 color{};    //The color to multiply the texture by.
-  glm::vec3 position{}; //The center coordinate of the point sprite.
-  glm::vec3 offset{};   //The offset of each corner in relation to the position.
-  glm::vec2 texture{};  //Texture coords for this corner.
+  glm::vec4 color{};       //The color to multiply the texture by.
+  glm::vec3 position{};    //The center coordinate of the point sprite.
+  glm::vec3 offset{};      //The offset of the point sprite in units of radius.
+  glm::vec4 textureRect{}; //Texture coords of the bottom left and top right corners.
+  float radius{1.0f};      //The radius of the point sprite in pixels.
 };
+
+//##################################################################################################
+void fillPointSprite(PointSprite_lt& ps,
+                     const PointSpriteShader::PointSprite& p,
+                     const std::vector<SpriteCoords>& coords)
+{
+  ps.color    = p.color;
+  ps.position = p.position;
+  ps.offset   = p.offset;
+  ps.radius   = p.radius;
+
+  if(p.spriteIndex<coords.size())
+  {
+    const auto& c = coords.at(p.spriteIndex).coords;
+    ps.textureRect = {c.at(0), c.at(2)};
+  }
+  else
+    ps.textureRect = {0.0f, 0.0f, 1.0f, 1.0f};
+}
+
+//##################################################################################################
+void fillPointSprites(std::vector<PointSprite_lt>& verts,
+                      const std::vector<PointSpriteShader::PointSprite>& pointSptrites,
+                      const std::vector<SpriteCoords>& coords,
+                      size_t first,
+                      size_t count)
+{
+  verts.resize(count);
+  const PointSpriteShader::PointSprite* p = pointSptrites.data() + first;
+  const PointSpriteShader::PointSprite* pMax = p + count;
+  PointSprite_lt* v = verts.data();
+  for(; p<pMax; p++, v++)
+    fillPointSprite(*v, *p, coords);
+}
+
+//##################################################################################################
+//! Create the buffers or change the capacity of the per point buffer, the old contents are lost.
+void allocateVertexBuffer(PointSpriteShader::VertexBuffer* vertexBuffer,
+                          size_t capacity,
+                          const std::vector<PointSprite_lt>& verts,
+                          GLenum usage)
+{
+  bool create = !vertexBuffer->vboID;
+  if(create)
+    glGenBuffers(1, &vertexBuffer->vboID);
+
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
+  glBufferData(GL_ARRAY_BUFFER, TPGLsizei(capacity*sizeof(PointSprite_lt)), nullptr, usage);
+  if(!verts.empty())
+    glBufferSubData(GL_ARRAY_BUFFER, 0, TPGLsizei(verts.size()*sizeof(PointSprite_lt)), verts.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  vertexBuffer->capacity = GLuint(capacity);
+
+#ifdef TP_INSTANCING_SUPPORTED
+  if(!create)
+    return;
+
+  // The corners of the quad in the same order as SpriteCoords, drawn as a triangle fan.
+  const std::array<glm::vec2, 4> corners =
+  {
+    {
+      {-1.0f,-1.0f},
+      { 1.0f,-1.0f},
+      { 1.0f, 1.0f},
+      {-1.0f, 1.0f}
+    }
+  };
+
+  glGenBuffers(1, &vertexBuffer->quadVboID);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->quadVboID);
+  glBufferData(GL_ARRAY_BUFFER, TPGLsizei(corners.size()*sizeof(glm::vec2)), corners.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  tpGenVertexArrays(1, &vertexBuffer->vaoID);
+  tpBindVertexArray(vertexBuffer->vaoID);
+  vertexBuffer->bindVBO();
+  tpBindVertexArray(0);
+#endif
+}
 }
 
 //##################################################################################################
@@ -41,19 +122,17 @@ struct PointSpriteShader::Private
   //################################################################################################
   void draw(PointSpriteShader::VertexBuffer* vertexBuffer)
   {
-    if(vertexBuffer->indexCount<3)
+    if(vertexBuffer->pointCount<1)
       return;
 
-#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+#ifdef TP_INSTANCING_SUPPORTED
     tpBindVertexArray(vertexBuffer->vaoID);
-    tpDrawElements(GL_TRIANGLES,
-                   vertexBuffer->indexCount,
-                   GL_UNSIGNED_INT,
-                   nullptr);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, GLsizei(vertexBuffer->pointCount));
     tpBindVertexArray(0);
 #else
     vertexBuffer->bindVBO();
-    glDrawArrays(GL_TRIANGLES, 0, vertexBuffer->indexCount);
+    glDrawArrays(GL_POINTS, 0, GLsizei(vertexBuffer->pointCount));
+    glDisableVertexAttribArray(4);
 #endif
   }
 };
@@ -83,7 +162,11 @@ const std::string& PointSpriteShader::vertexShaderStr(ShaderType shaderType)
   }
 #endif
 
+#ifdef TP_INSTANCING_SUPPORTED
   static ShaderResource s{"/tp_maps/PointSpriteShader.vert"};
+#else
+  static ShaderResource s{"/tp_maps/PointSpriteShader.points.vert"};
+#endif
   return s.dataStr(shaderProfile(), shaderType);
 }
 
@@ -98,7 +181,11 @@ const std::string& PointSpriteShader::fragmentShaderStr(ShaderType shaderType)
   }
 #endif
 
+#ifdef TP_INSTANCING_SUPPORTED
   static ShaderResource s{"/tp_maps/PointSpriteShader.frag"};
+#else
+  static ShaderResource s{"/tp_maps/PointSpriteShader.points.frag"};
+#endif
   return s.dataStr(shaderProfile(), shaderType);
 }
 
@@ -110,7 +197,9 @@ void PointSpriteShader::bindLocations(GLuint program, ShaderType shaderType)
   glBindAttribLocation(program, 0, "inColor");
   glBindAttribLocation(program, 1, "inPosition");
   glBindAttribLocation(program, 2, "inOffset");
-  glBindAttribLocation(program, 3, "inTexture");
+  glBindAttribLocation(program, 3, "inTextureRect");
+  glBindAttribLocation(program, 4, "inRadius");
+  glBindAttribLocation(program, 5, "inCorner");
 }
 
 //##################################################################################################
@@ -231,9 +320,11 @@ PointSpriteShader::VertexBuffer::~VertexBuffer()
 #ifdef TP_VERTEX_ARRAYS_SUPPORTED
   if(vaoID)
     tpDeleteVertexArrays(1, &vaoID);
+#endif
 
-  if(iboID)
-    glDeleteBuffers(1, &iboID);
+#ifdef TP_INSTANCING_SUPPORTED
+  if(quadVboID)
+    glDeleteBuffers(1, &quadVboID);
 #endif
 
   if(vboID)
@@ -247,14 +338,22 @@ void PointSpriteShader::VertexBuffer::bindVBO() const
   glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(PointSprite_lt), tpVoidLiteral( 0)); //vec4 color;
   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(PointSprite_lt), tpVoidLiteral(16)); //vec3 position;
   glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(PointSprite_lt), tpVoidLiteral(28)); //vec3 offset;
-  glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(PointSprite_lt), tpVoidLiteral(40)); //vec2 texture;
+  glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(PointSprite_lt), tpVoidLiteral(40)); //vec4 textureRect;
+  glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(PointSprite_lt), tpVoidLiteral(56)); //float radius;
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
   glEnableVertexAttribArray(2);
   glEnableVertexAttribArray(3);
+  glEnableVertexAttribArray(4);
 
-#ifdef TP_VERTEX_ARRAYS_SUPPORTED
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
+#ifdef TP_INSTANCING_SUPPORTED
+  for(GLuint i=0; i<5; i++)
+    glVertexAttribDivisor(i, 1);
+
+  glBindBuffer(GL_ARRAY_BUFFER, quadVboID);
+  glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr); //vec2 corner;
+  glEnableVertexAttribArray(5);
+  glVertexAttribDivisor(5, 0);
 #endif
 }
 
@@ -268,89 +367,50 @@ PointSpriteShader::VertexBuffer* PointSpriteShader::generateVertexBuffer(Map* ma
   if(pointSptrites.empty())
     return vertexBuffer;
 
-  std::vector<GLuint> indexes;
   std::vector<PointSprite_lt> verts;
+  fillPointSprites(verts, pointSptrites, coords, 0, pointSptrites.size());
 
-  const std::array<glm::vec3, 4> offsets =
-  {
-    {
-      {-1.0f,-1.0f,0.0f},
-      { 1.0f,-1.0f,0.0f},
-      { 1.0f, 1.0f,0.0f},
-      {-1.0f, 1.0f,0.0f}
-    }
-  };
+  vertexBuffer->pointCount = GLuint(verts.size());
+  allocateVertexBuffer(vertexBuffer, verts.size(), verts, GL_STATIC_DRAW);
 
-  const std::array<glm::vec2, 4> textureCoords =
-  {
-    {
-      {0.0f,0.0f},
-      {1.0f,0.0f},
-      {1.0f,1.0f},
-      {0.0f,1.0f}
-    }
-  };
+  return vertexBuffer;
+}
 
+//##################################################################################################
+void PointSpriteShader::updateVertexBuffer(VertexBuffer* vertexBuffer,
+                                           const std::vector<PointSprite>& pointSptrites,
+                                           const std::vector<SpriteCoords>& coords,
+                                           size_t first,
+                                           size_t count) const
+{
+  size_t pointCount = pointSptrites.size();
+  vertexBuffer->pointCount = GLuint(pointCount);
+
+  std::vector<PointSprite_lt> verts;
+
+  if(pointCount>vertexBuffer->capacity || !vertexBuffer->vboID)
   {
-    const PointSpriteShader::PointSprite* p = pointSptrites.data();
-    const PointSpriteShader::PointSprite* pMax = p + pointSptrites.size();
-    indexes.reserve(pointSptrites.size()*6);
-    for(; p<pMax; p++)
-    {
-      indexes.push_back(GLuint(verts.size()+0));
-      indexes.push_back(GLuint(verts.size()+1));
-      indexes.push_back(GLuint(verts.size()+3));
-      indexes.push_back(GLuint(verts.size()+1));
-      indexes.push_back(GLuint(verts.size()+2));
-      indexes.push_back(GLuint(verts.size()+3));
-
-      const auto& texCoords = (p->spriteIndex<coords.size())?coords.at(p->spriteIndex).coords:textureCoords;
-
-      for(size_t i=0; i<4; i++)
-      {
-        PointSprite_lt& ps = verts.emplace_back();
-        ps.color    = p->color;
-        ps.position = p->position;
-        ps.offset   = p->offset+offsets.at(i);
-        ps.offset.x *=p->radius;
-        ps.offset.y *=p->radius;
-        ps.texture  = texCoords.at(i);
-      }
-    }
+    fillPointSprites(verts, pointSptrites, coords, 0, pointCount);
+    size_t capacity = tpMax(pointCount, size_t(vertexBuffer->capacity)*2);
+    allocateVertexBuffer(vertexBuffer, capacity, verts, GL_DYNAMIC_DRAW);
+    return;
   }
-  vertexBuffer->indexCount  = GLuint(indexes.size());
 
-#ifdef TP_VERTEX_ARRAYS_SUPPORTED
-  vertexBuffer->vertexCount = GLuint(verts.size());
-
-  glGenBuffers(1, &vertexBuffer->iboID);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertexBuffer->iboID);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, TPGLsizei(indexes.size()*sizeof(GLuint)), indexes.data(), GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  if(first>=pointCount)
+    return;
 
-  glGenBuffers(1, &vertexBuffer->vboID);
-  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
-  glBufferData(GL_ARRAY_BUFFER, TPGLsizei(verts.size()*sizeof(PointSprite_lt)), verts.data(), GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  count = tpMin(count, pointCount-first);
+  if(count==0)
+    return;
 
-  tpGenVertexArrays(1, &vertexBuffer->vaoID);
-  tpBindVertexArray(vertexBuffer->vaoID);
-  vertexBuffer->bindVBO();
-  tpBindVertexArray(0);
-#else
-  vertexBuffer->vertexCount = GLuint(indexes.size());
-  std::vector<PointSprite_lt> indexedVerts;
-  indexedVerts.reserve(indexes.size());
-  for(auto index : indexes)
-    indexedVerts.push_back(verts.at(size_t(index)));
+  fillPointSprites(verts, pointSptrites, coords, first, count);
 
-  glGenBuffers(1, &vertexBuffer->vboID);
   glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
-  glBufferData(GL_ARRAY_BUFFER, TPGLsizei(indexedVerts.size()*sizeof(PointSprite_lt)), indexedVerts.data(), GL_STATIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  GLintptr(first*sizeof(PointSprite_lt)),
+                  TPGLsizei(count*sizeof(PointSprite_lt)),
+                  verts.data());
   glBindBuffer(GL_ARRAY_BUFFER, 0);
-#endif
-
-  return vertexBuffer;
 }
 
 //##################################################################################################
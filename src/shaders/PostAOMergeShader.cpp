@@ -7,6 +7,7 @@ namespace tp_maps
 struct PostAOMergeShader::Private
 {
   GLint ssaoTextureLocation{0};
+  GLint ssaoPixelSizeLocation{-1};
 };
 
 //##################################################################################################
@@ -36,6 +37,13 @@ void PostAOMergeShader::setSSAOTexture(const GLuint ssaoTextureID)
   }
 }
 
+//##################################################################################################
+void PostAOMergeShader::setSSAOTextureSize(size_t width, size_t height)
+{
+  if(d->ssaoPixelSizeLocation>=0)
+    glUniform2f(d->ssaoPixelSizeLocation, 1.0f/float(tpMax(size_t(1), width)), 1.0f/float(tpMax(size_t(1), height)));
+}
+
 //##################################################################################################
 const std::string& PostAOMergeShader::fragmentShaderStr(ShaderType shaderType)
 {
@@ -54,6 +62,7 @@ const std::string& PostAOMergeShader::fragmentShaderStr(ShaderType shaderType)
   AO_FRAG_VARS += "const float boostLowerThreshold="  + std::to_string(parameters.boostLowerThreshold) + ";\n";
   AO_FRAG_VARS += "const float boostUpperFactor="     + std::to_string(parameters.boostUpperFactor) + ";\n";
   AO_FRAG_VARS += "const float boostLowerFactor="     + std::to_string(parameters.boostLowerFactor) + ";\n";
+  AO_FRAG_VARS += "#define RESOLUTION_DIVISOR "       + std::to_string(tpMax(size_t(1), parameters.resolutionDivisor)) + "\n";
 
   tp_utils::replace(fragSrcScratch, "/*AO_FRAG_VARS*/", AO_FRAG_VARS);
 
@@ -64,7 +73,8 @@ const std::string& PostAOMergeShader::fragmentShaderStr(ShaderType shaderType)
 void PostAOMergeShader::getLocations(GLuint program, ShaderType shaderType)
 {
   PostAOBaseShader::getLocations(program, shaderType);
-  d->ssaoTextureLocation = glGetUniformLocation(program, "ssaoTextureSampler");
+  d->ssaoTextureLocation   = glGetUniformLocation(program, "ssaoTextureSampler");
+  d->ssaoPixelSizeLocation = glGetUniformLocation(program, "ssaoPixelSize");
 }
 
 }
@@ -1,5 +1,6 @@
 #include "tp_maps/shaders/PostAOShader.h"
 #include "tp_maps/Map.h"
+#include "tp_maps/RenderModeManager.h"
 
 namespace tp_maps
 {
@@ -16,6 +17,7 @@ struct PostAOShader::Private
   GLuint ssaoNoiseTexture{0};
   GLint ssaoKernelLocation{0};
   GLuint ssaoNoiseTextureLocation{0};
+  GLint noiseOffsetLocation{-1};
 
   //################################################################################################
   ~Private()
@@ -109,6 +111,13 @@ void PostAOShader::use(ShaderType shaderType)
   glActiveTexture(GL_TEXTURE4);
   glBindTexture(GL_TEXTURE_2D, d->ssaoNoiseTexture);
   glUniform1i(d->ssaoNoiseTextureLocation, 4);
+
+  // Rotate the kernel of each progressive sample by stepping through the noise texture.
+  if(d->noiseOffsetLocation>=0)
+  {
+    size_t sample = map()->renderModeManger().progressiveSample();
+    glUniform2f(d->noiseOffsetLocation, float(sample%4)/4.0f, float((sample/4)%4)/4.0f);
+  }
 }
 
 //##################################################################################################
@@ -125,6 +134,7 @@ const std::string& PostAOShader::fragmentShaderStr(ShaderType shaderType)
   AO_FRAG_VARS += "const float radius=" + std::to_string(parameters.radius) + ";\n";
   AO_FRAG_VARS += "#define N_SAMPLES " + std::to_string(parameters.nSamples > 0 ? parameters.nSamples : 1 ) + "\n";
   AO_FRAG_VARS += "const float bias=" + std::to_string(parameters.bias) + ";\n";
+  AO_FRAG_VARS += "const float resolutionDivisor=" + std::to_string(tpMax(size_t(1), parameters.resolutionDivisor)) + ".0;\n";
 
   if(parameters.useScreenBuffer)
   {
@@ -143,6 +153,7 @@ void PostAOShader::getLocations(GLuint program, ShaderType shaderType)
   PostAOBaseShader::getLocations(program, shaderType);
   d->ssaoKernelLocation       = glGetUniformLocation(program, "ssaoKernel");
   d->ssaoNoiseTextureLocation = glGetUniformLocation(program, "noiseSampler");
+  d->noiseOffsetLocation      = glGetUniformLocation(program, "noiseOffset");
 }
 
 //##################################################################################################
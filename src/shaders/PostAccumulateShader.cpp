@@ -0,0 +1,60 @@
+#include "tp_maps/shaders/PostAccumulateShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct PostAccumulateShader::Private
+{
+  GLint historyTextureLocation{-1};
+  GLint blendWeightLocation{-1};
+};
+
+//##################################################################################################
+PostAccumulateShader::PostAccumulateShader(Map* map, tp_maps::ShaderProfile shaderProfile):
+  PostShader(map, shaderProfile),
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+PostAccumulateShader::~PostAccumulateShader()
+{
+  delete d;
+}
+
+//##################################################################################################
+void PostAccumulateShader::setHistoryTexture(const GLuint historyTextureID)
+{
+  if(d->historyTextureLocation>=0)
+  {
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, historyTextureID);
+    glUniform1i(d->historyTextureLocation, 4);
+  }
+}
+
+//##################################################################################################
+void PostAccumulateShader::setBlendWeight(float blendWeight)
+{
+  if(d->blendWeightLocation>=0)
+    glUniform1f(d->blendWeightLocation, blendWeight);
+}
+
+//##################################################################################################
+const std::string& PostAccumulateShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/PostAccumulateShader.frag"};
+  return s.dataStr(shaderProfile(), shaderType);
+}
+
+//##################################################################################################
+void PostAccumulateShader::getLocations(GLuint program, ShaderType shaderType)
+{
+  PostShader::getLocations(program, shaderType);
+  d->historyTextureLocation = glGetUniformLocation(program, "historySampler");
+  d->blendWeightLocation    = glGetUniformLocation(program, "blendWeight");
+}
+
+}
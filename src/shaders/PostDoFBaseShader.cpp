@@ -13,7 +13,9 @@ bool PostDoFParameters::fuzzyEquals(const PostDoFParameters& other) const
          && std::abs(other.nearPlane-nearPlane) <= fuzzFactor*avDepth
          && std::abs(other.farPlane-farPlane) <= fuzzFactor*avDepth
          && std::abs(other.focalDistance-focalDistance) <= fuzzFactor*focalDistance
-         && std::abs(other.blurinessCutoffConstant-blurinessCutoffConstant) <= fuzzFactor*blurinessCutoffConstant;
+         && std::abs(other.blurinessCutoffConstant-blurinessCutoffConstant) <= fuzzFactor*blurinessCutoffConstant
+         && other.fast == fast
+         && std::abs(other.skipThreshold-skipThreshold) <= fuzzFactor*skipThreshold;
 }
 
 //##################################################################################################
@@ -79,4 +81,24 @@ void PostDoFBaseShader::getLocations(GLuint program, ShaderType shaderType)
   d->farLocation = glGetUniformLocation(program, "far");
 }
 
+//##################################################################################################
+std::string PostDoFBaseShader::dofFragVars() const
+{
+  const auto& parameters = d->parameters;
+
+  std::string DOF_FRAG_VARS;
+
+  DOF_FRAG_VARS += "const float depthOfField = " + std::to_string(parameters.depthOfField) + ";\n";
+  DOF_FRAG_VARS += "const float fStop = " + std::to_string(parameters.fStop) + ";\n";
+
+  // For depth calculation
+  DOF_FRAG_VARS += "const float nearPlane = " + std::to_string(parameters.nearPlane) + ";\n";
+  DOF_FRAG_VARS += "const float farPlane = " + std::to_string(parameters.farPlane) + ";\n";
+  DOF_FRAG_VARS += "const float focalDistance = " + std::to_string(parameters.focalDistance) + ";\n";
+  DOF_FRAG_VARS += "const float blurinessCutoffConstant = " + std::to_string(parameters.blurinessCutoffConstant) + ";\n";
+  DOF_FRAG_VARS += "const float skipThreshold = " + std::to_string(parameters.skipThreshold) + ";\n";
+
+  return DOF_FRAG_VARS;
+}
+
 }
@@ -0,0 +1,47 @@
+#include "tp_maps/shaders/PostDoFFastBlurShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct PostDoFFastBlurShader::Private
+{
+  GLint blurStepLocation{-1};
+};
+
+//##################################################################################################
+PostDoFFastBlurShader::PostDoFFastBlurShader(Map* map, tp_maps::ShaderProfile shaderProfile):
+  PostShader(map, shaderProfile),
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+PostDoFFastBlurShader::~PostDoFFastBlurShader()
+{
+  delete d;
+}
+
+//##################################################################################################
+void PostDoFFastBlurShader::setBlurStep(const glm::vec2& blurStep)
+{
+  if(d->blurStepLocation>=0)
+    glUniform2f(d->blurStepLocation, blurStep.x, blurStep.y);
+}
+
+//##################################################################################################
+const std::string& PostDoFFastBlurShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/DoFFastBlurShader.frag"};
+  return s.dataStr(shaderProfile(), shaderType);
+}
+
+//##################################################################################################
+void PostDoFFastBlurShader::getLocations(GLuint program, ShaderType shaderType)
+{
+  PostShader::getLocations(program, shaderType);
+  d->blurStepLocation = glGetUniformLocation(program, "blurStep");
+}
+
+}
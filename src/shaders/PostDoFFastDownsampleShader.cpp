@@ -0,0 +1,15 @@
+#include "tp_maps/shaders/PostDoFFastDownsampleShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+const std::string& PostDoFFastDownsampleShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/DoFFastDownsampleShader.frag"};
+  fragSrcScratch = s.dataStr(shaderProfile(), shaderType);
+  tp_utils::replace(fragSrcScratch, "#pragma replace DOF_FRAG_VARS", dofFragVars());
+  return fragSrcScratch;
+}
+
+}
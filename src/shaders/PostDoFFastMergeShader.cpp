@@ -0,0 +1,55 @@
+#include "tp_maps/shaders/PostDoFFastMergeShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct PostDoFFastMergeShader::Private
+{
+  GLint blurredTextureLocation{-1};
+};
+
+//##################################################################################################
+PostDoFFastMergeShader::PostDoFFastMergeShader(Map* map,
+                                               tp_maps::ShaderProfile shaderProfile,
+                                               const PostDoFParameters& parameters):
+  PostDoFBaseShader(map, shaderProfile, parameters),
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+PostDoFFastMergeShader::~PostDoFFastMergeShader()
+{
+  delete d;
+}
+
+//##################################################################################################
+void PostDoFFastMergeShader::setBlurredTexture(const GLuint blurredTextureID)
+{
+  if(d->blurredTextureLocation>=0)
+  {
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, blurredTextureID);
+    glUniform1i(d->blurredTextureLocation, 4);
+  }
+}
+
+//##################################################################################################
+const std::string& PostDoFFastMergeShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/DoFFastMergeShader.frag"};
+  fragSrcScratch = s.dataStr(shaderProfile(), shaderType);
+  tp_utils::replace(fragSrcScratch, "#pragma replace DOF_FRAG_VARS", dofFragVars());
+  return fragSrcScratch;
+}
+
+//##################################################################################################
+void PostDoFFastMergeShader::getLocations(GLuint program, ShaderType shaderType)
+{
+  PostDoFBaseShader::getLocations(program, shaderType);
+  d->blurredTextureLocation = glGetUniformLocation(program, "blurredTextureSampler");
+}
+
+}
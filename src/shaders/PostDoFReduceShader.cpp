@@ -0,0 +1,52 @@
+#include "tp_maps/shaders/PostDoFReduceShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct PostDoFReduceShader::Private
+{
+  GLint sourceSizeLocation{-1};
+  GLint outputSizeLocation{-1};
+};
+
+//##################################################################################################
+PostDoFReduceShader::PostDoFReduceShader(Map* map, tp_maps::ShaderProfile shaderProfile):
+  PostShader(map, shaderProfile),
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+PostDoFReduceShader::~PostDoFReduceShader()
+{
+  delete d;
+}
+
+//##################################################################################################
+void PostDoFReduceShader::setSizes(const glm::vec2& sourceSize, const glm::vec2& outputSize)
+{
+  if(d->sourceSizeLocation>=0)
+    glUniform2f(d->sourceSizeLocation, sourceSize.x, sourceSize.y);
+
+  if(d->outputSizeLocation>=0)
+    glUniform2f(d->outputSizeLocation, outputSize.x, outputSize.y);
+}
+
+//##################################################################################################
+const std::string& PostDoFReduceShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/DoFReduceShader.frag"};
+  return s.dataStr(shaderProfile(), shaderType);
+}
+
+//##################################################################################################
+void PostDoFReduceShader::getLocations(GLuint program, ShaderType shaderType)
+{
+  PostShader::getLocations(program, shaderType);
+  d->sourceSizeLocation = glGetUniformLocation(program, "sourceSize");
+  d->outputSizeLocation = glGetUniformLocation(program, "outputSize");
+}
+
+}
@@ -0,0 +1,42 @@
+#include "tp_maps/shaders/PostFusedShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct PostFusedShader::Private
+{
+  std::string fusedFragmentSnippets;
+  std::unordered_map<ShaderType, std::string> fragmentShaderStrs;
+};
+
+//##################################################################################################
+PostFusedShader::PostFusedShader(Map* map, tp_maps::ShaderProfile shaderProfile, const std::string& fusedFragmentSnippets):
+  PostShader(map, shaderProfile),
+  d(new Private())
+{
+  d->fusedFragmentSnippets = fusedFragmentSnippets;
+}
+
+//##################################################################################################
+PostFusedShader::~PostFusedShader()
+{
+  delete d;
+}
+
+//##################################################################################################
+const std::string& PostFusedShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/PostFusedShader.frag"};
+
+  std::string& result = d->fragmentShaderStrs[shaderType];
+  if(result.empty())
+  {
+    result = s.dataStr(shaderProfile(), shaderType);
+    tp_utils::replace(result, "#pragma replace TP_FUSED_POST_EFFECTS", d->fusedFragmentSnippets);
+  }
+
+  return result;
+}
+
+}
@@ -95,7 +95,7 @@ void PostShader::setProjectionMatrix(const glm::mat4& projectionMatrix)
   }
 
   if(d->pixelSizeLocation>=0)
-    glUniform2f(d->pixelSizeLocation, 1.0f/float(map()->width()), 1.0f/float(map()->height()));
+    glUniform2f(d->pixelSizeLocation, 1.0f/float(map()->renderWidth()), 1.0f/float(map()->renderHeight()));
 }
 
 //##################################################################################################
@@ -0,0 +1,56 @@
+#include "tp_maps/shaders/PostUpscaleShader.h"
+
+namespace tp_maps
+{
+
+//##################################################################################################
+struct PostUpscaleShader::Private
+{
+  GLint sourcePixelSizeLocation{-1};
+  GLint sharpnessLocation{-1};
+};
+
+//##################################################################################################
+PostUpscaleShader::PostUpscaleShader(Map* map, tp_maps::ShaderProfile shaderProfile):
+  PostShader(map, shaderProfile),
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+PostUpscaleShader::~PostUpscaleShader()
+{
+  delete d;
+}
+
+//##################################################################################################
+void PostUpscaleShader::setSourceSize(size_t width, size_t height)
+{
+  if(d->sourcePixelSizeLocation>=0)
+    glUniform2f(d->sourcePixelSizeLocation, 1.0f/float(tpMax(size_t(1), width)), 1.0f/float(tpMax(size_t(1), height)));
+}
+
+//##################################################################################################
+void PostUpscaleShader::setSharpness(float sharpness)
+{
+  if(d->sharpnessLocation>=0)
+    glUniform1f(d->sharpnessLocation, sharpness);
+}
+
+//##################################################################################################
+const std::string& PostUpscaleShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/PostUpscaleShader.frag"};
+  return s.dataStr(shaderProfile(), shaderType);
+}
+
+//##################################################################################################
+void PostUpscaleShader::getLocations(GLuint program, ShaderType shaderType)
+{
+  PostShader::getLocations(program, shaderType);
+  d->sourcePixelSizeLocation = glGetUniformLocation(program, "sourcePixelSize");
+  d->sharpnessLocation       = glGetUniformLocation(program, "sharpness");
+}
+
+}
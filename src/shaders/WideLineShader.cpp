@@ -0,0 +1,418 @@
+#include "tp_maps/shaders/WideLineShader.h"
+#include "tp_maps/Map.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include "glm/gtc/type_ptr.hpp"
+
+#include <array>
+
+namespace tp_maps
+{
+
+namespace
+{
+#ifdef TP_INSTANCING_SUPPORTED
+// Segments are drawn as instances of a quad, with a triangle strip.
+typedef WideLineShader::Segment Vertex_lt;
+const size_t verticesPerSegment=1;
+#else
+// Without instancing each segment is repeated for each corner of 2 triangles.
+struct Vertex_lt
+{
+  WideLineShader::Segment segment;
+  glm::vec2 corner{0.0f, 0.0f};
+};
+const size_t verticesPerSegment=6;
+#endif
+
+//##################################################################################################
+void fillVertices(std::vector<Vertex_lt>& verts, const std::vector<WideLineShader::Segment>& segments)
+{
+#ifdef TP_INSTANCING_SUPPORTED
+  verts = segments;
+#else
+  const std::array<glm::vec2, 6> corners =
+  {
+    {
+      {0.0f,-1.0f},
+      {1.0f,-1.0f},
+      {1.0f, 1.0f},
+      {0.0f,-1.0f},
+      {1.0f, 1.0f},
+      {0.0f, 1.0f}
+    }
+  };
+
+  verts.resize(segments.size()*verticesPerSegment);
+  Vertex_lt* v = verts.data();
+  for(const auto& segment : segments)
+  {
+    for(const auto& corner : corners)
+    {
+      v->segment = segment;
+      v->corner = corner;
+      v++;
+    }
+  }
+#endif
+}
+}
+
+//##################################################################################################
+struct WideLineShader::Private
+{
+  TP_REF_COUNT_OBJECTS("tp_maps::WideLineShader::Private");
+  TP_NONCOPYABLE(Private);
+  Private() = default;
+
+  GLint matrixLocation{0};
+  GLint screenSizeLocation{0};
+  GLint halfWidthLocation{0};
+  GLint worldScaleLocation{0};
+  GLint capStyleLocation{0};
+  GLint pickingLocation{0};
+  GLint pickingColorLocation{0};
+
+  //################################################################################################
+  void draw(WideLineShader::VertexBuffer* vertexBuffer, size_t first, size_t count)
+  {
+    if(count<1)
+      return;
+
+#ifdef TP_INSTANCING_SUPPORTED
+    tpBindVertexArray(vertexBuffer->vaoID);
+    if(first)
+      vertexBuffer->bindVBO(first);
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(count));
+
+    if(first)
+      vertexBuffer->bindVBO(0);
+    tpBindVertexArray(0);
+#else
+    vertexBuffer->bindVBO();
+    glDrawArrays(GL_TRIANGLES, GLint(first*verticesPerSegment), GLsizei(count*verticesPerSegment));
+    for(GLuint i=1; i<7; i++)
+      glDisableVertexAttribArray(i);
+#endif
+  }
+};
+
+//##################################################################################################
+WideLineShader::WideLineShader(Map* map, tp_maps::ShaderProfile shaderProfile):
+  Shader(map, shaderProfile),
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+WideLineShader::~WideLineShader()
+{
+  delete d;
+}
+
+//##################################################################################################
+const std::string& WideLineShader::vertexShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/WideLineShader.vert"};
+  return s.dataStr(shaderProfile(), shaderType);
+}
+
+//##################################################################################################
+const std::string& WideLineShader::fragmentShaderStr(ShaderType shaderType)
+{
+  static ShaderResource s{"/tp_maps/WideLineShader.frag"};
+  return s.dataStr(shaderProfile(), shaderType);
+}
+
+//##################################################################################################
+void WideLineShader::bindLocations(GLuint program, ShaderType shaderType)
+{
+  TP_UNUSED(shaderType);
+
+  glBindAttribLocation(program, 0, "inStart");
+  glBindAttribLocation(program, 1, "inEnd");
+  glBindAttribLocation(program, 2, "inColor");
+  glBindAttribLocation(program, 3, "inCaps");
+  glBindAttribLocation(program, 4, "inCorner");
+  glBindAttribLocation(program, 5, "inPrevious");
+  glBindAttribLocation(program, 6, "inNext");
+}
+
+//##################################################################################################
+void WideLineShader::getLocations(GLuint program, ShaderType shaderType)
+{
+  TP_UNUSED(shaderType);
+
+  d->matrixLocation       = glGetUniformLocation(program, "matrix");
+  d->screenSizeLocation   = glGetUniformLocation(program, "screenSize");
+  d->halfWidthLocation    = glGetUniformLocation(program, "halfWidth");
+  d->worldScaleLocation   = glGetUniformLocation(program, "worldScale");
+  d->capStyleLocation     = glGetUniformLocation(program, "capStyle");
+  d->pickingLocation      = glGetUniformLocation(program, "picking");
+  d->pickingColorLocation = glGetUniformLocation(program, "pickingColor");
+
+  if(d->matrixLocation<0)
+    tpWarning() << "WideLineShader matrixLocation: " << d->matrixLocation;
+
+  if(d->screenSizeLocation<0)
+    tpWarning() << "WideLineShader screenSizeLocation: " << d->screenSizeLocation;
+}
+
+//##################################################################################################
+void WideLineShader::init()
+{
+  if(map()->extendedFBO() == ExtendedFBO::Yes)
+    compile(ShaderType::RenderExtendedFBO);
+  else
+    compile(ShaderType::Render);
+}
+
+//##################################################################################################
+void WideLineShader::use(ShaderType shaderType)
+{
+  //https://webglfundamentals.org/webgl/lessons/webgl-and-alpha.html
+
+  float picking=0.0f;
+  switch(shaderType)
+  {
+  case ShaderType::Light: [[fallthrough]];
+  case ShaderType::Render: [[fallthrough]];
+  case ShaderType::RenderExtendedFBO:
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
+    break;
+
+  case ShaderType::Picking:
+    glDisable(GL_BLEND);
+    picking=1.0f;
+    break;
+  }
+
+  Shader::use(ShaderType::Render);
+  glUniform1f(d->pickingLocation, picking);
+}
+
+//##################################################################################################
+void WideLineShader::setMatrix(const glm::mat4& matrix)
+{
+  glUniformMatrix4fv(d->matrixLocation, 1, GL_FALSE, glm::value_ptr(matrix));
+}
+
+//##################################################################################################
+void WideLineShader::setScreenSize(const glm::vec2& screenSize)
+{
+  glUniform2fv(d->screenSizeLocation, 1, glm::value_ptr(screenSize));
+}
+
+//##################################################################################################
+void WideLineShader::setLineWidth(float lineWidth)
+{
+  glUniform1f(d->halfWidthLocation, lineWidth*0.5f);
+  glUniform1f(d->worldScaleLocation, 0.0f);
+}
+
+//##################################################################################################
+void WideLineShader::setWorldLineWidth(float lineWidth, const glm::mat4& projectionMatrix)
+{
+  glUniform1f(d->halfWidthLocation, lineWidth*0.5f);
+  glUniform1f(d->worldScaleLocation, projectionMatrix[1][1]*0.5f);
+}
+
+//##################################################################################################
+void WideLineShader::setLineCap(LineCap lineCap)
+{
+  glUniform1f(d->capStyleLocation, float(int(lineCap)));
+}
+
+//##################################################################################################
+void WideLineShader::appendSegments(std::vector<Segment>& segments,
+                                    const std::vector<glm::vec3>& points,
+                                    GLenum mode,
+                                    const glm::vec4& color)
+{
+  if(points.size()<2)
+    return;
+
+  if(mode == GL_LINES)
+  {
+    for(size_t i=1; i<points.size(); i+=2)
+    {
+      auto& segment = segments.emplace_back();
+      segment.start = points.at(i-1);
+      segment.end   = points.at(i);
+      segment.color = color;
+    }
+    return;
+  }
+
+  bool loop = (mode == GL_LINE_LOOP);
+  size_t count = loop?points.size():(points.size()-1);
+  for(size_t i=0; i<count; i++)
+  {
+    auto& segment = segments.emplace_back();
+    segment.start = points.at(i);
+    segment.end   = points.at((i+1)%points.size());
+    segment.color = color;
+    segment.caps.x = (!loop && i==0)?1.0f:0.0f;
+    segment.caps.y = (!loop && i==count-1)?1.0f:0.0f;
+    segment.previous = points.at((i+points.size()-1)%points.size());
+    segment.next     = points.at((i+2)%points.size());
+  }
+}
+
+//##################################################################################################
+WideLineShader::VertexBuffer::VertexBuffer(Map* map_, const Shader *shader_):
+  map(map_),
+  shader(shader_)
+{
+
+}
+
+//##################################################################################################
+WideLineShader::VertexBuffer::~VertexBuffer()
+{
+  if(!shader.shader())
+    return;
+
+  map->makeCurrent();
+
+#ifdef TP_VERTEX_ARRAYS_SUPPORTED
+  if(vaoID)
+    tpDeleteVertexArrays(1, &vaoID);
+#endif
+
+#ifdef TP_INSTANCING_SUPPORTED
+  if(quadVboID)
+    glDeleteBuffers(1, &quadVboID);
+#endif
+
+  if(vboID)
+    glDeleteBuffers(1, &vboID);
+}
+
+//##################################################################################################
+void WideLineShader::VertexBuffer::bindVBO(size_t firstSegment) const
+{
+  size_t offset = firstSegment*verticesPerSegment*sizeof(Vertex_lt);
+
+  glBindBuffer(GL_ARRAY_BUFFER, vboID);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_lt), tpVoidLiteral(offset+ 0)); //vec3 start;
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_lt), tpVoidLiteral(offset+12)); //vec3 end;
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex_lt), tpVoidLiteral(offset+24)); //vec4 color;
+  glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex_lt), tpVoidLiteral(offset+40)); //vec2 caps;
+  glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_lt), tpVoidLiteral(offset+48)); //vec3 previous;
+  glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_lt), tpVoidLiteral(offset+60)); //vec3 next;
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glEnableVertexAttribArray(2);
+  glEnableVertexAttribArray(3);
+  glEnableVertexAttribArray(5);
+  glEnableVertexAttribArray(6);
+
+#ifdef TP_INSTANCING_SUPPORTED
+  for(GLuint i : {0, 1, 2, 3, 5, 6})
+    glVertexAttribDivisor(i, 1);
+
+  glBindBuffer(GL_ARRAY_BUFFER, quadVboID);
+  glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr); //vec2 corner;
+  glEnableVertexAttribArray(4);
+  glVertexAttribDivisor(4, 0);
+#else
+  glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex_lt), tpVoidLiteral(offset+72)); //vec2 corner;
+  glEnableVertexAttribArray(4);
+#endif
+}
+
+//##################################################################################################
+WideLineShader::VertexBuffer* WideLineShader::generateVertexBuffer(Map* map, const std::vector<Segment>& segments) const
+{
+  auto vertexBuffer = new VertexBuffer(map, this);
+
+  if(segments.empty())
+    return vertexBuffer;
+
+  std::vector<Vertex_lt> verts;
+  fillVertices(verts, segments);
+
+  vertexBuffer->segmentCount = GLuint(segments.size());
+
+  glGenBuffers(1, &vertexBuffer->vboID);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
+  glBufferData(GL_ARRAY_BUFFER, TPGLsizei(verts.size()*sizeof(Vertex_lt)), verts.data(), GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+#ifdef TP_INSTANCING_SUPPORTED
+  // The corners of the quad, x is 0 at the start of the segment and 1 at the end.
+  const std::array<glm::vec2, 4> corners =
+  {
+    {
+      {0.0f,-1.0f},
+      {1.0f,-1.0f},
+      {0.0f, 1.0f},
+      {1.0f, 1.0f}
+    }
+  };
+
+  glGenBuffers(1, &vertexBuffer->quadVboID);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->quadVboID);
+  glBufferData(GL_ARRAY_BUFFER, TPGLsizei(corners.size()*sizeof(glm::vec2)), corners.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  tpGenVertexArrays(1, &vertexBuffer->vaoID);
+  tpBindVertexArray(vertexBuffer->vaoID);
+  vertexBuffer->bindVBO();
+  tpBindVertexArray(0);
+#endif
+
+  return vertexBuffer;
+}
+
+//##################################################################################################
+void WideLineShader::updateVertexBuffer(VertexBuffer* vertexBuffer,
+                                        const std::vector<Segment>& segments,
+                                        size_t first) const
+{
+  if(segments.empty() || !vertexBuffer->vboID || first+segments.size()>vertexBuffer->segmentCount)
+    return;
+
+  std::vector<Vertex_lt> verts;
+  fillVertices(verts, segments);
+
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->vboID);
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  GLintptr(first*verticesPerSegment*sizeof(Vertex_lt)),
+                  TPGLsizei(verts.size()*sizeof(Vertex_lt)),
+                  verts.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//##################################################################################################
+void WideLineShader::deleteVertexBuffer(VertexBuffer* vertexBuffer) const
+{
+  delete vertexBuffer;
+}
+
+//##################################################################################################
+void WideLineShader::drawLines(VertexBuffer* vertexBuffer)
+{
+  d->draw(vertexBuffer, 0, vertexBuffer->segmentCount);
+}
+
+//##################################################################################################
+void WideLineShader::drawLinesPicking(VertexBuffer* vertexBuffer,
+                                      const glm::vec4& pickingID,
+                                      size_t firstSegment,
+                                      size_t segmentCount)
+{
+  if(firstSegment>=vertexBuffer->segmentCount)
+    return;
+
+  glUniform4fv(d->pickingColorLocation, 1, glm::value_ptr(pickingID));
+  d->draw(vertexBuffer, firstSegment, tpMin(segmentCount, size_t(vertexBuffer->segmentCount)-firstSegment));
+}
+
+}
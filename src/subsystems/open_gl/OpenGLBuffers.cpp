@@ -7,6 +7,9 @@
 
 #include "tp_utils/DebugUtils.h"
 
+#include <memory>
+#include <string>
+
 #ifdef TP_MAPS_DEBUG
 #  define DEBUG_printOpenGLError(A) Errors::printOpenGLError(A)
 #else
@@ -16,6 +19,29 @@
 namespace tp_maps
 {
 
+namespace
+{
+//##################################################################################################
+//! Transient buffers that have not been used for this many frames are deleted.
+constexpr size_t maxUnusedTransientFrames = 10;
+
+//##################################################################################################
+struct TransientBuffer_lt
+{
+  std::unique_ptr<OpenGLFBO> fbo{std::make_unique<OpenGLFBO>()};
+  size_t width{0};
+  size_t height{0};
+  CreateColorBuffer createColorBuffer{CreateColorBuffer::No};
+  Multisample multisample{Multisample::No};
+  HDR hdr{HDR::No};
+  ExtendedFBO extendedFBO{ExtendedFBO::No};
+  HDRPrecision hdrPrecision{HDRPrecision::Half};
+  size_t bytes{0};
+  size_t lastUsedFrame{0};
+  bool inUse{false};
+};
+}
+
 //##################################################################################################
 // enum class SamplesUpdate { None, Settings, Heuristic };
 
@@ -30,6 +56,13 @@ struct OpenGLBuffers::Private
 
   std::unordered_map<tp_utils::StringID, OpenGLFBO*> storedBuffers;
 
+  std::vector<TransientBuffer_lt> transientBuffers;
+  TransientBufferStats transientBufferStats;
+  size_t transientFrame{0};
+  size_t transientBytesInUse{0};
+  size_t transientPeakBytes{0};
+  size_t transientRequestedBytes{0};
+
   //################################################################################################
   Private(Map* map_):
     map(map_)
@@ -87,29 +120,162 @@ struct OpenGLBuffers::Private
   //################################################################################################
   size_t samples()
   {
-    bool const useMSAA = map->renderModeManger().msaaAllowed();
-    return useMSAA ? samples_ : 1;
+    const auto& renderModeManager = map->renderModeManger();
+    return renderModeManager.msaaAllowed() ? tpMin(samples_, renderModeManager.maxSamples()) : 1;
   }
 
   //################################################################################################
-  GLint colorFormatF(Alpha alpha)
+  bool isES()
   {
-#ifdef TP_GLES2
-    return (alpha==Alpha::Yes)?GL_RGBA32F_EXT:GL_RGB16F_EXT;
-#else
     switch(map->shaderProfile())
     {
       case ShaderProfile::GLSL_100_ES: [[fallthrough]];
       case ShaderProfile::GLSL_300_ES: [[fallthrough]];
       case ShaderProfile::GLSL_310_ES: [[fallthrough]];
       case ShaderProfile::GLSL_320_ES:
-      return (alpha==Alpha::Yes)?GL_RGBA32F:GL_RGB16F;
+      return true;
       default:
-      return (alpha==Alpha::Yes)?GL_RGBA32F:GL_RGB32F;
+      return false;
+    }
+  }
+
+  //################################################################################################
+  //! Returns the alpha that will actually be allocated for a float buffer.
+  /*!
+  Half precision is always RGBA as RGB16F is not color renderable on most platforms, on ES the same
+  is true of RGB32F.
+  */
+  Alpha floatAlpha(Alpha alpha, HDRPrecision hdrPrecision)
+  {
+    switch(hdrPrecision)
+    {
+      case HDRPrecision::Half:
+      return Alpha::Yes;
+      case HDRPrecision::Packed:
+      return alpha;
+      case HDRPrecision::Full:
+      return isES()?Alpha::Yes:alpha;
+    }
+    return alpha;
+  }
+
+  //################################################################################################
+  GLint colorFormatF(Alpha alpha, HDRPrecision hdrPrecision)
+  {
+#ifdef TP_GLES2
+    if(hdrPrecision == HDRPrecision::Full)
+      return (alpha==Alpha::Yes)?GL_RGBA32F_EXT:GL_RGB16F_EXT;
+    return GL_RGBA16F_EXT;
+#else
+    switch(hdrPrecision)
+    {
+      case HDRPrecision::Packed:
+      if(alpha == Alpha::No)
+        return GL_R11F_G11F_B10F;
+      [[fallthrough]];
+      case HDRPrecision::Half:
+      return GL_RGBA16F;
+      case HDRPrecision::Full:
+      break;
+    }
+
+    if(isES())
+      return (alpha==Alpha::Yes)?GL_RGBA32F:GL_RGB16F;
+    return (alpha==Alpha::Yes)?GL_RGBA32F:GL_RGB32F;
+#endif
+  }
+
+  //################################################################################################
+  //! Returns true if R11F_G11F_B10F can be rendered to.
+  /*!
+  This is core in desktop GL 3, GLES 3 needs GL_EXT_color_buffer_float.
+  */
+  bool packedSupported()
+  {
+#if defined(TP_GLES2)
+    return false;
+#else
+    static int packedSupported_{-1};
+
+    if(packedSupported_ == -1)
+    {
+      packedSupported_ = isES()?0:1;
+
+#  if defined(TP_GL3) || defined(TP_GLES3)
+      if(!packedSupported_)
+      {
+        GLint count=0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(GLint i=0; i<count && !packedSupported_; i++)
+        {
+          auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+          if(name && std::string(name) == "GL_EXT_color_buffer_float")
+            packedSupported_ = 1;
+        }
+      }
+#  endif
     }
+
+    return packedSupported_;
 #endif
   }
 
+  //################################################################################################
+  //! Returns the precision that will actually be allocated, Packed falls back to Half.
+  HDRPrecision supportedPrecision(HDRPrecision hdrPrecision)
+  {
+    return (hdrPrecision==HDRPrecision::Packed && !packedSupported())?HDRPrecision::Half:hdrPrecision;
+  }
+
+  //################################################################################################
+  //! Normals are signed so they can't be stored in the unsigned packed format.
+  HDRPrecision normalsPrecision(HDRPrecision hdrPrecision)
+  {
+    return (hdrPrecision==HDRPrecision::Packed)?HDRPrecision::Half:hdrPrecision;
+  }
+
+  //################################################################################################
+  //! An estimate of the memory used by each pixel of a color texture.
+  size_t colorBytesPerPixel(HDR hdr, Alpha alpha, HDRPrecision hdrPrecision)
+  {
+    if(hdr == HDR::No)
+      return 4;
+
+    alpha = floatAlpha(alpha, hdrPrecision);
+    switch(hdrPrecision)
+    {
+      case HDRPrecision::Packed:
+      return (alpha==Alpha::Yes)?8:4;
+      case HDRPrecision::Half:
+      return 8;
+      case HDRPrecision::Full:
+      break;
+    }
+    return (alpha==Alpha::Yes)?16:12;
+  }
+
+  //################################################################################################
+  //! An estimate of the memory used by a buffer, used for the transient buffer stats.
+  size_t bufferBytes(const OpenGLFBO& buffer, CreateColorBuffer createColorBuffer)
+  {
+    size_t bytesPerPixel = 4;
+
+    if(createColorBuffer == CreateColorBuffer::Yes || map->shaderProfile() == ShaderProfile::GLSL_100_ES)
+      bytesPerPixel += colorBytesPerPixel(buffer.hdr, Alpha::No, buffer.hdrPrecision);
+
+    if(buffer.extendedFBO == ExtendedFBO::Yes)
+    {
+      bytesPerPixel += colorBytesPerPixel(HDR::Yes, Alpha::No, normalsPrecision(buffer.hdrPrecision));
+      bytesPerPixel += colorBytesPerPixel(HDR::Yes, Alpha::Yes, buffer.hdrPrecision);
+    }
+
+    // The multisampled render buffers are kept alongside the resolved textures.
+    if(buffer.multisample == Multisample::Yes)
+      bytesPerPixel += bytesPerPixel * buffer.samples;
+
+    return buffer.width * buffer.height * bytesPerPixel;
+  }
+
   //################################################################################################
   struct DepthFormatData
   {
@@ -144,7 +310,7 @@ struct OpenGLBuffers::Private
   }
 
   //################################################################################################
-  void create2DColorTexture(GLuint& textureID, size_t width, size_t height, HDR hdr, Alpha alpha)
+  void create2DColorTexture(GLuint& textureID, size_t width, size_t height, HDR hdr, Alpha alpha, HDRPrecision hdrPrecision)
   {
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
@@ -161,26 +327,12 @@ struct OpenGLBuffers::Private
     else
     {
       // On ES force alpha as GL_RGB32F is not an option but GL_RGBA32F is.
-      if(alpha == Alpha::No)
-      {
-        switch (map->shaderProfile())
-        {
-          case ShaderProfile::GLSL_100_ES: [[fallthrough]];
-          case ShaderProfile::GLSL_300_ES: [[fallthrough]];
-          case ShaderProfile::GLSL_310_ES: [[fallthrough]];
-          case ShaderProfile::GLSL_320_ES:
-          alpha = Alpha::Yes;
-          break;
-
-          default:
-          break;
-        }
-      }
+      alpha = floatAlpha(alpha, hdrPrecision);
 
       if(alpha == Alpha::No)
-        glTexImage2D(GL_TEXTURE_2D, 0, colorFormatF(alpha), TPGLsizei(width), TPGLsizei(height), 0, GL_RGB, GL_FLOAT, nullptr);
+        glTexImage2D(GL_TEXTURE_2D, 0, colorFormatF(alpha, hdrPrecision), TPGLsizei(width), TPGLsizei(height), 0, GL_RGB, GL_FLOAT, nullptr);
       else
-        glTexImage2D(GL_TEXTURE_2D, 0, colorFormatF(alpha), TPGLsizei(width), TPGLsizei(height), 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexImage2D(GL_TEXTURE_2D, 0, colorFormatF(alpha, hdrPrecision), TPGLsizei(width), TPGLsizei(height), 0, GL_RGBA, GL_FLOAT, nullptr);
       DEBUG_printOpenGLError("create2DColorTexture C");
     }
 
@@ -208,7 +360,7 @@ struct OpenGLBuffers::Private
   }
 
   //################################################################################################
-  void createColorRBO(GLuint& rboID, size_t width, size_t height, HDR hdr, Alpha alpha, GLenum attachment)
+  void createColorRBO(GLuint& rboID, size_t width, size_t height, HDR hdr, Alpha alpha, HDRPrecision hdrPrecision, GLenum attachment)
   {
     glGenRenderbuffers(1, &rboID);
     glBindRenderbuffer(GL_RENDERBUFFER, rboID);
@@ -222,10 +374,8 @@ struct OpenGLBuffers::Private
     }
     else
     {
-      if(alpha == Alpha::No)
-        glRenderbufferStorageMultisample(GL_RENDERBUFFER, TPGLsizei(samples()), colorFormatF(alpha), TPGLsizei(width), TPGLsizei(height));
-      else
-        glRenderbufferStorageMultisample(GL_RENDERBUFFER, TPGLsizei(samples()), colorFormatF(alpha), TPGLsizei(width), TPGLsizei(height));
+      alpha = floatAlpha(alpha, hdrPrecision);
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, TPGLsizei(samples()), colorFormatF(alpha, hdrPrecision), TPGLsizei(width), TPGLsizei(height));
     }
 
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, rboID);
@@ -297,6 +447,7 @@ struct OpenGLBuffers::Private
   \param multisample should be true to enable antialiasing (MSAA).
   \param hdr are we using 8 bit or HDR buffers.
   \param extendedFBO are we creating extra buffers for normals and specular.
+  \param hdrPrecision the precision of the float color, normals, and specular buffers.
 
   \return true if we managed to create a functional FBO.
   */
@@ -307,7 +458,8 @@ struct OpenGLBuffers::Private
                      Multisample multisample,
                      HDR hdr,
                      ExtendedFBO extendedFBO,
-                     bool clear)
+                     bool clear,
+                     HDRPrecision hdrPrecision)
   {
     DEBUG_printOpenGLError("prepareBuffer Start");
 
@@ -315,6 +467,7 @@ struct OpenGLBuffers::Private
 
     buffer.blitRequired = false;
     buffer.multisampleParam = multisample;
+    hdrPrecision = supportedPrecision(hdrPrecision);
 
 #ifdef TP_ENABLE_MULTISAMPLE_FBO
     if (multisample == Multisample::Yes) {
@@ -326,18 +479,19 @@ struct OpenGLBuffers::Private
 #endif
 
 
-    if(buffer.width!=width || buffer.height!=height || buffer.samples!=samples() || buffer.hdr != hdr || buffer.extendedFBO != extendedFBO || buffer.multisample != multisample)
+    if(buffer.width!=width || buffer.height!=height || buffer.samples!=samples() || buffer.hdr != hdr || buffer.hdrPrecision != hdrPrecision || buffer.extendedFBO != extendedFBO || buffer.multisample != multisample)
       deleteBuffer(buffer);
 
     if(!buffer.frameBuffer)
     {
       glGenFramebuffers(1, &buffer.frameBuffer);
-      buffer.width       = width;
-      buffer.height      = height;
-      buffer.samples     = samples();
-      buffer.hdr         = hdr;
-      buffer.extendedFBO = extendedFBO;
-      buffer.multisample = multisample;
+      buffer.width        = width;
+      buffer.height       = height;
+      buffer.samples      = samples();
+      buffer.hdr          = hdr;
+      buffer.hdrPrecision = hdrPrecision;
+      buffer.extendedFBO  = extendedFBO;
+      buffer.multisample  = multisample;
     }
 
     DEBUG_printOpenGLError("prepareBuffer Init");
@@ -352,7 +506,7 @@ struct OpenGLBuffers::Private
     if(createColorBuffer == CreateColorBuffer::Yes)
     {
       if(!buffer.textureID)
-        create2DColorTexture(buffer.textureID, width, height, hdr, Alpha::No);
+        create2DColorTexture(buffer.textureID, width, height, hdr, Alpha::No, hdrPrecision);
 
       glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, buffer.textureID, 0);
       DEBUG_printOpenGLError("prepareBuffer bind 2D texture to FBO");
@@ -369,10 +523,10 @@ struct OpenGLBuffers::Private
     if(extendedFBO == ExtendedFBO::Yes)
     {
       if(!buffer.normalsID)
-        create2DColorTexture(buffer.normalsID, width, height, HDR::Yes, Alpha::No);
+        create2DColorTexture(buffer.normalsID, width, height, HDR::Yes, Alpha::No, normalsPrecision(hdrPrecision));
 
       if(!buffer.specularID)
-        create2DColorTexture(buffer.specularID, width, height, HDR::Yes, Alpha::Yes);
+        create2DColorTexture(buffer.specularID, width, height, HDR::Yes, Alpha::Yes, hdrPrecision);
 
       glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, buffer.normalsID, 0);
       glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, buffer.specularID, 0);
@@ -408,7 +562,7 @@ struct OpenGLBuffers::Private
       //   createMultisampleTexture(buffer.multisampleTextureID, width, height, hdr, Alpha::No, GL_COLOR_ATTACHMENT0);
 
       if(!buffer.multisampleColorRBO)
-        createColorRBO(buffer.multisampleColorRBO, width, height, hdr, Alpha::No, GL_COLOR_ATTACHMENT0);
+        createColorRBO(buffer.multisampleColorRBO, width, height, hdr, Alpha::No, hdrPrecision, GL_COLOR_ATTACHMENT0);
 
       if(extendedFBO == ExtendedFBO::Yes)
       {
@@ -419,10 +573,10 @@ struct OpenGLBuffers::Private
         //   createMultisampleTexture(buffer.multisampleSpecularTextureID, width, height, HDR::Yes, Alpha::Yes, GL_COLOR_ATTACHMENT2);
 
         if(!buffer.multisampleNormalsRBO)
-          createColorRBO(buffer.multisampleNormalsRBO, width, height, HDR::Yes, Alpha::No, GL_COLOR_ATTACHMENT1);
+          createColorRBO(buffer.multisampleNormalsRBO, width, height, HDR::Yes, Alpha::No, normalsPrecision(hdrPrecision), GL_COLOR_ATTACHMENT1);
 
         if(!buffer.multisampleSpecularRBO)
-          createColorRBO(buffer.multisampleSpecularRBO, width, height, HDR::Yes, Alpha::Yes, GL_COLOR_ATTACHMENT2);
+          createColorRBO(buffer.multisampleSpecularRBO, width, height, HDR::Yes, Alpha::Yes, hdrPrecision, GL_COLOR_ATTACHMENT2);
 
         setDrawBuffers({GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2});
       }
@@ -505,17 +659,128 @@ struct OpenGLBuffers::Private
   }
 
   //################################################################################################
-  void deleteBuffer(OpenGLFBO& buffer)
+  OpenGLFBO* acquireTransientBuffer(const tp_utils::StringID& name,
+                                    size_t width,
+                                    size_t height,
+                                    CreateColorBuffer createColorBuffer,
+                                    Multisample multisample,
+                                    HDR hdr,
+                                    ExtendedFBO extendedFBO,
+                                    bool clear,
+                                    HDRPrecision hdrPrecision)
   {
-    for(auto i=storedBuffers.begin(); i!=storedBuffers.end(); ++i)
+    TransientBuffer_lt* transientBuffer=nullptr;
+    for(auto& t : transientBuffers)
     {
-      if(i->second == &buffer)
+      if(!t.inUse &&
+         t.width == width &&
+         t.height == height &&
+         t.createColorBuffer == createColorBuffer &&
+         t.multisample == multisample &&
+         t.hdr == hdr &&
+         t.extendedFBO == extendedFBO &&
+         t.hdrPrecision == hdrPrecision)
       {
-        storedBuffers.erase(i);
+        transientBuffer = &t;
         break;
       }
     }
 
+    if(!transientBuffer)
+    {
+      transientBuffer = &transientBuffers.emplace_back();
+      transientBuffer->width             = width;
+      transientBuffer->height            = height;
+      transientBuffer->createColorBuffer = createColorBuffer;
+      transientBuffer->multisample       = multisample;
+      transientBuffer->hdr               = hdr;
+      transientBuffer->extendedFBO       = extendedFBO;
+      transientBuffer->hdrPrecision      = hdrPrecision;
+    }
+
+    // The previous contents are no longer valid so stop publishing them under the old name.
+    OpenGLFBO* fbo = transientBuffer->fbo.get();
+    eraseStoredBuffer(fbo);
+    fbo->name = name;
+
+    if(!prepareBuffer(*fbo, width, height, createColorBuffer, multisample, hdr, extendedFBO, clear, hdrPrecision))
+      return nullptr;
+
+    transientBuffer->inUse = true;
+    transientBuffer->lastUsedFrame = transientFrame;
+    transientBuffer->bytes = bufferBytes(*fbo, createColorBuffer);
+
+    transientBytesInUse += transientBuffer->bytes;
+    transientRequestedBytes += transientBuffer->bytes;
+    transientPeakBytes = tpMax(transientPeakBytes, transientBytesInUse);
+
+    return fbo;
+  }
+
+  //################################################################################################
+  void releaseTransientBuffer(OpenGLFBO* buffer)
+  {
+    for(auto& t : transientBuffers)
+    {
+      if(t.fbo.get() == buffer)
+      {
+        if(t.inUse)
+        {
+          t.inUse = false;
+          transientBytesInUse -= t.bytes;
+        }
+        return;
+      }
+    }
+  }
+
+  //################################################################################################
+  void collectTransientBuffers()
+  {
+    for(auto& t : transientBuffers)
+      t.inUse = false;
+
+    for(auto i=transientBuffers.begin(); i!=transientBuffers.end();)
+    {
+      if((transientFrame - i->lastUsedFrame) > maxUnusedTransientFrames)
+      {
+        deleteBuffer(*i->fbo);
+        i = transientBuffers.erase(i);
+      }
+      else
+        ++i;
+    }
+
+    transientBufferStats.allocatedBytes = 0;
+    for(const auto& t : transientBuffers)
+      transientBufferStats.allocatedBytes += t.bytes;
+    transientBufferStats.bufferCount    = transientBuffers.size();
+    transientBufferStats.peakBytes      = transientPeakBytes;
+    transientBufferStats.requestedBytes = transientRequestedBytes;
+
+    transientFrame++;
+    transientBytesInUse     = 0;
+    transientPeakBytes      = 0;
+    transientRequestedBytes = 0;
+  }
+
+  //################################################################################################
+  void eraseStoredBuffer(const OpenGLFBO* buffer)
+  {
+    for(auto i=storedBuffers.begin(); i!=storedBuffers.end();)
+    {
+      if(i->second == buffer)
+        i = storedBuffers.erase(i);
+      else
+        ++i;
+    }
+  }
+
+  //################################################################################################
+  void deleteBuffer(OpenGLFBO& buffer)
+  {
+    eraseStoredBuffer(&buffer);
+
     glBindTexture(GL_TEXTURE_2D, 0);
 
     if(buffer.frameBuffer)
@@ -643,7 +908,8 @@ bool OpenGLBuffers::prepareBuffer(OpenGLFBO& buffer,
                                   Multisample multisample,
                                   HDR hdr,
                                   ExtendedFBO extendedFBO,
-                                  bool clear) const
+                                  bool clear,
+                                  HDRPrecision hdrPrecision) const
 {
   return d->prepareBuffer(buffer,
                           width,
@@ -652,7 +918,66 @@ bool OpenGLBuffers::prepareBuffer(OpenGLFBO& buffer,
                           multisample,
                           hdr,
                           extendedFBO,
-                          clear);
+                          clear,
+                          hdrPrecision);
+}
+
+//##################################################################################################
+OpenGLFBO* OpenGLBuffers::acquireTransientBuffer(const tp_utils::StringID& name,
+                                                 size_t width,
+                                                 size_t height,
+                                                 CreateColorBuffer createColorBuffer,
+                                                 Multisample multisample,
+                                                 HDR hdr,
+                                                 ExtendedFBO extendedFBO,
+                                                 bool clear,
+                                                 HDRPrecision hdrPrecision) const
+{
+  return d->acquireTransientBuffer(name,
+                                   width,
+                                   height,
+                                   createColorBuffer,
+                                   multisample,
+                                   hdr,
+                                   extendedFBO,
+                                   clear,
+                                   hdrPrecision);
+}
+
+//##################################################################################################
+void OpenGLBuffers::releaseTransientBuffer(OpenGLFBO* buffer) const
+{
+  d->releaseTransientBuffer(buffer);
+}
+
+//##################################################################################################
+void OpenGLBuffers::collectTransientBuffers()
+{
+  d->collectTransientBuffers();
+}
+
+//##################################################################################################
+void OpenGLBuffers::deleteTransientBuffers()
+{
+  for(auto& t : d->transientBuffers)
+    d->deleteBuffer(*t.fbo);
+  d->transientBuffers.clear();
+  d->transientBytesInUse = 0;
+}
+
+//##################################################################################################
+void OpenGLBuffers::invalidateTransientBuffers()
+{
+  for(auto& t : d->transientBuffers)
+    d->eraseStoredBuffer(t.fbo.get());
+  d->transientBuffers.clear();
+  d->transientBytesInUse = 0;
+}
+
+//##################################################################################################
+TransientBufferStats OpenGLBuffers::transientBufferStats() const
+{
+  return d->transientBufferStats;
 }
 
 //##################################################################################################
@@ -665,7 +990,8 @@ bool OpenGLBuffers::bindBuffer(OpenGLFBO& buffer) const
                           buffer.multisample,
                           buffer.hdr,
                           buffer.extendedFBO,
-                          false);
+                          false,
+                          buffer.hdrPrecision);
 }
 
 //##################################################################################################
@@ -1,26 +1,450 @@
 #include "tp_maps/textures/BasicTexture.h"
 #include "tp_maps/Map.h"
+#include "tp_maps/WorkerThreads.h"
 
 #include "tp_utils/DebugUtils.h"
 #include "tp_utils/StackTrace.h"
 #include "tp_utils/TimeUtils.h"
 
+#include <algorithm>
 #include <cstring>
+#include <mutex>
 
 namespace tp_maps
 {
 
+namespace
+{
+//##################################################################################################
+bool usesMipmaps(GLint minFilterOption)
+{
+  return
+      minFilterOption == GL_NEAREST_MIPMAP_NEAREST ||
+      minFilterOption == GL_LINEAR_MIPMAP_NEAREST  ||
+      minFilterOption == GL_NEAREST_MIPMAP_LINEAR  ||
+      minFilterOption == GL_LINEAR_MIPMAP_LINEAR;
+}
+
+//##################################################################################################
+void setTextureParameters(Map* map,
+                          TPGLenum target,
+                          GLint magFilterOption,
+                          GLint minFilterOption,
+                          GLint textureWrapS,
+                          GLint textureWrapT)
+{
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, magFilterOption);
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilterOption);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureWrapS);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureWrapT);
+
+#if defined(TP_LINUX) && !defined(TP_GLES3)
+  if(map->maxTextureAnisotropy()>1.0f)
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, map->maxTextureAnisotropy());
+#else
+  TP_UNUSED(map);
+#endif
+}
+
+//##################################################################################################
+//! Returns false for profiles where non power of two textures are restricted or slow.
+/*!
+GLES 2 only supports NPOT textures without mipmaps or repeat wrapping, and some GL 2 drivers fall
+back to software for them.
+*/
+bool supportsNPOT(ShaderProfile shaderProfile)
+{
+  switch(shaderProfile)
+  {
+    case ShaderProfile::GLSL_110: [[fallthrough]];
+    case ShaderProfile::GLSL_120: [[fallthrough]];
+    case ShaderProfile::GLSL_100_ES:
+      return false;
+
+    default:
+      return true;
+  }
+}
+
+//##################################################################################################
+bool isGLES(ShaderProfile shaderProfile)
+{
+  switch(shaderProfile)
+  {
+    case ShaderProfile::GLSL_100_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_300_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_310_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_320_ES:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+//##################################################################################################
+size_t nextPowerOfTwo(size_t v)
+{
+  size_t p=1;
+  while(p<v)
+    p*=2;
+  return p;
+}
+
+//##################################################################################################
+//! Allocate a level without uploading any data, the formats match those used by uploadLevel.
+void allocateLevel(ShaderProfile shaderProfile,
+                   TPGLenum target,
+                   GLint level,
+                   TPGLenum format,
+                   size_t width,
+                   size_t height)
+{
+  // For GL ES the internalFormat and format need to be the same.
+  TPGLenum dataFormat = isGLES(shaderProfile)?format:GL_RGBA;
+  glTexImage2D(target, level, GLint(format), int(width), int(height), 0, dataFormat, GL_UNSIGNED_BYTE, nullptr);
+}
+
+//##################################################################################################
+//! Upload a single level with glTexImage2D, or glTexSubImage2D if subImage is true.
+void uploadLevel(ShaderProfile shaderProfile,
+                 TPGLenum target,
+                 GLint level,
+                 TPGLenum format,
+                 const tp_image_utils::ColorMap& img,
+                 bool subImage,
+                 GLint xOffset=0,
+                 GLint yOffset=0)
+{
+  auto upload = [&](TPGLenum internalFormat, TPGLenum dataFormat, const void* data)
+  {
+    if(subImage)
+      glTexSubImage2D(target, level, xOffset, yOffset, int(img.width()), int(img.height()), dataFormat, GL_UNSIGNED_BYTE, data);
+    else
+      glTexImage2D(target, level, GLint(internalFormat), int(img.width()), int(img.height()), 0, dataFormat, GL_UNSIGNED_BYTE, data);
+  };
+
+  switch(shaderProfile)
+  {
+    case ShaderProfile::GLSL_110: [[fallthrough]];
+    case ShaderProfile::GLSL_120: [[fallthrough]];
+    case ShaderProfile::GLSL_130: [[fallthrough]];
+    case ShaderProfile::GLSL_140: [[fallthrough]];
+    case ShaderProfile::GLSL_150: [[fallthrough]];
+    case ShaderProfile::GLSL_330: [[fallthrough]];
+    case ShaderProfile::GLSL_400: [[fallthrough]];
+    case ShaderProfile::GLSL_410: [[fallthrough]];
+    case ShaderProfile::GLSL_420: [[fallthrough]];
+    case ShaderProfile::GLSL_430: [[fallthrough]];
+    case ShaderProfile::GLSL_440: [[fallthrough]];
+    case ShaderProfile::GLSL_450: [[fallthrough]];
+    case ShaderProfile::GLSL_460:
+    {
+      upload(format, GL_RGBA, img.constData());
+      break;
+    }
+
+    case ShaderProfile::GLSL_100_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_300_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_310_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_320_ES:
+    {
+      if(format == GL_RGB)
+      {
+        // For GL ES we seem to need the internalFormat and format to be the same, so here we take the
+        // RGBA data and pack it as RGB.
+        struct RGB
+        {
+          uint8_t r;
+          uint8_t g;
+          uint8_t b;
+        };
+        std::vector<RGB> packed;
+        packed.resize(img.size());
+
+        auto dst = packed.begin();
+        auto src = img.constData();
+        for(; dst!=packed.end(); src++, ++dst)
+        {
+          dst->r = src->r;
+          dst->g = src->g;
+          dst->b = src->b;
+        }
+
+        // Each pixel is 3 bytes so row alignment may not be 4 bytes so set it to 1
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        upload(GL_RGB, GL_RGB, packed.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      }
+      else if(format == GL_RGBA)
+      {
+        upload(GL_RGBA, GL_RGBA, img.constData());
+      }
+
+      break;
+    }
+
+    case ShaderProfile::HLSL_10:
+    case ShaderProfile::HLSL_11:
+    case ShaderProfile::HLSL_12:
+    case ShaderProfile::HLSL_13:
+    case ShaderProfile::HLSL_14:
+    case ShaderProfile::HLSL_20:
+    case ShaderProfile::HLSL_20a:
+    case ShaderProfile::HLSL_20b:
+    case ShaderProfile::HLSL_30:
+    case ShaderProfile::HLSL_40:
+    case ShaderProfile::HLSL_41:
+    case ShaderProfile::HLSL_50:
+    case ShaderProfile::HLSL_51:
+    case ShaderProfile::HLSL_60:
+    case ShaderProfile::HLSL_61:
+    case ShaderProfile::HLSL_62:
+    case ShaderProfile::HLSL_63:
+    case ShaderProfile::HLSL_64:
+    case ShaderProfile::HLSL_65:
+    case ShaderProfile::HLSL_66:
+    case ShaderProfile::HLSL_67:
+    {
+      tpWarning() << "HLSL not implemented.";
+      break;
+    }
+  }
+}
+
+//##################################################################################################
+//! Returns true if mipmaps holds every level below img down to 1x1.
+bool isCompleteMipChain(const tp_image_utils::ColorMap& img, const std::vector<tp_image_utils::ColorMap>& mipmaps)
+{
+  if(mipmaps.empty())
+    return false;
+
+  size_t w = img.width();
+  size_t h = img.height();
+  for(const auto& mipmap : mipmaps)
+  {
+    w = tpMax(size_t(1), w/2);
+    h = tpMax(size_t(1), h/2);
+    if(mipmap.width()!=w || mipmap.height()!=h || !mipmap.constData())
+      return false;
+  }
+
+  return w==1 && h==1;
+}
+}
+
 //##################################################################################################
 struct BasicTexture::Private
 {
   TP_REF_COUNT_OBJECTS("tp_maps::BasicTexture::Private");
   TP_NONCOPYABLE(Private);
-  Private() = default;
+
+  Q* q;
 
   tp_image_utils::ColorMap image;
   NChannels nChannels{NChannels::RGBA};
   bool imageReady{false};
   bool makeSquare{true};
+
+  CompressedFormat compressedFormat{CompressedFormat::None};
+  std::string compressedCacheDirectory;
+  CompressedImage compressedImage;
+
+  std::vector<tp_image_utils::ColorMap> mipmaps;
+
+  // Images are compressed on the map's worker threads, the uncompressed image is used until the
+  // result is applied from the map's animate callback.
+  WorkerThreads* workerThreads{nullptr};
+  bool animateCallbackConnected{false};
+  bool compressionPending{false};
+  bool compressionMipmaps{false};
+  size_t compressionGeneration{0};
+
+  std::mutex completedMutex;
+  std::shared_ptr<CompressedImage> completedImage;
+  size_t completedGeneration{0};
+
+  //################################################################################################
+  Private(Q* q_):
+    q(q_)
+  {
+
+  }
+
+  //################################################################################################
+  ~Private()
+  {
+    if(workerThreads)
+      workerThreads->cancelJobs(this);
+  }
+
+  //################################################################################################
+  //! Call when the image or format changes so that results from older jobs are discarded.
+  void cancelCompression()
+  {
+    compressionGeneration++;
+    compressionPending = false;
+  }
+
+  //################################################################################################
+  void requestCompression(Map* map, bool mipmaps)
+  {
+    if(compressionPending && compressionMipmaps == mipmaps)
+      return;
+
+    compressionPending = true;
+    compressionMipmaps = mipmaps;
+    size_t generation = ++compressionGeneration;
+
+    if(!workerThreads)
+      workerThreads = &map->workerThreads();
+
+    if(!animateCallbackConnected)
+    {
+      animateCallbackConnected = true;
+      animateCallback.connect(map->animateCallbacks);
+    }
+
+    workerThreads->addJob(this, [this,
+                                image = image,
+                                format = compressedFormat,
+                                mipmaps,
+                                cacheDirectory = compressedCacheDirectory,
+                                generation]
+    {
+      auto result = std::make_shared<CompressedImage>(compressImageCached(image, format, mipmaps, cacheDirectory));
+
+      std::lock_guard<std::mutex> lock(completedMutex);
+      completedImage = result;
+      completedGeneration = generation;
+    });
+  }
+
+  //################################################################################################
+  void applyCompletedImage()
+  {
+    std::shared_ptr<CompressedImage> result;
+    size_t generation=0;
+    {
+      std::lock_guard<std::mutex> lock(completedMutex);
+      result.swap(completedImage);
+      generation = completedGeneration;
+    }
+
+    if(!result || generation != compressionGeneration)
+      return;
+
+    compressionPending = false;
+    compressedImage = std::move(*result);
+
+    // Ask the owner to bind the texture again now that the compressed image is ready.
+    q->imageChanged();
+  }
+
+  //################################################################################################
+  tp_utils::Callback<void(double)> animateCallback = [&](double)
+  {
+    applyCompletedImage();
+  };
+
+  //################################################################################################
+  //! Returns true if compressedImage should be uploaded rather than image.
+  /*!
+  If the compressed image is missing or stale it is encoded on the worker threads and this returns
+  false so that the uncompressed image is uploaded in the mean time.
+  */
+  bool prepareCompressedImage(Map* map, bool mipmaps)
+  {
+    if(image.constData() && compressedFormat != CompressedFormat::None)
+    {
+      bool stale = !compressedImage.isValid() || compressedImage.format != compressedFormat;
+      if(mipmaps && compressedImage.levels.size()==1 && (image.width()>1 || image.height()>1))
+        stale = true;
+
+      if(stale)
+      {
+        if(isSupported(map, compressedFormat))
+          requestCompression(map, mipmaps);
+        return false;
+      }
+    }
+
+    return compressedImage.isValid() && isSupported(map, compressedImage.format);
+  }
+
+  //################################################################################################
+  //! The size of the texture, this is only larger than the image on profiles without NPOT support.
+  glm::uvec2 textureSize(Map* map) const
+  {
+    glm::uvec2 size(image.width(), image.height());
+
+    // Compressed textures are uploaded at their own size.
+    if(compressedFormat != CompressedFormat::None && isSupported(map, compressedFormat))
+      return size;
+
+    if(makeSquare && !supportsNPOT(map->shaderProfile()))
+    {
+      auto pot = nextPowerOfTwo(tpMax(image.width(), image.height()));
+      size = {pot, pot};
+    }
+
+    return size;
+  }
+
+  //################################################################################################
+  bool padded(Map* map) const
+  {
+    auto size = textureSize(map);
+    return size.x != image.width() || size.y != image.height();
+  }
+
+  //################################################################################################
+  //! Upload the image into the corner of a texture that has already been allocated at textureSize.
+  /*!
+  The edge texels are clamped out to the full texture size so that linear filtering and the smaller
+  mipmap levels, which average across the padding, never sample undefined texels.
+  */
+  void uploadPadded(Map* map, TPGLenum format)
+  {
+    auto shaderProfile = map->shaderProfile();
+    auto size = textureSize(map);
+
+    uploadLevel(shaderProfile, GL_TEXTURE_2D, 0, format, image, true);
+
+    size_t w = image.width();
+    size_t h = image.height();
+    size_t tw = size.x;
+    size_t th = size.y;
+    const TPPixel* src = image.constData();
+
+    if(w<tw)
+    {
+      tp_image_utils::ColorMap columns(tw-w, h);
+      TPPixel* dst = columns.data();
+      for(size_t y=0; y<h; y++)
+        std::fill(dst + y*(tw-w), dst + (y+1)*(tw-w), src[y*w + (w-1)]);
+      uploadLevel(shaderProfile, GL_TEXTURE_2D, 0, format, columns, true, GLint(w), 0);
+    }
+
+    if(h<th)
+    {
+      tp_image_utils::ColorMap rows(tw, th-h);
+      TPPixel* dst = rows.data();
+      const TPPixel* last = src + (h-1)*w;
+      std::memcpy(dst, last, w*sizeof(TPPixel));
+      std::fill(dst + w, dst + tw, last[w-1]);
+      for(size_t y=1; y<th-h; y++)
+        std::memcpy(dst + y*tw, dst, tw*sizeof(TPPixel));
+      uploadLevel(shaderProfile, GL_TEXTURE_2D, 0, format, rows, true, 0, GLint(h));
+    }
+  }
+
+  //################################################################################################
+  static bool isSupported(Map* map, CompressedFormat format)
+  {
+    const auto& formats = map->supportedCompressedFormats();
+    return std::find(formats.begin(), formats.end(), format) != formats.end();
+  }
 };
 
 //##################################################################################################
@@ -29,7 +453,7 @@ BasicTexture::BasicTexture(Map* map,
                            NChannels nChannels,
                            bool makeSquare):
   Texture(map),
-  d(new Private())
+  d(new Private(this))
 {
   d->makeSquare = makeSquare;
   setImage(image, nChannels);
@@ -46,12 +470,13 @@ void BasicTexture::setImage(const tp_image_utils::ColorMap& image,
                             NChannels nChannels,
                             bool quiet)
 {
-  if(d->makeSquare)
-    image.clone2IntoOther(d->image);
-  else
-    d->image = image;
+  // Padding for profiles without NPOT support is applied on upload, see Private::textureSize.
+  d->image = image;
 
   d->nChannels = nChannels;
+  d->compressedImage = CompressedImage();
+  d->cancelCompression();
+  d->mipmaps.clear();
 
   d->imageReady = (d->image.constData() && d->image.width()>0 && d->image.height()>0);
 
@@ -59,6 +484,54 @@ void BasicTexture::setImage(const tp_image_utils::ColorMap& image,
     imageChanged();
 }
 
+//##################################################################################################
+void BasicTexture::setCompressedImage(const CompressedImage& compressedImage,
+                                      bool quiet)
+{
+  d->image = tp_image_utils::ColorMap();
+  d->nChannels = NChannels::RGBA;
+  d->compressedImage = compressedImage;
+  d->cancelCompression();
+  d->mipmaps.clear();
+
+  d->imageReady = d->compressedImage.isValid();
+
+  if(!quiet)
+    imageChanged();
+}
+
+//##################################################################################################
+void BasicTexture::setCompressedFormat(CompressedFormat compressedFormat,
+                                       const std::string& cacheDirectory)
+{
+  d->compressedFormat = compressedFormat;
+  d->compressedCacheDirectory = cacheDirectory;
+
+  if(d->image.constData())
+  {
+    d->compressedImage = CompressedImage();
+    d->cancelCompression();
+  }
+}
+
+//##################################################################################################
+CompressedFormat BasicTexture::compressedFormat() const
+{
+  return d->compressedFormat;
+}
+
+//##################################################################################################
+void BasicTexture::setMipmaps(const std::vector<tp_image_utils::ColorMap>& mipmaps)
+{
+  d->mipmaps = mipmaps;
+}
+
+//##################################################################################################
+const std::vector<tp_image_utils::ColorMap>& BasicTexture::mipmaps() const
+{
+  return d->mipmaps;
+}
+
 //##################################################################################################
 const tp_image_utils::ColorMap& BasicTexture::image() const
 {
@@ -79,95 +552,39 @@ void BasicTexture::updateContent(GLuint texId)
 
   glBindTexture(GL_TEXTURE_2D, texId);
 
-  TPGLenum format = d->nChannels==NChannels::RGB?GL_RGB:GL_RGBA;
-
-  switch(map()->shaderProfile())
-  {
-  case ShaderProfile::GLSL_110: [[fallthrough]];
-  case ShaderProfile::GLSL_120: [[fallthrough]];
-  case ShaderProfile::GLSL_130: [[fallthrough]];
-  case ShaderProfile::GLSL_140: [[fallthrough]];
-  case ShaderProfile::GLSL_150: [[fallthrough]];
-  case ShaderProfile::GLSL_330: [[fallthrough]];
-  case ShaderProfile::GLSL_400: [[fallthrough]];
-  case ShaderProfile::GLSL_410: [[fallthrough]];
-  case ShaderProfile::GLSL_420: [[fallthrough]];
-  case ShaderProfile::GLSL_430: [[fallthrough]];
-  case ShaderProfile::GLSL_440: [[fallthrough]];
-  case ShaderProfile::GLSL_450: [[fallthrough]];
-  case ShaderProfile::GLSL_460:
+  if(d->prepareCompressedImage(map(), usesMipmaps(minFilterOption())))
   {
-    glTexSubImage2D(GL_TEXTURE_2D, 0 /*level */, 0 /* x offset */, 0 /* y offset */, int(d->image.width()), int(d->image.height()), GL_RGBA, GL_UNSIGNED_BYTE, d->image.constData());
-    break;
+    GLenum internalFormat = compressedFormatGLEnum(d->compressedImage.format);
+    for(size_t l=0; l<d->compressedImage.levels.size(); l++)
+    {
+      const auto& level = d->compressedImage.levels.at(l);
+      glCompressedTexSubImage2D(GL_TEXTURE_2D, GLint(l), 0, 0, GLsizei(level.width), GLsizei(level.height), internalFormat, GLsizei(level.data.size()), level.data.data());
+    }
+    return;
   }
 
-  case ShaderProfile::GLSL_100_ES: [[fallthrough]];
-  case ShaderProfile::GLSL_300_ES: [[fallthrough]];
-  case ShaderProfile::GLSL_310_ES: [[fallthrough]];
-  case ShaderProfile::GLSL_320_ES:
-  {
-    if(format == GL_RGB)
-    {
-      // For GL ES we seem to need the internalFormat and format to be the same, so here we take the
-      // RGBA data and pack it as RGB.
-      struct RGB
-      {
-        uint8_t r;
-        uint8_t g;
-        uint8_t b;
-      };
-      std::vector<RGB> packed;
-      packed.resize(d->image.size());
-
-      auto dst = packed.begin();
-      auto src = d->image.constData();
-      for(; dst!=packed.end(); src++, ++dst)
-      {
-        dst->r = src->r;
-        dst->g = src->g;
-        dst->b = src->b;
-      }
+  // The new image is still being encoded, imageChanged is called when it is ready.
+  if(d->compressionPending)
+    return;
 
-      // Each pixel is 3 bytes so row alignment may not be 4 bytes so set it to 1
-      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-      glTexSubImage2D(GL_TEXTURE_2D, 0 /*level */, 0 /* x offset */, 0 /* y offset */, int(d->image.width()), int(d->image.height()), GL_RGB, GL_UNSIGNED_BYTE, packed.data());
-      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-    }
-    else if(format == GL_RGBA)
-    {
-      glTexSubImage2D(GL_TEXTURE_2D, 0 /*level */, 0 /* x offset */, 0 /* y offset */, int(d->image.width()), int(d->image.height()), GL_RGBA, GL_UNSIGNED_BYTE, d->image.constData());
-    }
+  if(!d->image.constData())
+    return;
 
-    break;
-  }
+  TPGLenum format = d->nChannels==NChannels::RGB?GL_RGB:GL_RGBA;
 
-  case ShaderProfile::HLSL_10:
-  case ShaderProfile::HLSL_11:
-  case ShaderProfile::HLSL_12:
-  case ShaderProfile::HLSL_13:
-  case ShaderProfile::HLSL_14:
-  case ShaderProfile::HLSL_20:
-  case ShaderProfile::HLSL_20a:
-  case ShaderProfile::HLSL_20b:
-  case ShaderProfile::HLSL_30:
-  case ShaderProfile::HLSL_40:
-  case ShaderProfile::HLSL_41:
-  case ShaderProfile::HLSL_50:
-  case ShaderProfile::HLSL_51:
-  case ShaderProfile::HLSL_60:
-  case ShaderProfile::HLSL_61:
-  case ShaderProfile::HLSL_62:
-  case ShaderProfile::HLSL_63:
-  case ShaderProfile::HLSL_64:
-  case ShaderProfile::HLSL_65:
-  case ShaderProfile::HLSL_66:
-  case ShaderProfile::HLSL_67:
+  if(d->padded(map()))
   {
-    tpWarning() << "HLSL not implemented.";
-    break;
-  }
+    d->uploadPadded(map(), format);
+    if(usesMipmaps(minFilterOption()))
+      glGenerateMipmap(GL_TEXTURE_2D);
+    return;
   }
 
+  uploadLevel(map()->shaderProfile(), GL_TEXTURE_2D, 0, format, d->image, true);
+
+  if(usesMipmaps(minFilterOption()) && isCompleteMipChain(d->image, d->mipmaps))
+    for(size_t l=0; l<d->mipmaps.size(); l++)
+      uploadLevel(map()->shaderProfile(), GL_TEXTURE_2D, GLint(l+1), format, d->mipmaps.at(l), true);
 }
 
 //##################################################################################################
@@ -176,13 +593,58 @@ GLuint BasicTexture::bindTexture()
   if(!d->imageReady)
     return 0;
 
+  if(d->prepareCompressedImage(map(), usesMipmaps(minFilterOption())))
+    return bindCompressedTexture(d->compressedImage,
+                                 GL_TEXTURE_2D,
+                                 magFilterOption(),
+                                 minFilterOption(),
+                                 textureWrapS(),
+                                 textureWrapT());
+
+  if(!d->image.constData())
+  {
+    tpWarning() << "Compressed texture format not supported: " << compressedFormatToString(d->compressedImage.format);
+    return 0;
+  }
+
+  TPGLenum format = d->nChannels==NChannels::RGB?GL_RGB:GL_RGBA;
+
+  if(d->padded(map()))
+  {
+    TP_FUNCTION_TIME("BasicTexture::bindTexture padded");
+
+    if(!map()->initialized())
+    {
+      tpWarning() << "Error! Trying to generate a texture on a map that is not initialized.";
+      tp_utils::printStackTrace();
+      return 0;
+    }
+
+    auto size = d->textureSize(map());
+
+    GLuint txId=0;
+    glGenTextures(1, &txId);
+    glBindTexture(GL_TEXTURE_2D, txId);
+
+    allocateLevel(map()->shaderProfile(), GL_TEXTURE_2D, 0, format, size.x, size.y);
+    d->uploadPadded(map(), format);
+
+    if(usesMipmaps(minFilterOption()))
+      glGenerateMipmap(GL_TEXTURE_2D);
+
+    setTextureParameters(map(), GL_TEXTURE_2D, magFilterOption(), minFilterOption(), textureWrapS(), textureWrapT());
+
+    return txId;
+  }
+
   GLuint texture = bindTexture(d->image,
                                GL_TEXTURE_2D,
-                               d->nChannels==NChannels::RGB?GL_RGB:GL_RGBA,
+                               format,
                                magFilterOption(),
                                minFilterOption(),
                                textureWrapS(),
-                               textureWrapT());
+                               textureWrapT(),
+                               d->mipmaps);
 
   return texture;
 }
@@ -194,7 +656,8 @@ GLuint BasicTexture::bindTexture(const tp_image_utils::ColorMap& img,
                                  GLint magFilterOption,
                                  GLint minFilterOption,
                                  GLint textureWrapS,
-                                 GLint textureWrapT)
+                                 GLint textureWrapT,
+                                 const std::vector<tp_image_utils::ColorMap>& mipmaps)
 {
   TP_FUNCTION_TIME("BasicTexture::bindTexture");
 
@@ -230,121 +693,99 @@ GLuint BasicTexture::bindTexture(const tp_image_utils::ColorMap& img,
   glGenTextures(1, &txId);
   glBindTexture(target, txId);
 
-  switch(map()->shaderProfile())
+  uploadLevel(map()->shaderProfile(), target, 0, format, img, false);
+
+  if(usesMipmaps(minFilterOption))
   {
-    case ShaderProfile::GLSL_110: [[fallthrough]];
-    case ShaderProfile::GLSL_120: [[fallthrough]];
-    case ShaderProfile::GLSL_130: [[fallthrough]];
-    case ShaderProfile::GLSL_140: [[fallthrough]];
-    case ShaderProfile::GLSL_150: [[fallthrough]];
-    case ShaderProfile::GLSL_330: [[fallthrough]];
-    case ShaderProfile::GLSL_400: [[fallthrough]];
-    case ShaderProfile::GLSL_410: [[fallthrough]];
-    case ShaderProfile::GLSL_420: [[fallthrough]];
-    case ShaderProfile::GLSL_430: [[fallthrough]];
-    case ShaderProfile::GLSL_440: [[fallthrough]];
-    case ShaderProfile::GLSL_450: [[fallthrough]];
-    case ShaderProfile::GLSL_460:
+    if(isCompleteMipChain(img, mipmaps))
     {
-      glTexImage2D(target, 0, format, int(img.width()), int(img.height()), 0, GL_RGBA, GL_UNSIGNED_BYTE, img.constData());
-      break;
-    }
+      for(size_t l=0; l<mipmaps.size(); l++)
+        uploadLevel(map()->shaderProfile(), target, GLint(l+1), format, mipmaps.at(l), false);
 
-    case ShaderProfile::GLSL_100_ES: [[fallthrough]];
-    case ShaderProfile::GLSL_300_ES: [[fallthrough]];
-    case ShaderProfile::GLSL_310_ES: [[fallthrough]];
-    case ShaderProfile::GLSL_320_ES:
-    {
-      if(format == GL_RGB)
-      {
-        // For GL ES we seem to need the internalFormat and format to be the same, so here we take the
-        // RGBA data and pack it as RGB.
-        struct RGB
-        {
-          uint8_t r;
-          uint8_t g;
-          uint8_t b;
-        };
-        std::vector<RGB> packed;
-        packed.resize(img.size());
+#ifndef TP_GLES2
+      glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, GLint(mipmaps.size()));
+#endif
+    }
+    else
+      glGenerateMipmap(target);
+  }
 
-        auto dst = packed.begin();
-        auto src = img.constData();
-        for(; dst!=packed.end(); src++, ++dst)
-        {
-          dst->r = src->r;
-          dst->g = src->g;
-          dst->b = src->b;
-        }
+  setTextureParameters(map(), target, magFilterOption, minFilterOption, textureWrapS, textureWrapT);
 
-        // Each pixel is 3 bytes so row alignment may not be 4 bytes so set it to 1
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glTexImage2D(target, 0, GL_RGB, int(img.width()), int(img.height()), 0, GL_RGB, GL_UNSIGNED_BYTE, packed.data());
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-      }
-      else if(format == GL_RGBA)
-      {
-        glTexImage2D(target, 0, GL_RGBA, int(img.width()), int(img.height()), 0, GL_RGBA, GL_UNSIGNED_BYTE, img.constData());
-      }
+  return txId;
+}
 
-      break;
-    }
+//##################################################################################################
+GLuint BasicTexture::bindCompressedTexture(const CompressedImage& compressedImage,
+                                           TPGLenum target,
+                                           GLint magFilterOption,
+                                           GLint minFilterOption,
+                                           GLint textureWrapS,
+                                           GLint textureWrapT)
+{
+  TP_FUNCTION_TIME("BasicTexture::bindCompressedTexture");
 
-    case ShaderProfile::HLSL_10:
-    case ShaderProfile::HLSL_11:
-    case ShaderProfile::HLSL_12:
-    case ShaderProfile::HLSL_13:
-    case ShaderProfile::HLSL_14:
-    case ShaderProfile::HLSL_20:
-    case ShaderProfile::HLSL_20a:
-    case ShaderProfile::HLSL_20b:
-    case ShaderProfile::HLSL_30:
-    case ShaderProfile::HLSL_40:
-    case ShaderProfile::HLSL_41:
-    case ShaderProfile::HLSL_50:
-    case ShaderProfile::HLSL_51:
-    case ShaderProfile::HLSL_60:
-    case ShaderProfile::HLSL_61:
-    case ShaderProfile::HLSL_62:
-    case ShaderProfile::HLSL_63:
-    case ShaderProfile::HLSL_64:
-    case ShaderProfile::HLSL_65:
-    case ShaderProfile::HLSL_66:
-    case ShaderProfile::HLSL_67:
-    {
-      tpWarning() << "HLSL not implemented.";
-      break;
-    }
+  if(!map()->initialized())
+  {
+    tpWarning() << "Error! Trying to generate a texture on a map that is not initialized.";
+    tp_utils::printStackTrace();
+    return 0;
   }
 
-  if((minFilterOption == GL_NEAREST_MIPMAP_NEAREST) || (minFilterOption == GL_LINEAR_MIPMAP_LINEAR))
-    glGenerateMipmap(target);
+  if(!compressedImage.isValid())
+  {
+    tpWarning() << "BasicTexture::bindCompressedTexture() called with invalid image";
+    tp_utils::printStackTrace();
+    return 0;
+  }
 
-  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, magFilterOption);
-  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilterOption);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureWrapS);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureWrapT);
+  GLuint txId=0;
+  glGenTextures(1, &txId);
+  glBindTexture(target, txId);
 
-#if defined(TP_LINUX) && !defined(TP_GLES3)
+  GLenum internalFormat = compressedFormatGLEnum(compressedImage.format);
+  for(size_t l=0; l<compressedImage.levels.size(); l++)
   {
-    float maxAnisotropy;
-    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAnisotropy);
+    const auto& level = compressedImage.levels.at(l);
+    glCompressedTexImage2D(target, GLint(l), internalFormat, GLsizei(level.width), GLsizei(level.height), 0, GLsizei(level.data.size()), level.data.data());
   }
+
+#ifndef TP_GLES2
+  glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, GLint(compressedImage.levels.size()-1));
 #endif
 
+  // glGenerateMipmap can't be used with compressed textures, so without a chain don't use mipmaps.
+  if(compressedImage.levels.size()==1 && usesMipmaps(minFilterOption))
+    minFilterOption = GL_LINEAR;
+
+  setTextureParameters(map(), target, magFilterOption, minFilterOption, textureWrapS, textureWrapT);
+
   return txId;
 }
 
 //##################################################################################################
 glm::vec2 BasicTexture::textureDims() const
 {
-  return {d->image.fw(), d->image.fh()};
+  if(!d->image.constData() && d->compressedImage.isValid())
+    return {1.0f, 1.0f};
+
+  auto size = d->textureSize(map());
+  if(size.x<1 || size.y<1)
+    return {d->image.fw(), d->image.fh()};
+
+  return
+  {
+    d->image.fw() * float(d->image.width())  / float(size.x),
+    d->image.fh() * float(d->image.height()) / float(size.y)
+  };
 }
 
 //##################################################################################################
 glm::vec2 BasicTexture::imageDims() const
 {
+  if(!d->image.constData() && d->compressedImage.isValid())
+    return {float(d->compressedImage.width()), float(d->compressedImage.height())};
+
   return {float(d->image.width())*d->image.fw(), float(d->image.height())*d->image.fh()};
 }
 
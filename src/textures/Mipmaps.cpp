@@ -0,0 +1,338 @@
+#include "tp_maps/textures/Mipmaps.h"
+
+#include "tp_image_utils/ColorMap.h"
+
+#include "tp_utils/DebugUtils.h"
+#include "tp_utils/TimeUtils.h"
+
+#include <array>
+#include <cmath>
+
+namespace tp_maps
+{
+
+namespace
+{
+
+//##################################################################################################
+//! Linear float RGBA image used between levels to avoid quantizing each level to 8 bits.
+struct FloatImage_lt
+{
+  size_t w{0};
+  size_t h{0};
+  std::vector<float> data;
+
+  FloatImage_lt(size_t w_, size_t h_):
+    w(w_),
+    h(h_),
+    data(w_*h_*4, 0.0f)
+  {
+
+  }
+
+  float* pixel(size_t x, size_t y){return data.data() + (y*w+x)*4;}
+  const float* pixel(size_t x, size_t y) const {return data.data() + (y*w+x)*4;}
+};
+
+//##################################################################################################
+const std::array<float, 256>& srgbToLinearTable()
+{
+  static const std::array<float, 256> table = []
+  {
+    std::array<float, 256> t{};
+    for(size_t i=0; i<256; i++)
+    {
+      float c = float(i)/255.0f;
+      t[i] = (c<=0.04045f)?(c/12.92f):std::pow((c+0.055f)/1.055f, 2.4f);
+    }
+    return t;
+  }();
+  return table;
+}
+
+//##################################################################################################
+uint8_t toByte(float c)
+{
+  return uint8_t(std::lround(tpBound(0.0f, c, 1.0f)*255.0f));
+}
+
+//##################################################################################################
+uint8_t linearToSRGB(float c)
+{
+  c = tpBound(0.0f, c, 1.0f);
+  c = (c<=0.0031308f)?(c*12.92f):(1.055f*std::pow(c, 1.0f/2.4f) - 0.055f);
+  return toByte(c);
+}
+
+//##################################################################################################
+FloatImage_lt toFloat(const tp_image_utils::ColorMap& image, bool gammaCorrect)
+{
+  const auto& table = srgbToLinearTable();
+
+  FloatImage_lt result(image.width(), image.height());
+  const TPPixel* src = image.constData();
+  float* dst = result.data.data();
+  for(const TPPixel* srcMax=src+image.size(); src<srcMax; src++, dst+=4)
+  {
+    if(gammaCorrect)
+    {
+      dst[0] = table[src->r];
+      dst[1] = table[src->g];
+      dst[2] = table[src->b];
+    }
+    else
+    {
+      dst[0] = float(src->r)/255.0f;
+      dst[1] = float(src->g)/255.0f;
+      dst[2] = float(src->b)/255.0f;
+    }
+    dst[3] = float(src->a)/255.0f;
+  }
+
+  return result;
+}
+
+//##################################################################################################
+tp_image_utils::ColorMap toColorMap(const FloatImage_lt& image, bool gammaCorrect)
+{
+  tp_image_utils::ColorMap result(image.w, image.h);
+  const float* src = image.data.data();
+  TPPixel* dst = result.data();
+  for(TPPixel* dstMax=dst+result.size(); dst<dstMax; dst++, src+=4)
+  {
+    if(gammaCorrect)
+    {
+      dst->r = linearToSRGB(src[0]);
+      dst->g = linearToSRGB(src[1]);
+      dst->b = linearToSRGB(src[2]);
+    }
+    else
+    {
+      dst->r = toByte(src[0]);
+      dst->g = toByte(src[1]);
+      dst->b = toByte(src[2]);
+    }
+    dst->a = toByte(src[3]);
+  }
+
+  return result;
+}
+
+//##################################################################################################
+//! Box filter an 8 bit image to half its size, odd dimensions repeat the edge pixels.
+tp_image_utils::ColorMap boxDownsample(const tp_image_utils::ColorMap& image)
+{
+  size_t w = image.width();
+  size_t h = image.height();
+  size_t dw = tpMax(size_t(1), w/2);
+  size_t dh = tpMax(size_t(1), h/2);
+
+  tp_image_utils::ColorMap result(dw, dh);
+  const TPPixel* src = image.constData();
+  TPPixel* dst = result.data();
+
+  for(size_t y=0; y<dh; y++)
+  {
+    size_t y0 = tpMin(y*2, h-1);
+    size_t y1 = tpMin(y*2+1, h-1);
+    for(size_t x=0; x<dw; x++)
+    {
+      size_t x0 = tpMin(x*2, w-1);
+      size_t x1 = tpMin(x*2+1, w-1);
+      const TPPixel& a = src[y0*w+x0];
+      const TPPixel& b = src[y0*w+x1];
+      const TPPixel& c = src[y1*w+x0];
+      const TPPixel& d = src[y1*w+x1];
+      TPPixel& o = dst[y*dw+x];
+      o.r = uint8_t((int(a.r)+b.r+c.r+d.r+2)/4);
+      o.g = uint8_t((int(a.g)+b.g+c.g+d.g+2)/4);
+      o.b = uint8_t((int(a.b)+b.b+c.b+d.b+2)/4);
+      o.a = uint8_t((int(a.a)+b.a+c.a+d.a+2)/4);
+    }
+  }
+
+  return result;
+}
+
+//##################################################################################################
+FloatImage_lt boxDownsample(const FloatImage_lt& image)
+{
+  size_t dw = tpMax(size_t(1), image.w/2);
+  size_t dh = tpMax(size_t(1), image.h/2);
+
+  FloatImage_lt result(dw, dh);
+  for(size_t y=0; y<dh; y++)
+  {
+    size_t y0 = tpMin(y*2, image.h-1);
+    size_t y1 = tpMin(y*2+1, image.h-1);
+    for(size_t x=0; x<dw; x++)
+    {
+      size_t x0 = tpMin(x*2, image.w-1);
+      size_t x1 = tpMin(x*2+1, image.w-1);
+      const float* a = image.pixel(x0, y0);
+      const float* b = image.pixel(x1, y0);
+      const float* c = image.pixel(x0, y1);
+      const float* d = image.pixel(x1, y1);
+      float* o = result.pixel(x, y);
+      for(size_t i=0; i<4; i++)
+        o[i] = (a[i]+b[i]+c[i]+d[i])*0.25f;
+    }
+  }
+
+  return result;
+}
+
+//##################################################################################################
+//! Zeroth order modified Bessel function of the first kind, used by the Kaiser window.
+float besselI0(float x)
+{
+  float sum = 1.0f;
+  float term = 1.0f;
+  float halfX = x*0.5f;
+  for(int k=1; k<16; k++)
+  {
+    term *= (halfX/float(k))*(halfX/float(k));
+    sum += term;
+  }
+  return sum;
+}
+
+//##################################################################################################
+//! Weights for the 6 source pixels at distances -2.5 to 2.5 from the center of a reduced pixel.
+const std::array<float, 6>& kaiserWeights()
+{
+  static const std::array<float, 6> weights = []
+  {
+    constexpr float pi = 3.14159265358979f;
+    constexpr float beta = 4.0f;
+    constexpr float radius = 3.0f;
+
+    std::array<float, 6> w{};
+    float total = 0.0f;
+    for(size_t i=0; i<6; i++)
+    {
+      float d = float(i) - 2.5f;
+
+      // Sinc with its cutoff at half the source sample rate.
+      float x = pi*d*0.5f;
+      float sinc = std::sin(x)/x;
+
+      float r = d/radius;
+      float window = besselI0(beta*std::sqrt(tpMax(0.0f, 1.0f-r*r)))/besselI0(beta);
+
+      w[i] = sinc*window;
+      total += w[i];
+    }
+
+    for(auto& v : w)
+      v /= total;
+
+    return w;
+  }();
+  return weights;
+}
+
+//##################################################################################################
+//! Reduce one axis by half using the Kaiser filter, a dimension of 1 is copied unchanged.
+FloatImage_lt kaiserDownsampleAxis(const FloatImage_lt& image, bool horizontal)
+{
+  const auto& weights = kaiserWeights();
+
+  size_t len = horizontal?image.w:image.h;
+  if(len<2)
+    return image;
+
+  size_t dLen = len/2;
+  size_t dw = horizontal?dLen:image.w;
+  size_t dh = horizontal?image.h:dLen;
+  FloatImage_lt result(dw, dh);
+
+  auto clampIndex = [&](int64_t i){return size_t(tpBound(int64_t(0), i, int64_t(len)-1));};
+
+  for(size_t y=0; y<dh; y++)
+  {
+    for(size_t x=0; x<dw; x++)
+    {
+      size_t c = horizontal?x:y;
+      float* o = result.pixel(x, y);
+      for(size_t t=0; t<6; t++)
+      {
+        size_t s = clampIndex(int64_t(c*2) + int64_t(t) - 2);
+        const float* p = horizontal?image.pixel(s, y):image.pixel(x, s);
+        for(size_t i=0; i<4; i++)
+          o[i] += p[i]*weights[t];
+      }
+
+      // The negative lobes can overshoot.
+      for(size_t i=0; i<4; i++)
+        o[i] = tpBound(0.0f, o[i], 1.0f);
+    }
+  }
+
+  return result;
+}
+}
+
+//##################################################################################################
+std::vector<MipmapFilter> mipmapFilters()
+{
+  return {MipmapFilter::Box, MipmapFilter::Kaiser};
+}
+
+//##################################################################################################
+std::string mipmapFilterToString(MipmapFilter mipmapFilter)
+{
+  switch(mipmapFilter)
+  {
+    case MipmapFilter::Box:    return "Box";
+    case MipmapFilter::Kaiser: return "Kaiser";
+  }
+  return "Box";
+}
+
+//##################################################################################################
+MipmapFilter mipmapFilterFromString(const std::string& mipmapFilter)
+{
+  if(mipmapFilter == "Kaiser")
+    return MipmapFilter::Kaiser;
+  return MipmapFilter::Box;
+}
+
+//##################################################################################################
+std::vector<tp_image_utils::ColorMap> generateMipmaps(const tp_image_utils::ColorMap& image,
+                                                      MipmapFilter mipmapFilter,
+                                                      bool gammaCorrect)
+{
+  TP_FUNCTION_TIME("generateMipmaps");
+
+  std::vector<tp_image_utils::ColorMap> mipmaps;
+  if(image.width()<1 || image.height()<1 || !image.constData())
+    return mipmaps;
+
+  // Plain box filtering stays in 8 bits so that it matches the results of glGenerateMipmap.
+  if(mipmapFilter == MipmapFilter::Box && !gammaCorrect)
+  {
+    const tp_image_utils::ColorMap* level = &image;
+    while(level->width()>1 || level->height()>1)
+    {
+      mipmaps.push_back(boxDownsample(*level));
+      level = &mipmaps.back();
+    }
+    return mipmaps;
+  }
+
+  FloatImage_lt level = toFloat(image, gammaCorrect);
+  while(level.w>1 || level.h>1)
+  {
+    if(mipmapFilter == MipmapFilter::Kaiser)
+      level = kaiserDownsampleAxis(kaiserDownsampleAxis(level, true), false);
+    else
+      level = boxDownsample(level);
+
+    mipmaps.push_back(toColorMap(level, gammaCorrect));
+  }
+
+  return mipmaps;
+}
+
+}
@@ -0,0 +1,1346 @@
+#include "tp_maps/textures/TextureCompression.h"
+#include "tp_maps/textures/Mipmaps.h"
+
+#include "tp_image_utils/ColorMap.h"
+
+#include "tp_utils/DebugUtils.h"
+#include "tp_utils/TimeUtils.h"
+
+#include "glm/glm.hpp" // IWYU pragma: keep
+
+#include <array>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace tp_maps
+{
+
+namespace
+{
+// The internal formats are defined here because not every platform header defines all of them.
+constexpr GLenum TP_GL_COMPRESSED_RGB_S3TC_DXT1  = 0x83F0;
+constexpr GLenum TP_GL_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+constexpr GLenum TP_GL_COMPRESSED_RED_RGTC1      = 0x8DBB;
+constexpr GLenum TP_GL_COMPRESSED_RG_RGTC2       = 0x8DBD;
+constexpr GLenum TP_GL_COMPRESSED_RGBA_BPTC      = 0x8E8C;
+constexpr GLenum TP_GL_COMPRESSED_RGB8_ETC2      = 0x9274;
+constexpr GLenum TP_GL_COMPRESSED_RGBA8_ETC2_EAC = 0x9278;
+
+constexpr uint32_t cacheMagic   = 0x54435054; // "TPCT"
+constexpr uint32_t cacheVersion = 1;
+
+//##################################################################################################
+//! A 4x4 block of pixels in row major order, edge pixels are repeated for partial blocks.
+using Block_lt = std::array<TPPixel, 16>;
+
+//##################################################################################################
+void readBlock(const tp_image_utils::ColorMap& image, size_t bx, size_t by, Block_lt& block)
+{
+  const TPPixel* data = image.constData();
+  size_t w = image.width();
+  size_t h = image.height();
+
+  for(size_t y=0; y<4; y++)
+  {
+    size_t sy = std::min(by*4+y, h-1);
+    for(size_t x=0; x<4; x++)
+      block[y*4+x] = data[sy*w + std::min(bx*4+x, w-1)];
+  }
+}
+
+//##################################################################################################
+uint8_t channel(const TPPixel& p, size_t c)
+{
+  switch(c)
+  {
+    case 0: return p.r;
+    case 1: return p.g;
+    case 2: return p.b;
+    default: return p.a;
+  }
+}
+
+//##################################################################################################
+void writeLE(uint8_t* out, uint64_t value, size_t bytes)
+{
+  for(size_t i=0; i<bytes; i++)
+    out[i] = uint8_t(value >> (i*8));
+}
+
+//##################################################################################################
+void writeBE(uint8_t* out, uint64_t value, size_t bytes)
+{
+  for(size_t i=0; i<bytes; i++)
+    out[i] = uint8_t(value >> ((bytes-1-i)*8));
+}
+
+//##################################################################################################
+template<typename V, typename M>
+V principalAxis(const M& covariance, V axis)
+{
+  for(int i=0; i<8; i++)
+  {
+    V next = covariance * axis;
+    float l = glm::length(next);
+    if(l<1e-6f)
+      break;
+    axis = next / l;
+  }
+  return axis;
+}
+
+//##################################################################################################
+uint16_t to565(const glm::vec3& c)
+{
+  auto q = [](float v, float m){return uint16_t(std::clamp(int(v*m/255.0f + 0.5f), 0, int(m)));};
+  return uint16_t((q(c.x, 31.0f)<<11) | (q(c.y, 63.0f)<<5) | q(c.z, 31.0f));
+}
+
+//##################################################################################################
+glm::vec3 from565(uint16_t c)
+{
+  int r = (c>>11) & 31;
+  int g = (c>> 5) & 63;
+  int b =  c      & 31;
+  return {float((r<<3)|(r>>2)), float((g<<2)|(g>>4)), float((b<<3)|(b>>2))};
+}
+
+//##################################################################################################
+void encodeBC1(const Block_lt& block, uint8_t* out)
+{
+  glm::vec3 mean{0.0f};
+  for(const auto& p : block)
+    mean += glm::vec3(p.r, p.g, p.b);
+  mean /= 16.0f;
+
+  glm::mat3 covariance{0.0f};
+  for(const auto& p : block)
+  {
+    glm::vec3 v = glm::vec3(p.r, p.g, p.b) - mean;
+    covariance += glm::outerProduct(v, v);
+  }
+
+  glm::vec3 axis = principalAxis(covariance, glm::normalize(glm::vec3(1.0f)));
+
+  float tMin=0.0f;
+  float tMax=0.0f;
+  for(const auto& p : block)
+  {
+    float t = glm::dot(glm::vec3(p.r, p.g, p.b) - mean, axis);
+    tMin = std::min(tMin, t);
+    tMax = std::max(tMax, t);
+  }
+
+  uint16_t c0 = to565(glm::clamp(mean + axis*tMax, 0.0f, 255.0f));
+  uint16_t c1 = to565(glm::clamp(mean + axis*tMin, 0.0f, 255.0f));
+
+  // c0>c1 selects the 4 color mode.
+  if(c0<c1)
+    std::swap(c0, c1);
+
+  uint32_t indices=0;
+  if(c0!=c1)
+  {
+    std::array<glm::vec3, 4> palette;
+    palette[0] = from565(c0);
+    palette[1] = from565(c1);
+    palette[2] = (2.0f*palette[0] + palette[1]) / 3.0f;
+    palette[3] = (palette[0] + 2.0f*palette[1]) / 3.0f;
+
+    for(size_t i=0; i<16; i++)
+    {
+      glm::vec3 v(block[i].r, block[i].g, block[i].b);
+      uint32_t best=0;
+      float bestError=std::numeric_limits<float>::max();
+      for(uint32_t c=0; c<4; c++)
+      {
+        glm::vec3 e = palette[c] - v;
+        if(float error = glm::dot(e, e); error<bestError)
+        {
+          bestError = error;
+          best = c;
+        }
+      }
+      indices |= best << (i*2);
+    }
+  }
+
+  writeLE(out  , c0, 2);
+  writeLE(out+2, c1, 2);
+  writeLE(out+4, indices, 4);
+}
+
+//##################################################################################################
+void encodeBC4(const Block_lt& block, size_t c, uint8_t* out)
+{
+  uint8_t mn=255;
+  uint8_t mx=0;
+  for(const auto& p : block)
+  {
+    mn = std::min(mn, channel(p, c));
+    mx = std::max(mx, channel(p, c));
+  }
+
+  // a0>a1 selects the 8 value mode.
+  out[0] = mx;
+  out[1] = mn;
+
+  uint64_t indices=0;
+  if(mx>mn)
+  {
+    std::array<int, 8> palette;
+    palette[0] = mx;
+    palette[1] = mn;
+    for(int i=2; i<8; i++)
+      palette[size_t(i)] = ((8-i)*mx + (i-1)*mn) / 7;
+
+    for(size_t i=0; i<16; i++)
+    {
+      int v = channel(block[i], c);
+      uint64_t best=0;
+      int bestError=std::numeric_limits<int>::max();
+      for(size_t p=0; p<8; p++)
+      {
+        if(int error = std::abs(palette[p]-v); error<bestError)
+        {
+          bestError = error;
+          best = p;
+        }
+      }
+      indices |= best << (i*3);
+    }
+  }
+
+  writeLE(out+2, indices, 6);
+}
+
+//##################################################################################################
+//! Writes values to a 128 bit block least significant bit first.
+struct BitWriter_lt
+{
+  uint8_t* out;
+  size_t bit{0};
+
+  void write(uint32_t value, size_t bits)
+  {
+    for(size_t i=0; i<bits; i++, bit++)
+      if((value>>i) & 1)
+        out[bit/8] |= uint8_t(1 << (bit%8));
+  }
+};
+
+//##################################################################################################
+//! BC7 mode 6, a single subset with RGBA endpoints and 4 bit indices.
+void encodeBC7(const Block_lt& block, uint8_t* out)
+{
+  static const std::array<int, 16> weights{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+  auto vec = [](const TPPixel& p){return glm::vec4(p.r, p.g, p.b, p.a);};
+
+  glm::vec4 mean{0.0f};
+  for(const auto& p : block)
+    mean += vec(p);
+  mean /= 16.0f;
+
+  glm::mat4 covariance{0.0f};
+  for(const auto& p : block)
+  {
+    glm::vec4 v = vec(p) - mean;
+    covariance += glm::outerProduct(v, v);
+  }
+
+  glm::vec4 axis = principalAxis(covariance, glm::normalize(glm::vec4(1.0f)));
+
+  float tMin=0.0f;
+  float tMax=0.0f;
+  for(const auto& p : block)
+  {
+    float t = glm::dot(vec(p) - mean, axis);
+    tMin = std::min(tMin, t);
+    tMax = std::max(tMax, t);
+  }
+
+  std::array<glm::vec4, 2> endpoints{glm::clamp(mean + axis*tMin, 0.0f, 255.0f),
+                                     glm::clamp(mean + axis*tMax, 0.0f, 255.0f)};
+
+  // Quantize each endpoint to 7 bits per channel plus a shared p-bit, choosing the best p-bit.
+  std::array<glm::ivec4, 2> q;
+  std::array<int, 2> pBits{0, 0};
+  std::array<glm::ivec4, 2> e;
+  for(size_t i=0; i<2; i++)
+  {
+    float bestError=std::numeric_limits<float>::max();
+    for(int p=0; p<2; p++)
+    {
+      glm::ivec4 qq = glm::clamp(glm::ivec4((endpoints[i] - float(p)) / 2.0f + 0.5f), 0, 127);
+      glm::ivec4 ee = (qq<<1) | p;
+      glm::vec4 d = glm::vec4(ee) - endpoints[i];
+      if(float error = glm::dot(d, d); error<bestError)
+      {
+        bestError = error;
+        q[i] = qq;
+        e[i] = ee;
+        pBits[i] = p;
+      }
+    }
+  }
+
+  std::array<glm::ivec4, 16> palette;
+  for(size_t w=0; w<16; w++)
+    palette[w] = ((64-weights[w])*e[0] + weights[w]*e[1] + 32) >> 6;
+
+  std::array<uint32_t, 16> indices;
+  for(size_t i=0; i<16; i++)
+  {
+    glm::ivec4 v(block[i].r, block[i].g, block[i].b, block[i].a);
+    int bestError=std::numeric_limits<int>::max();
+    for(uint32_t w=0; w<16; w++)
+    {
+      glm::ivec4 d = palette[w] - v;
+      if(int error = d.x*d.x + d.y*d.y + d.z*d.z + d.w*d.w; error<bestError)
+      {
+        bestError = error;
+        indices[i] = w;
+      }
+    }
+  }
+
+  // The most significant bit of the anchor index is implicitly 0.
+  if(indices[0] & 8)
+  {
+    std::swap(q[0], q[1]);
+    std::swap(pBits[0], pBits[1]);
+    for(auto& index : indices)
+      index = 15 - index;
+  }
+
+  std::memset(out, 0, 16);
+  BitWriter_lt writer{out};
+  writer.write(1<<6, 7);
+  for(int c=0; c<4; c++)
+  {
+    writer.write(uint32_t(q[0][c]), 7);
+    writer.write(uint32_t(q[1][c]), 7);
+  }
+  writer.write(uint32_t(pBits[0]), 1);
+  writer.write(uint32_t(pBits[1]), 1);
+  writer.write(indices[0], 3);
+  for(size_t i=1; i<16; i++)
+    writer.write(indices[i], 4);
+}
+
+//##################################################################################################
+const std::array<std::array<int, 2>, 8> etcModifiers{{{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}}};
+
+//##################################################################################################
+//! Pixel index values map to modifiers as: 0=+a, 1=+b, 2=-a, 3=-b.
+int etcModifier(size_t table, uint32_t index)
+{
+  int m = etcModifiers[table][index&1];
+  return (index&2)?-m:m;
+}
+
+//##################################################################################################
+//! Find the best table for a sub-block returning the error and writing the pixel indices.
+int fitETCSubBlock(const Block_lt& block,
+                   const std::array<size_t, 8>& pixels,
+                   const glm::ivec3& base,
+                   uint32_t& bestTable,
+                   std::array<uint32_t, 16>& indices)
+{
+  int bestError=std::numeric_limits<int>::max();
+  std::array<uint32_t, 16> tableIndices;
+
+  for(uint32_t table=0; table<8; table++)
+  {
+    int error=0;
+    for(auto i : pixels)
+    {
+      glm::ivec3 v(block[i].r, block[i].g, block[i].b);
+      int bestPixelError=std::numeric_limits<int>::max();
+      for(uint32_t m=0; m<4; m++)
+      {
+        glm::ivec3 d = glm::clamp(base + etcModifier(table, m), 0, 255) - v;
+        if(int e = d.x*d.x + d.y*d.y + d.z*d.z; e<bestPixelError)
+        {
+          bestPixelError = e;
+          tableIndices[i] = m;
+        }
+      }
+      error += bestPixelError;
+    }
+
+    if(error<bestError)
+    {
+      bestError = error;
+      bestTable = table;
+      for(auto i : pixels)
+        indices[i] = tableIndices[i];
+    }
+  }
+
+  return bestError;
+}
+
+//##################################################################################################
+//! ETC1 compatible individual and differential modes, these decode identically as ETC2.
+void encodeETC2RGB(const Block_lt& block, uint8_t* out)
+{
+  uint32_t bestHigh=0;
+  uint32_t bestLow=0;
+  int bestError=std::numeric_limits<int>::max();
+
+  for(uint32_t flip=0; flip<2; flip++)
+  {
+    std::array<std::array<size_t, 8>, 2> pixels;
+    std::array<size_t, 2> counts{0, 0};
+    std::array<glm::vec3, 2> averages{glm::vec3(0.0f), glm::vec3(0.0f)};
+
+    for(size_t y=0; y<4; y++)
+    {
+      for(size_t x=0; x<4; x++)
+      {
+        size_t s = flip?(y/2):(x/2);
+        size_t i = y*4+x;
+        pixels[s][counts[s]++] = i;
+        averages[s] += glm::vec3(block[i].r, block[i].g, block[i].b) / 8.0f;
+      }
+    }
+
+    std::array<glm::ivec3, 2> q;
+    std::array<glm::ivec3, 2> bases;
+    for(size_t s=0; s<2; s++)
+      q[s] = glm::clamp(glm::ivec3(averages[s] * (31.0f/255.0f) + 0.5f), 0, 31);
+
+    glm::ivec3 delta = q[1] - q[0];
+    uint32_t diff = (glm::all(glm::greaterThanEqual(delta, glm::ivec3(-4))) && glm::all(glm::lessThanEqual(delta, glm::ivec3(3))))?1:0;
+
+    if(diff)
+    {
+      for(size_t s=0; s<2; s++)
+        bases[s] = (q[s]<<3) | (q[s]>>2);
+    }
+    else
+    {
+      for(size_t s=0; s<2; s++)
+      {
+        q[s] = glm::clamp(glm::ivec3(averages[s] * (15.0f/255.0f) + 0.5f), 0, 15);
+        bases[s] = (q[s]<<4) | q[s];
+      }
+    }
+
+    std::array<uint32_t, 16> indices;
+    std::array<uint32_t, 2> tables{0, 0};
+    int error = fitETCSubBlock(block, pixels[0], bases[0], tables[0], indices) +
+                fitETCSubBlock(block, pixels[1], bases[1], tables[1], indices);
+
+    if(error>=bestError)
+      continue;
+
+    bestError = error;
+
+    uint32_t high=0;
+    if(diff)
+    {
+      high |= uint32_t(q[0].x)<<27 | uint32_t(delta.x&7)<<24;
+      high |= uint32_t(q[0].y)<<19 | uint32_t(delta.y&7)<<16;
+      high |= uint32_t(q[0].z)<<11 | uint32_t(delta.z&7)<< 8;
+    }
+    else
+    {
+      high |= uint32_t(q[0].x)<<28 | uint32_t(q[1].x)<<24;
+      high |= uint32_t(q[0].y)<<20 | uint32_t(q[1].y)<<16;
+      high |= uint32_t(q[0].z)<<12 | uint32_t(q[1].z)<< 8;
+    }
+    high |= tables[0]<<5 | tables[1]<<2 | diff<<1 | flip;
+
+    // Pixel indices are stored column major, most significant bits in the upper half.
+    uint32_t low=0;
+    for(size_t y=0; y<4; y++)
+    {
+      for(size_t x=0; x<4; x++)
+      {
+        uint32_t index = indices[y*4+x];
+        size_t j = x*4+y;
+        low |= ((index>>1)&1) << (16+j);
+        low |= ( index    &1) << j;
+      }
+    }
+
+    bestHigh = high;
+    bestLow = low;
+  }
+
+  writeBE(out  , bestHigh, 4);
+  writeBE(out+4, bestLow , 4);
+}
+
+//##################################################################################################
+const std::array<std::array<int, 8>, 16> eacModifiers{{
+  {-3, -6,  -9, -15, 2, 5, 8, 14},
+  {-3, -7, -10, -13, 2, 6, 9, 12},
+  {-2, -5,  -8, -13, 1, 4, 7, 12},
+  {-2, -4,  -6, -13, 1, 3, 5, 12},
+  {-3, -6,  -8, -12, 2, 5, 7, 11},
+  {-3, -7,  -9, -11, 2, 6, 8, 10},
+  {-4, -7,  -8, -11, 3, 6, 7, 10},
+  {-3, -5,  -8, -11, 2, 4, 7, 10},
+  {-2, -6,  -8, -10, 1, 5, 7,  9},
+  {-2, -5,  -8, -10, 1, 4, 7,  9},
+  {-2, -4,  -8, -10, 1, 3, 7,  9},
+  {-2, -5,  -7, -10, 1, 4, 6,  9},
+  {-3, -4,  -7, -10, 2, 3, 6,  9},
+  {-1, -2,  -3, -10, 0, 1, 2,  9},
+  {-4, -6,  -8,  -9, 3, 5, 7,  8},
+  {-3, -5,  -7,  -9, 2, 4, 6,  8}
+}};
+
+//##################################################################################################
+void encodeEACAlpha(const Block_lt& block, uint8_t* out)
+{
+  int mn=255;
+  int mx=0;
+  for(const auto& p : block)
+  {
+    mn = std::min(mn, int(p.a));
+    mx = std::max(mx, int(p.a));
+  }
+
+  // Table 13 has a 0 modifier at index 4, this is used for flat blocks.
+  int bestBase=mn;
+  int bestMultiplier=1;
+  size_t bestTable=13;
+  std::array<uint64_t, 16> bestIndices;
+  bestIndices.fill(4);
+
+  if(mx>mn)
+  {
+    int bestError=std::numeric_limits<int>::max();
+    for(size_t table=0; table<16; table++)
+    {
+      const auto& modifiers = eacModifiers[table];
+      int span = modifiers[7] - modifiers[3];
+      int m = (mx-mn + span/2) / span;
+      for(int multiplier=std::max(1, m-1); multiplier<=std::min(15, m+1); multiplier++)
+      {
+        int base = std::clamp(((mn - modifiers[3]*multiplier) + (mx - modifiers[7]*multiplier) + 1) / 2, 0, 255);
+
+        int error=0;
+        std::array<uint64_t, 16> indices;
+        for(size_t i=0; i<16 && error<bestError; i++)
+        {
+          int bestPixelError=std::numeric_limits<int>::max();
+          for(size_t j=0; j<8; j++)
+          {
+            int d = std::clamp(base + modifiers[j]*multiplier, 0, 255) - int(block[i].a);
+            if(d*d<bestPixelError)
+            {
+              bestPixelError = d*d;
+              indices[i] = j;
+            }
+          }
+          error += bestPixelError;
+        }
+
+        if(error<bestError)
+        {
+          bestError = error;
+          bestBase = base;
+          bestMultiplier = multiplier;
+          bestTable = table;
+          bestIndices = indices;
+        }
+      }
+    }
+  }
+
+  uint64_t bits = uint64_t(bestBase)<<56 | uint64_t(bestMultiplier)<<52 | uint64_t(bestTable)<<48;
+  for(size_t y=0; y<4; y++)
+    for(size_t x=0; x<4; x++)
+      bits |= bestIndices[y*4+x] << (45 - 3*(x*4+y));
+
+  writeBE(out, bits, 8);
+}
+
+//##################################################################################################
+uint64_t readLE(const uint8_t* in, size_t bytes)
+{
+  uint64_t value=0;
+  for(size_t i=0; i<bytes; i++)
+    value |= uint64_t(in[i]) << (i*8);
+  return value;
+}
+
+//##################################################################################################
+uint64_t readBE(const uint8_t* in, size_t bytes)
+{
+  uint64_t value=0;
+  for(size_t i=0; i<bytes; i++)
+    value = (value<<8) | in[i];
+  return value;
+}
+
+//##################################################################################################
+//! BC3 color blocks always use the 4 color mode.
+void decodeBC1(const uint8_t* in, Block_lt& block, bool fourColor=false)
+{
+  auto c0 = uint16_t(readLE(in  , 2));
+  auto c1 = uint16_t(readLE(in+2, 2));
+  auto indices = uint32_t(readLE(in+4, 4));
+
+  std::array<glm::ivec4, 4> palette;
+  palette[0] = glm::ivec4(glm::ivec3(from565(c0)), 255);
+  palette[1] = glm::ivec4(glm::ivec3(from565(c1)), 255);
+  if(c0>c1 || fourColor)
+  {
+    palette[2] = (2*palette[0] + palette[1]) / 3;
+    palette[3] = (palette[0] + 2*palette[1]) / 3;
+  }
+  else
+  {
+    palette[2] = (palette[0] + palette[1]) / 2;
+    palette[3] = glm::ivec4(0);
+  }
+
+  for(size_t i=0; i<16; i++)
+  {
+    const auto& c = palette[(indices>>(i*2)) & 3];
+    block[i] = TPPixel(uint8_t(c.x), uint8_t(c.y), uint8_t(c.z), uint8_t(c.w));
+  }
+}
+
+//##################################################################################################
+void decodeBC4(const uint8_t* in, size_t c, Block_lt& block)
+{
+  int a0 = in[0];
+  int a1 = in[1];
+  uint64_t indices = readLE(in+2, 6);
+
+  std::array<int, 8> palette;
+  palette[0] = a0;
+  palette[1] = a1;
+  if(a0>a1)
+  {
+    for(int i=2; i<8; i++)
+      palette[size_t(i)] = ((8-i)*a0 + (i-1)*a1) / 7;
+  }
+  else
+  {
+    for(int i=2; i<6; i++)
+      palette[size_t(i)] = ((6-i)*a0 + (i-1)*a1) / 5;
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+
+  for(size_t i=0; i<16; i++)
+  {
+    auto v = uint8_t(palette[(indices>>(i*3)) & 7]);
+    switch(c)
+    {
+      case 0: block[i].r = v; break;
+      case 1: block[i].g = v; break;
+      case 2: block[i].b = v; break;
+      default: block[i].a = v; break;
+    }
+  }
+}
+
+//##################################################################################################
+//! Only mode 6 is decoded as that is the only mode that encodeBC7 writes.
+bool decodeBC7(const uint8_t* in, Block_lt& block)
+{
+  static const std::array<int, 16> weights{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+  size_t bit=0;
+  auto read = [&](size_t bits)
+  {
+    uint32_t value=0;
+    for(size_t i=0; i<bits; i++, bit++)
+      value |= uint32_t((in[bit/8]>>(bit%8)) & 1) << i;
+    return value;
+  };
+
+  if(read(7) != (1<<6))
+    return false;
+
+  std::array<glm::ivec4, 2> e;
+  for(int c=0; c<4; c++)
+  {
+    e[0][c] = int(read(7));
+    e[1][c] = int(read(7));
+  }
+
+  for(auto& endpoint : e)
+    endpoint = (endpoint<<1) | int(read(1));
+
+  for(size_t i=0; i<16; i++)
+  {
+    auto w = weights[read(i==0?3:4)];
+    glm::ivec4 c = ((64-w)*e[0] + w*e[1] + 32) >> 6;
+    block[i] = TPPixel(uint8_t(c.x), uint8_t(c.y), uint8_t(c.z), uint8_t(c.w));
+  }
+
+  return true;
+}
+
+//##################################################################################################
+//! Only the ETC1 compatible modes are decoded as those are the only modes that encodeETC2RGB writes.
+bool decodeETC2RGB(const uint8_t* in, Block_lt& block)
+{
+  auto high = uint32_t(readBE(in  , 4));
+  auto low  = uint32_t(readBE(in+4, 4));
+
+  bool diff = (high>>1) & 1;
+  bool flip = high & 1;
+
+  std::array<glm::ivec3, 2> bases;
+  if(diff)
+  {
+    glm::ivec3 q0(int(high>>27) & 31, int(high>>19) & 31, int(high>>11) & 31);
+    auto signExtend = [](uint32_t v){return int(v&3) - int(v&4);};
+    glm::ivec3 q1 = q0 + glm::ivec3(signExtend(high>>24), signExtend(high>>16), signExtend(high>>8));
+
+    // Overflow selects the ETC2 T, H, and planar modes.
+    if(glm::any(glm::lessThan(q1, glm::ivec3(0))) || glm::any(glm::greaterThan(q1, glm::ivec3(31))))
+      return false;
+
+    bases[0] = (q0<<3) | (q0>>2);
+    bases[1] = (q1<<3) | (q1>>2);
+  }
+  else
+  {
+    glm::ivec3 q0(int(high>>28) & 15, int(high>>20) & 15, int(high>>12) & 15);
+    glm::ivec3 q1(int(high>>24) & 15, int(high>>16) & 15, int(high>> 8) & 15);
+    bases[0] = (q0<<4) | q0;
+    bases[1] = (q1<<4) | q1;
+  }
+
+  std::array<size_t, 2> tables{(high>>5) & 7, (high>>2) & 7};
+
+  for(size_t y=0; y<4; y++)
+  {
+    for(size_t x=0; x<4; x++)
+    {
+      size_t s = flip?(y/2):(x/2);
+      size_t j = x*4+y;
+      uint32_t index = (((low>>(16+j)) & 1) << 1) | ((low>>j) & 1);
+      glm::ivec3 c = glm::clamp(bases[s] + etcModifier(tables[s], index), 0, 255);
+      auto& p = block[y*4+x];
+      p.r = uint8_t(c.x);
+      p.g = uint8_t(c.y);
+      p.b = uint8_t(c.z);
+    }
+  }
+
+  return true;
+}
+
+//##################################################################################################
+void decodeEACAlpha(const uint8_t* in, Block_lt& block)
+{
+  uint64_t bits = readBE(in, 8);
+  int base = int(bits>>56) & 255;
+  int multiplier = int(bits>>52) & 15;
+  const auto& modifiers = eacModifiers[(bits>>48) & 15];
+
+  for(size_t y=0; y<4; y++)
+    for(size_t x=0; x<4; x++)
+      block[y*4+x].a = uint8_t(std::clamp(base + modifiers[(bits>>(45 - 3*(x*4+y))) & 7]*multiplier, 0, 255));
+}
+
+//##################################################################################################
+std::string cachePath(const std::string& cacheDirectory,
+                      uint64_t hash,
+                      CompressedFormat compressedFormat,
+                      bool generateMipmaps)
+{
+  static const char* hex = "0123456789abcdef";
+  std::string name(16, '0');
+  for(size_t i=0; i<16; i++)
+    name[15-i] = hex[(hash>>(i*4))&15];
+
+  std::string path = cacheDirectory;
+  if(!path.empty() && path.back()!='/' && path.back()!='\\')
+    path += '/';
+
+  return path + name + '_' + compressedFormatToString(compressedFormat) + (generateMipmaps?"_mips":"") + ".tpct";
+}
+}
+
+//##################################################################################################
+std::vector<CompressedFormat> compressedFormats()
+{
+  return
+  {
+    CompressedFormat::None,
+    CompressedFormat::BC1,
+    CompressedFormat::BC3,
+    CompressedFormat::BC4,
+    CompressedFormat::BC5,
+    CompressedFormat::BC7,
+    CompressedFormat::ETC2_RGB,
+    CompressedFormat::ETC2_RGBA
+  };
+}
+
+//##################################################################################################
+std::string compressedFormatToString(CompressedFormat compressedFormat)
+{
+  switch(compressedFormat)
+  {
+    case CompressedFormat::None     : return "None";
+    case CompressedFormat::BC1      : return "BC1";
+    case CompressedFormat::BC3      : return "BC3";
+    case CompressedFormat::BC4      : return "BC4";
+    case CompressedFormat::BC5      : return "BC5";
+    case CompressedFormat::BC7      : return "BC7";
+    case CompressedFormat::ETC2_RGB : return "ETC2_RGB";
+    case CompressedFormat::ETC2_RGBA: return "ETC2_RGBA";
+  }
+  return "None";
+}
+
+//##################################################################################################
+CompressedFormat compressedFormatFromString(const std::string& compressedFormat)
+{
+  for(auto f : compressedFormats())
+    if(compressedFormatToString(f) == compressedFormat)
+      return f;
+  return CompressedFormat::None;
+}
+
+//##################################################################################################
+size_t compressedBlockBytes(CompressedFormat compressedFormat)
+{
+  switch(compressedFormat)
+  {
+    case CompressedFormat::None     : return 0;
+    case CompressedFormat::BC1      : return 8;
+    case CompressedFormat::BC3      : return 16;
+    case CompressedFormat::BC4      : return 8;
+    case CompressedFormat::BC5      : return 16;
+    case CompressedFormat::BC7      : return 16;
+    case CompressedFormat::ETC2_RGB : return 8;
+    case CompressedFormat::ETC2_RGBA: return 16;
+  }
+  return 0;
+}
+
+//##################################################################################################
+size_t compressedImageBytes(CompressedFormat compressedFormat, size_t width, size_t height)
+{
+  return ((width+3)/4) * ((height+3)/4) * compressedBlockBytes(compressedFormat);
+}
+
+//##################################################################################################
+GLenum compressedFormatGLEnum(CompressedFormat compressedFormat)
+{
+  switch(compressedFormat)
+  {
+    case CompressedFormat::None     : return 0;
+    case CompressedFormat::BC1      : return TP_GL_COMPRESSED_RGB_S3TC_DXT1;
+    case CompressedFormat::BC3      : return TP_GL_COMPRESSED_RGBA_S3TC_DXT5;
+    case CompressedFormat::BC4      : return TP_GL_COMPRESSED_RED_RGTC1;
+    case CompressedFormat::BC5      : return TP_GL_COMPRESSED_RG_RGTC2;
+    case CompressedFormat::BC7      : return TP_GL_COMPRESSED_RGBA_BPTC;
+    case CompressedFormat::ETC2_RGB : return TP_GL_COMPRESSED_RGB8_ETC2;
+    case CompressedFormat::ETC2_RGBA: return TP_GL_COMPRESSED_RGBA8_ETC2_EAC;
+  }
+  return 0;
+}
+
+//##################################################################################################
+std::vector<CompressedFormat> querySupportedCompressedFormats(ShaderProfile shaderProfile)
+{
+  std::vector<CompressedFormat> formats;
+  auto add = [&](CompressedFormat f)
+  {
+    if(std::find(formats.begin(), formats.end(), f) == formats.end())
+      formats.push_back(f);
+  };
+
+  {
+    GLint count=0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+    std::vector<GLint> glFormats(size_t(std::max(0, count)));
+    if(!glFormats.empty())
+      glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, glFormats.data());
+
+    for(auto f : compressedFormats())
+      if(f != CompressedFormat::None && std::find(glFormats.begin(), glFormats.end(), GLint(compressedFormatGLEnum(f))) != glFormats.end())
+        add(f);
+  }
+
+#if defined(TP_GL3) || defined(TP_GLES3)
+  {
+    GLint count=0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for(GLint i=0; i<count; i++)
+    {
+      auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+      if(!name)
+        continue;
+
+      std::string extension(name);
+      if(extension == "GL_EXT_texture_compression_s3tc")
+      {
+        add(CompressedFormat::BC1);
+        add(CompressedFormat::BC3);
+      }
+      else if(extension == "GL_ARB_texture_compression_rgtc" || extension == "GL_EXT_texture_compression_rgtc")
+      {
+        add(CompressedFormat::BC4);
+        add(CompressedFormat::BC5);
+      }
+      else if(extension == "GL_ARB_texture_compression_bptc" || extension == "GL_EXT_texture_compression_bptc")
+        add(CompressedFormat::BC7);
+    }
+  }
+#endif
+
+  // Formats that are core in a given version.
+  switch(shaderProfile)
+  {
+    case ShaderProfile::GLSL_420: [[fallthrough]];
+    case ShaderProfile::GLSL_430: [[fallthrough]];
+    case ShaderProfile::GLSL_440: [[fallthrough]];
+    case ShaderProfile::GLSL_450: [[fallthrough]];
+    case ShaderProfile::GLSL_460:
+    add(CompressedFormat::BC7);
+    [[fallthrough]];
+
+    case ShaderProfile::GLSL_130: [[fallthrough]];
+    case ShaderProfile::GLSL_140: [[fallthrough]];
+    case ShaderProfile::GLSL_150: [[fallthrough]];
+    case ShaderProfile::GLSL_330: [[fallthrough]];
+    case ShaderProfile::GLSL_400: [[fallthrough]];
+    case ShaderProfile::GLSL_410:
+    add(CompressedFormat::BC4);
+    add(CompressedFormat::BC5);
+    break;
+
+    case ShaderProfile::GLSL_300_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_310_ES: [[fallthrough]];
+    case ShaderProfile::GLSL_320_ES:
+    add(CompressedFormat::ETC2_RGB);
+    add(CompressedFormat::ETC2_RGBA);
+    break;
+
+    default:
+    break;
+  }
+
+  return formats;
+}
+
+//##################################################################################################
+CompressedFormat selectCompressedFormat(TextureUsage usage,
+                                        bool hasAlpha,
+                                        const std::vector<CompressedFormat>& supportedFormats)
+{
+  auto first = [&](std::initializer_list<CompressedFormat> options)
+  {
+    for(auto f : options)
+      if(std::find(supportedFormats.begin(), supportedFormats.end(), f) != supportedFormats.end())
+        return f;
+    return CompressedFormat::None;
+  };
+
+  switch(usage)
+  {
+    case TextureUsage::Color:
+    return hasAlpha?first({CompressedFormat::BC7, CompressedFormat::BC3, CompressedFormat::ETC2_RGBA}):
+                    first({CompressedFormat::BC1, CompressedFormat::ETC2_RGB});
+
+    case TextureUsage::Normals:
+    return first({CompressedFormat::BC5, CompressedFormat::ETC2_RGB});
+
+    case TextureUsage::Data:
+    // The channels are unrelated so only formats that don't correlate them are suitable.
+    return first({CompressedFormat::BC7});
+
+    case TextureUsage::Mask:
+    return first({CompressedFormat::BC4, CompressedFormat::ETC2_RGB});
+  }
+
+  return CompressedFormat::None;
+}
+
+//##################################################################################################
+bool CompressedImage::isValid() const
+{
+  if(format == CompressedFormat::None || levels.empty())
+    return false;
+
+  for(const auto& level : levels)
+    if(level.width<1 || level.height<1 || level.data.size() != compressedImageBytes(format, level.width, level.height))
+      return false;
+
+  return true;
+}
+
+//##################################################################################################
+size_t CompressedImage::width() const
+{
+  return levels.empty()?0:levels.front().width;
+}
+
+//##################################################################################################
+size_t CompressedImage::height() const
+{
+  return levels.empty()?0:levels.front().height;
+}
+
+//##################################################################################################
+size_t CompressedImage::sizeInBytes() const
+{
+  size_t size=0;
+  for(const auto& level : levels)
+    size += level.data.size();
+  return size;
+}
+
+//##################################################################################################
+bool imageHasAlpha(const tp_image_utils::ColorMap& image)
+{
+  const TPPixel* p = image.constData();
+  const TPPixel* pMax = p + image.size();
+  for(; p<pMax; p++)
+    if(p->a != 255)
+      return true;
+  return false;
+}
+
+//##################################################################################################
+uint64_t imageContentHash(const tp_image_utils::ColorMap& image)
+{
+  auto mix = [](uint64_t h)
+  {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  };
+
+  uint64_t h = mix((uint64_t(image.width())<<32) ^ uint64_t(image.height()) ^ 0x9e3779b97f4a7c15ULL);
+
+  const auto* bytes = reinterpret_cast<const uint8_t*>(image.constData());
+  size_t size = image.size()*sizeof(TPPixel);
+  size_t i=0;
+  for(; i+8<=size; i+=8)
+  {
+    uint64_t v;
+    std::memcpy(&v, bytes+i, 8);
+    h = (h ^ mix(v)) * 0x9e3779b97f4a7c15ULL;
+  }
+
+  if(i<size)
+  {
+    uint64_t v=0;
+    std::memcpy(&v, bytes+i, size-i);
+    h = (h ^ mix(v)) * 0x9e3779b97f4a7c15ULL;
+  }
+
+  return mix(h ^ size);
+}
+
+//##################################################################################################
+CompressedImageLevel compressImageLevel(const tp_image_utils::ColorMap& image,
+                                        CompressedFormat compressedFormat)
+{
+  TP_FUNCTION_TIME("compressImageLevel");
+
+  CompressedImageLevel level;
+  level.width = image.width();
+  level.height = image.height();
+
+  if(level.width<1 || level.height<1 || !image.constData() || compressedFormat == CompressedFormat::None)
+    return level;
+
+  size_t blockBytes = compressedBlockBytes(compressedFormat);
+  size_t bw = (level.width+3)/4;
+  size_t bh = (level.height+3)/4;
+  level.data.resize(bw*bh*blockBytes);
+
+  Block_lt block;
+  uint8_t* out = level.data.data();
+  for(size_t by=0; by<bh; by++)
+  {
+    for(size_t bx=0; bx<bw; bx++, out+=blockBytes)
+    {
+      readBlock(image, bx, by, block);
+
+      switch(compressedFormat)
+      {
+        case CompressedFormat::None: break;
+        case CompressedFormat::BC1: encodeBC1(block, out); break;
+        case CompressedFormat::BC3: encodeBC4(block, 3, out); encodeBC1(block, out+8); break;
+        case CompressedFormat::BC4: encodeBC4(block, 0, out); break;
+        case CompressedFormat::BC5: encodeBC4(block, 0, out); encodeBC4(block, 1, out+8); break;
+        case CompressedFormat::BC7: encodeBC7(block, out); break;
+        case CompressedFormat::ETC2_RGB: encodeETC2RGB(block, out); break;
+        case CompressedFormat::ETC2_RGBA: encodeEACAlpha(block, out); encodeETC2RGB(block, out+8); break;
+      }
+    }
+  }
+
+  return level;
+}
+
+//##################################################################################################
+bool decompressImageLevel(const CompressedImageLevel& level,
+                          CompressedFormat compressedFormat,
+                          tp_image_utils::ColorMap& image)
+{
+  TP_FUNCTION_TIME("decompressImageLevel");
+
+  size_t blockBytes = compressedBlockBytes(compressedFormat);
+  size_t bw = (level.width+3)/4;
+  size_t bh = (level.height+3)/4;
+  if(compressedFormat == CompressedFormat::None || level.data.size() != bw*bh*blockBytes)
+    return false;
+
+  image = tp_image_utils::ColorMap(level.width, level.height);
+  TPPixel* data = image.data();
+
+  Block_lt block;
+  const uint8_t* in = level.data.data();
+  for(size_t by=0; by<bh; by++)
+  {
+    for(size_t bx=0; bx<bw; bx++, in+=blockBytes)
+    {
+      block.fill(TPPixel(0, 0, 0, 255));
+
+      bool ok=true;
+      switch(compressedFormat)
+      {
+        case CompressedFormat::None: break;
+        case CompressedFormat::BC1: decodeBC1(in, block); break;
+        case CompressedFormat::BC3: decodeBC1(in+8, block, true); decodeBC4(in, 3, block); break;
+        case CompressedFormat::BC4: decodeBC4(in, 0, block); break;
+        case CompressedFormat::BC5: decodeBC4(in, 0, block); decodeBC4(in+8, 1, block); break;
+        case CompressedFormat::BC7: ok = decodeBC7(in, block); break;
+        case CompressedFormat::ETC2_RGB: ok = decodeETC2RGB(in, block); break;
+        case CompressedFormat::ETC2_RGBA: ok = decodeETC2RGB(in+8, block); decodeEACAlpha(in, block); break;
+      }
+
+      if(!ok)
+        return false;
+
+      for(size_t y=0; y<4 && by*4+y<level.height; y++)
+        for(size_t x=0; x<4 && bx*4+x<level.width; x++)
+          data[(by*4+y)*level.width + bx*4+x] = block[y*4+x];
+    }
+  }
+
+  return true;
+}
+
+//##################################################################################################
+std::vector<std::string> checkTextureCompression()
+{
+  std::vector<std::string> failures;
+
+  // Smooth images that every format should reproduce closely, the odd size checks partial blocks.
+  std::vector<tp_image_utils::ColorMap> images;
+  {
+    auto& solid = images.emplace_back(8, 8);
+    for(size_t i=0; i<solid.size(); i++)
+      solid.data()[i] = TPPixel(200, 120, 40, 160);
+
+    auto& gradient = images.emplace_back(10, 6);
+    for(size_t y=0; y<gradient.height(); y++)
+    {
+      for(size_t x=0; x<gradient.width(); x++)
+      {
+        auto v = uint8_t((x+y)*8);
+        gradient.data()[y*gradient.width()+x] = TPPixel(uint8_t(v+20), uint8_t(v+60), uint8_t(v/2+30), uint8_t(255-v));
+      }
+    }
+  }
+
+  for(auto format : compressedFormats())
+  {
+    if(format == CompressedFormat::None)
+      continue;
+
+    std::vector<size_t> channels;
+    switch(format)
+    {
+      case CompressedFormat::None: break;
+      case CompressedFormat::BC4: channels = {0}; break;
+      case CompressedFormat::BC5: channels = {0, 1}; break;
+      case CompressedFormat::BC1: [[fallthrough]];
+      case CompressedFormat::ETC2_RGB: channels = {0, 1, 2}; break;
+      case CompressedFormat::BC3: [[fallthrough]];
+      case CompressedFormat::BC7: [[fallthrough]];
+      case CompressedFormat::ETC2_RGBA: channels = {0, 1, 2, 3}; break;
+    }
+
+    for(size_t i=0; i<images.size(); i++)
+    {
+      const auto& image = images.at(i);
+      std::string name = compressedFormatToString(format) + " image " + std::to_string(i);
+
+      auto level = compressImageLevel(image, format);
+      if(level.data.size() != compressedImageBytes(format, image.width(), image.height()))
+      {
+        failures.push_back(name + ": wrong encoded size.");
+        continue;
+      }
+
+      tp_image_utils::ColorMap decoded;
+      if(!decompressImageLevel(level, format, decoded))
+      {
+        failures.push_back(name + ": encoded an unexpected block mode.");
+        continue;
+      }
+
+      // Errors from a broken bit layout are far larger than the quantization error.
+      double error=0.0;
+      for(size_t p=0; p<image.size(); p++)
+        for(auto c : channels)
+          error += std::abs(int(channel(image.constData()[p], c)) - int(channel(decoded.constData()[p], c)));
+      error /= double(image.size()*channels.size());
+
+      if(error>8.0)
+        failures.push_back(name + ": mean error " + std::to_string(error) + " is too large.");
+    }
+  }
+
+  return failures;
+}
+
+//##################################################################################################
+CompressedImage compressImage(const tp_image_utils::ColorMap& image,
+                              CompressedFormat compressedFormat,
+                              bool generateMipmaps)
+{
+  TP_FUNCTION_TIME("compressImage");
+
+  CompressedImage compressedImage;
+  if(image.width()<1 || image.height()<1 || !image.constData() || compressedFormat == CompressedFormat::None)
+    return compressedImage;
+
+  compressedImage.format = compressedFormat;
+  compressedImage.levels.push_back(compressImageLevel(image, compressedFormat));
+
+  if(generateMipmaps)
+  {
+    for(const auto& level : generateMipmaps(image, MipmapFilter::Box, false))
+      compressedImage.levels.push_back(compressImageLevel(level, compressedFormat));
+  }
+
+  return compressedImage;
+}
+
+//##################################################################################################
+CompressedImage compressImageCached(const tp_image_utils::ColorMap& image,
+                                    CompressedFormat compressedFormat,
+                                    bool generateMipmaps,
+                                    const std::string& cacheDirectory)
+{
+  if(cacheDirectory.empty())
+    return compressImage(image, compressedFormat, generateMipmaps);
+
+  std::string path = cachePath(cacheDirectory, imageContentHash(image), compressedFormat, generateMipmaps);
+
+  CompressedImage compressedImage;
+  if(loadCompressedImage(path, compressedImage) &&
+     compressedImage.format == compressedFormat &&
+     compressedImage.width() == image.width() &&
+     compressedImage.height() == image.height())
+    return compressedImage;
+
+  compressedImage = compressImage(image, compressedFormat, generateMipmaps);
+  if(compressedImage.isValid() && !saveCompressedImage(path, compressedImage))
+    tpWarning() << "Failed to write compressed texture cache: " << path;
+
+  return compressedImage;
+}
+
+//##################################################################################################
+bool loadCompressedImage(const std::string& path, CompressedImage& compressedImage)
+{
+  compressedImage = CompressedImage();
+
+  std::ifstream in(path, std::ios::binary);
+  if(!in)
+    return false;
+
+  auto read = [&](auto& value)
+  {
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return bool(in);
+  };
+
+  uint32_t magic=0;
+  uint32_t version=0;
+  uint32_t format=0;
+  uint32_t levelCount=0;
+  if(!read(magic) || !read(version) || !read(format) || !read(levelCount))
+    return false;
+
+  if(magic != cacheMagic || version != cacheVersion || format>uint32_t(CompressedFormat::ETC2_RGBA) || levelCount>32)
+    return false;
+
+  compressedImage.format = CompressedFormat(format);
+  compressedImage.levels.resize(levelCount);
+  for(auto& level : compressedImage.levels)
+  {
+    uint32_t w=0;
+    uint32_t h=0;
+    uint64_t size=0;
+    if(!read(w) || !read(h) || !read(size))
+      return false;
+
+    level.width = w;
+    level.height = h;
+    if(size != compressedImageBytes(compressedImage.format, level.width, level.height))
+      return false;
+
+    level.data.resize(size_t(size));
+    in.read(reinterpret_cast<char*>(level.data.data()), std::streamsize(size));
+    if(!in)
+      return false;
+  }
+
+  return compressedImage.isValid();
+}
+
+//##################################################################################################
+bool saveCompressedImage(const std::string& path, const CompressedImage& compressedImage)
+{
+  if(!compressedImage.isValid())
+    return false;
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if(!out)
+    return false;
+
+  auto write = [&](auto value)
+  {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+
+  write(cacheMagic);
+  write(cacheVersion);
+  write(uint32_t(compressedImage.format));
+  write(uint32_t(compressedImage.levels.size()));
+  for(const auto& level : compressedImage.levels)
+  {
+    write(uint32_t(level.width));
+    write(uint32_t(level.height));
+    write(uint64_t(level.data.size()));
+    out.write(reinterpret_cast<const char*>(level.data.data()), std::streamsize(level.data.size()));
+  }
+
+  return bool(out);
+}
+
+}
@@ -73,9 +73,15 @@ HEADERS += inc/tp_maps/SwapRowOrder.h
 SOURCES += src/RenderModeManager.cpp
 HEADERS += inc/tp_maps/RenderModeManager.h
 
+SOURCES += src/WorkerThreads.cpp
+HEADERS += inc/tp_maps/WorkerThreads.h
+
 SOURCES += src/Subview.cpp
 HEADERS += inc/tp_maps/Subview.h
 
+SOURCES += src/RenderGraph.cpp
+HEADERS += inc/tp_maps/RenderGraph.h
+
 SOURCES += src/ColorManagement.cpp
 HEADERS += inc/tp_maps/ColorManagement.h
 
@@ -125,6 +131,9 @@ HEADERS += inc/tp_maps/picking_results/GeometryPickingResult.h
 SOURCES += src/picking_results/PointsPickingResult.cpp
 HEADERS += inc/tp_maps/picking_results/PointsPickingResult.h
 
+SOURCES += src/picking_results/PointCloudPickingResult.cpp
+HEADERS += inc/tp_maps/picking_results/PointCloudPickingResult.h
+
 SOURCES += src/picking_results/LinesPickingResult.cpp
 HEADERS += inc/tp_maps/picking_results/LinesPickingResult.h
 
@@ -153,12 +162,18 @@ HEADERS += inc/tp_maps/controllers/CADController.h
 SOURCES += src/shaders/LineShader.cpp
 HEADERS += inc/tp_maps/shaders/LineShader.h
 
+SOURCES += src/shaders/WideLineShader.cpp
+HEADERS += inc/tp_maps/shaders/WideLineShader.h
+
 SOURCES += src/shaders/PointSpriteShader.cpp
 HEADERS += inc/tp_maps/shaders/PointSpriteShader.h
 
 SOURCES += src/shaders/FontShader.cpp
 HEADERS += inc/tp_maps/shaders/FontShader.h
 
+SOURCES += src/shaders/FontSDFShader.cpp
+HEADERS += inc/tp_maps/shaders/FontSDFShader.h
+
 SOURCES += src/shaders/FrameShader.cpp
 HEADERS += inc/tp_maps/shaders/FrameShader.h
 
@@ -223,6 +238,15 @@ HEADERS += inc/tp_maps/shaders/PostSSRShader.h
 SOURCES += src/shaders/PostGammaShader.cpp
 HEADERS += inc/tp_maps/shaders/PostGammaShader.h
 
+SOURCES += src/shaders/PostAccumulateShader.cpp
+HEADERS += inc/tp_maps/shaders/PostAccumulateShader.h
+
+SOURCES += src/shaders/PostUpscaleShader.cpp
+HEADERS += inc/tp_maps/shaders/PostUpscaleShader.h
+
+SOURCES += src/shaders/PostFusedShader.cpp
+HEADERS += inc/tp_maps/shaders/PostFusedShader.h
+
 SOURCES += src/shaders/PostBlitShader.cpp
 HEADERS += inc/tp_maps/shaders/PostBlitShader.h
 
@@ -272,6 +296,18 @@ HEADERS += inc/tp_maps/shaders/PostDoFMergeShader.h
 SOURCES += src/shaders/PostDoFDownsampleShader.cpp
 HEADERS += inc/tp_maps/shaders/PostDoFDownsampleShader.h
 
+SOURCES += src/shaders/PostDoFFastDownsampleShader.cpp
+HEADERS += inc/tp_maps/shaders/PostDoFFastDownsampleShader.h
+
+SOURCES += src/shaders/PostDoFFastBlurShader.cpp
+HEADERS += inc/tp_maps/shaders/PostDoFFastBlurShader.h
+
+SOURCES += src/shaders/PostDoFFastMergeShader.cpp
+HEADERS += inc/tp_maps/shaders/PostDoFFastMergeShader.h
+
+SOURCES += src/shaders/PostDoFReduceShader.cpp
+HEADERS += inc/tp_maps/shaders/PostDoFReduceShader.h
+
 
 #-- Color Management -------------------------------------------------------------------------------
 
@@ -310,6 +346,9 @@ HEADERS += inc/tp_maps/layers/LinesLayer.h
 SOURCES += src/layers/PointsLayer.cpp
 HEADERS += inc/tp_maps/layers/PointsLayer.h
 
+SOURCES += src/layers/PointCloudLayer.cpp
+HEADERS += inc/tp_maps/layers/PointCloudLayer.h
+
 SOURCES += src/layers/FrustumLayer.cpp
 HEADERS += inc/tp_maps/layers/FrustumLayer.h
 
@@ -346,6 +385,9 @@ HEADERS += inc/tp_maps/layers/PostBlitLayer.h
 SOURCES += src/layers/PostGammaLayer.cpp
 HEADERS += inc/tp_maps/layers/PostGammaLayer.h
 
+SOURCES += src/layers/PostAccumulateLayer.cpp
+HEADERS += inc/tp_maps/layers/PostAccumulateLayer.h
+
 SOURCES += src/layers/PostSSAOLayer.cpp
 HEADERS += inc/tp_maps/layers/PostSSAOLayer.h
 
@@ -372,6 +414,12 @@ HEADERS += inc/tp_maps/layers/PostGrid2DLayer.h
 SOURCES += src/textures/BasicTexture.cpp
 HEADERS += inc/tp_maps/textures/BasicTexture.h
 
+SOURCES += src/textures/TextureCompression.cpp
+HEADERS += inc/tp_maps/textures/TextureCompression.h
+
+SOURCES += src/textures/Mipmaps.cpp
+HEADERS += inc/tp_maps/textures/Mipmaps.h
+
 SOURCES += src/textures/DefaultSpritesTexture.cpp
 HEADERS += inc/tp_maps/textures/DefaultSpritesTexture.h
 